@@ -0,0 +1,1151 @@
+/*
+ * art.c -- Adaptive Radix Trees
+ *
+ * Copyright (C) 2012-2013 yanyg (cppgp@qq.com)
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING, if not see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include <ycc/algos/art.h>
+
+#define __ART_NODE4	0
+#define __ART_NODE16	1
+#define __ART_NODE48	2
+#define __ART_NODE256	3
+
+/*
+ * Bytes of the compressed path kept in the node.  A longer path is
+ * skipped by the search and checked by the key compare at the leaf,
+ * insert and erase read the rest of it from any leaf below.
+ */
+#define __ART_PREFIX_MAX	9
+
+struct __art_node
+{
+	struct art_leaf *leaf;	/* the key ending after the prefix */
+	uint32_t prefix_len;
+	uint16_t num;		/* children */
+	uint8_t type;
+	unsigned char prefix[__ART_PREFIX_MAX];
+};
+
+/* node4 and node16 keep the key bytes sorted */
+struct __art_node4
+{
+	struct __art_node node;
+	unsigned char keys[4];
+	void *children[4];
+};
+
+struct __art_node16
+{
+	struct __art_node node;
+	unsigned char keys[16];
+	void *children[16];
+};
+
+/* index[byte] is 1 + the slot in children, 0 if none */
+struct __art_node48
+{
+	struct __art_node node;
+	unsigned char index[256];
+	void *children[48];
+};
+
+struct __art_node256
+{
+	struct __art_node node;
+	void *children[256];
+};
+
+#define __art_n4(n)	((struct __art_node4*)(n))
+#define __art_n16(n)	((struct __art_node16*)(n))
+#define __art_n48(n)	((struct __art_node48*)(n))
+#define __art_n256(n)	((struct __art_node256*)(n))
+
+/* a child is an inner node, or a leaf tagged by the low bit */
+#define __art_is_leaf(p)	((uintptr_t)(p) & 1)
+#define __art_leaf(p)		((struct art_leaf*)((uintptr_t)(p) - 1))
+#define __art_tag(leaf)		((void*)((uintptr_t)(leaf) + 1))
+
+#define __art_min(a, b)		((a) < (b) ? (a) : (b))
+
+static const size_t __art_size[] = {
+	sizeof(struct __art_node4), sizeof(struct __art_node16),
+	sizeof(struct __art_node48), sizeof(struct __art_node256),
+};
+
+static struct __art_node *__art_alloc(unsigned type)
+{
+	struct __art_node *n = calloc(1, __art_size[type]);
+
+	if (n)
+		n->type = type;
+	else
+		errno = ENOMEM;
+
+	return n;
+}
+
+static inline void __art_copy_header(struct __art_node *dst,
+				     const struct __art_node *src)
+{
+	dst->leaf = src->leaf;
+	dst->prefix_len = src->prefix_len;
+	dst->num = src->num;
+	memcpy(dst->prefix, src->prefix, __ART_PREFIX_MAX);
+}
+
+static inline bool __art_leaf_match(const struct art_leaf *leaf,
+				    const unsigned char *key, size_t len)
+{
+	return leaf->len == len && !memcmp(leaf->key, key, len);
+}
+
+static inline int __art_leaf_cmp(const struct art_leaf *leaf,
+				 const unsigned char *key, size_t len)
+{
+	int cmp = memcmp(leaf->key, key, __art_min(leaf->len, len));
+
+	if (cmp)
+		return cmp;
+
+	return leaf->len < len ? -1 : leaf->len > len;
+}
+
+/* the slot of the child at byte 'c', NULL if none */
+static void **__art_find_child(struct __art_node *n, unsigned char c)
+{
+	unsigned i;
+
+	switch (n->type) {
+	case __ART_NODE4:
+		for (i = 0; i < n->num; ++i)
+			if (__art_n4(n)->keys[i] == c)
+				return &__art_n4(n)->children[i];
+		return NULL;
+
+	case __ART_NODE16:
+	{
+#ifdef __SSE2__
+		/* all 16 bytes at once, the slots past 'num' masked out */
+		__m128i cmp = _mm_cmpeq_epi8(_mm_set1_epi8((char)c),
+			_mm_loadu_si128((const __m128i*)__art_n16(n)->keys));
+		unsigned mask = (unsigned)_mm_movemask_epi8(cmp) &
+				((1u << n->num) - 1);
+
+		return mask ? &__art_n16(n)->children[__builtin_ctz(mask)] :
+			      NULL;
+#else
+		for (i = 0; i < n->num; ++i)
+			if (__art_n16(n)->keys[i] == c)
+				return &__art_n16(n)->children[i];
+		return NULL;
+#endif
+	}
+
+	case __ART_NODE48:
+		i = __art_n48(n)->index[c];
+		return i ? &__art_n48(n)->children[i - 1] : NULL;
+
+	default:
+		return __art_n256(n)->children[c] ?
+			&__art_n256(n)->children[c] : NULL;
+	}
+}
+
+/* the child at the first byte >= 'from', stored to 'byte' */
+static void *__art_child_ge(const struct __art_node *n, unsigned from,
+			    unsigned *byte)
+{
+	const unsigned char *keys;
+	void *const *children;
+	unsigned i;
+
+	switch (n->type) {
+	case __ART_NODE4:
+	case __ART_NODE16:
+		if (n->type == __ART_NODE4) {
+			keys = __art_n4(n)->keys;
+			children = __art_n4(n)->children;
+		} else {
+			keys = __art_n16(n)->keys;
+			children = __art_n16(n)->children;
+		}
+		for (i = 0; i < n->num; ++i)
+			if (keys[i] >= from) {
+				*byte = keys[i];
+				return children[i];
+			}
+		return NULL;
+
+	case __ART_NODE48:
+		for (i = from; i < 256; ++i)
+			if (__art_n48(n)->index[i]) {
+				*byte = i;
+				return __art_n48(n)->children[
+					__art_n48(n)->index[i] - 1];
+			}
+		return NULL;
+
+	default:
+		for (i = from; i < 256; ++i)
+			if (__art_n256(n)->children[i]) {
+				*byte = i;
+				return __art_n256(n)->children[i];
+			}
+		return NULL;
+	}
+}
+
+static void *__art_child_last(const struct __art_node *n)
+{
+	int i;
+
+	switch (n->type) {
+	case __ART_NODE4:
+		return __art_n4(n)->children[n->num - 1];
+
+	case __ART_NODE16:
+		return __art_n16(n)->children[n->num - 1];
+
+	case __ART_NODE48:
+		for (i = 255; !__art_n48(n)->index[i]; --i)
+			;
+		return __art_n48(n)->children[__art_n48(n)->index[i] - 1];
+
+	default:
+		for (i = 255; !__art_n256(n)->children[i]; --i)
+			;
+		return __art_n256(n)->children[i];
+	}
+}
+
+/* 'p' not NULL, the key ending at a node is less than those below it */
+static struct art_leaf *__art_minimum(const void *p)
+{
+	const struct __art_node *n;
+	unsigned c;
+
+	while (!__art_is_leaf(p)) {
+		n = p;
+		if (n->leaf)
+			return n->leaf;
+		p = __art_child_ge(n, 0, &c);
+	}
+
+	return __art_leaf(p);
+}
+
+static struct art_leaf *__art_maximum(const void *p)
+{
+	const struct __art_node *n;
+
+	while (!__art_is_leaf(p)) {
+		n = p;
+		if (!n->num)
+			return n->leaf;
+		p = __art_child_last(n);
+	}
+
+	return __art_leaf(p);
+}
+
+/* the stored prefix bytes of 'n' matching 'key' from 'depth' */
+static inline size_t __art_check_prefix(const struct __art_node *n,
+					const unsigned char *key,
+					size_t len, size_t depth)
+{
+	size_t max = __art_min(__art_min(n->prefix_len, __ART_PREFIX_MAX),
+			       len - depth);
+	size_t i;
+
+	for (i = 0; i < max && n->prefix[i] == key[depth + i]; ++i)
+		;
+
+	return i;
+}
+
+/* as __art_check_prefix on the whole prefix, read from a leaf */
+static size_t __art_prefix_mismatch(const struct __art_node *n,
+				    const unsigned char *key,
+				    size_t len, size_t depth)
+{
+	size_t max = __art_min(n->prefix_len, len - depth);
+	const struct art_leaf *leaf;
+	size_t i;
+
+	for (i = 0; i < max && i < __ART_PREFIX_MAX; ++i)
+		if (n->prefix[i] != key[depth + i])
+			return i;
+
+	if (i < max) {
+		leaf = __art_minimum(n);
+		for (; i < max; ++i)
+			if (leaf->key[depth + i] != key[depth + i])
+				return i;
+	}
+
+	return i;
+}
+
+static void __art_add_sorted(unsigned char *keys, void **children,
+			     unsigned num, unsigned char c, void *child)
+{
+	unsigned i;
+
+	for (i = num; i && keys[i - 1] > c; --i) {
+		keys[i] = keys[i - 1];
+		children[i] = children[i - 1];
+	}
+	keys[i] = c;
+	children[i] = child;
+}
+
+/* a fresh node4 of 'depth' takes 'leaf' as its key or as a child */
+static void __art_add_leaf4(struct __art_node *n, struct art_leaf *leaf,
+			    size_t depth)
+{
+	if (leaf->len == depth)
+		n->leaf = leaf;
+	else
+		__art_add_sorted(__art_n4(n)->keys, __art_n4(n)->children,
+				 n->num++, leaf->key[depth], __art_tag(leaf));
+}
+
+/* add 'child' at 'c' to 'n' at '*ref', moving to a larger node if full */
+static int __art_add_child(void **ref, struct __art_node *n,
+			   unsigned char c, void *child)
+{
+	struct __art_node *new;
+	unsigned i;
+
+	switch (n->type) {
+	case __ART_NODE4:
+		if (n->num < 4) {
+			__art_add_sorted(__art_n4(n)->keys,
+					 __art_n4(n)->children,
+					 n->num++, c, child);
+			return 0;
+		}
+		if (!(new = __art_alloc(__ART_NODE16)))
+			return -1;
+		__art_copy_header(new, n);
+		memcpy(__art_n16(new)->keys, __art_n4(n)->keys, 4);
+		memcpy(__art_n16(new)->children, __art_n4(n)->children,
+		       4 * sizeof(void*));
+		__art_add_sorted(__art_n16(new)->keys,
+				 __art_n16(new)->children,
+				 new->num++, c, child);
+		break;
+
+	case __ART_NODE16:
+		if (n->num < 16) {
+			__art_add_sorted(__art_n16(n)->keys,
+					 __art_n16(n)->children,
+					 n->num++, c, child);
+			return 0;
+		}
+		if (!(new = __art_alloc(__ART_NODE48)))
+			return -1;
+		__art_copy_header(new, n);
+		for (i = 0; i < 16; ++i) {
+			__art_n48(new)->index[__art_n16(n)->keys[i]] = i + 1;
+			__art_n48(new)->children[i] = __art_n16(n)->children[i];
+		}
+		__art_n48(new)->index[c] = 17;
+		__art_n48(new)->children[16] = child;
+		++new->num;
+		break;
+
+	case __ART_NODE48:
+		if (n->num < 48) {
+			/* the erased slots are NULL */
+			for (i = 0; __art_n48(n)->children[i]; ++i)
+				;
+			__art_n48(n)->children[i] = child;
+			__art_n48(n)->index[c] = i + 1;
+			++n->num;
+			return 0;
+		}
+		if (!(new = __art_alloc(__ART_NODE256)))
+			return -1;
+		__art_copy_header(new, n);
+		for (i = 0; i < 256; ++i)
+			if (__art_n48(n)->index[i])
+				__art_n256(new)->children[i] =
+					__art_n48(n)->children[
+						__art_n48(n)->index[i] - 1];
+		__art_n256(new)->children[c] = child;
+		++new->num;
+		break;
+
+	default:
+		__art_n256(n)->children[c] = child;
+		++n->num;
+		return 0;
+	}
+
+	*ref = new;
+	free(n);
+	return 0;
+}
+
+static void __art_remove_child(struct __art_node *n, unsigned char c,
+			       void **slot)
+{
+	unsigned char *keys;
+	void **children;
+	unsigned pos;
+
+	switch (n->type) {
+	case __ART_NODE4:
+	case __ART_NODE16:
+		if (n->type == __ART_NODE4) {
+			keys = __art_n4(n)->keys;
+			children = __art_n4(n)->children;
+		} else {
+			keys = __art_n16(n)->keys;
+			children = __art_n16(n)->children;
+		}
+		pos = slot - children;
+		memmove(keys + pos, keys + pos + 1, n->num - pos - 1);
+		memmove(children + pos, children + pos + 1,
+			(n->num - pos - 1) * sizeof(void*));
+		break;
+
+	case __ART_NODE48:
+		__art_n48(n)->index[c] = 0;
+		*slot = NULL;
+		break;
+
+	default:
+		*slot = NULL;
+		break;
+	}
+
+	--n->num;
+}
+
+/*
+ * 'n' at '*ref' lost its key or a child.  A node of one child and no
+ * key is merged into the child, its prefix and the byte between them
+ * prepended to the child's.  A node of one key and no child is the
+ * leaf.  Others move to a smaller node at fewer children than grew
+ * them, not to flip on insert and erase at the edge; if that fails
+ * the node just stays larger.
+ */
+static void __art_shrink(void **ref, struct __art_node *n)
+{
+	struct __art_node *new, *child;
+	unsigned i, j, c;
+	size_t plen;
+	void *p;
+
+	if (!n->num) {
+		*ref = __art_tag(n->leaf);
+		free(n);
+		return;
+	}
+
+	if (n->num == 1 && !n->leaf) {
+		p = __art_child_ge(n, 0, &c);
+		if (!__art_is_leaf(p)) {
+			child = p;
+			plen = n->prefix_len;
+			if (plen < __ART_PREFIX_MAX) {
+				n->prefix[plen++] = c;
+				memcpy(n->prefix + plen, child->prefix,
+				       __art_min(__ART_PREFIX_MAX - plen,
+						 child->prefix_len));
+			}
+			memcpy(child->prefix, n->prefix, __ART_PREFIX_MAX);
+			child->prefix_len += n->prefix_len + 1;
+		}
+		*ref = p;
+		free(n);
+		return;
+	}
+
+	switch (n->type) {
+	case __ART_NODE16:
+		if (n->num > 3 || !(new = __art_alloc(__ART_NODE4)))
+			return;
+		__art_copy_header(new, n);
+		memcpy(__art_n4(new)->keys, __art_n16(n)->keys, n->num);
+		memcpy(__art_n4(new)->children, __art_n16(n)->children,
+		       n->num * sizeof(void*));
+		break;
+
+	case __ART_NODE48:
+		if (n->num > 12 || !(new = __art_alloc(__ART_NODE16)))
+			return;
+		__art_copy_header(new, n);
+		for (i = j = 0; i < 256; ++i)
+			if (__art_n48(n)->index[i]) {
+				__art_n16(new)->keys[j] = i;
+				__art_n16(new)->children[j++] =
+					__art_n48(n)->children[
+						__art_n48(n)->index[i] - 1];
+			}
+		break;
+
+	case __ART_NODE256:
+		if (n->num > 37 || !(new = __art_alloc(__ART_NODE48)))
+			return;
+		__art_copy_header(new, n);
+		for (i = j = 0; i < 256; ++i)
+			if (__art_n256(n)->children[i]) {
+				__art_n48(new)->children[j] =
+					__art_n256(n)->children[i];
+				__art_n48(new)->index[i] = ++j;
+			}
+		break;
+
+	default:
+		return;
+	}
+
+	*ref = new;
+	free(n);
+}
+
+/*
+ * Split the prefix of 'n' at '*ref' at 'pos' where 'leaf' departs, a
+ * new node4 takes the common part and both as children.
+ */
+static int __art_split_prefix(void **ref, struct __art_node *n,
+			      struct art_leaf *leaf, size_t depth,
+			      size_t pos)
+{
+	struct __art_node *new = __art_alloc(__ART_NODE4);
+	const struct art_leaf *min;
+	unsigned char c;
+
+	if (!new)
+		return -1;
+
+	new->prefix_len = pos;
+	memcpy(new->prefix, n->prefix, __art_min(pos, __ART_PREFIX_MAX));
+
+	if (n->prefix_len <= __ART_PREFIX_MAX) {
+		c = n->prefix[pos];
+		n->prefix_len -= pos + 1;
+		memmove(n->prefix, n->prefix + pos + 1, n->prefix_len);
+	} else {
+		min = __art_minimum(n);
+		c = min->key[depth + pos];
+		n->prefix_len -= pos + 1;
+		memcpy(n->prefix, min->key + depth + pos + 1,
+		       __art_min(n->prefix_len, __ART_PREFIX_MAX));
+	}
+
+	__art_add_sorted(__art_n4(new)->keys, __art_n4(new)->children,
+			 new->num++, c, n);
+	__art_add_leaf4(new, leaf, depth + pos);
+	*ref = new;
+	return 0;
+}
+
+/* a new node4 takes the common part of two keys and both as children */
+static int __art_split_leaf(void **ref, struct art_leaf *old,
+			    struct art_leaf *leaf, size_t depth)
+{
+	size_t max = __art_min(old->len, leaf->len), i;
+	struct __art_node *new;
+
+	if (__art_leaf_match(old, leaf->key, leaf->len)) {
+		errno = EEXIST;
+		return -1;
+	}
+
+	if (!(new = __art_alloc(__ART_NODE4)))
+		return -1;
+
+	for (i = depth; i < max && old->key[i] == leaf->key[i]; ++i)
+		;
+	new->prefix_len = i - depth;
+	memcpy(new->prefix, leaf->key + depth,
+	       __art_min(i - depth, __ART_PREFIX_MAX));
+
+	__art_add_leaf4(new, old, i);
+	__art_add_leaf4(new, leaf, i);
+	*ref = new;
+	return 0;
+}
+
+static int __art_insert(void **ref, struct art_leaf *leaf)
+{
+	const unsigned char *key = leaf->key;
+	size_t len = leaf->len, depth = 0, pos;
+	struct __art_node *n;
+	void **slot;
+
+	for (;;) {
+		if (!*ref) {
+			*ref = __art_tag(leaf);
+			return 0;
+		}
+
+		if (__art_is_leaf(*ref))
+			return __art_split_leaf(ref, __art_leaf(*ref), leaf,
+						depth);
+
+		n = *ref;
+		if (n->prefix_len) {
+			pos = __art_prefix_mismatch(n, key, len, depth);
+			if (pos < n->prefix_len)
+				return __art_split_prefix(ref, n, leaf, depth,
+							  pos);
+			depth += n->prefix_len;
+		}
+
+		if (depth == len) {
+			if (n->leaf) {
+				errno = EEXIST;
+				return -1;
+			}
+			n->leaf = leaf;
+			return 0;
+		}
+
+		if (!(slot = __art_find_child(n, key[depth])))
+			return __art_add_child(ref, n, key[depth],
+					       __art_tag(leaf));
+
+		ref = slot;
+		++depth;
+	}
+}
+
+int art_insert(struct art_root *art, struct art_leaf *leaf)
+{
+	if (__art_insert(&art->node, leaf))
+		return -1;
+
+	++art->count;
+	return 0;
+}
+
+struct art_leaf *art_erase(struct art_root *art, const void *key,
+			   size_t len)
+{
+	const unsigned char *k = key;
+	void **ref = &art->node, **slot;
+	struct art_leaf *leaf;
+	struct __art_node *n;
+	size_t depth = 0;
+
+	if (!*ref)
+		return NULL;
+
+	for (;;) {
+		/* a leaf is met here only at the root */
+		if (__art_is_leaf(*ref)) {
+			leaf = __art_leaf(*ref);
+			if (!__art_leaf_match(leaf, k, len))
+				return NULL;
+			*ref = NULL;
+			break;
+		}
+
+		n = *ref;
+		if (__art_check_prefix(n, k, len, depth) !=
+		    __art_min(n->prefix_len, __ART_PREFIX_MAX))
+			return NULL;
+		if ((depth += n->prefix_len) > len)
+			return NULL;
+
+		if (depth == len) {
+			leaf = n->leaf;
+			if (!leaf || !__art_leaf_match(leaf, k, len))
+				return NULL;
+			n->leaf = NULL;
+			__art_shrink(ref, n);
+			break;
+		}
+
+		if (!(slot = __art_find_child(n, k[depth])))
+			return NULL;
+
+		if (__art_is_leaf(*slot)) {
+			leaf = __art_leaf(*slot);
+			if (!__art_leaf_match(leaf, k, len))
+				return NULL;
+			__art_remove_child(n, k[depth], slot);
+			__art_shrink(ref, n);
+			break;
+		}
+
+		ref = slot;
+		++depth;
+	}
+
+	--art->count;
+	return leaf;
+}
+
+struct art_leaf *art_find(const struct art_root *art, const void *key,
+			  size_t len)
+{
+	const unsigned char *k = key;
+	const void *p = art->node;
+	struct __art_node *n;
+	struct art_leaf *leaf;
+	size_t depth = 0;
+	void **slot;
+
+	while (p) {
+		if (__art_is_leaf(p)) {
+			leaf = __art_leaf(p);
+			return __art_leaf_match(leaf, k, len) ? leaf : NULL;
+		}
+
+		n = (struct __art_node*)p;
+		if (n->prefix_len) {
+			if (__art_check_prefix(n, k, len, depth) !=
+			    __art_min(n->prefix_len, __ART_PREFIX_MAX))
+				return NULL;
+			if ((depth += n->prefix_len) > len)
+				return NULL;
+		}
+
+		/* the bytes skipped past the stored prefix are checked here */
+		if (depth == len) {
+			leaf = n->leaf;
+			return leaf && __art_leaf_match(leaf, k, len) ?
+				leaf : NULL;
+		}
+
+		if (!(slot = __art_find_child(n, k[depth])))
+			return NULL;
+		p = *slot;
+		++depth;
+	}
+
+	return NULL;
+}
+
+/*
+ * Descend by 'key' keeping the subtree of the least keys greater than
+ * the path so far, it has the bound if the path leaves the tree.
+ */
+static struct art_leaf *__art_bound(const struct art_root *art,
+				    const unsigned char *key, size_t len,
+				    bool upper)
+{
+	const void *p = art->node, *next = NULL, *child;
+	const struct art_leaf *min = NULL;
+	const struct __art_node *n;
+	struct art_leaf *leaf;
+	size_t depth = 0, i;
+	unsigned c;
+	void **slot;
+	int cmp;
+
+	while (p) {
+		if (__art_is_leaf(p)) {
+			leaf = __art_leaf(p);
+			cmp = __art_leaf_cmp(leaf, key, len);
+			if (cmp > 0 || (!upper && !cmp))
+				return leaf;
+			break;
+		}
+
+		n = p;
+		for (i = 0; i < n->prefix_len; ++i) {
+			if (i < __ART_PREFIX_MAX) {
+				c = n->prefix[i];
+			} else {
+				if (!min)
+					min = __art_minimum(n);
+				c = min->key[depth + i];
+			}
+			if (depth + i == len || key[depth + i] < c)
+				return __art_minimum(n);
+			if (key[depth + i] > c)
+				goto out;
+		}
+		depth += n->prefix_len;
+		min = NULL;
+
+		if (depth == len) {
+			if (n->leaf && !upper)
+				return n->leaf;
+			next = __art_child_ge(n, 0, &c);
+			break;
+		}
+
+		if (key[depth] < 255 &&
+		    (child = __art_child_ge(n, key[depth] + 1u, &c)))
+			next = child;
+
+		if (!(slot = __art_find_child((struct __art_node*)n,
+					      key[depth])))
+			break;
+		p = *slot;
+		++depth;
+	}
+
+out:
+	return next ? __art_minimum(next) : NULL;
+}
+
+struct art_leaf *art_lower_bound(const struct art_root *art,
+				 const void *key, size_t len)
+{
+	return __art_bound(art, key, len, false);
+}
+
+struct art_leaf *art_upper_bound(const struct art_root *art,
+				 const void *key, size_t len)
+{
+	return __art_bound(art, key, len, true);
+}
+
+struct art_leaf *art_first(const struct art_root *art)
+{
+	return art->node ? __art_minimum(art->node) : NULL;
+}
+
+struct art_leaf *art_last(const struct art_root *art)
+{
+	return art->node ? __art_maximum(art->node) : NULL;
+}
+
+/*
+ * The walks are preorder and keep the path in a ring of frames, the
+ * oldest fall off on a deep tree.  When the ring runs dry on a node
+ * done, its ancestors are found again from the root by the key of the
+ * last leaf visited, which is below that node.  A chain of nested keys
+ * is as deep as the number of keys, it MUST NOT be walked recursively.
+ */
+#define __ART_WALK_DEPTH	64
+
+/* an inner node on the path, 'depth' past its prefix, 'next' byte */
+struct __art_frame
+{
+	const struct __art_node *node;
+	size_t depth;
+	unsigned next;
+};
+
+struct __art_walk
+{
+	const void *root;
+	const struct art_leaf *last;
+	unsigned top, cnt;
+	struct __art_frame ring[__ART_WALK_DEPTH];
+};
+
+static inline struct __art_frame *__art_walk_top(struct __art_walk *walk)
+{
+	return &walk->ring[(walk->top - 1) % __ART_WALK_DEPTH];
+}
+
+static inline void __art_walk_push(struct __art_walk *walk,
+				   const struct __art_node *n,
+				   size_t depth, unsigned next)
+{
+	struct __art_frame *f = &walk->ring[walk->top++ % __ART_WALK_DEPTH];
+
+	f->node = n;
+	f->depth = depth;
+	f->next = next;
+	if (walk->cnt < __ART_WALK_DEPTH)
+		++walk->cnt;
+}
+
+/* enter 'n' below the byte at 'depth', its own key is visited first */
+static inline void __art_walk_enter(struct __art_walk *walk,
+				    const struct __art_node *n, size_t depth)
+{
+	__art_walk_push(walk, n, depth + n->prefix_len, 0);
+	if (n->leaf)
+		walk->last = n->leaf;
+}
+
+/* push the ancestors of 'done' from the root */
+static void __art_walk_refill(struct __art_walk *walk,
+			      const struct __art_node *done)
+{
+	const unsigned char *key = walk->last->key;
+	const struct __art_node *n;
+	const void *p = walk->root;
+	size_t depth = 0;
+
+	while (p != done) {
+		n = p;
+		depth += n->prefix_len;
+		__art_walk_push(walk, n, depth, key[depth] + 1u);
+		p = *__art_find_child((struct __art_node*)n, key[depth]);
+		++depth;
+	}
+}
+
+/* the root, an inner node or a tagged leaf */
+static const void *__art_walk_first(struct __art_walk *walk,
+				    const void *root)
+{
+	walk->root = root;
+	walk->last = NULL;
+	walk->top = walk->cnt = 0;
+
+	if (root && !__art_is_leaf(root))
+		__art_walk_enter(walk, root, 0);
+
+	return root;
+}
+
+/* the next inner node or tagged leaf in preorder, NULL at the end */
+static const void *__art_walk_next(struct __art_walk *walk)
+{
+	const struct __art_node *done;
+	struct __art_frame *f;
+	const void *child;
+	unsigned c;
+
+	while (walk->cnt) {
+		f = __art_walk_top(walk);
+		if (f->next < 256 &&
+		    (child = __art_child_ge(f->node, f->next, &c))) {
+			f->next = c + 1;
+			if (__art_is_leaf(child))
+				walk->last = __art_leaf(child);
+			else
+				__art_walk_enter(walk, child, f->depth + 1);
+			return child;
+		}
+
+		done = f->node;
+		--walk->top;
+		if (!--walk->cnt && done != walk->root)
+			__art_walk_refill(walk, done);
+	}
+
+	return NULL;
+}
+
+/* the leaf of a walk step, the own key of an inner node or NULL */
+static inline struct art_leaf *__art_walk_leaf(const void *p)
+{
+	return __art_is_leaf(p) ? __art_leaf(p) :
+				  ((const struct __art_node*)p)->leaf;
+}
+
+bool art_visit_cond(const struct art_root *art,
+		    bool (*visit_cond)(const struct art_leaf *leaf,
+				       const void *arg),
+		    const void *arg)
+{
+	struct __art_walk walk;
+	struct art_leaf *leaf;
+	const void *p;
+
+	for (p = __art_walk_first(&walk, art->node); p;
+	     p = __art_walk_next(&walk))
+		if ((leaf = __art_walk_leaf(p)) && !visit_cond(leaf, arg))
+			return false;
+
+	return true;
+}
+
+void art_visit(const struct art_root *art,
+	       void (*visit)(const struct art_leaf *leaf, const void *arg),
+	       const void *arg)
+{
+	struct __art_walk walk;
+	struct art_leaf *leaf;
+	const void *p;
+
+	for (p = __art_walk_first(&walk, art->node); p;
+	     p = __art_walk_next(&walk))
+		if ((leaf = __art_walk_leaf(p)))
+			visit(leaf, arg);
+}
+
+/*
+ * The leaves may go with their keys, so clear can not find a path
+ * again.  A node is not searched any more once entered, its own key is
+ * destroyed first and 'leaf' links the parent, 'prefix_len' the next
+ * byte.
+ */
+void art_clear(struct art_root *art,
+	       void (*destroy)(struct art_leaf *leaf, const void *arg),
+	       const void *arg)
+{
+	struct __art_node *n = NULL, *parent;
+	void *p = art->node;
+	unsigned c;
+
+	for (;;) {
+		if (p && __art_is_leaf(p)) {
+			if (destroy)
+				destroy(__art_leaf(p), arg);
+		} else if (p) {
+			parent = n;
+			n = p;
+			if (n->leaf && destroy)
+				destroy(n->leaf, arg);
+			n->leaf = (struct art_leaf*)parent;
+			n->prefix_len = 0;
+		}
+
+		if (!n)
+			break;
+
+		while (n->prefix_len > 255 ||
+		       !(p = __art_child_ge(n, n->prefix_len, &c))) {
+			parent = (struct __art_node*)n->leaf;
+			free(n);
+			if (!(n = parent))
+				goto out;
+		}
+		n->prefix_len = c + 1;
+	}
+
+out:
+	ART_INIT(*art);
+}
+
+#ifndef NDEBUG
+#include <ycc/debug.h>
+/*
+ * 'n' is entered at 'depth', before its prefix.  The least key below
+ * it holds the prefix, every child's least key has the path of 'n' and
+ * the byte of the child.  So every leaf is checked by its parent.
+ */
+static bool __art_isvalid(const struct __art_node *n, size_t depth)
+{
+	static const unsigned cap[] = { 4, 16, 48, 256 };
+	const struct art_leaf *min, *cmin;
+	const void *child;
+	unsigned c, i, num;
+
+	if (n->type > __ART_NODE256 || n->num > cap[n->type] ||
+	    n->num + !!n->leaf < 2) {
+		dprintf("node of type %u with %u children%s\n", n->type,
+			n->num, n->leaf ? " and a key" : "");
+		return false;
+	}
+
+	min = __art_minimum(n);
+	if (min->len < depth + n->prefix_len ||
+	    memcmp(min->key + depth, n->prefix,
+		   __art_min(n->prefix_len, __ART_PREFIX_MAX))) {
+		dprintf("bad prefix of %u bytes at %zu\n", n->prefix_len,
+			depth);
+		return false;
+	}
+	depth += n->prefix_len;
+
+	if (n->leaf && n->leaf->len != depth) {
+		dprintf("key of %zu bytes at %zu\n", n->leaf->len, depth);
+		return false;
+	}
+
+	switch (n->type) {
+	case __ART_NODE4:
+	case __ART_NODE16:
+		for (i = 1; i < n->num; ++i) {
+			const unsigned char *keys = n->type == __ART_NODE4 ?
+				__art_n4(n)->keys : __art_n16(n)->keys;
+
+			if (keys[i - 1] >= keys[i]) {
+				dprintf("bytes out of order\n");
+				return false;
+			}
+		}
+		break;
+
+	case __ART_NODE48:
+		for (i = num = 0; i < 256; ++i) {
+			unsigned slot = __art_n48(n)->index[i];
+
+			if (!slot)
+				continue;
+			if (slot > 48 || !__art_n48(n)->children[slot - 1]) {
+				dprintf("bad index %u\n", i);
+				return false;
+			}
+			++num;
+		}
+		for (i = 0; i < 48; ++i)
+			num -= !!__art_n48(n)->children[i];
+		if (num) {
+			dprintf("index and slots disagree\n");
+			return false;
+		}
+		break;
+	}
+
+	for (num = 0, child = __art_child_ge(n, 0, &c); child;
+	     child = c < 255 ? __art_child_ge(n, c + 1, &c) : NULL) {
+		cmin = __art_minimum(child);
+		if (cmin->len <= depth || cmin->key[depth] != c ||
+		    memcmp(cmin->key, min->key, depth)) {
+			dprintf("bad child at byte %u\n", c);
+			return false;
+		}
+		++num;
+	}
+
+	if (num != n->num) {
+		dprintf("%u children of %u\n", num, n->num);
+		return false;
+	}
+
+	return true;
+}
+
+/* a node is checked before the walk goes below it */
+bool art_isvalid(const struct art_root *art)
+{
+	const struct __art_node *n;
+	struct __art_walk walk;
+	size_t count = 0;
+	const void *p;
+
+	for (p = __art_walk_first(&walk, art->node); p;
+	     p = __art_walk_next(&walk)) {
+		if (__art_is_leaf(p)) {
+			++count;
+			continue;
+		}
+		n = p;
+		if (!__art_isvalid(n, __art_walk_top(&walk)->depth -
+				      n->prefix_len))
+			return false;
+		count += !!n->leaf;
+	}
+
+	if (count != art->count) {
+		dprintf("%zu keys of %zu\n", count, art->count);
+		return false;
+	}
+
+	return true;
+}
+#endif
+
+/* eof */
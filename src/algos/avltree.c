@@ -22,139 +22,164 @@
 
 #include <ycc/algos/avltree.h>
 
-void avl_insert_rebalance(struct avl_node *node, struct avl_root *avl)
-{
-	struct avl_node *parent, *gparent;
-	struct avl_node ** const proot = &avl->node;
-
-	/* do rebalance */
-	while ((parent=node->parent) && node->depth == parent->depth) {
-		++parent->depth;
+#include "bstree-join.h"
 
-		if (!(gparent=parent->parent))
-			break;
+/*
+ * __avl_fix  --  rotate 'node' back into balance
+ *
+ * 'bal' is the balance factor 'node' would have, -2 or 2, it is passed
+ * on instead of stored since two bits cannot hold it.  Returns the new
+ * root of the subtree, '*pkeep' tells whether the subtree is as high as
+ * with 'bal' (the higher child was balanced) or one lower.
+ */
+static struct avl_node *__avl_fix(struct avl_node *node, int bal,
+				  struct avl_node **proot, bool *pkeep)
+{
+	struct avl_node *child, *grand;
+	int sub;
+
+	if (bal > 0) {
+		child = node->right;
+		sub = avl_balance(child);
+		if (sub >= 0) {
+			__BSTLINK_ROTATE_LEFT(node, proot);
+			avl_set_balance(node, 1 - sub);
+			avl_set_balance(child, sub - 1);
+			*pkeep = !sub;
+			return child;
+		}
 
-		if (parent == gparent->left) {
-			register struct avl_node *uncle = gparent->right;
+		grand = child->left;
+		__BSTLINK_ROTATE_RIGHT(child, proot);
+		__BSTLINK_ROTATE_LEFT(node, proot);
+	} else {
+		child = node->left;
+		sub = avl_balance(child);
+		if (sub <= 0) {
+			__BSTLINK_ROTATE_RIGHT(node, proot);
+			avl_set_balance(node, -1 - sub);
+			avl_set_balance(child, sub + 1);
+			*pkeep = !sub;
+			return child;
+		}
 
-			if ((uncle && parent->depth - uncle->depth > 1) ||
-			    !uncle) {
-				if (node == parent->right) {
-					++node->depth;
-					--parent->depth;
-					__BSTLINK_ROTATE_LEFT(parent, proot);
-				}
+		grand = child->right;
+		__BSTLINK_ROTATE_LEFT(child, proot);
+		__BSTLINK_ROTATE_RIGHT(node, proot);
+	}
 
-				--gparent->depth;
-				__BSTLINK_ROTATE_RIGHT(gparent, proot);
-			}
-			else
-				node = parent;
-		} else {
-			register struct avl_node *uncle = gparent->left;
-
-			if ((uncle && parent->depth - uncle->depth > 1) ||
-			    !uncle) {
-				if (node == parent->left) {
-					++node->depth;
-					--parent->depth;
-					__BSTLINK_ROTATE_RIGHT(parent, proot);
-				}
-
-				--gparent->depth;
-				__BSTLINK_ROTATE_LEFT(gparent, proot);
-			}
-			else
-				node = parent;
-		}
+	/* double rotation, 'grand' takes both over */
+	sub = avl_balance(grand);
+	if (bal > 0) {
+		avl_set_balance(node, sub > 0 ? -1 : 0);
+		avl_set_balance(child, sub < 0 ? 1 : 0);
+	} else {
+		avl_set_balance(node, sub < 0 ? 1 : 0);
+		avl_set_balance(child, sub > 0 ? -1 : 0);
 	}
+	avl_set_balance(grand, 0);
+	*pkeep = false;
+
+	return grand;
 }
 
-static inline void
-__avl_erase_rebalance(struct avl_node *node,
-		      struct avl_node *parent,
-		      struct avl_node **proot)
+/*
+ * The subtree 'node' grew one higher, retrace up to the root.  Returns
+ * true if the whole tree grew.
+ */
+static bool __avl_grow(struct avl_node *node, struct avl_node **proot)
 {
-	struct avl_node *other;
+	struct avl_node *parent;
+	bool keep;
 
-	/* empty tree */
-	assert(parent);
+	while ((parent = avl_parent(node))) {
+		int bal = avl_balance(parent) +
+			  (node == parent->right ? 1 : -1);
 
-	while (node != *proot) {
-		unsigned depth = node ? node->depth : 1;
-
-		if (depth + 1 == parent->depth)
-			return;
+		if (!bal) {
+			avl_set_balance(parent, 0);
+			return false;
+		}
 
-		if (parent->left == node) {
-			other = parent->right;
+		if (bal == 1 || bal == -1) {
+			avl_set_balance(parent, bal);
+			node = parent;
+			continue;
+		}
 
-			if (other->depth + 1 != parent->depth) {
-				--parent->depth;
-				goto down;
-			}
+		/*
+		 * After an insert the higher child is never balanced, the
+		 * rotation restores the old height.  A join may hang a
+		 * balanced subtree, then the rotated one is still higher.
+		 */
+		node = __avl_fix(parent, bal, proot, &keep);
+		if (!keep)
+			return false;
+	}
 
-			if (other->depth == depth + 1)
-				return;
+	return true;
+}
 
-			if (other->left &&
-			    (!other->right ||
-			     other->left->depth > other->right->depth)) {
-				++other->left->depth;
-				--other->depth;
-				__BSTLINK_ROTATE_RIGHT(other, proot);
-				other = other->parent;
-			}
-
-			if (other->left && other->left->depth > depth) {
-				--parent->depth;
-				++other->depth;
-			} else
-				parent->depth -= 2;
-
-			__BSTLINK_ROTATE_LEFT(parent, proot);
-			parent = other;
-		} else {
-			other = parent->left;
+void avl_insert_rebalance(struct avl_node *node, struct avl_root *avl)
+{
+	__avl_grow(node, &avl->node);
+}
 
-			if (other->depth + 1 != parent->depth) {
-				--parent->depth;
-				goto down;
-			}
+/* a subtree of 'parent', left or right, shrank one lower */
+static void __avl_shrink(struct avl_node *parent, bool left,
+			 struct avl_node **proot)
+{
+	struct avl_node *node;
+	bool keep;
 
-			if (other->depth == depth + 1)
-				return;
+	for (;;) {
+		int bal = avl_balance(parent) + (left ? 1 : -1);
 
-			if (other->right &&
-			    (!other->left ||
-			     other->right->depth > other->left->depth)) {
-					++other->right->depth;
-					--other->depth;
-					__BSTLINK_ROTATE_LEFT(other, proot);
-					other = other->parent;
-			}
-
-			if (other->right && other->right->depth > depth) {
-				--parent->depth;
-				++other->depth;
-			} else
-				parent->depth -= 2;
-
-			__BSTLINK_ROTATE_RIGHT(parent, proot);
-			parent = other;
+		if (bal == 1 || bal == -1) {
+			avl_set_balance(parent, bal);
+			return;
 		}
 
-		down:
+		if (!bal) {
+			avl_set_balance(parent, 0);
 			node = parent;
-			parent = parent->parent;
+		} else {
+			node = __avl_fix(parent, bal, proot, &keep);
+			if (keep)
+				return;
+		}
+
+		if (!(parent = avl_parent(node)))
+			return;
+		left = node == parent->left;
 	}
 }
 
+static inline void
+__avl_erase_rebalance(struct avl_node *node,
+		      struct avl_node *parent,
+		      struct avl_node **proot)
+{
+	struct avl_node *gparent;
+
+	/* parent lost its only child, node's side is ambiguous */
+	if (!parent->left && !parent->right) {
+		avl_set_balance(parent, 0);
+		if ((gparent = avl_parent(parent)))
+			__avl_shrink(gparent, parent == gparent->left, proot);
+		return;
+	}
+
+	__avl_shrink(parent, node ? node == parent->left : !parent->left,
+		     proot);
+}
+
 /* erase specialized */
 #define __BSTLINK_TYPE struct avl_node
 #define __BSTLINK_ERASE_SPECIALIZE_BOTH(node, scor)		\
-	avl_set_depth(scor, avl_depth(node))
-#define __BSTLINK_ERASE_SPECIALIZE_DO(child, parent, proot)	\
+	avl_set_balance(scor, avl_balance(node))
+#define __BSTLINK_ERASE_SPECIALIZE_DO(child, parent, proot,		\
+				      augment, once)			\
 	if (parent)						\
 		__avl_erase_rebalance(child, parent, proot);
 
@@ -164,70 +189,424 @@ void avl_erase(struct avl_node *node, struct avl_root *avl)
 	__BSTLINK_ERASE(node, &avl->node);
 }
 
-#ifndef NDEBUG
-#include <ycc/debug.h>
-static bool __avl_isvalid(struct avl_node *root)
+/* follow the higher child down, O(log n) */
+static unsigned __avl_height(const struct avl_node *node)
 {
-	size_t droot, dleft, dright, dmax = 0;
+	unsigned height = 0;
 
-	if (!root)
-		return true;
+	for (; node; ++height)
+		node = avl_balance(node) > 0 ? node->right : node->left;
 
-	droot = root->depth;
+	return height;
+}
 
-	if (!root->left && !root->right) {
-		if (droot != 1) {
-			dprintf("droot = %u\n", droot);
-			return false;
-		}
-		return true;
+/* the heights of the children of 'node' of height 'h' */
+static inline unsigned __avl_height_left(const struct avl_node *node,
+					 unsigned h)
+{
+	return h - (avl_balance(node) > 0 ? 2 : 1);
+}
+
+static inline unsigned __avl_height_right(const struct avl_node *node,
+					  unsigned h)
+{
+	return h - (avl_balance(node) < 0 ? 2 : 1);
+}
+
+/*
+ * __avl_join  --  join 'left', 'pivot' and 'right'
+ *
+ * 'left' and 'right' are detached subtrees (parent is NULL) of heights
+ * 'hl' and 'hr'.  It costs O(|hl - hr| + 1), the height of the result
+ * is in '*ph'.
+ */
+static struct avl_node *__avl_join(struct avl_node *left, unsigned hl,
+				   struct avl_node *pivot,
+				   struct avl_node *right, unsigned hr,
+				   unsigned *ph)
+{
+	struct avl_node *root, *parent, *child;
+	unsigned h;
+
+	if (hl <= hr + 1 && hr <= hl + 1) {
+		avl_set_parent(pivot, NULL);
+		pivot->left = left;
+		pivot->right = right;
+		if (left)
+			avl_set_parent(left, pivot);
+		if (right)
+			avl_set_parent(right, pivot);
+		avl_set_balance(pivot, (int)hr - (int)hl);
+		__BSTLINK_SIZE_FIXUP(pivot);
+		*ph = (hl > hr ? hl : hr) + 1;
+		return pivot;
 	}
 
-	if (!root->left) {
-		dright = root->right->depth;
-		if (dright != 1 || droot != 2) {
-			dprintf("droot = %u, dright = %u\n", droot, dright);
-			return false;
-		}
+	/*
+	 * Walk down the right spine of the higher 'left' (or the left
+	 * spine of the higher 'right') to a subtree at most one higher
+	 * than the lower tree, and hang 'pivot' there.  The balance
+	 * factors tell the height of every subtree passed.
+	 */
+	if (hl > hr) {
+		root = child = left;
+		h = hl;
+		do {
+			h = __avl_height_right(child, h);
+			parent = child;
+			child = child->right;
+		} while (h > hr + 1);
+		pivot->left = child;
+		pivot->right = right;
+		parent->right = pivot;
+		if (right)
+			avl_set_parent(right, pivot);
+		avl_set_balance(pivot, (int)hr - (int)h);
+	} else {
+		root = child = right;
+		h = hr;
+		do {
+			h = __avl_height_left(child, h);
+			parent = child;
+			child = child->left;
+		} while (h > hl + 1);
+		pivot->left = left;
+		pivot->right = child;
+		parent->left = pivot;
+		if (left)
+			avl_set_parent(left, pivot);
+		avl_set_balance(pivot, (int)h - (int)hl);
+	}
+
+	if (child)
+		avl_set_parent(child, pivot);
+	avl_set_parent(pivot, parent);
+	__BSTLINK_SIZE_FIXUP(pivot);
 
-		return __avl_isvalid(root->right);
+	/* 'pivot' is one higher than the subtree it replaced */
+	*ph = (hl > hr ? hl : hr) + __avl_grow(pivot, &root);
+
+	return root;
+}
+
+/* split the detached subtree 'node' of height 'h' into '< arg', '>= arg' */
+static void __avl_split(struct avl_node *node, unsigned h,
+			bstlink_compare_t compare, const void *arg,
+			struct avl_node **pleft, unsigned *phl,
+			struct avl_node **pright, unsigned *phr)
+{
+	struct avl_node *left, *right, *sub;
+	unsigned hcl, hcr, hs;
+
+	if (!node) {
+		*pleft = *pright = NULL;
+		*phl = *phr = 0;
+		return;
 	}
 
-	if (!root->right) {
-		dleft = root->left->depth;
-		if (dleft != 1 || droot != 2) {
-			dprintf("droot = %u, dleft = %u\n", dleft, dleft);
-			return false;
-		}
+	left = node->left;
+	right = node->right;
+	if (left)
+		avl_set_parent(left, NULL);
+	if (right)
+		avl_set_parent(right, NULL);
+
+	/* read before the join below resets the balance of 'node' */
+	hcl = __avl_height_left(node, h);
+	hcr = __avl_height_right(node, h);
+
+	if (compare((struct bst_link*)node, arg) < 0) {
+		__avl_split(right, hcr, compare, arg, &sub, &hs, pright, phr);
+		*pleft = __avl_join(left, hcl, node, sub, hs, phl);
+	} else {
+		__avl_split(left, hcl, compare, arg, pleft, phl, &sub, &hs);
+		*pright = __avl_join(sub, hs, node, right, hcr, phr);
+	}
+}
+
+void avl_split(struct avl_root *avl,
+	       int (*compare)(const struct avl_node *node, const void *arg),
+	       const void *arg,
+	       struct avl_root *left,
+	       struct avl_root *right)
+{
+	struct avl_node *node = avl->node, *l, *r;
+	unsigned hl, hr;
+
+	avl->node = NULL;
+	__avl_split(node, __avl_height(node), (bstlink_compare_t)compare,
+		    arg, &l, &hl, &r, &hr);
+	left->node = l;
+	right->node = r;
+}
+
+void avl_join(struct avl_root *avl,
+	      struct avl_root *left,
+	      struct avl_node *pivot,
+	      struct avl_root *right)
+{
+	struct avl_node *l = left->node, *r = right->node;
+	unsigned h;
+
+	left->node = right->node = NULL;
+	avl->node = __avl_join(l, __avl_height(l), pivot, r, __avl_height(r),
+			       &h);
+}
 
-		return __avl_isvalid(root->left);
+static struct avl_node *__avl_concat(struct avl_node *left, unsigned hl,
+				     struct avl_node *right, unsigned hr,
+				     unsigned *ph)
+{
+	struct avl_root tmp = { right };
+	struct avl_node *pivot;
+
+	if (!left || !right) {
+		*ph = left ? hl : hr;
+		return left ? left : right;
 	}
 
-	dleft = root->left->depth;
-	dright = root->right->depth;
+	/* the first node of 'right' becomes the pivot, the erase is O(log n) */
+	pivot = avl_first(&tmp);
+	avl_erase(pivot, &tmp);
 
-	if (dleft > dright)
-		dmax = dleft;
-	else
-		dmax = dright;
+	return __avl_join(left, hl, pivot, tmp.node, __avl_height(tmp.node),
+			  ph);
+}
 
-	if (dmax - dleft > 1 || dmax - dright > 1) {
-		dprintf("dleft = %u, dright = %u\n", dleft, dright);
-		return false;
+void avl_concat(struct avl_root *avl,
+		struct avl_root *left,
+		struct avl_root *right)
+{
+	struct avl_node *l = left->node, *r = right->node;
+	unsigned h;
+
+	left->node = right->node = NULL;
+	avl->node = __avl_concat(l, __avl_height(l), r, __avl_height(r), &h);
+}
+
+/* join ops, see bstree-join.h, 'aux' is the height */
+static struct __bst_tree __avl_tree_make(struct bst_link *link)
+{
+	struct __bst_tree tree = { link, __avl_height((void*)link) };
+
+	return tree;
+}
+
+static void __avl_tree_expose(struct __bst_tree tree,
+			      struct __bst_tree *left,
+			      struct __bst_tree *right)
+{
+	struct bst_link *link = tree.link;
+
+	left->link = link->left;
+	right->link = link->right;
+	left->aux = __avl_height_left((struct avl_node*)link, tree.aux);
+	right->aux = __avl_height_right((struct avl_node*)link, tree.aux);
+
+	if (link->left)
+		bstlink_set_parent(link->left, NULL);
+	if (link->right)
+		bstlink_set_parent(link->right, NULL);
+}
+
+static void __avl_tree_split(struct __bst_tree tree,
+			     bstlink_compare_t compare,
+			     const void *arg,
+			     struct __bst_tree *left,
+			     struct __bst_tree *right)
+{
+	struct avl_node *l, *r;
+	unsigned hl, hr;
+
+	__avl_split((struct avl_node*)tree.link, tree.aux, compare, arg,
+		    &l, &hl, &r, &hr);
+	left->link = (struct bst_link*)l;
+	left->aux = hl;
+	right->link = (struct bst_link*)r;
+	right->aux = hr;
+}
+
+static struct __bst_tree __avl_tree_join(struct __bst_tree left,
+					 struct bst_link *pivot,
+					 struct __bst_tree right)
+{
+	struct __bst_tree tree;
+	unsigned h;
+
+	tree.link = (struct bst_link*)
+		    __avl_join((struct avl_node*)left.link, left.aux,
+			       (struct avl_node*)pivot,
+			       (struct avl_node*)right.link, right.aux, &h);
+	tree.aux = h;
+
+	return tree;
+}
+
+static struct __bst_tree __avl_tree_concat(struct __bst_tree left,
+					   struct __bst_tree right)
+{
+	struct __bst_tree tree;
+	unsigned h;
+
+	tree.link = (struct bst_link*)
+		    __avl_concat((struct avl_node*)left.link, left.aux,
+				 (struct avl_node*)right.link, right.aux, &h);
+	tree.aux = h;
+
+	return tree;
+}
+
+const struct __bst_join_ops __avl_join_ops = {
+	.make	= __avl_tree_make,
+	.expose	= __avl_tree_expose,
+	.split	= __avl_tree_split,
+	.join	= __avl_tree_join,
+	.concat	= __avl_tree_concat,
+};
+
+static void
+__avl_setop(enum __bst_setop op,
+	    struct avl_root *avl,
+	    struct avl_root *avl1,
+	    struct avl_root *avl2,
+	    int (*compare_link)(const struct avl_node *node1,
+			       const struct avl_node *node2,
+			       const void *arg),
+	    void (*destroy)(struct avl_node *node, const void *arg),
+	    const void *arg_compare,
+	    const void *arg_destroy,
+	    unsigned nthreads)
+{
+	struct bst_link *link1 = (struct bst_link*)avl1->node;
+	struct bst_link *link2 = (struct bst_link*)avl2->node;
+
+	avl1->node = avl2->node = NULL;
+	avl->node = (struct avl_node*)
+		   __bst_setop(&__avl_join_ops, op, link1, link2,
+			       (bstlink_compare_link_t)compare_link,
+			       (bstlink_destroy_t)destroy,
+			       arg_compare, arg_destroy, nthreads);
+}
+
+void avl_union(struct avl_root *avl,
+	       struct avl_root *avl1,
+	       struct avl_root *avl2,
+	       int (*compare_link)(const struct avl_node *node1,
+				   const struct avl_node *node2,
+				   const void *arg),
+	       void (*destroy)(struct avl_node *node, const void *arg),
+	       const void *arg_compare,
+	       const void *arg_destroy,
+	       unsigned nthreads)
+{
+	__avl_setop(__BST_SETOP_UNION, avl, avl1, avl2, compare_link,
+		    destroy, arg_compare, arg_destroy, nthreads);
+}
+
+void avl_intersection(struct avl_root *avl,
+		      struct avl_root *avl1,
+		      struct avl_root *avl2,
+		      int (*compare_link)(const struct avl_node *node1,
+					  const struct avl_node *node2,
+					  const void *arg),
+		      void (*destroy)(struct avl_node *node, const void *arg),
+		      const void *arg_compare,
+		      const void *arg_destroy,
+		      unsigned nthreads)
+{
+	__avl_setop(__BST_SETOP_INTERSECTION, avl, avl1, avl2, compare_link,
+		    destroy, arg_compare, arg_destroy, nthreads);
+}
+
+void avl_difference(struct avl_root *avl,
+		    struct avl_root *avl1,
+		    struct avl_root *avl2,
+		    int (*compare_link)(const struct avl_node *node1,
+					const struct avl_node *node2,
+					const void *arg),
+		    void (*destroy)(struct avl_node *node, const void *arg),
+		    const void *arg_compare,
+		    const void *arg_destroy,
+		    unsigned nthreads)
+{
+	__avl_setop(__BST_SETOP_DIFFERENCE, avl, avl1, avl2, compare_link,
+		    destroy, arg_compare, arg_destroy, nthreads);
+}
+
+/*
+ * The left half is never the smaller one, it is 'height' - 1 high.  The
+ * builds go in post-order, the one before 'node' is its right child if
+ * any, '*arg' keeps its height.
+ */
+static void __avl_build(struct avl_node *node,
+			size_t depth,
+			size_t height,
+			const void *arg)
+{
+	size_t *last = (size_t*)arg;
+	size_t hright = node->right ? *last : 0;
+
+	avl_set_balance(node, (int)hright - (int)(height - 1));
+	*last = height;
+}
+
+void avl_build_sorted(struct avl_root *avl,
+		      struct avl_node **nodes,
+		      size_t num)
+{
+	size_t last = 0;
+
+	avl->node = __BSTLINK_BUILD_SORTED(nodes, num, __avl_build, &last,
+					   struct avl_node);
+}
+
+#ifndef NDEBUG
+#include <ycc/debug.h>
+/* returns the height of 'root', or -1 if invalid */
+static int __avl_isvalid(const struct avl_node *root)
+{
+	int hleft, hright;
+
+	if (!root)
+		return 0;
+
+#ifdef	BSTLINK_SIZE
+	if (root->size != bstlink_size((struct bst_link*)root->left) +
+			  bstlink_size((struct bst_link*)root->right) + 1) {
+		dprintf("bad subtree size %zu\n", root->size);
+		return -1;
 	}
+#endif
 
-	if (droot != dmax + 1) {
-		dprintf("droot = %u, dleft = %u, dright = %u\n",
-			droot, dleft, dright);
-		return false;
+	if ((root->left && avl_parent(root->left) != root) ||
+	    (root->right && avl_parent(root->right) != root)) {
+		dprintf("bad parent link\n");
+		return -1;
 	}
 
-	return __avl_isvalid(root->left) && __avl_isvalid(root->right);
+	hleft = __avl_isvalid(root->left);
+	hright = __avl_isvalid(root->right);
+	if (hleft < 0 || hright < 0)
+		return -1;
+
+	if (hright - hleft != avl_balance(root) ||
+	    hright - hleft > 1 || hleft - hright > 1) {
+		dprintf("balance = %d, hleft = %d, hright = %d\n",
+			avl_balance(root), hleft, hright);
+		return -1;
+	}
+
+	return (hleft > hright ? hleft : hright) + 1;
 }
 
 bool avl_isvalid(struct avl_root *avl)
 {
-	return __avl_isvalid(avl->node);
+	if (avl->node && avl_parent(avl->node)) {
+		dprintf("root has a parent\n");
+		return false;
+	}
+
+	return __avl_isvalid(avl->node) >= 0;
 }
 #endif
 
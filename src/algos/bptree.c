@@ -0,0 +1,671 @@
+/*
+ * bptree.c -- B+ Trees
+ *
+ * Copyright (C) 2012-2013 yanyg (cppgp@qq.com)
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING, if not see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <ycc/algos/bptree.h>
+
+#define __BPT_LEAF_MIN	(BPT_LEAF_ORDER / 2)
+#define __BPT_INNER_MIN	(BPT_INNER_ORDER / 2)
+
+/* an insert allocates at most one node per level plus a new root */
+#define __BPT_MAX_HEIGHT	48
+
+#define __bpt_leaf(node)	((struct bpt_leaf*)(node))
+#define __bpt_inner(node)	((struct bpt_inner*)(node))
+
+/*
+ * In-node search: count the keys less (not greater) than 'key'.  The
+ * keys are sorted so the count is the position, no branch depends on
+ * the keys and compilers turn the loop into vector compares.
+ */
+static inline unsigned __bpt_count_less(const unsigned long *keys,
+					unsigned num, unsigned long key)
+{
+	unsigned i, n = 0;
+
+	for (i = 0; i < num; ++i)
+		n += keys[i] < key;
+
+	return n;
+}
+
+static inline unsigned __bpt_count_not_greater(const unsigned long *keys,
+					       unsigned num,
+					       unsigned long key)
+{
+	unsigned i, n = 0;
+
+	for (i = 0; i < num; ++i)
+		n += keys[i] <= key;
+
+	return n;
+}
+
+static void *__bpt_alloc(size_t size)
+{
+	void *p;
+	int err = posix_memalign(&p, BPT_CACHE_LINE, size);
+
+	if (err) {
+		errno = err;
+		return NULL;
+	}
+
+	return p;
+}
+
+/* descend to the leaf of the first key >= 'key', or > 'key' if 'upper' */
+static struct bpt_leaf *__bpt_descend(const struct bpt_node *node,
+				      unsigned long key, bool upper)
+{
+	while (!node->leaf) {
+		const struct bpt_inner *inner = __bpt_inner(node);
+		unsigned i = upper ?
+			__bpt_count_not_greater(inner->keys, node->num, key) :
+			__bpt_count_less(inner->keys, node->num, key);
+
+		node = inner->children[i];
+	}
+
+	return __bpt_leaf(node);
+}
+
+/* the separators are not strict, a bound may be the next leaf's first */
+static bool __bpt_bound(const struct bpt_root *bpt, unsigned long key,
+			bool upper, struct bpt_iter *iter)
+{
+	struct bpt_leaf *leaf;
+	unsigned pos;
+
+	if (!bpt->node) {
+		iter->leaf = NULL;
+		iter->pos = 0;
+		return false;
+	}
+
+	leaf = __bpt_descend(bpt->node, key, upper);
+	pos = upper ? __bpt_count_not_greater(leaf->keys, leaf->node.num, key) :
+		      __bpt_count_less(leaf->keys, leaf->node.num, key);
+	if (pos == leaf->node.num) {
+		leaf = leaf->next;
+		pos = 0;
+	}
+
+	iter->leaf = leaf;
+	iter->pos = pos;
+	return leaf != NULL;
+}
+
+bool bpt_lower_bound(const struct bpt_root *bpt, unsigned long key,
+		     struct bpt_iter *iter)
+{
+	return __bpt_bound(bpt, key, false, iter);
+}
+
+bool bpt_upper_bound(const struct bpt_root *bpt, unsigned long key,
+		     struct bpt_iter *iter)
+{
+	return __bpt_bound(bpt, key, true, iter);
+}
+
+bool bpt_find(const struct bpt_root *bpt, unsigned long key,
+	      struct bpt_iter *iter)
+{
+	if (__bpt_bound(bpt, key, false, iter) && bpt_iter_key(iter) == key)
+		return true;
+
+	iter->leaf = NULL;
+	iter->pos = 0;
+	return false;
+}
+
+static unsigned __bpt_child_index(const struct bpt_inner *parent,
+				  const struct bpt_node *child)
+{
+	unsigned i = 0;
+
+	while (parent->children[i] != child)
+		++i;
+
+	return i;
+}
+
+static void __bpt_leaf_put(struct bpt_leaf *leaf, unsigned pos,
+			   unsigned long key, void *value)
+{
+	unsigned num = leaf->node.num;
+
+	memmove(leaf->keys + pos + 1, leaf->keys + pos,
+		(num - pos) * sizeof(leaf->keys[0]));
+	memmove(leaf->values + pos + 1, leaf->values + pos,
+		(num - pos) * sizeof(leaf->values[0]));
+	leaf->keys[pos] = key;
+	leaf->values[pos] = value;
+	leaf->node.num = num + 1;
+}
+
+/* hang 'right' after 'left' separated by 'key', split full parents */
+static void __bpt_insert_parent(struct bpt_root *bpt,
+				struct bpt_node *left,
+				unsigned long key,
+				struct bpt_node *right,
+				void **spare)
+{
+	unsigned long keys[BPT_INNER_ORDER + 1];
+	struct bpt_node *children[BPT_INNER_ORDER + 2];
+	struct bpt_inner *parent, *sibling;
+	unsigned i, num, m;
+
+	while ((parent = left->parent)) {
+		i = __bpt_child_index(parent, left);
+		num = parent->node.num;
+
+		if (num < BPT_INNER_ORDER) {
+			memmove(parent->keys + i + 1, parent->keys + i,
+				(num - i) * sizeof(keys[0]));
+			memmove(parent->children + i + 2,
+				parent->children + i + 1,
+				(num - i) * sizeof(children[0]));
+			parent->keys[i] = key;
+			parent->children[i + 1] = right;
+			parent->node.num = num + 1;
+			right->parent = parent;
+			return;
+		}
+
+		/* split, the middle key moves up */
+		memcpy(keys, parent->keys, i * sizeof(keys[0]));
+		keys[i] = key;
+		memcpy(keys + i + 1, parent->keys + i,
+		       (num - i) * sizeof(keys[0]));
+		memcpy(children, parent->children, (i + 1) * sizeof(children[0]));
+		children[i + 1] = right;
+		memcpy(children + i + 2, parent->children + i + 1,
+		       (num - i) * sizeof(children[0]));
+
+		m = (BPT_INNER_ORDER + 1) / 2;
+		sibling = *spare++;
+		sibling->node.leaf = 0;
+		sibling->node.num = BPT_INNER_ORDER - m;
+		memcpy(sibling->keys, keys + m + 1,
+		       (BPT_INNER_ORDER - m) * sizeof(keys[0]));
+		memcpy(sibling->children, children + m + 1,
+		       (BPT_INNER_ORDER - m + 1) * sizeof(children[0]));
+		for (i = 0; i <= sibling->node.num; ++i)
+			sibling->children[i]->parent = sibling;
+
+		parent->node.num = m;
+		memcpy(parent->keys, keys, m * sizeof(keys[0]));
+		memcpy(parent->children, children, (m + 1) * sizeof(children[0]));
+		for (i = 0; i <= m; ++i)
+			parent->children[i]->parent = parent;
+
+		sibling->node.parent = parent->node.parent;
+		left = &parent->node;
+		right = &sibling->node;
+		key = keys[m];
+	}
+
+	/* a new root */
+	parent = *spare;
+	parent->node.parent = NULL;
+	parent->node.leaf = 0;
+	parent->node.num = 1;
+	parent->keys[0] = key;
+	parent->children[0] = left;
+	parent->children[1] = right;
+	left->parent = right->parent = parent;
+	bpt->node = &parent->node;
+}
+
+/* move the upper half of the full 'leaf' to a new leaf and put 'key' */
+static void __bpt_leaf_split(struct bpt_root *bpt, struct bpt_leaf *leaf,
+			     unsigned pos, unsigned long key, void *value,
+			     void **spare)
+{
+	struct bpt_leaf *right = *spare++;
+	unsigned lnum = (BPT_LEAF_ORDER + 1) / 2, from;
+
+	/* 'lnum' keys stay with the new key in place */
+	from = pos < lnum ? lnum - 1 : lnum;
+	right->node.leaf = 1;
+	right->node.num = BPT_LEAF_ORDER - from;
+	memcpy(right->keys, leaf->keys + from,
+	       right->node.num * sizeof(leaf->keys[0]));
+	memcpy(right->values, leaf->values + from,
+	       right->node.num * sizeof(leaf->values[0]));
+	leaf->node.num = from;
+
+	if (pos < lnum)
+		__bpt_leaf_put(leaf, pos, key, value);
+	else
+		__bpt_leaf_put(right, pos - lnum, key, value);
+
+	right->prev = leaf;
+	right->next = leaf->next;
+	if (leaf->next)
+		leaf->next->prev = right;
+	else
+		bpt->last = right;
+	leaf->next = right;
+
+	right->node.parent = leaf->node.parent;
+	__bpt_insert_parent(bpt, &leaf->node, right->keys[0], &right->node,
+			    spare);
+}
+
+static int __bpt_insert(struct bpt_root *bpt, unsigned long key,
+			void *value, bool unique)
+{
+	void *spare[__BPT_MAX_HEIGHT];
+	struct bpt_leaf *leaf;
+	struct bpt_inner *parent;
+	unsigned pos, need, i;
+
+	if (!bpt->node) {
+		if (!(leaf = __bpt_alloc(sizeof(*leaf))))
+			return -1;
+
+		leaf->node.parent = NULL;
+		leaf->node.leaf = 1;
+		leaf->node.num = 0;
+		leaf->prev = leaf->next = NULL;
+		bpt->node = &leaf->node;
+		bpt->first = bpt->last = leaf;
+	}
+
+	leaf = __bpt_descend(bpt->node, key, true);
+	pos = __bpt_count_not_greater(leaf->keys, leaf->node.num, key);
+
+	if (unique &&
+	    ((pos && leaf->keys[pos - 1] == key) ||
+	     (!pos && leaf->prev &&
+	      leaf->prev->keys[leaf->prev->node.num - 1] == key))) {
+		errno = EEXIST;
+		return -1;
+	}
+
+	if (leaf->node.num < BPT_LEAF_ORDER) {
+		__bpt_leaf_put(leaf, pos, key, value);
+		++bpt->count;
+		return 0;
+	}
+
+	/* allocate up front so that a failure leaves the tree intact */
+	need = 2;
+	for (parent = leaf->node.parent;
+	     parent && parent->node.num == BPT_INNER_ORDER;
+	     parent = parent->node.parent)
+		++need;
+	if (parent)
+		--need;
+
+	for (i = 0; i < need; ++i) {
+		spare[i] = __bpt_alloc(i ? sizeof(struct bpt_inner) :
+					   sizeof(struct bpt_leaf));
+		if (!spare[i]) {
+			while (i--)
+				free(spare[i]);
+			return -1;
+		}
+	}
+
+	__bpt_leaf_split(bpt, leaf, pos, key, value, spare);
+	++bpt->count;
+	return 0;
+}
+
+int bpt_insert(struct bpt_root *bpt, unsigned long key, void *value)
+{
+	return __bpt_insert(bpt, key, value, false);
+}
+
+int bpt_insert_unique(struct bpt_root *bpt, unsigned long key, void *value)
+{
+	return __bpt_insert(bpt, key, value, true);
+}
+
+/* drop key 'i' and child 'i + 1' of 'inner' */
+static void __bpt_inner_remove(struct bpt_inner *inner, unsigned i)
+{
+	unsigned num = inner->node.num;
+
+	memmove(inner->keys + i, inner->keys + i + 1,
+		(num - i - 1) * sizeof(inner->keys[0]));
+	memmove(inner->children + i + 1, inner->children + i + 2,
+		(num - i - 1) * sizeof(inner->children[0]));
+	inner->node.num = num - 1;
+}
+
+/* 'inner' lost a child, borrow from or merge with a sibling upward */
+static void __bpt_inner_rebalance(struct bpt_root *bpt,
+				  struct bpt_inner *inner)
+{
+	struct bpt_inner *parent, *left, *right;
+	unsigned i, num;
+
+	while ((parent = inner->node.parent)) {
+		if (inner->node.num >= __BPT_INNER_MIN)
+			return;
+
+		i = __bpt_child_index(parent, &inner->node);
+		num = inner->node.num;
+
+		left = i ? __bpt_inner(parent->children[i - 1]) : NULL;
+		if (left && left->node.num > __BPT_INNER_MIN) {
+			/* rotate the last child of 'left' over */
+			memmove(inner->keys + 1, inner->keys,
+				num * sizeof(inner->keys[0]));
+			memmove(inner->children + 1, inner->children,
+				(num + 1) * sizeof(inner->children[0]));
+			inner->keys[0] = parent->keys[i - 1];
+			inner->children[0] = left->children[left->node.num];
+			inner->children[0]->parent = inner;
+			inner->node.num = num + 1;
+			parent->keys[i - 1] = left->keys[--left->node.num];
+			return;
+		}
+
+		right = i < parent->node.num ?
+			__bpt_inner(parent->children[i + 1]) : NULL;
+		if (right && right->node.num > __BPT_INNER_MIN) {
+			/* rotate the first child of 'right' over */
+			inner->keys[num] = parent->keys[i];
+			inner->children[num + 1] = right->children[0];
+			inner->children[num + 1]->parent = inner;
+			inner->node.num = num + 1;
+			parent->keys[i] = right->keys[0];
+			memmove(right->keys, right->keys + 1,
+				(right->node.num - 1) * sizeof(right->keys[0]));
+			memmove(right->children, right->children + 1,
+				right->node.num * sizeof(right->children[0]));
+			--right->node.num;
+			return;
+		}
+
+		/* merge 'right' and the separator into 'left' */
+		if (left) {
+			right = inner;
+			--i;
+		} else
+			left = inner;
+
+		num = left->node.num;
+		left->keys[num] = parent->keys[i];
+		memcpy(left->keys + num + 1, right->keys,
+		       right->node.num * sizeof(right->keys[0]));
+		memcpy(left->children + num + 1, right->children,
+		       (right->node.num + 1) * sizeof(right->children[0]));
+		left->node.num = num + 1 + right->node.num;
+		for (num = 0; num <= left->node.num; ++num)
+			left->children[num]->parent = left;
+		free(right);
+
+		__bpt_inner_remove(parent, i);
+		inner = parent;
+	}
+
+	/* the root lost its last separator */
+	if (!inner->node.num) {
+		bpt->node = inner->children[0];
+		bpt->node->parent = NULL;
+		free(inner);
+	}
+}
+
+void bpt_erase(struct bpt_root *bpt, struct bpt_iter *iter)
+{
+	struct bpt_leaf *leaf = iter->leaf, *left, *right;
+	struct bpt_inner *parent = leaf->node.parent;
+	unsigned pos = iter->pos, num = leaf->node.num - 1, i;
+
+	memmove(leaf->keys + pos, leaf->keys + pos + 1,
+		(num - pos) * sizeof(leaf->keys[0]));
+	memmove(leaf->values + pos, leaf->values + pos + 1,
+		(num - pos) * sizeof(leaf->values[0]));
+	leaf->node.num = num;
+	--bpt->count;
+
+	if (!parent && !num) {
+		free(leaf);
+		BPT_INIT(*bpt);
+		iter->leaf = NULL;
+		iter->pos = 0;
+		return;
+	}
+
+	if (!parent || num >= __BPT_LEAF_MIN)
+		goto out;
+
+	i = __bpt_child_index(parent, &leaf->node);
+
+	left = i ? __bpt_leaf(parent->children[i - 1]) : NULL;
+	if (left && left->node.num > __BPT_LEAF_MIN) {
+		memmove(leaf->keys + 1, leaf->keys, num * sizeof(leaf->keys[0]));
+		memmove(leaf->values + 1, leaf->values,
+			num * sizeof(leaf->values[0]));
+		--left->node.num;
+		leaf->keys[0] = left->keys[left->node.num];
+		leaf->values[0] = left->values[left->node.num];
+		leaf->node.num = num + 1;
+		parent->keys[i - 1] = leaf->keys[0];
+		++pos;
+		goto out;
+	}
+
+	right = i < parent->node.num ?
+		__bpt_leaf(parent->children[i + 1]) : NULL;
+	if (right && right->node.num > __BPT_LEAF_MIN) {
+		leaf->keys[num] = right->keys[0];
+		leaf->values[num] = right->values[0];
+		leaf->node.num = num + 1;
+		--right->node.num;
+		memmove(right->keys, right->keys + 1,
+			right->node.num * sizeof(right->keys[0]));
+		memmove(right->values, right->values + 1,
+			right->node.num * sizeof(right->values[0]));
+		parent->keys[i] = right->keys[0];
+		goto out;
+	}
+
+	/* merge 'right' into 'left', 'iter' follows its key */
+	if (left) {
+		right = leaf;
+		pos += left->node.num;
+		leaf = left;
+		--i;
+	} else
+		left = leaf;
+
+	num = left->node.num;
+	memcpy(left->keys + num, right->keys,
+	       right->node.num * sizeof(right->keys[0]));
+	memcpy(left->values + num, right->values,
+	       right->node.num * sizeof(right->values[0]));
+	left->node.num = num + right->node.num;
+
+	left->next = right->next;
+	if (right->next)
+		right->next->prev = left;
+	else
+		bpt->last = left;
+	free(right);
+
+	__bpt_inner_remove(parent, i);
+	__bpt_inner_rebalance(bpt, parent);
+
+out:
+	if (pos == leaf->node.num) {
+		leaf = leaf->next;
+		pos = 0;
+	}
+	iter->leaf = leaf;
+	iter->pos = pos;
+}
+
+size_t bpt_erase_range(struct bpt_root *bpt,
+		       const struct bpt_iter *beg,
+		       const struct bpt_iter *end)
+{
+	struct bpt_iter iter = *beg;
+	struct bpt_leaf *leaf;
+	size_t num = 0, i;
+
+	/* count first, erasing moves the keys 'end' refers to */
+	for (leaf = beg->leaf; leaf && leaf != end->leaf; leaf = leaf->next)
+		num += leaf->node.num;
+	if (leaf)
+		num += end->pos;
+	num -= beg->pos;
+
+	for (i = 0; i < num; ++i)
+		bpt_erase(bpt, &iter);
+
+	return num;
+}
+
+static void __bpt_clear(struct bpt_node *node,
+			void (*destroy)(unsigned long key, void *value,
+					const void *arg),
+			const void *arg)
+{
+	unsigned i;
+
+	if (node->leaf) {
+		struct bpt_leaf *leaf = __bpt_leaf(node);
+
+		if (destroy)
+			for (i = 0; i < node->num; ++i)
+				destroy(leaf->keys[i], leaf->values[i], arg);
+	} else {
+		for (i = 0; i <= node->num; ++i)
+			__bpt_clear(__bpt_inner(node)->children[i],
+				    destroy, arg);
+	}
+
+	free(node);
+}
+
+void bpt_clear(struct bpt_root *bpt,
+	       void (*destroy)(unsigned long key, void *value,
+			       const void *arg),
+	       const void *arg)
+{
+	if (bpt->node)
+		__bpt_clear(bpt->node, destroy, arg);
+
+	BPT_INIT(*bpt);
+}
+
+#ifndef NDEBUG
+#include <ycc/debug.h>
+struct __bpt_check
+{
+	const struct bpt_leaf *prev;
+	size_t count;
+	int height;
+};
+
+/* keys of 'node' lie in [lo, hi], the bounds are not strict */
+static bool __bpt_isvalid(const struct bpt_node *node,
+			  const struct bpt_inner *parent,
+			  unsigned long lo, unsigned long hi,
+			  int depth, struct __bpt_check *check)
+{
+	const unsigned long *keys;
+	unsigned i, min;
+
+	if (node->parent != parent) {
+		dprintf("bad parent link\n");
+		return false;
+	}
+
+	min = node->leaf ? __BPT_LEAF_MIN : __BPT_INNER_MIN;
+	if (node->num > (node->leaf ? BPT_LEAF_ORDER : BPT_INNER_ORDER) ||
+	    node->num < (parent ? min : 1)) {
+		dprintf("bad key number %u\n", node->num);
+		return false;
+	}
+
+	keys = node->leaf ? __bpt_leaf(node)->keys : __bpt_inner(node)->keys;
+	for (i = 0; i < node->num; ++i) {
+		if (keys[i] < lo || keys[i] > hi ||
+		    (i && keys[i] < keys[i - 1])) {
+			dprintf("key %lu out of order\n", keys[i]);
+			return false;
+		}
+	}
+
+	if (node->leaf) {
+		const struct bpt_leaf *leaf = __bpt_leaf(node);
+
+		if (leaf->prev != check->prev ||
+		    (check->prev && check->prev->next != leaf)) {
+			dprintf("bad leaf links\n");
+			return false;
+		}
+		if (check->height < 0)
+			check->height = depth;
+		if (check->height != depth) {
+			dprintf("leaf depth %d, expect %d\n",
+				depth, check->height);
+			return false;
+		}
+		check->prev = leaf;
+		check->count += node->num;
+		return true;
+	}
+
+	for (i = 0; i <= node->num; ++i) {
+		if (!__bpt_isvalid(__bpt_inner(node)->children[i],
+				   __bpt_inner(node),
+				   i ? keys[i - 1] : lo,
+				   i < node->num ? keys[i] : hi,
+				   depth + 1, check))
+			return false;
+	}
+
+	return true;
+}
+
+bool bpt_isvalid(const struct bpt_root *bpt)
+{
+	struct __bpt_check check = { NULL, 0, -1 };
+
+	if (!bpt->node)
+		return !bpt->first && !bpt->last && !bpt->count;
+
+	if (!__bpt_isvalid(bpt->node, NULL, 0, (unsigned long)-1, 0, &check))
+		return false;
+
+	if (bpt->first->prev || bpt->last != check.prev ||
+	    bpt->count != check.count) {
+		dprintf("bad first, last or count\n");
+		return false;
+	}
+
+	return true;
+}
+#endif
+
+/* eof */
@@ -0,0 +1,139 @@
+/*
+ * bstree-frozen.c -- Binary-Search-Trees Frozen Search Arrays
+ *
+ * Copyright (C) 2012-2013 yanyg (cppgp@qq.com)
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING, if not see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * The keys are laid out in Eytzinger (breadth-first) order, 1 based:
+ * the children of slot k are 2k and 2k + 1.  A lookup walks k down
+ * with 'k = 2k + (keys[k] < key)', which compiles to a conditional
+ * move, and prefetches the 16 descendants four levels below, they are
+ * two cache lines since the array is aligned.  See Khuong and Morin,
+ * "Array Layouts for Comparison-Based Searching".
+ */
+
+#include <errno.h>
+#include <stdlib.h>
+
+#include <ycc/algos/bstree-link.h>
+
+#define __BSTFRZ_LINE	64
+
+/* first slot of the in-order walk of the implicit subtree 'k' */
+static size_t __bstfrz_first(size_t k, size_t num)
+{
+	while (2 * k <= num)
+		k *= 2;
+
+	return k;
+}
+
+/* in-order successor of slot 'k', 0 past the last */
+static size_t __bstfrz_next(size_t k, size_t num)
+{
+	if (2 * k + 1 <= num)
+		return __bstfrz_first(2 * k + 1, num);
+
+	while (k & 1)
+		k >>= 1;
+
+	return k >> 1;
+}
+
+int bstlink_freeze(struct bst_frozen *frz,
+		   const struct bst_link *link,
+		   bstlink_key_t key)
+{
+	const struct bst_link *p;
+	size_t num = 0, k;
+	void *keys;
+	int err;
+
+	for (p = bstlink_first(link); p; p = bstlink_next(p))
+		++num;
+
+	/* slot 0 is the 'not found' answer */
+	err = posix_memalign(&keys, __BSTFRZ_LINE,
+			     (num + 1) * sizeof(unsigned long));
+	if (err) {
+		errno = err;
+		return -1;
+	}
+
+	frz->links = malloc((num + 1) * sizeof(struct bst_link*));
+	if (!frz->links) {
+		free(keys);
+		return -1;
+	}
+
+	frz->num = num;
+	frz->keys = keys;
+	frz->keys[0] = 0;
+	frz->links[0] = NULL;
+
+	k = __bstfrz_first(1, num);
+	for (p = bstlink_first(link); p; p = bstlink_next(p)) {
+		frz->keys[k] = key(p);
+		frz->links[k] = (struct bst_link*)p;
+		k = __bstfrz_next(k, num);
+	}
+
+	return 0;
+}
+
+void bstlink_frozen_destroy(struct bst_frozen *frz)
+{
+	free(frz->keys);
+	free(frz->links);
+	frz->num = 0;
+	frz->keys = NULL;
+	frz->links = NULL;
+}
+
+/* slot of the first key >= 'key', 0 if none */
+static inline size_t __bstfrz_lower_bound(const struct bst_frozen *frz,
+					  unsigned long key)
+{
+	const unsigned long *keys = frz->keys;
+	size_t k = 1, num = frz->num;
+
+	while (k <= num) {
+		__builtin_prefetch(keys + 16 * k);
+		__builtin_prefetch(keys + 16 * k + 8);
+		k = 2 * k + (keys[k] < key);
+	}
+
+	/* undo the right turns after the last left one, and that one */
+	return k >> __builtin_ffsl((long)~k);
+}
+
+struct bst_link *bstlink_frozen_lower_bound(const struct bst_frozen *frz,
+					    unsigned long key)
+{
+	return frz->links[__bstfrz_lower_bound(frz, key)];
+}
+
+struct bst_link *bstlink_frozen_find(const struct bst_frozen *frz,
+				     unsigned long key)
+{
+	size_t k = __bstfrz_lower_bound(frz, key);
+
+	return k && frz->keys[k] == key ? frz->links[k] : NULL;
+}
+
+/* eof */
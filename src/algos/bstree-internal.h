@@ -39,11 +39,39 @@ __BEGIN_DECLS
 		_bstlink_erase						\
 		(							\
 			(struct bst_link*)(link),			\
-			(struct bst_link**)(proot)			\
+			(struct bst_link**)(proot),			\
+			NULL,						\
+			false						\
 		)
 
+#define __BSTLINK_ERASE_AUGMENT(link, proot, augment)			\
+		_bstlink_erase						\
+		(							\
+			(struct bst_link*)(link),			\
+			(struct bst_link**)(proot),			\
+			(const struct bstlink_augment*)(augment),	\
+			false						\
+		)
+
+/* links stored by __BSTLINK_STORE(.., true), see rbtree-seq.h */
+#define __BSTLINK_ERASE_ONCE(link, proot)				\
+		_bstlink_erase						\
+		(							\
+			(struct bst_link*)(link),			\
+			(struct bst_link**)(proot),			\
+			NULL,						\
+			true						\
+		)
+
+/*
+ * '__BSTLINK_ERASE_SPECIALIZE_DO' gets 'augment' and 'once' too, the
+ * rotations of the rebalance have to call it back and store alike.
+ */
 static inline void
-_bstlink_erase(struct bst_link *link, struct bst_link **proot)
+_bstlink_erase(struct bst_link *link,
+	       struct bst_link **proot,
+	       const struct bstlink_augment *augment,
+	       bool once)
 {
 	struct bst_link *child, *parent;
 #ifdef	__BSTLINK_ERASE_SPECIALIZE_DECLARE
@@ -56,19 +84,21 @@ _bstlink_erase(struct bst_link *link, struct bst_link **proot)
 		else
 			child = link->left;
 
-		parent = link->parent;
+		parent = bstlink_parent(link);
 		if (child)
-			child->parent = parent;
+			bstlink_set_parent(child, parent);
 		if (parent) {
 			if (parent->left == link)
-				parent->left = child;
+				__BSTLINK_STORE(parent->left, child, once);
 			else
-				parent->right = child;
+				__BSTLINK_STORE(parent->right, child, once);
 		} else
-			*proot = child;
+			__BSTLINK_STORE(*proot, child, once);
 #ifdef	__BSTLINK_ERASE_SPECIALIZE_SINGLE
 	__BSTLINK_ERASE_SPECIALIZE_SINGLE((__BSTLINK_TYPE*)link);
 #endif
+		if (augment && parent)
+			augment->propagate(parent, NULL);
 	} else {
 		struct bst_link *scor;	/* scor: successor */
 		
@@ -76,41 +106,56 @@ _bstlink_erase(struct bst_link *link, struct bst_link **proot)
 		while (scor->left)
 			scor = scor->left;
 
-		if (link->parent) {
-			if (link->parent->left == link)
-				link->parent->left = scor;
+		if (bstlink_parent(link)) {
+			if (bstlink_parent(link)->left == link)
+				__BSTLINK_STORE(bstlink_parent(link)->left,
+						scor, once);
 			else
-				link->parent->right = scor;
+				__BSTLINK_STORE(bstlink_parent(link)->right,
+						scor, once);
 		} else
-			*proot = scor;
+			__BSTLINK_STORE(*proot, scor, once);
 
 		child = scor->right;
-		parent = scor->parent;
+		parent = bstlink_parent(scor);
 
 		if (parent == link)
 			parent = scor;
 		else {
 			if (child)
-				child->parent = parent;
+				bstlink_set_parent(child, parent);
 
-			parent->left = child;
-			scor->right = link->right;
-			link->right->parent = scor;
+			__BSTLINK_STORE(parent->left, child, once);
+			__BSTLINK_STORE(scor->right, link->right, once);
+			bstlink_set_parent(link->right, scor);
 		}
 
-		scor->parent = link->parent;
-		scor->left = link->left;
-		link->left->parent = scor;
+		bstlink_set_parent(scor, bstlink_parent(link));
+		__BSTLINK_STORE(scor->left, link->left, once);
+		bstlink_set_parent(link->left, scor);
+#ifdef	BSTLINK_SIZE
+		scor->size = link->size;
+#endif
 #ifdef	__BSTLINK_ERASE_SPECIALIZE_BOTH
 	__BSTLINK_ERASE_SPECIALIZE_BOTH((__BSTLINK_TYPE*)link,
 					(__BSTLINK_TYPE*)scor);
 #endif
+		if (augment) {
+			augment->copy(link, scor);
+			if (parent != scor)
+				augment->propagate(parent, scor);
+			augment->propagate(scor, NULL);
+		}
 	}
 
+	/* 'parent' is where a node was really taken off */
+	bstlink_size_add(parent, (size_t)-1);
+
 #ifdef	__BSTLINK_ERASE_SPECIALIZE_DO
 	__BSTLINK_ERASE_SPECIALIZE_DO((__BSTLINK_TYPE*)child,
 				      (__BSTLINK_TYPE*)parent,
-				      (__BSTLINK_TYPE**)proot);
+				      (__BSTLINK_TYPE**)proot,
+				      augment, once);
 #endif
 }
 
@@ -0,0 +1,138 @@
+/*
+ * bstree-join.h -- Binary-Search-Trees Join Based Internal Routines
+ *
+ * Copyright (C) 2012-2013 yanyg (cppgp@qq.com)
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING, if not see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * You always need not to include this file directly.
+ * Every balanced tree exports its split/join cores through a
+ * __bst_join_ops, the set algorithms are written once on top of them.
+ */
+
+#ifndef __YCALGOS_BSTREE_JOIN_H_
+#define __YCALGOS_BSTREE_JOIN_H_
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <unistd.h>
+
+#include <ycc/compiler.h>
+#include <ycc/algos/bstree-link.h>
+
+__BEGIN_DECLS
+
+/* a detached subtree, 'aux' is tree specific */
+struct __bst_tree
+{
+	struct bst_link *link;
+	size_t aux;		/* rb: black-height, avl: height */
+};
+
+struct __bst_join_ops
+{
+	/* wrap a detached subtree */
+	struct __bst_tree (*make)(struct bst_link *link);
+	/* detach the children of a non-empty tree */
+	void (*expose)(struct __bst_tree tree,
+		       struct __bst_tree *left,
+		       struct __bst_tree *right);
+	/* '< arg' to 'left', '>= arg' to 'right' */
+	void (*split)(struct __bst_tree tree,
+		      bstlink_compare_t compare,
+		      const void *arg,
+		      struct __bst_tree *left,
+		      struct __bst_tree *right);
+	struct __bst_tree (*join)(struct __bst_tree left,
+				  struct bst_link *pivot,
+				  struct __bst_tree right);
+	struct __bst_tree (*concat)(struct __bst_tree left,
+				    struct __bst_tree right);
+};
+
+extern const struct __bst_join_ops __rb_join_ops;
+extern const struct __bst_join_ops __avl_join_ops;
+extern const struct __bst_join_ops __treap_join_ops;
+
+/* do not fork on trees whose left spine is shorter than this */
+#define __BST_FORK_SPINE	12
+
+/*
+ * the depth of recursion the forks stop at, every level doubles the
+ * threads at work, 0 'nthreads' means one per online cpu
+ */
+static inline unsigned __bst_fork_depth(unsigned nthreads)
+{
+	unsigned depth;
+
+	if (!nthreads) {
+		long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+		nthreads = cpus > 0 ? (unsigned)cpus : 1;
+	}
+
+	for (depth = 0; (1u << depth) < nthreads; ++depth)
+		;
+
+	return depth;
+}
+
+/* fork on the subtree 'link' at 'depth' unless too deep or too small */
+static inline bool __bst_should_fork(const struct bst_link *link,
+				     unsigned depth,
+				     unsigned fork_depth)
+{
+	unsigned spine = 0;
+
+	if (depth >= fork_depth)
+		return false;
+
+	for (; link && spine < __BST_FORK_SPINE; link = link->left)
+		++spine;
+
+	return spine == __BST_FORK_SPINE;
+}
+
+enum __bst_setop
+{
+	__BST_SETOP_UNION,
+	__BST_SETOP_INTERSECTION,
+	__BST_SETOP_DIFFERENCE,
+};
+
+/*
+ * __bst_setop  --  join based set algorithms
+ *
+ * Description
+ *	Consumes the detached trees 'link1' and 'link2' and returns the
+ *	root of 'link1 op link2'.  Nodes of 'link1' are kept on equal
+ *	keys, every node dropped from either tree goes to 'destroy'.
+ *	The top levels of the recursion fork onto up to 'nthreads'
+ *	threads, 0 means one per online cpu.
+ */
+struct bst_link *__bst_setop(const struct __bst_join_ops *ops,
+			     enum __bst_setop op,
+			     struct bst_link *link1,
+			     struct bst_link *link2,
+			     bstlink_compare_link_t compare_link,
+			     bstlink_destroy_t destroy,
+			     const void *arg_compare,
+			     const void *arg_destroy,
+			     unsigned nthreads);
+
+__END_DECLS
+
+#endif	/* __YCALGOS_BSTREE_JOIN_H_ */
@@ -38,7 +38,9 @@
  *    X and Y(the right child of X) MUST not be NULL
  *    T1, T2, and T3 are subtrees which can be empty or non-empty
  */
-void bstlink_rotate_left(struct bst_link *link, struct bst_link **proot)
+static inline void __bstlink_rotate_left(struct bst_link *link,
+					 struct bst_link **proot,
+					 bool once)
 {
 	struct bst_link *right, *parent;
 
@@ -47,23 +49,38 @@ void bstlink_rotate_left(struct bst_link *link, struct bst_link **proot)
 	assert(link->right);
 
 	right = link->right;
-	parent = link->parent;
+	parent = bstlink_parent(link);
 
-	if ((link->right = right->left))
-		right->left->parent = link;
-	right->left = link;
+	__BSTLINK_STORE(link->right, right->left, once);
+	if (right->left)
+		bstlink_set_parent(right->left, link);
+	__BSTLINK_STORE(right->left, link, once);
 
-	right->parent = parent;
+	bstlink_set_parent(right, parent);
 
 	if (parent) {
 		if (link == parent->left)
-			parent->left = right;
+			__BSTLINK_STORE(parent->left, right, once);
 		else
-			parent->right = right;
+			__BSTLINK_STORE(parent->right, right, once);
 	} else
-		*proot = right;
+		__BSTLINK_STORE(*proot, right, once);
+
+	bstlink_set_parent(link, right);
+#ifdef	BSTLINK_SIZE
+	right->size = link->size;
+	bstlink_size_update(link);
+#endif
+}
+
+void bstlink_rotate_left(struct bst_link *link, struct bst_link **proot)
+{
+	__bstlink_rotate_left(link, proot, false);
+}
 
-	link->parent = right;
+void bstlink_rotate_left_once(struct bst_link *link, struct bst_link **proot)
+{
+	__bstlink_rotate_left(link, proot, true);
 }
 
 /*
@@ -82,7 +99,9 @@ void bstlink_rotate_left(struct bst_link *link, struct bst_link **proot)
  *    T1, T2, and T3 are subtrees which can be empty or non-empty
  *
  */
-void bstlink_rotate_right(struct bst_link *link, struct bst_link **proot)
+static inline void __bstlink_rotate_right(struct bst_link *link,
+					  struct bst_link **proot,
+					  bool once)
 {
 	struct bst_link *left, *parent;
 
@@ -91,23 +110,38 @@ void bstlink_rotate_right(struct bst_link *link, struct bst_link **proot)
 	assert(link->left);
 
 	left = link->left;
-	parent = link->parent;
+	parent = bstlink_parent(link);
 
-	if ((link->left=left->right))
-		left->right->parent = link;
-	left->right = link;
+	__BSTLINK_STORE(link->left, left->right, once);
+	if (left->right)
+		bstlink_set_parent(left->right, link);
+	__BSTLINK_STORE(left->right, link, once);
 
-	left->parent = parent;
+	bstlink_set_parent(left, parent);
 
 	if (parent) {
 		if (link == parent->right)
-			parent->right = left;
+			__BSTLINK_STORE(parent->right, left, once);
 		else
-			parent->left = left;
+			__BSTLINK_STORE(parent->left, left, once);
 	} else
-		*proot = left;
+		__BSTLINK_STORE(*proot, left, once);
 
-	link->parent = left;
+	bstlink_set_parent(link, left);
+#ifdef	BSTLINK_SIZE
+	left->size = link->size;
+	bstlink_size_update(link);
+#endif
+}
+
+void bstlink_rotate_right(struct bst_link *link, struct bst_link **proot)
+{
+	__bstlink_rotate_right(link, proot, false);
+}
+
+void bstlink_rotate_right_once(struct bst_link *link, struct bst_link **proot)
+{
+	__bstlink_rotate_right(link, proot, true);
 }
 
 struct bst_link *bstlink_first(const struct bst_link *link)
@@ -152,7 +186,7 @@ struct bst_link *bstlink_next(const struct bst_link *link)
 	 * which right-subtree does not include link.
 	 * Otherwise return NULL.
 	 */
-	while ((parent=link->parent) && link == parent->right)
+	while ((parent=bstlink_parent(link)) && link == parent->right)
 		link = parent;
 
 	return (struct bst_link*)parent;
@@ -179,17 +213,88 @@ struct bst_link *bstlink_prev(const struct bst_link *link)
 	 * which left-subtree does not include link.
 	 * Otherwise return NULL.
 	 */
-	while ((parent=link->parent) && link == parent->left)
+	while ((parent=bstlink_parent(link)) && link == parent->left)
 		link = parent;
 
 	return (struct bst_link*)parent;
 }
 
+/*
+ * The walks below climb by the parent links, and stop at 'root' even
+ * if it is not the root of the tree.
+ */
+struct bst_link *bstlink_next_preorder(const struct bst_link *link,
+				       const struct bst_link *root)
+{
+	struct bst_link *parent;
+
+	if (link->left)
+		return link->left;
+	if (link->right)
+		return link->right;
+
+	/* up to the first ancestor with a right subtree not yet walked */
+	for (; link != root; link = parent) {
+		parent = bstlink_parent(link);
+		if (link == parent->left && parent->right)
+			return parent->right;
+	}
+
+	return NULL;
+}
+
+struct bst_link *bstlink_next_inorder(const struct bst_link *link,
+				      const struct bst_link *root)
+{
+	struct bst_link *parent;
+
+	if (link->right)
+		return bstlink_first(link->right);
+
+	for (; link != root; link = parent) {
+		parent = bstlink_parent(link);
+		if (link == parent->left)
+			return parent;
+	}
+
+	return NULL;
+}
+
+/* the first leaf going left where possible, right otherwise */
+struct bst_link *bstlink_first_postorder(const struct bst_link *root)
+{
+	while (root) {
+		if (root->left)
+			root = root->left;
+		else if (root->right)
+			root = root->right;
+		else
+			break;
+	}
+
+	return (struct bst_link*)root;
+}
+
+struct bst_link *bstlink_next_postorder(const struct bst_link *link,
+					const struct bst_link *root)
+{
+	struct bst_link *parent;
+
+	if (link == root)
+		return NULL;
+
+	parent = bstlink_parent(link);
+	if (link == parent->left && parent->right)
+		return bstlink_first_postorder(parent->right);
+
+	return parent;
+}
+
 void bstlink_replace(struct bst_link *victim,
 		     struct bst_link *new,
 		     struct bst_link **proot)
 {
-	struct bst_link *parent = victim->parent;
+	struct bst_link *parent = bstlink_parent(victim);
 
 	if (parent) {
 		if (victim == parent->left)
@@ -200,9 +305,9 @@ void bstlink_replace(struct bst_link *victim,
 		*proot = new;
 
 	if (victim->left)
-		victim->left->parent = new;
+		bstlink_set_parent(victim->left, new);
 	if (victim->right)
-		victim->right->parent = new;
+		bstlink_set_parent(victim->right, new);
 
 	*new = *victim;
 }
@@ -278,23 +383,121 @@ void bstlink_lower_upper_bound(const struct bst_link *link,
 
 	while (link) {
 		int icmp = compare(link, arg);
-		if (icmp >= 0) {
-			*plb = (struct bst_link*)link;
-			if (icmp)
-				*pub = (struct bst_link*)link;
+
+		if (icmp < 0)
+			link = link->right;
+		else if (icmp > 0) {
+			*plb = *pub = (struct bst_link*)link;
 			link = link->left;
-		} else
-		link = link->right;
+		} else {
+			/* the bounds part ways here */
+			struct bst_link *lb, *ub;
+
+			lb = bstlink_lower_bound(link->left, compare, arg);
+			ub = bstlink_upper_bound(link->right, compare, arg);
+			*plb = lb ? lb : (struct bst_link*)link;
+			if (ub)
+				*pub = ub;
+			return;
+		}
 	}
 }
 
-bool bstlink_insert(struct bst_link *link,
-		    struct bst_link **proot,
-		    bstlink_compare_link_t compare_link,
-		    const void *arg,
-		    bool bunique)
+/* searches walking in lockstep, enough to cover a DRAM latency */
+#define __BSTLINK_BATCH_WIDTH	16
+
+/*
+ * Every slot takes one step per round and prefetches the child it goes
+ * to, the other slots' steps hide the miss.  A finished slot is loaded
+ * with the next search at once so that the width stays full.
+ */
+static void __bstlink_batch(const struct bst_link *root,
+			    bstlink_compare_t compare,
+			    const void * const *args,
+			    size_t num,
+			    struct bst_link **results,
+			    bool bfind)
 {
-	struct bst_link *parent = NULL;
+	struct {
+		const struct bst_link *link, *lb;
+		size_t i;
+		bool equal;
+	} slots[__BSTLINK_BATCH_WIDTH];
+	size_t next, active, s;
+
+	if (!root) {
+		for (next = 0; next < num; ++next)
+			results[next] = NULL;
+		return;
+	}
+
+	for (next = 0; next < num && next < __BSTLINK_BATCH_WIDTH; ++next) {
+		slots[next].link = root;
+		slots[next].lb = NULL;
+		slots[next].i = next;
+		slots[next].equal = false;
+	}
+	active = next;
+
+	while (active) {
+		for (s = 0; s < active; ) {
+			const struct bst_link *link = slots[s].link;
+			int icmp = compare(link, args[slots[s].i]);
+
+			if (icmp >= 0) {
+				slots[s].lb = link;
+				slots[s].equal = !icmp;
+				link = link->left;
+			} else
+				link = link->right;
+
+			if (link) {
+				__builtin_prefetch(link);
+				slots[s++].link = link;
+				continue;
+			}
+
+			results[slots[s].i] = (struct bst_link*)
+				(!bfind || slots[s].equal ? slots[s].lb : NULL);
+
+			if (next < num) {
+				slots[s].link = root;
+				slots[s].lb = NULL;
+				slots[s].i = next++;
+				slots[s].equal = false;
+				++s;
+			} else
+				slots[s] = slots[--active];
+		}
+	}
+}
+
+void bstlink_find_batch(const struct bst_link *link,
+			bstlink_compare_t compare,
+			const void * const *args,
+			size_t num,
+			struct bst_link **results)
+{
+	__bstlink_batch(link, compare, args, num, results, true);
+}
+
+void bstlink_lower_bound_batch(const struct bst_link *link,
+			       bstlink_compare_t compare,
+			       const void * const *args,
+			       size_t num,
+			       struct bst_link **results)
+{
+	__bstlink_batch(link, compare, args, num, results, false);
+}
+
+static inline bool __bstlink_insert(struct bst_link *link,
+				    struct bst_link **proot,
+				    bstlink_compare_link_t compare_link,
+				    const void *arg,
+				    bool bunique,
+				    bool once)
+{
+	struct bst_link *parent = NULL, *slot;
 
 	while (*proot) {
 		int icmp = compare_link(*proot, link, arg);
@@ -315,11 +518,93 @@ bool bstlink_insert(struct bst_link *link,
 		}
 	}
 
-	bstlink_init(link, parent, proot);
+	if (!once) {
+		bstlink_init(link, parent, proot);
+		return true;
+	}
+
+	/* 'link' is set up before it is published */
+	bstlink_init(link, parent, &slot);
+	__atomic_store_n(proot, link, __ATOMIC_RELEASE);
 
 	return true;
 }
 
+bool bstlink_insert(struct bst_link *link,
+		    struct bst_link **proot,
+		    bstlink_compare_link_t compare_link,
+		    const void *arg,
+		    bool bunique)
+{
+	return __bstlink_insert(link, proot, compare_link, arg, bunique,
+				false);
+}
+
+bool bstlink_insert_once(struct bst_link *link,
+			 struct bst_link **proot,
+			 bstlink_compare_link_t compare_link,
+			 const void *arg,
+			 bool bunique)
+{
+	return __bstlink_insert(link, proot, compare_link, arg, bunique,
+				true);
+}
+
+/*
+ * Climb from 'hint' towards the new position: going up from a left
+ * child meets a greater node, from a right child a less one.  Only
+ * those which could bound the position are compared, the climb stops
+ * at the first one on the far side and the descent restarts below the
+ * last one passed.  Appending after the last node, hinted with it,
+ * costs the one compare to 'hint'.
+ */
+void bstlink_insert_hint(struct bst_link *link,
+			 struct bst_link *hint,
+			 struct bst_link **proot,
+			 bstlink_compare_link_t compare_link,
+			 const void *arg)
+{
+	struct bst_link *x, *parent, **plink;
+
+	if (!hint) {
+		(void)bstlink_insert(link, proot, compare_link, arg, false);
+		return;
+	}
+
+	if (compare_link(hint, link, arg) <= 0) {
+		/* after 'hint' */
+		for (x = hint; (parent = bstlink_parent(x)); x = parent) {
+			if (x != parent->left)
+				continue;
+			if (compare_link(parent, link, arg) > 0)
+				break;
+			hint = parent;
+		}
+		plink = &hint->right;
+	} else {
+		/* before 'hint' */
+		for (x = hint; (parent = bstlink_parent(x)); x = parent) {
+			if (x != parent->right)
+				continue;
+			if (compare_link(parent, link, arg) <= 0)
+				break;
+			hint = parent;
+		}
+		plink = &hint->left;
+	}
+
+	parent = hint;
+	while (*plink) {
+		parent = *plink;
+		if (compare_link(parent, link, arg) > 0)
+			plink = &parent->left;
+		else
+			plink = &parent->right;
+	}
+
+	bstlink_init(link, parent, plink);
+}
+
 #if 0
 void bstlink_erase(struct bst_link *link, struct bst_link **proot)
 {
@@ -334,9 +619,9 @@ void bstlink_erase(struct bst_link *link, struct bst_link **proot)
 		else
 			child = link->left;
 
-		parent = link->parent;
+		parent = bstlink_parent(link);
 		if (child)
-			child->parent = parent;
+			bstlink_set_parent(child, parent);
 		if (parent) {
 			if (parent->left == link)
 				parent->left = child;
@@ -354,31 +639,31 @@ void bstlink_erase(struct bst_link *link, struct bst_link **proot)
 		while (scor->left)
 			scor = scor->left;
 
-		if (link->parent) {
-			if (link->parent->left == link)
-				link->parent->left = scor;
+		if (bstlink_parent(link)) {
+			if (bstlink_parent(link)->left == link)
+				bstlink_parent(link)->left = scor;
 			else
-				link->parent->right = scor;
+				bstlink_parent(link)->right = scor;
 		} else
 			*proot = scor;
 
 		child = scor->right;
-		parent = scor->parent;
+		parent = bstlink_parent(scor);
 
 		if (parent == link)
 			parent = scor;
 		else {
 			if (child)
-				child->parent = parent;
+				bstlink_set_parent(child, parent);
 
 			parent->left = child;
 			scor->right = link->right;
-			link->right->parent = scor;
+			bstlink_set_parent(link->right, scor);
 		}
 
-		scor->parent = link->parent;
+		bstlink_set_parent(scor, bstlink_parent(link));
 		scor->left = link->left;
-		link->left->parent = scor;
+		bstlink_set_parent(link->left, scor);
 #ifdef __BSTLINK_ERASE_SPECIALIZE_BOTH
 	__BSTLINK_ERASE_SPECIALIZE_BOTH();
 #endif
@@ -390,10 +675,66 @@ void bstlink_erase(struct bst_link *link, struct bst_link **proot)
 }
 #endif
 
+#ifdef	BSTLINK_SIZE
+struct bst_link *bstlink_select(const struct bst_link *link, size_t k)
+{
+	while (link) {
+		size_t left = bstlink_size(link->left);
+
+		if (k < left)
+			link = link->left;
+		else if (k > left) {
+			k -= left + 1;
+			link = link->right;
+		} else
+			break;
+	}
+
+	return (struct bst_link*)link;
+}
+
+size_t bstlink_rank(const struct bst_link *link)
+{
+	size_t r = bstlink_size(link->left);
+	const struct bst_link *parent;
+
+	for (; (parent=bstlink_parent(link)); link = parent) {
+		if (link == parent->right)
+			r += bstlink_size(parent->left) + 1;
+	}
+
+	return r;
+}
+
+size_t bstlink_count_less(const struct bst_link *link,
+			  bstlink_compare_t compare,
+			  const void *arg,
+			  bool bequal)
+{
+	size_t c = 0;
+
+	while (link) {
+		int icmp = compare(link, arg);
+
+		if (icmp < 0 || (!icmp && bequal)) {
+			c += bstlink_size(link->left) + 1;
+			link = link->right;
+		} else
+			link = link->left;
+	}
+
+	return c;
+}
+#endif
+
 size_t bstlink_count(const struct bst_link *link,
 		     bstlink_compare_t compare,
 		     const void *arg)
 {
+#ifdef	BSTLINK_SIZE
+	return bstlink_count_less(link, compare, arg, true) -
+	       bstlink_count_less(link, compare, arg, false);
+#else
 	size_t c = 0;
 	struct bst_link *lb, *ub;
 
@@ -405,65 +746,253 @@ size_t bstlink_count(const struct bst_link *link,
 	}
 
 	return c;
+#endif
 }
 
+/*
+ * The walks of visit, height and destroy keep the last ancestors they
+ * will come back to, a balanced tree never takes more than this.
+ */
+#define __BSTLINK_WALK_DEPTH	64
+
+/*
+ * An inorder walk which destroys each node once its left subtree is
+ * gone.  Deeper than __BSTLINK_WALK_DEPTH, the left child is rotated
+ * up instead of keeping the node: that moves one node off the left
+ * spine per rotation and needs no memory at all.
+ */
 void bstlink_destroy(struct bst_link *link,
 		     bstlink_destroy_t destroy,
 		     const void *arg)
 {
-	while (link) {
-		struct bst_link *right = link->right;
-		bstlink_destroy(link->left, destroy, arg);
+	struct bst_link *stack[__BSTLINK_WALK_DEPTH], *left, *right;
+	unsigned cnt = 0;
+
+	for (;;) {
+		while (link && (left = link->left)) {
+			if (cnt < __BSTLINK_WALK_DEPTH)
+				stack[cnt++] = link;
+			else {
+				link->left = left->right;
+				left->right = link;
+			}
+			link = left;
+		}
+
+		if (!link) {
+			if (!cnt)
+				return;
+			link = stack[--cnt];
+		}
+
+		right = link->right;
 		destroy(link, arg);
 		link = right;
 	}
 }
 
+/*
+ * visit and height keep the ancestors in a ring, the oldest fall off
+ * on a deep tree, and find the next one by the parent links only when
+ * the ring runs dry.
+ */
+struct __bstlink_walk {
+	const struct bst_link *root;
+	unsigned top, cnt;
+	const struct bst_link *ring[__BSTLINK_WALK_DEPTH];
+};
+
+static inline void __bstlink_walk_init(struct __bstlink_walk *walk,
+				       const struct bst_link *root)
+{
+	walk->root = root;
+	walk->top = walk->cnt = 0;
+}
+
+/* returns the slot of 'link' */
+static inline unsigned __bstlink_walk_push(struct __bstlink_walk *walk,
+					   const struct bst_link *link)
+{
+	unsigned i = walk->top++ % __BSTLINK_WALK_DEPTH;
+
+	walk->ring[i] = link;
+	if (walk->cnt < __BSTLINK_WALK_DEPTH)
+		++walk->cnt;
+
+	return i;
+}
+
+/* returns the slot popped, or -1 if the ring ran dry */
+static inline int __bstlink_walk_pop(struct __bstlink_walk *walk)
+{
+	if (!walk->cnt)
+		return -1;
+
+	--walk->cnt;
+	return --walk->top % __BSTLINK_WALK_DEPTH;
+}
+
+/* the least node of 'link', its left ancestors on the way are kept */
+static inline const struct bst_link *
+__bstlink_walk_first(struct __bstlink_walk *walk, const struct bst_link *link)
+{
+	for (; link->left; link = link->left)
+		(void)__bstlink_walk_push(walk, link);
+
+	return link;
+}
+
+static inline const struct bst_link *
+__bstlink_walk_next(struct __bstlink_walk *walk, const struct bst_link *link)
+{
+	int i;
+
+	if (link->right)
+		return __bstlink_walk_first(walk, link->right);
+	if ((i = __bstlink_walk_pop(walk)) >= 0)
+		return walk->ring[i];
+
+	return bstlink_next_inorder(link, walk->root);
+}
+
 /* inorder-traverse */
 void bstlink_visit(struct bst_link *link,
 		   bstlink_visit_t visit,
 		   const void *arg)
 {
-	while (link) {
-		bstlink_visit(link->left, visit, arg);
-		visit(link, arg);
-		link = link->right;
-	}
+	struct __bstlink_walk walk;
+	const struct bst_link *cur;
+
+	if (!link)
+		return;
+
+	__bstlink_walk_init(&walk, link);
+	for (cur = __bstlink_walk_first(&walk, link); cur;
+	     cur = __bstlink_walk_next(&walk, cur))
+		visit(cur, arg);
 }
 
 bool bstlink_visit_cond(struct bst_link *link,
 			bstlink_visit_cond_t visit_cond,
 			const void *arg)
 {
-	while (link) {
-		if (!bstlink_visit_cond(link->left, visit_cond, arg) ||
-		    !visit_cond(link, arg))
-			return false;
+	struct __bstlink_walk walk;
+	const struct bst_link *cur;
 
-		link = link->right;
+	if (!link)
+		return true;
+
+	__bstlink_walk_init(&walk, link);
+	for (cur = __bstlink_walk_first(&walk, link); cur;
+	     cur = __bstlink_walk_next(&walk, cur)) {
+		if (!visit_cond(cur, arg))
+			return false;
 	}
 
 	return true;
 }
 
+/*
+ * The max height is the depth of the deepest node, the min height the
+ * depth of the shallowest one missing a child.  A preorder walk keeps
+ * the right subtrees it passes by with their depths.
+ */
 size_t bstlink_height(const struct bst_link *link, bool bmax)
 {
-	size_t h = 0;
+	struct __bstlink_walk walk;
+	size_t depths[__BSTLINK_WALK_DEPTH];
+	const struct bst_link *parent;
+	size_t depth = 1, h = bmax ? 0 : (size_t)-1;
+	int i;
+
+	if (!link)
+		return 0;
+
+	__bstlink_walk_init(&walk, link);
+	for (;;) {
+		if ((!link->left || !link->right) &&
+		    (bmax ? depth > h : depth < h))
+			h = depth;
+
+		if (link->left) {
+			if (link->right) {
+				i = __bstlink_walk_push(&walk, link->right);
+				depths[i] = depth + 1;
+			}
+			link = link->left;
+			++depth;
+			continue;
+		}
+		if (link->right) {
+			link = link->right;
+			++depth;
+			continue;
+		}
+		if ((i = __bstlink_walk_pop(&walk)) >= 0) {
+			link = walk.ring[i];
+			depth = depths[i];
+			continue;
+		}
+
+		/* the ring ran dry, climb to a right subtree not walked */
+		for (; link != walk.root; link = parent, --depth) {
+			parent = bstlink_parent(link);
+			if (link == parent->left && parent->right)
+				break;
+		}
+		if (link == walk.root)
+			return h;
+		link = bstlink_parent(link)->right;
+	}
+}
 
-	if (link) {
-		size_t left = bstlink_height(link->left, bmax);
-		size_t right = bstlink_height(link->right, bmax);
 #define __BSTLINK_MAX(x, y)	( (x) > (y) ? (x) : (y) )
-#define __BSTLINK_MIN(x, y)	( (x) < (y) ? (x) : (y) )
-		if (bmax)
-			h = __BSTLINK_MAX(left, right);
-		else
-			h = __BSTLINK_MIN(left, right);
 
-		++h;
+static struct bst_link *
+__bstlink_build_sorted(struct bst_link **links,
+		       size_t num,
+		       struct bst_link *parent,
+		       size_t depth,
+		       size_t *pheight,
+		       bstlink_build_t build,
+		       const void *arg)
+{
+	size_t mid, left, right;
+	struct bst_link *link;
+
+	if (!num) {
+		*pheight = 0;
+		return NULL;
 	}
 
-	return h;
+	mid = num / 2;
+	link = links[mid];
+	bstlink_set_parent(link, parent);
+	link->left = __bstlink_build_sorted(links, mid, link, depth + 1,
+					    &left, build, arg);
+	link->right = __bstlink_build_sorted(links + mid + 1, num - mid - 1,
+					     link, depth + 1, &right,
+					     build, arg);
+
+	*pheight = __BSTLINK_MAX(left, right) + 1;
+#ifdef	BSTLINK_SIZE
+	link->size = num;
+#endif
+	if (build)
+		build(link, depth, *pheight, arg);
+
+	return link;
+}
+
+struct bst_link *bstlink_build_sorted(struct bst_link **links,
+				      size_t num,
+				      bstlink_build_t build,
+				      const void *arg)
+{
+	size_t height;
+
+	return __bstlink_build_sorted(links, num, NULL, 0, &height,
+				      build, arg);
 }
 
 /* eof */
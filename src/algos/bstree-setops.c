@@ -0,0 +1,190 @@
+/*
+ * bstree-setops.c -- Binary-Search-Trees Parallel Set Algorithms
+ *
+ * Copyright (C) 2012-2013 yanyg (cppgp@qq.com)
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING, if not see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Union, intersection and difference are written on top of split and
+ * join (Blelloch, Ferizovic and Sun, "Just Join for Parallel Ordered
+ * Sets"): expose the root of the first tree, split the second one by
+ * it and recurse on both sides.  It costs O(m log(n/m + 1)) for trees
+ * of m <= n nodes, the two recursive calls are independent and forked
+ * onto threads near the top.
+ */
+
+#include <pthread.h>
+
+#include "bstree-join.h"
+
+struct __bst_setop_ctx
+{
+	const struct __bst_join_ops *ops;
+	enum __bst_setop op;
+	bstlink_compare_link_t compare_link;
+	bstlink_destroy_t destroy;
+	const void *arg_compare;
+	const void *arg_destroy;
+	unsigned fork_depth;
+};
+
+struct __bst_setop_key
+{
+	const struct __bst_setop_ctx *ctx;
+	const struct bst_link *pivot;
+	bool upper;
+};
+
+struct __bst_setop_task
+{
+	const struct __bst_setop_ctx *ctx;
+	struct __bst_tree tree1, tree2, result;
+	unsigned depth;
+};
+
+/* compare to the pivot, with 'upper' the pivot's equals order before */
+static int __bst_setop_compare(const struct bst_link *link, const void *arg)
+{
+	const struct __bst_setop_key *key = arg;
+	int icmp = key->ctx->compare_link(link, key->pivot,
+					  key->ctx->arg_compare);
+
+	if (key->upper && !icmp)
+		return -1;
+
+	return icmp;
+}
+
+static void __bst_setop_destroy(const struct __bst_setop_ctx *ctx,
+				struct bst_link *link)
+{
+	if (link)
+		bstlink_destroy(link, ctx->destroy, ctx->arg_destroy);
+}
+
+static struct __bst_tree __bst_setop_run(const struct __bst_setop_ctx *ctx,
+					 struct __bst_tree tree1,
+					 struct __bst_tree tree2,
+					 unsigned depth);
+
+static void *__bst_setop_thread(void *arg)
+{
+	struct __bst_setop_task *task = arg;
+
+	task->result = __bst_setop_run(task->ctx, task->tree1, task->tree2,
+				       task->depth);
+
+	return NULL;
+}
+
+static struct __bst_tree __bst_setop_run(const struct __bst_setop_ctx *ctx,
+					 struct __bst_tree tree1,
+					 struct __bst_tree tree2,
+					 unsigned depth)
+{
+	const struct __bst_join_ops *ops = ctx->ops;
+	struct __bst_setop_key key = { ctx, NULL, false };
+	struct __bst_setop_task task;
+	struct __bst_tree left1, right1, left2, equal2, right2, left, right;
+	struct bst_link *pivot;
+	bool found, forked = false;
+	pthread_t tid;
+
+	if (!tree1.link || !tree2.link) {
+		switch (ctx->op) {
+		case __BST_SETOP_UNION:
+			return tree1.link ? tree1 : tree2;
+		case __BST_SETOP_INTERSECTION:
+			__bst_setop_destroy(ctx, tree1.link);
+			__bst_setop_destroy(ctx, tree2.link);
+			return ops->make(NULL);
+		default:
+			__bst_setop_destroy(ctx, tree2.link);
+			return tree1;
+		}
+	}
+
+	pivot = tree1.link;
+	ops->expose(tree1, &left1, &right1);
+
+	key.pivot = pivot;
+	ops->split(tree2, __bst_setop_compare, &key, &left2, &right2);
+	key.upper = true;
+	ops->split(right2, __bst_setop_compare, &key, &equal2, &right2);
+
+	found = equal2.link != NULL;
+	__bst_setop_destroy(ctx, equal2.link);
+
+	task.ctx = ctx;
+	task.tree1 = left1;
+	task.tree2 = left2;
+	task.depth = depth + 1;
+	if (__bst_should_fork(left1.link ? left1.link : left2.link, depth,
+			      ctx->fork_depth) &&
+	    !pthread_create(&tid, NULL, __bst_setop_thread, &task))
+		forked = true;
+	else
+		task.result = __bst_setop_run(ctx, left1, left2, depth + 1);
+
+	right = __bst_setop_run(ctx, right1, right2, depth + 1);
+
+	if (forked)
+		pthread_join(tid, NULL);
+	left = task.result;
+
+	switch (ctx->op) {
+	case __BST_SETOP_UNION:
+		return ops->join(left, pivot, right);
+	case __BST_SETOP_INTERSECTION:
+		if (found)
+			return ops->join(left, pivot, right);
+		break;
+	default:
+		if (!found)
+			return ops->join(left, pivot, right);
+		break;
+	}
+
+	ctx->destroy(pivot, ctx->arg_destroy);
+	return ops->concat(left, right);
+}
+
+struct bst_link *__bst_setop(const struct __bst_join_ops *ops,
+			     enum __bst_setop op,
+			     struct bst_link *link1,
+			     struct bst_link *link2,
+			     bstlink_compare_link_t compare_link,
+			     bstlink_destroy_t destroy,
+			     const void *arg_compare,
+			     const void *arg_destroy,
+			     unsigned nthreads)
+{
+	struct __bst_setop_ctx ctx;
+
+	ctx.ops = ops;
+	ctx.op = op;
+	ctx.compare_link = compare_link;
+	ctx.destroy = destroy;
+	ctx.arg_compare = arg_compare;
+	ctx.arg_destroy = arg_destroy;
+	ctx.fork_depth = __bst_fork_depth(nthreads);
+
+	return __bst_setop_run(&ctx, ops->make(link1), ops->make(link2),
+			       0).link;
+}
+
+/* eof */
@@ -0,0 +1,162 @@
+/*
+ * itree.c -- Interval Trees
+ *
+ * Copyright (C) 2012-2013 yanyg (cppgp@qq.com)
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING, if not see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#include <ycc/algos/itree.h>
+
+#define __itree_node(ptr)	rb_entry(ptr, struct itree_node, rb_node)
+
+static inline unsigned long __itree_compute(const struct itree_node *node)
+{
+	unsigned long last = node->last;
+
+	if (node->rb_node.left &&
+	    __itree_node(node->rb_node.left)->subtree_last > last)
+		last = __itree_node(node->rb_node.left)->subtree_last;
+	if (node->rb_node.right &&
+	    __itree_node(node->rb_node.right)->subtree_last > last)
+		last = __itree_node(node->rb_node.right)->subtree_last;
+
+	return last;
+}
+
+RB_AUGMENT_CALLBACKS(__itree_augment, struct itree_node, rb_node,
+		     unsigned long, subtree_last, __itree_compute)
+
+void itree_insert(struct itree_node *node, struct itree_root *itree)
+{
+	struct rb_node **plink = &itree->rb.node, *parent = NULL;
+
+	while (*plink) {
+		parent = *plink;
+		if (node->start < __itree_node(parent)->start)
+			plink = &parent->left;
+		else
+			plink = &parent->right;
+	}
+
+	node->subtree_last = node->last;
+	rb_link_node(&node->rb_node, parent, plink);
+	rb_insert_augmented(&node->rb_node, &itree->rb, &__itree_augment);
+}
+
+void itree_erase(struct itree_node *node, struct itree_root *itree)
+{
+	rb_erase_augmented(&node->rb_node, &itree->rb, &__itree_augment);
+}
+
+/* the left-most node of the subtree 'node' overlapping [start, last] */
+static struct itree_node *
+__itree_subtree_search(struct itree_node *node,
+		       unsigned long start,
+		       unsigned long last)
+{
+	for (;;) {
+		struct rb_node *rb_node = node->rb_node.left;
+
+		if (rb_node && start <= __itree_node(rb_node)->subtree_last) {
+			node = __itree_node(rb_node);
+			continue;
+		}
+
+		if (node->start > last)
+			return NULL;
+		if (start <= node->last)
+			return node;
+
+		rb_node = node->rb_node.right;
+		if (!rb_node || start > __itree_node(rb_node)->subtree_last)
+			return NULL;
+		node = __itree_node(rb_node);
+	}
+}
+
+struct itree_node *itree_iter_first(const struct itree_root *itree,
+				    unsigned long start,
+				    unsigned long last)
+{
+	struct itree_node *node;
+
+	if (!itree->rb.node)
+		return NULL;
+
+	node = __itree_node(itree->rb.node);
+	if (node->subtree_last < start)
+		return NULL;
+
+	return __itree_subtree_search(node, start, last);
+}
+
+struct itree_node *itree_iter_next(const struct itree_node *node,
+				   unsigned long start,
+				   unsigned long last)
+{
+	struct rb_node *rb_node = node->rb_node.right, *prev;
+
+	for (;;) {
+		/* the left subtree and 'node' are done, try the right */
+		if (rb_node && start <= __itree_node(rb_node)->subtree_last)
+			return __itree_subtree_search(__itree_node(rb_node),
+						      start, last);
+
+		/* go up until coming from a left child */
+		do {
+			prev = (struct rb_node*)&node->rb_node;
+			if (!(rb_node = rb_parent(prev)))
+				return NULL;
+			node = __itree_node(rb_node);
+			rb_node = node->rb_node.right;
+		} while (prev == rb_node);
+
+		if (node->start > last)
+			return NULL;
+		if (start <= node->last)
+			return (struct itree_node*)node;
+	}
+}
+
+#ifndef NDEBUG
+static bool __itree_isvalid(const struct rb_node *rb_node)
+{
+	const struct itree_node *node;
+
+	if (!rb_node)
+		return true;
+
+	node = __itree_node(rb_node);
+	if (node->start > node->last ||
+	    node->subtree_last != __itree_compute(node))
+		return false;
+
+	if (rb_node->left && __itree_node(rb_node->left)->start > node->start)
+		return false;
+	if (rb_node->right && __itree_node(rb_node->right)->start < node->start)
+		return false;
+
+	return __itree_isvalid(rb_node->left) &&
+	       __itree_isvalid(rb_node->right);
+}
+
+bool itree_isvalid(struct itree_root *itree)
+{
+	return rb_isvalid(&itree->rb) && __itree_isvalid(itree->rb.node);
+}
+#endif
+
+/* eof */
@@ -0,0 +1,405 @@
+/*
+ * rbtree-hash.c -- Hash Tables of Red-Black Trees
+ *
+ * Copyright (C) 2012-2013 yanyg (cppgp@qq.com)
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING, if not see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <ycc/debug.h>
+#include <ycc/algos/rbtree-hash.h>
+
+#define RBH_MIN		16
+
+/* the table doubles over RBH_GROW nodes per bucket */
+#define RBH_GROW	2
+/* and halves under one per RBH_SHRINK buckets */
+#define RBH_SHRINK	8
+
+#define __rbh_rotl(x, b)	(((x) << (b)) | ((x) >> (64 - (b))))
+
+#define __RBH_SIPROUND(v0, v1, v2, v3) do {				\
+	v0 += v1; v1 = __rbh_rotl(v1, 13); v1 ^= v0;			\
+	v0 = __rbh_rotl(v0, 32);					\
+	v2 += v3; v3 = __rbh_rotl(v3, 16); v3 ^= v2;			\
+	v0 += v3; v3 = __rbh_rotl(v3, 21); v3 ^= v0;			\
+	v2 += v1; v1 = __rbh_rotl(v1, 17); v1 ^= v2;			\
+	v2 = __rbh_rotl(v2, 32);					\
+} while (0)
+
+static inline uint64_t __rbh_load64(const unsigned char *p, size_t len)
+{
+	uint64_t x = 0;
+
+	/* little endian whatever the host is */
+	while (len--)
+		x |= (uint64_t)p[len] << (8 * len);
+
+	return x;
+}
+
+uint64_t rbh_hash(const struct rbh_root *rbh, const void *data, size_t len)
+{
+	const unsigned char *p = data;
+	uint64_t k0 = rbh->seed[0], k1 = rbh->seed[1], m;
+	uint64_t v0 = k0 ^ 0x736f6d6570736575ULL;
+	uint64_t v1 = k1 ^ 0x646f72616e646f6dULL;
+	uint64_t v2 = k0 ^ 0x6c7967656e657261ULL;
+	uint64_t v3 = k1 ^ 0x7465646279746573ULL;
+	size_t left = len;
+
+	for (; left >= 8; p += 8, left -= 8) {
+		m = __rbh_load64(p, 8);
+		v3 ^= m;
+		__RBH_SIPROUND(v0, v1, v2, v3);
+		__RBH_SIPROUND(v0, v1, v2, v3);
+		v0 ^= m;
+	}
+
+	m = __rbh_load64(p, left) | (uint64_t)len << 56;
+	v3 ^= m;
+	__RBH_SIPROUND(v0, v1, v2, v3);
+	__RBH_SIPROUND(v0, v1, v2, v3);
+	v0 ^= m;
+
+	v2 ^= 0xff;
+	__RBH_SIPROUND(v0, v1, v2, v3);
+	__RBH_SIPROUND(v0, v1, v2, v3);
+	__RBH_SIPROUND(v0, v1, v2, v3);
+	__RBH_SIPROUND(v0, v1, v2, v3);
+
+	return v0 ^ v1 ^ v2 ^ v3;
+}
+
+/* a seed nobody outside can guess, the clock if urandom is not there */
+static void __rbh_seed(struct rbh_root *rbh)
+{
+	struct timespec ts;
+	int fd = open("/dev/urandom", O_RDONLY);
+
+	if (fd >= 0) {
+		ssize_t n = read(fd, rbh->seed, sizeof(rbh->seed));
+
+		close(fd);
+		if (n == (ssize_t)sizeof(rbh->seed))
+			return;
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	rbh->seed[0] = (uint64_t)ts.tv_nsec << 32 ^ (uint64_t)ts.tv_sec ^
+		       (uint64_t)(unsigned long)rbh;
+	rbh->seed[1] = (uint64_t)getpid() << 32 ^ (uint64_t)time(NULL) ^
+		       (uint64_t)(unsigned long)&ts;
+}
+
+/* the bucket of 'hash', in the old table while it is not moved yet */
+static inline struct rb_root *__rbh_bucket(const struct rbh_root *rbh,
+					   uint64_t hash)
+{
+	if (rbh->old) {
+		size_t small = rbh->num < rbh->old_num ? rbh->num
+						       : rbh->old_num;
+
+		if ((hash & (small - 1)) >= rbh->moved)
+			return &rbh->old[hash & (rbh->old_num - 1)];
+	}
+
+	return &rbh->buckets[hash & (rbh->num - 1)];
+}
+
+/*
+ * a tree turned into the list of its nodes in order, linked by 'right',
+ * by right rotations in O(n) and no memory
+ */
+static struct rb_node *__rbh_vine(struct rb_node *node)
+{
+	struct rb_node *head = NULL, **tail = &head, *left;
+
+	while (node) {
+		if ((left = node->left)) {
+			node->left = left->right;
+			left->right = node;
+			node = left;
+		} else {
+			*tail = node;
+			tail = &node->right;
+			node = node->right;
+		}
+	}
+
+	return head;
+}
+
+/* 'node' after all of 'rb', whose last node is '*plast' */
+static inline void __rbh_append(struct rb_root *rb,
+				struct rb_node **plast,
+				struct rb_node *node)
+{
+	struct rb_node *last = *plast;
+
+	rb_link_node(node, last, last ? &last->right : &rb->node);
+	rb_insert_rebalance(node, rb);
+	*plast = node;
+}
+
+/* old bucket 'i' into buckets 'i' and 'i + old_num', by one hash bit */
+static void __rbh_split(struct rbh_root *rbh, size_t i)
+{
+	struct rb_root *rb[2] = {
+		&rbh->buckets[i], &rbh->buckets[i + rbh->old_num]
+	};
+	struct rb_node *last[2] = { NULL, NULL }, *node, *next;
+	int k;
+
+	for (node = __rbh_vine(rbh->old[i].node); node; node = next) {
+		next = node->right;
+		k = !!(rbh->hash(rbh, node) & rbh->old_num);
+		__rbh_append(rb[k], &last[k], node);
+	}
+	rb_init(&rbh->old[i]);
+}
+
+/* old buckets 'i' and 'i + num' into bucket 'i' */
+static void __rbh_merge(struct rbh_root *rbh, size_t i)
+{
+	struct rb_node *node1 = __rbh_vine(rbh->old[i].node);
+	struct rb_node *node2 = __rbh_vine(rbh->old[i + rbh->num].node);
+	struct rb_node *last = NULL, *node;
+	const void *arg = rbh->arg;
+
+	while (node1 || node2) {
+		if (!node2 ||
+		    (node1 && rbh->compare_link(node1, node2, arg) <= 0)) {
+			node = node1;
+			node1 = node1->right;
+		} else {
+			node = node2;
+			node2 = node2->right;
+		}
+		__rbh_append(&rbh->buckets[i], &last, node);
+	}
+	rb_init(&rbh->old[i]);
+	rb_init(&rbh->old[i + rbh->num]);
+}
+
+static void __rbh_migrate(struct rbh_root *rbh, size_t steps)
+{
+	bool grow = rbh->num > rbh->old_num;
+	size_t small = grow ? rbh->old_num : rbh->num;
+
+	for (; steps && rbh->moved < small; --steps) {
+		if (grow)
+			__rbh_split(rbh, rbh->moved);
+		else
+			__rbh_merge(rbh, rbh->moved);
+		++rbh->moved;
+	}
+
+	if (rbh->moved == small) {
+		rb_free(rbh->old, rbh->old_num, NULL, NULL);
+		rbh->old = NULL;
+		rbh->old_num = 0;
+	}
+}
+
+/* start a resize, on failure the table stays as it is and tries later */
+static void __rbh_resize(struct rbh_root *rbh, size_t num)
+{
+	struct rb_root *buckets = rb_alloc(num);
+
+	if (!buckets)
+		return;
+
+	rbh->old = rbh->buckets;
+	rbh->old_num = rbh->num;
+	rbh->buckets = buckets;
+	rbh->num = num;
+	rbh->moved = 0;
+}
+
+/* after 'count' changed, go on with a resize or start one */
+static void __rbh_update(struct rbh_root *rbh)
+{
+	if (rbh->old)
+		__rbh_migrate(rbh, RBH_MIGRATE);
+	else if (rbh->count > RBH_GROW * rbh->num)
+		__rbh_resize(rbh, rbh->num * 2);
+	else if (rbh->num > rbh->min && rbh->count < rbh->num / RBH_SHRINK)
+		__rbh_resize(rbh, rbh->num / 2);
+}
+
+int rbh_init(struct rbh_root *rbh,
+	     size_t num,
+	     uint64_t (*hash)(const struct rbh_root *rbh,
+			      const struct rb_node *node),
+	     int (*compare_link)(const struct rb_node *node1,
+				 const struct rb_node *node2,
+				 const void *arg),
+	     const void *arg)
+{
+	size_t n = RBH_MIN;
+
+	while (n < num)
+		n *= 2;
+
+	if (!(rbh->buckets = rb_alloc(n))) {
+		errno = ENOMEM;
+		return -1;
+	}
+
+	rbh->old = NULL;
+	rbh->num = rbh->min = n;
+	rbh->old_num = 0;
+	rbh->moved = 0;
+	rbh->count = 0;
+	rbh->hash = hash;
+	rbh->compare_link = compare_link;
+	rbh->arg = arg;
+	__rbh_seed(rbh);
+
+	return 0;
+}
+
+void rbh_destroy(struct rbh_root *rbh,
+		 void (*destroy)(struct rb_node *node, const void *arg),
+		 const void *arg)
+{
+	if (rbh->old)
+		rb_free(rbh->old, rbh->old_num, destroy, arg);
+	rb_free(rbh->buckets, rbh->num, destroy, arg);
+	rbh->old = rbh->buckets = NULL;
+	rbh->count = 0;
+}
+
+void rbh_set_seed(struct rbh_root *rbh, const uint64_t seed[2])
+{
+	rbh->seed[0] = seed[0];
+	rbh->seed[1] = seed[1];
+}
+
+void rbh_insert(struct rbh_root *rbh, struct rb_node *node)
+{
+	rb_insert(node, __rbh_bucket(rbh, rbh->hash(rbh, node)),
+		  rbh->compare_link, rbh->arg);
+	++rbh->count;
+	__rbh_update(rbh);
+}
+
+bool rbh_insert_unique(struct rbh_root *rbh, struct rb_node *node)
+{
+	if (!rb_insert_unique(node, __rbh_bucket(rbh, rbh->hash(rbh, node)),
+			      rbh->compare_link, rbh->arg))
+		return false;
+
+	++rbh->count;
+	__rbh_update(rbh);
+
+	return true;
+}
+
+void rbh_erase(struct rbh_root *rbh, struct rb_node *node)
+{
+	rb_erase(node, __rbh_bucket(rbh, rbh->hash(rbh, node)));
+	--rbh->count;
+	__rbh_update(rbh);
+}
+
+struct rb_node *rbh_find(const struct rbh_root *rbh,
+			 uint64_t hash,
+			 int (*compare)(const struct rb_node *node,
+					const void *arg),
+			 const void *arg)
+{
+	return rb_find(__rbh_bucket(rbh, hash), compare, arg);
+}
+
+bool rbh_visit_cond(const struct rbh_root *rbh,
+		    bool (*visit_cond)(const struct rb_node *node,
+				       const void *arg),
+		    const void *arg)
+{
+	size_t i;
+
+	for (i = 0; rbh->old && i < rbh->old_num; ++i) {
+		if (!rb_visit_cond(&rbh->old[i], visit_cond, arg))
+			return false;
+	}
+
+	for (i = 0; i < rbh->num; ++i) {
+		if (!rb_visit_cond(&rbh->buckets[i], visit_cond, arg))
+			return false;
+	}
+
+	return true;
+}
+
+#ifndef NDEBUG
+static size_t __rbh_check(const struct rbh_root *rbh,
+			  struct rb_root *rb,
+			  bool *valid)
+{
+	struct rb_node *node;
+	size_t count = 0;
+
+	if (!rb_isvalid(rb))
+		*valid = false;
+
+	for (node = rb_first(rb); node; node = rb_next(node)) {
+		struct rb_node *next = rb_next(node);
+
+		if (__rbh_bucket(rbh, rbh->hash(rbh, node)) != rb) {
+			dprintf("rbh: node %p out of its bucket\n", node);
+			*valid = false;
+		}
+		if (next && rbh->compare_link(node, next, rbh->arg) > 0) {
+			dprintf("rbh: node %p out of order\n", node);
+			*valid = false;
+		}
+		++count;
+	}
+
+	return count;
+}
+
+bool rbh_isvalid(const struct rbh_root *rbh)
+{
+	size_t i, count = 0;
+	bool valid = true;
+
+	if (rbh->num & (rbh->num - 1) || rbh->num < rbh->min) {
+		dprintf("rbh: %zu buckets\n", rbh->num);
+		return false;
+	}
+
+	for (i = 0; rbh->old && i < rbh->old_num; ++i)
+		count += __rbh_check(rbh, &rbh->old[i], &valid);
+	for (i = 0; i < rbh->num; ++i)
+		count += __rbh_check(rbh, &rbh->buckets[i], &valid);
+
+	if (count != rbh->count) {
+		dprintf("rbh: %zu nodes, counted %zu\n", rbh->count, count);
+		return false;
+	}
+
+	return valid;
+}
+#endif
+
+/* eof */
@@ -0,0 +1,123 @@
+/*
+ * rbtree-seq.c -- Red-Black Trees with lockless readers
+ *
+ * Copyright (C) 2012-2013 yanyg (cppgp@qq.com)
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING, if not see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#include <limits.h>
+#include <sched.h>
+
+#include <ycc/algos/rbtree-seq.h>
+
+/* the height of a red-black tree of n nodes is at most 2 log2(n + 1) */
+#define RB_SEQ_MAX_DEPTH	(2 * CHAR_BIT * sizeof(void*))
+
+#define __rb_seq_load(p)	__atomic_load_n(&(p), __ATOMIC_RELAXED)
+
+static inline unsigned long
+__rb_seq_read_begin(const struct rb_seq_root *root)
+{
+	unsigned long seq;
+
+	/* a writer is in, let it go on */
+	while ((seq = __atomic_load_n(&root->seq, __ATOMIC_ACQUIRE)) & 1)
+		sched_yield();
+
+	return seq;
+}
+
+static inline bool __rb_seq_read_retry(const struct rb_seq_root *root,
+				       unsigned long seq)
+{
+	/* the walk is done before the counter is read again */
+	__atomic_thread_fence(__ATOMIC_ACQUIRE);
+
+	return __atomic_load_n(&root->seq, __ATOMIC_RELAXED) != seq;
+}
+
+/*
+ * the walk of bstlink_find ('equal') or bstlink_lower_bound, the loads
+ * are single, false if the walk is too deep to be a consistent one.
+ */
+static bool __rb_seq_walk(const struct rb_seq_root *root,
+			  int (*compare)(const struct rb_node *node,
+					 const void *arg),
+			  const void *arg,
+			  bool equal,
+			  struct rb_node **result)
+{
+	struct rb_node *node = __rb_seq_load(root->rb.node), *r = NULL;
+	size_t depth = 0;
+
+	while (node) {
+		int icmp;
+
+		if (++depth > RB_SEQ_MAX_DEPTH)
+			return false;
+
+		icmp = compare(node, arg);
+		if (icmp < 0) {
+			node = __rb_seq_load(node->right);
+			continue;
+		}
+
+		if (icmp == 0 || !equal)
+			r = node;
+		else if (r)
+			break;
+		node = __rb_seq_load(node->left);
+	}
+
+	*result = r;
+	return true;
+}
+
+static struct rb_node *__rb_seq_search(const struct rb_seq_root *root,
+				       int (*compare)(const struct rb_node *node,
+						      const void *arg),
+				       const void *arg,
+				       bool equal)
+{
+	unsigned long seq;
+	struct rb_node *r;
+	bool done;
+
+	do {
+		seq = __rb_seq_read_begin(root);
+		done = __rb_seq_walk(root, compare, arg, equal, &r);
+	} while (__rb_seq_read_retry(root, seq) || !done);
+
+	return r;
+}
+
+struct rb_node *rb_seq_find(const struct rb_seq_root *root,
+			    int (*compare)(const struct rb_node *node,
+					   const void *arg),
+			    const void *arg)
+{
+	return __rb_seq_search(root, compare, arg, true);
+}
+
+struct rb_node *rb_seq_lower_bound(const struct rb_seq_root *root,
+				   int (*compare)(const struct rb_node *node,
+						  const void *arg),
+				   const void *arg)
+{
+	return __rb_seq_search(root, compare, arg, false);
+}
+
+/* eof */
@@ -0,0 +1,413 @@
+/*
+ * rbtree-shard.c -- Range-Sharded Red-Black Trees
+ *
+ * Copyright (C) 2012-2013 yanyg (cppgp@qq.com)
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING, if not see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#include <errno.h>
+#include <stdlib.h>
+
+#include <ycc/debug.h>
+#include <ycc/algos/rbtree-shard.h>
+
+/*
+ * 'lo' and 'count' of a shard change under its lock, 'lo' under the lock
+ * of the shard before too.  They are read without lock to route a key
+ * and to decide a rebalance, the lock checks again.
+ */
+#define __rbs_load(p)		__atomic_load_n(&(p), __ATOMIC_RELAXED)
+#define __rbs_store(p, v)	__atomic_store_n(&(p), (v), __ATOMIC_RELAXED)
+
+struct __rbs_arg
+{
+	unsigned long (*key)(const struct rb_node *node);
+	unsigned long val;
+};
+
+static int __rbs_compare(const struct rb_node *node, const void *arg)
+{
+	const struct __rbs_arg *a = arg;
+	unsigned long key = a->key(node);
+
+	return key < a->val ? -1 : key > a->val;
+}
+
+static int __rbs_compare_link(const struct rb_node *node1,
+			      const struct rb_node *node2,
+			      const void *arg)
+{
+	const struct rbs_root *rbs = arg;
+	unsigned long key1 = rbs->key(node1), key2 = rbs->key(node2);
+
+	return key1 < key2 ? -1 : key1 > key2;
+}
+
+/* lock and return the index of the shard of 'key' */
+static unsigned __rbs_lock(struct rbs_root *rbs, unsigned long key)
+{
+	struct rbs_shard *shards = rbs->shards;
+
+	for (;;) {
+		unsigned lo = 0, hi = rbs->num;
+
+		/* the last shard whose range begins at or before 'key' */
+		while (hi - lo > 1) {
+			unsigned mid = lo + (hi - lo) / 2;
+
+			if (__rbs_load(shards[mid].lo) <= key)
+				lo = mid;
+			else
+				hi = mid;
+		}
+
+		pthread_mutex_lock(&shards[lo].lock);
+		if (shards[lo].lo <= key &&
+		    (lo + 1 == rbs->num || key < shards[lo + 1].lo))
+			return lo;
+		/* a boundary moved meanwhile */
+		pthread_mutex_unlock(&shards[lo].lock);
+	}
+}
+
+static inline bool __rbs_unbalanced(size_t count1, size_t count2,
+				    unsigned shift)
+{
+	size_t big = count1 > count2 ? count1 : count2;
+	size_t small = count1 + count2 - big;
+
+	return big - small > (small >> shift) + RBS_BALANCE_MIN;
+}
+
+/*
+ * move nodes between shard i and i + 1 if they differ by more than
+ * (smaller >> shift), true if any moved.  Equal keys are never parted,
+ * the move is given up if it would not make the counts closer.
+ */
+static bool __rbs_balance(struct rbs_root *rbs, unsigned i, unsigned shift)
+{
+	struct rbs_shard *s1 = &rbs->shards[i], *s2 = s1 + 1;
+	struct __rbs_arg a = { rbs->key, };
+	struct rb_root moved;
+	struct rb_node *node, *prev;
+	size_t diff, m, n;
+	bool r = false;
+
+	if (!__rbs_unbalanced(__rbs_load(s1->count), __rbs_load(s2->count),
+			      shift))
+		return false;
+
+	pthread_mutex_lock(&s1->lock);
+	pthread_mutex_lock(&s2->lock);
+
+	if (!__rbs_unbalanced(s1->count, s2->count, shift))
+		goto out;
+
+	if (s1->count > s2->count) {
+		/* the top of s1 goes to s2 from the m-th last node on */
+		diff = s1->count - s2->count;
+		for (node = rb_last(&s1->rb), m = 1; m < diff / 2; ++m)
+			node = rb_prev(node);
+		a.val = rbs->key(node);
+		for (n = m, prev = rb_prev(node);
+		     prev && rbs->key(prev) == a.val; prev = rb_prev(prev))
+			++n;
+		if (n >= diff)
+			goto out;
+
+		rb_split(&s1->rb, __rbs_compare, &a, &s1->rb, &moved);
+		rb_concat(&s2->rb, &moved, &s2->rb);
+		__rbs_store(s1->count, s1->count - n);
+		__rbs_store(s2->count, s2->count + n);
+	} else {
+		/* the bottom of s2 goes to s1 up to the m-th node */
+		diff = s2->count - s1->count;
+		for (node = rb_first(&s2->rb), m = 0; m < diff / 2; ++m)
+			node = rb_next(node);
+		a.val = rbs->key(node);
+		for (n = m, prev = rb_prev(node);
+		     prev && rbs->key(prev) == a.val; prev = rb_prev(prev))
+			--n;
+		if (!n)
+			goto out;
+
+		rb_split(&s2->rb, __rbs_compare, &a, &moved, &s2->rb);
+		rb_concat(&s1->rb, &s1->rb, &moved);
+		__rbs_store(s1->count, s1->count + n);
+		__rbs_store(s2->count, s2->count - n);
+	}
+	__rbs_store(s2->lo, a.val);
+	r = true;
+
+out:
+	pthread_mutex_unlock(&s2->lock);
+	pthread_mutex_unlock(&s1->lock);
+
+	return r;
+}
+
+/* shard i has grown, the nodes it hands over may overload the next */
+static void __rbs_grown(struct rbs_root *rbs, unsigned i, size_t count)
+{
+	unsigned j;
+
+	if (count < RBS_BALANCE_MIN)
+		return;
+
+	for (j = i; j + 1 < rbs->num && __rbs_balance(rbs, j, 0); ++j)
+		;
+	if (j == i) {
+		for (; j > 0 && __rbs_balance(rbs, j - 1, 0); --j)
+			;
+	}
+}
+
+int rbs_init(struct rbs_root *rbs,
+	     unsigned num,
+	     unsigned long (*key)(const struct rb_node *node),
+	     unsigned long lo,
+	     unsigned long hi)
+{
+	unsigned long step;
+	unsigned i;
+	void *p;
+
+	if (!num || lo > hi) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	if (posix_memalign(&p, sizeof(struct rbs_shard),
+			   num * sizeof(struct rbs_shard))) {
+		errno = ENOMEM;
+		return -1;
+	}
+
+	rbs->shards = p;
+	rbs->num = num;
+	rbs->key = key;
+
+	step = (hi - lo) / num;
+	for (i = 0; i < num; ++i) {
+		struct rbs_shard *s = &rbs->shards[i];
+
+		pthread_mutex_init(&s->lock, NULL);
+		rb_init(&s->rb);
+		s->count = 0;
+		s->lo = i ? lo + step * i : 0;
+	}
+
+	return 0;
+}
+
+void rbs_destroy(struct rbs_root *rbs,
+		 void (*destroy)(struct rb_node *node, const void *arg),
+		 const void *arg)
+{
+	unsigned i;
+
+	for (i = 0; i < rbs->num; ++i) {
+		struct rbs_shard *s = &rbs->shards[i];
+
+		if (destroy)
+			rb_clear(&s->rb, destroy, arg);
+		pthread_mutex_destroy(&s->lock);
+	}
+
+	free(rbs->shards);
+	rbs->shards = NULL;
+	rbs->num = 0;
+}
+
+void rbs_insert(struct rbs_root *rbs, struct rb_node *node)
+{
+	unsigned i = __rbs_lock(rbs, rbs->key(node));
+	struct rbs_shard *s = &rbs->shards[i];
+	size_t count = s->count + 1;
+
+	rb_insert(node, &s->rb, __rbs_compare_link, rbs);
+	__rbs_store(s->count, count);
+	pthread_mutex_unlock(&s->lock);
+
+	__rbs_grown(rbs, i, count);
+}
+
+bool rbs_insert_unique(struct rbs_root *rbs, struct rb_node *node)
+{
+	unsigned i = __rbs_lock(rbs, rbs->key(node));
+	struct rbs_shard *s = &rbs->shards[i];
+	size_t count = s->count;
+	bool r;
+
+	r = rb_insert_unique(node, &s->rb, __rbs_compare_link, rbs);
+	if (r)
+		__rbs_store(s->count, ++count);
+	pthread_mutex_unlock(&s->lock);
+
+	if (r)
+		__rbs_grown(rbs, i, count);
+
+	return r;
+}
+
+struct rb_node *rbs_find(struct rbs_root *rbs, unsigned long key)
+{
+	struct __rbs_arg a = { rbs->key, key };
+	struct rbs_shard *s = &rbs->shards[__rbs_lock(rbs, key)];
+	struct rb_node *node;
+
+	node = rb_find(&s->rb, __rbs_compare, &a);
+	pthread_mutex_unlock(&s->lock);
+
+	return node;
+}
+
+void rbs_erase(struct rbs_root *rbs, struct rb_node *node)
+{
+	struct rbs_shard *s = &rbs->shards[__rbs_lock(rbs, rbs->key(node))];
+
+	rb_erase(node, &s->rb);
+	__rbs_store(s->count, s->count - 1);
+	pthread_mutex_unlock(&s->lock);
+}
+
+struct rb_node *rbs_erase_key(struct rbs_root *rbs, unsigned long key)
+{
+	struct __rbs_arg a = { rbs->key, key };
+	struct rbs_shard *s = &rbs->shards[__rbs_lock(rbs, key)];
+	struct rb_node *node;
+
+	node = rb_find(&s->rb, __rbs_compare, &a);
+	if (node) {
+		rb_erase(node, &s->rb);
+		__rbs_store(s->count, s->count - 1);
+	}
+	pthread_mutex_unlock(&s->lock);
+
+	return node;
+}
+
+bool rbs_scan(struct rbs_root *rbs,
+	      unsigned long lo,
+	      unsigned long hi,
+	      bool (*visit_cond)(const struct rb_node *node, const void *arg),
+	      const void *arg)
+{
+	struct __rbs_arg a = { rbs->key, lo };
+
+	while (a.val <= hi) {
+		unsigned i = __rbs_lock(rbs, a.val);
+		struct rbs_shard *s = &rbs->shards[i];
+		struct rb_node *node;
+
+		for (node = rb_lower_bound(&s->rb, __rbs_compare, &a);
+		     node && rbs->key(node) <= hi; node = rb_next(node)) {
+			if (!visit_cond(node, arg)) {
+				pthread_mutex_unlock(&s->lock);
+				return false;
+			}
+		}
+
+		if (i + 1 == rbs->num) {
+			pthread_mutex_unlock(&s->lock);
+			break;
+		}
+
+		/*
+		 * go on from the end seen under the lock, the keys below it
+		 * are visited even if they move to the next shard now
+		 */
+		a.val = s[1].lo;
+		pthread_mutex_unlock(&s->lock);
+	}
+
+	return true;
+}
+
+size_t rbs_count(const struct rbs_root *rbs)
+{
+	size_t count = 0;
+	unsigned i;
+
+	for (i = 0; i < rbs->num; ++i)
+		count += __rbs_load(rbs->shards[i].count);
+
+	return count;
+}
+
+void rbs_rebalance(struct rbs_root *rbs)
+{
+	unsigned i, pass;
+	bool moved = true;
+
+	/* a move brings two counts closer, the passes are bounded anyway */
+	for (pass = 0; moved && pass < rbs->num; ++pass) {
+		moved = false;
+		for (i = 0; i + 1 < rbs->num; ++i)
+			moved |= __rbs_balance(rbs, i, 2);
+	}
+}
+
+#ifndef NDEBUG
+bool rbs_isvalid(struct rbs_root *rbs)
+{
+	unsigned i;
+
+	if (!rbs->num || rbs->shards[0].lo) {
+		dprintf("rbs: %u shards, the first begins at %lu\n",
+			rbs->num, rbs->num ? rbs->shards[0].lo : 0);
+		return false;
+	}
+
+	for (i = 0; i < rbs->num; ++i) {
+		struct rbs_shard *s = &rbs->shards[i];
+		struct rb_node *node;
+		unsigned long key, prev = s->lo;
+		size_t count = 0;
+
+		if (i + 1 < rbs->num && s->lo > s[1].lo) {
+			dprintf("rbs: shard %u begins at %lu, the next at %lu\n",
+				i, s->lo, s[1].lo);
+			return false;
+		}
+
+		if (!rb_isvalid(&s->rb))
+			return false;
+
+		for (node = rb_first(&s->rb); node; node = rb_next(node)) {
+			key = rbs->key(node);
+			if (key < prev ||
+			    (i + 1 < rbs->num && key >= s[1].lo)) {
+				dprintf("rbs: key %lu out of shard %u\n",
+					key, i);
+				return false;
+			}
+			prev = key;
+			++count;
+		}
+
+		if (count != s->count) {
+			dprintf("rbs: shard %u has %zu nodes, counted %zu\n",
+				i, s->count, count);
+			return false;
+		}
+	}
+
+	return true;
+}
+#endif
+
+/* eof */
@@ -18,12 +18,46 @@
  * <http://www.gnu.org/licenses/>.
  */
 
+#include <pthread.h>
+#include <stdlib.h>
+
 #include <ycc/algos/rbtree.h>
 
-void rb_insert_rebalance(struct rb_node *node, struct rb_root *rb)
+#include "bstree-join.h"
+
+/* 'once' rotates by single stores, rb_seq has no augment */
+static inline void
+__rb_rotate_left(struct rb_node *node,
+		 struct rb_node **proot,
+		 const struct rb_augment_callbacks *augment,
+		 bool once)
+{
+	if (once)
+		__BSTLINK_ROTATE_LEFT_ONCE(node, proot);
+	else
+		__BSTLINK_ROTATE_LEFT_AUGMENT(node, proot, augment);
+}
+
+static inline void
+__rb_rotate_right(struct rb_node *node,
+		  struct rb_node **proot,
+		  const struct rb_augment_callbacks *augment,
+		  bool once)
+{
+	if (once)
+		__BSTLINK_ROTATE_RIGHT_ONCE(node, proot);
+	else
+		__BSTLINK_ROTATE_RIGHT_AUGMENT(node, proot, augment);
+}
+
+/* the root is left as is, it may be RED on return */
+static inline void
+__rb_insert_fixup(struct rb_node *node,
+		  struct rb_node **proot,
+		  const struct rb_augment_callbacks *augment,
+		  bool once)
 {
 	struct rb_node *parent, *gparent;
-	struct rb_node ** const proot = &rb->node;
 
 	/*
 	 * condition
@@ -31,8 +65,8 @@ void rb_insert_rebalance(struct rb_node *node, struct rb_root *rb)
 	 */
 
 	/* do rebalance */
-	while ((parent=node->parent) && rb_is_red(parent)) {
-		gparent = parent->parent;
+	while ((parent=rb_parent(node)) && rb_is_red(parent)) {
+		gparent = rb_parent(parent);
 		if (parent == gparent->left) {
 			register struct rb_node *uncle = gparent->right;
 
@@ -45,15 +79,15 @@ void rb_insert_rebalance(struct rb_node *node, struct rb_root *rb)
 			}
 
 			if (node == parent->right) {
-				__BSTLINK_ROTATE_LEFT(parent, proot);
+				__rb_rotate_left(parent, proot, augment, once);
 				node = parent;
 				/* parent had been changed, need reset */
-				parent = node->parent;	
+				parent = rb_parent(node);	
 			}
 
 			rb_set_black(parent);
 			rb_set_red(gparent);
-			__BSTLINK_ROTATE_RIGHT(gparent, proot);
+			__rb_rotate_right(gparent, proot, augment, once);
 		} else {
 			register struct rb_node *uncle = gparent->left;
 
@@ -66,24 +100,48 @@ void rb_insert_rebalance(struct rb_node *node, struct rb_root *rb)
 			}
 
 			if (node == parent->left) {
-				__BSTLINK_ROTATE_RIGHT(parent, proot);
+				__rb_rotate_right(parent, proot, augment, once);
 				node = parent;
-				parent = node->parent;
+				parent = rb_parent(node);
 			}
 
 			rb_set_black(parent);
 			rb_set_red(gparent);
-			__BSTLINK_ROTATE_LEFT(gparent, proot);
+			__rb_rotate_left(gparent, proot, augment, once);
 		}
 	}
+}
 
-	rb_set_black(*proot);
+void rb_insert_rebalance(struct rb_node *node, struct rb_root *rb)
+{
+	__rb_insert_fixup(node, &rb->node, NULL, false);
+	rb_set_black(rb->node);
+}
+
+void rb_insert_rebalance_once(struct rb_node *node, struct rb_root *rb)
+{
+	__rb_insert_fixup(node, &rb->node, NULL, true);
+	rb_set_black(rb->node);
+}
+
+void rb_insert_augmented(struct rb_node *node,
+			 struct rb_root *rb,
+			 const struct rb_augment_callbacks *augment)
+{
+	struct rb_node *parent = rb_parent(node);
+
+	if (parent)
+		augment->propagate(parent, NULL);
+	__rb_insert_fixup(node, &rb->node, augment, false);
+	rb_set_black(rb->node);
 }
 
 static inline void
 __rb_erase_rebalance(struct rb_node *node,
 		     struct rb_node *parent,
-		     struct rb_node **proot)
+		     struct rb_node **proot,
+		     const struct rb_augment_callbacks *augment,
+		     bool once)
 {
 	struct rb_node *other;
 
@@ -100,7 +158,7 @@ __rb_erase_rebalance(struct rb_node *node,
 			if (rb_is_red(other)) {
 				rb_set_black(other);
 				rb_set_red(parent);
-				__BSTLINK_ROTATE_LEFT(parent, proot);
+				__rb_rotate_left(parent, proot, augment, once);
 				other = parent->right;
 			}
 
@@ -108,20 +166,21 @@ __rb_erase_rebalance(struct rb_node *node,
 			    (!other->right || rb_is_black(other->right))) {
 				rb_set_red(other);
 				node = parent;
-				parent = node->parent;
+				parent = rb_parent(node);
 			} else {
 				if (!other->right ||
 				    rb_is_black(other->right)) {
 					rb_set_black(other->left);
 					rb_set_red(other);
-					__BSTLINK_ROTATE_RIGHT(other, proot);
+					__rb_rotate_right(other, proot,
+							  augment, once);
 					other = parent->right;
 				}
 				rb_set_color(other, rb_color(parent));
 				rb_set_black(parent);
 				/* now other->right cannot be null */
 				rb_set_black(other->right);
-				__BSTLINK_ROTATE_LEFT(parent, proot);
+				__rb_rotate_left(parent, proot, augment, once);
 				break;
 			}
 		} else {
@@ -129,7 +188,7 @@ __rb_erase_rebalance(struct rb_node *node,
 			if (rb_is_red(other)) {
 				rb_set_black(other);
 				rb_set_red(parent);
-				__BSTLINK_ROTATE_RIGHT(parent, proot);
+				__rb_rotate_right(parent, proot, augment, once);
 				other = parent->left;
 			}
 
@@ -137,18 +196,19 @@ __rb_erase_rebalance(struct rb_node *node,
 			    (!other->right || rb_is_black(other->right))) {
 				rb_set_red(other);
 				node = parent;
-				parent = node->parent;
+				parent = rb_parent(node);
 			} else {
 				if (!other->left || rb_is_black(other->left)) {
 					rb_set_black(other->right);
 					rb_set_red(other);
-					__BSTLINK_ROTATE_LEFT(other, proot);
+					__rb_rotate_left(other, proot,
+							 augment, once);
 					other = parent->left;
 				}
 				rb_set_color(other, rb_color(parent));
 				rb_set_black(parent);
 				rb_set_black(other->left);
-				__BSTLINK_ROTATE_RIGHT(parent, proot);
+				__rb_rotate_right(parent, proot, augment, once);
 				break;
 			}
 		}
@@ -168,9 +228,11 @@ __rb_erase_rebalance(struct rb_node *node,
 		color = rb_color(scor);				\
 		rb_set_color(scor, rb_color(node));		\
 	} while(0)
-#define __BSTLINK_ERASE_SPECIALIZE_DO(child, parent, proot)	\
+#define __BSTLINK_ERASE_SPECIALIZE_DO(child, parent, proot,		\
+				      augment, once)			\
 	if (color == RB_COLOR_BLACK)				\
-		__rb_erase_rebalance(child, parent, proot);
+		__rb_erase_rebalance(child, parent, proot,	\
+			(const struct rb_augment_callbacks*)augment, once);
 
 #include "bstree-internal.h"
 void rb_erase(struct rb_node *node, struct rb_root *rb)
@@ -178,15 +240,798 @@ void rb_erase(struct rb_node *node, struct rb_root *rb)
 	__BSTLINK_ERASE(node, &rb->node);
 }
 
-#ifndef NDEBUG
-static bool __rb_isvalid(struct rb_node *root)
+void rb_erase_once(struct rb_node *node, struct rb_root *rb)
+{
+	__BSTLINK_ERASE_ONCE(node, &rb->node);
+}
+
+void rb_erase_augmented(struct rb_node *node,
+			struct rb_root *rb,
+			const struct rb_augment_callbacks *augment)
+{
+	__BSTLINK_ERASE_AUGMENT(node, &rb->node, augment);
+}
+
+/* black-height of the subtree 'node', the null link counts 0 */
+static size_t __rb_black_height(const struct rb_node *node)
+{
+	size_t bh = 0;
+
+	for (; node; node = node->left)
+		bh += rb_is_black(node);
+
+	return bh;
+}
+
+/*
+ * __rb_join  --  join 'left', 'pivot' and 'right'
+ *
+ * 'left' and 'right' are detached subtrees (parent is NULL) with
+ * black-heights 'bhl' and 'bhr', their roots may be RED.  It costs
+ * O(|bhl - bhr| + 1), the black-height of the result is in '*pbh'.
+ */
+static struct rb_node *__rb_join(struct rb_node *left, size_t bhl,
+				 struct rb_node *pivot,
+				 struct rb_node *right, size_t bhr,
+				 size_t *pbh)
+{
+	struct rb_node *root, *parent, *child;
+	size_t bh;
+
+	if (left && rb_is_red(left)) {
+		rb_set_black(left);
+		++bhl;
+	}
+	if (right && rb_is_red(right)) {
+		rb_set_black(right);
+		++bhr;
+	}
+
+	if (bhl == bhr) {
+		rb_set_parent(pivot, NULL);
+		pivot->left = left;
+		pivot->right = right;
+		if (left)
+			rb_set_parent(left, pivot);
+		if (right)
+			rb_set_parent(right, pivot);
+		__BSTLINK_SIZE_FIXUP(pivot);
+		rb_set_black(pivot);
+		*pbh = bhl + 1;
+		return pivot;
+	}
+
+	/*
+	 * Walk down the right spine of the higher 'left' (or the left
+	 * spine of the higher 'right') to a black node whose black-height
+	 * equals the lower tree, and hang 'pivot' there as a RED node.
+	 */
+	parent = NULL;
+	if (bhl > bhr) {
+		root = child = left;
+		bh = bhl;
+		while (child && (rb_is_red(child) || bh > bhr)) {
+			bh -= rb_is_black(child);
+			parent = child;
+			child = child->right;
+		}
+		pivot->left = child;
+		pivot->right = right;
+		parent->right = pivot;
+		if (right)
+			rb_set_parent(right, pivot);
+		*pbh = bhl;
+	} else {
+		root = child = right;
+		bh = bhr;
+		while (child && (rb_is_red(child) || bh > bhl)) {
+			bh -= rb_is_black(child);
+			parent = child;
+			child = child->left;
+		}
+		pivot->left = left;
+		pivot->right = child;
+		parent->left = pivot;
+		if (left)
+			rb_set_parent(left, pivot);
+		*pbh = bhr;
+	}
+
+	if (child)
+		rb_set_parent(child, pivot);
+	rb_set_parent(pivot, parent);
+	rb_set_red(pivot);
+	__BSTLINK_SIZE_FIXUP(pivot);
+
+	__rb_insert_fixup(pivot, &root, NULL, false);
+	if (rb_is_red(root)) {
+		rb_set_black(root);
+		++*pbh;
+	}
+
+	return root;
+}
+
+/* split the detached subtree 'node' into '< arg' and '>= arg' */
+static void __rb_split(struct rb_node *node, size_t bh,
+		       bstlink_compare_t compare, const void *arg,
+		       struct rb_node **pleft, size_t *pbhl,
+		       struct rb_node **pright, size_t *pbhr)
+{
+	struct rb_node *left, *right, *sub;
+	size_t bhc, bhs;
+
+	if (!node) {
+		*pleft = *pright = NULL;
+		*pbhl = *pbhr = 0;
+		return;
+	}
+
+	left = node->left;
+	right = node->right;
+	if (left)
+		rb_set_parent(left, NULL);
+	if (right)
+		rb_set_parent(right, NULL);
+
+	/* both children have the same black-height */
+	bhc = bh - rb_is_black(node);
+
+	if (compare((struct bst_link*)node, arg) < 0) {
+		__rb_split(right, bhc, compare, arg, &sub, &bhs, pright, pbhr);
+		*pleft = __rb_join(left, bhc, node, sub, bhs, pbhl);
+	} else {
+		__rb_split(left, bhc, compare, arg, pleft, pbhl, &sub, &bhs);
+		*pright = __rb_join(sub, bhs, node, right, bhc, pbhr);
+	}
+}
+
+void rb_split(struct rb_root *rb,
+	      int (*compare)(const struct rb_node *node, const void *arg),
+	      const void *arg,
+	      struct rb_root *left,
+	      struct rb_root *right)
+{
+	struct rb_node *node = rb->node;
+	struct rb_node *l, *r;
+	size_t bhl, bhr;
+
+	rb->node = NULL;
+	__rb_split(node, __rb_black_height(node),
+		   (bstlink_compare_t)compare, arg, &l, &bhl, &r, &bhr);
+
+	if (l)
+		rb_set_black(l);
+	if (r)
+		rb_set_black(r);
+	left->node = l;
+	right->node = r;
+}
+
+void rb_join(struct rb_root *rb,
+	     struct rb_root *left,
+	     struct rb_node *pivot,
+	     struct rb_root *right)
+{
+	struct rb_node *l = left->node, *r = right->node;
+	size_t bh;
+
+	left->node = right->node = NULL;
+	rb->node = __rb_join(l, __rb_black_height(l), pivot,
+			     r, __rb_black_height(r), &bh);
+}
+
+static struct rb_node *__rb_concat(struct rb_node *left, size_t bhl,
+				   struct rb_node *right, size_t bhr,
+				   size_t *pbh)
+{
+	struct rb_root tmp = { right };
+	struct rb_node *pivot;
+
+	if (!left || !right) {
+		*pbh = left ? bhl : bhr;
+		return left ? left : right;
+	}
+
+	/* the first node of 'right' becomes the pivot */
+	rb_set_black(right);
+	pivot = rb_first(&tmp);
+	rb_erase(pivot, &tmp);
+
+	return __rb_join(left, bhl, pivot,
+			 tmp.node, __rb_black_height(tmp.node), pbh);
+}
+
+void rb_concat(struct rb_root *rb, struct rb_root *left, struct rb_root *right)
+{
+	struct rb_node *l = left->node, *r = right->node;
+	size_t bh;
+
+	left->node = right->node = NULL;
+	rb->node = __rb_concat(l, __rb_black_height(l),
+			       r, __rb_black_height(r), &bh);
+	if (rb->node)
+		rb_set_black(rb->node);
+}
+
+/*
+ * Split the tree of 'pos' into the nodes before 'pos' and the others,
+ * bottom-up: every ancestor goes with its other subtree to the side it
+ * orders on.  The black-heights of the joined trees only grow up the
+ * path, so the joins cost O(log n) all together.
+ */
+static void __rb_split_at(struct rb_node *pos,
+			  struct rb_node **pleft, size_t *pbhl,
+			  struct rb_node **pright, size_t *pbhr)
+{
+	struct rb_node *node = pos, *parent = rb_parent(pos);
+	struct rb_node *left = pos->left, *right = pos->right, *sibling;
+	size_t bh = __rb_black_height(pos) - rb_is_black(pos);
+	size_t bhl = bh, bhr;
+	bool black = rb_is_black(pos);
+
+	if (left)
+		rb_set_parent(left, NULL);
+	if (right)
+		rb_set_parent(right, NULL);
+	right = __rb_join(NULL, 0, pos, right, bh, &bhr);
+
+	/* 'bh' is the black-height of both children of 'parent' */
+	for (bh += black; parent; node = pos, bh += black) {
+		pos = parent;
+		parent = rb_parent(pos);
+		black = rb_is_black(pos);
+		if (node == pos->left) {
+			if ((sibling = pos->right))
+				rb_set_parent(sibling, NULL);
+			right = __rb_join(right, bhr, pos, sibling, bh, &bhr);
+		} else {
+			if ((sibling = pos->left))
+				rb_set_parent(sibling, NULL);
+			left = __rb_join(sibling, bh, pos, left, bhl, &bhl);
+		}
+	}
+
+	*pleft = left;
+	*pbhl = bhl;
+	*pright = right;
+	*pbhr = bhr;
+}
+
+void rb_detach_range(struct rb_node *beg,
+		     struct rb_node *end,
+		     struct rb_root *rb,
+		     struct rb_root *range)
+{
+	struct rb_node *l, *m, *r = NULL;
+	size_t bhl, bhm, bhr = 0, bh;
+
+	range->node = NULL;
+	if (beg == end)
+		return;
+
+	/* 'end' orders after 'beg', it is in 'm' */
+	__rb_split_at(beg, &l, &bhl, &m, &bhm);
+	if (end)
+		__rb_split_at(end, &m, &bhm, &r, &bhr);
+
+	rb->node = __rb_concat(l, bhl, r, bhr, &bh);
+	if (rb->node)
+		rb_set_black(rb->node);
+	if (m)
+		rb_set_black(m);
+	range->node = m;
+}
+
+void rb_erase_range(struct rb_node *beg,
+		    struct rb_node *end,
+		    struct rb_root *rb)
+{
+	struct rb_root range;
+
+	rb_detach_range(beg, end, rb, &range);
+}
+
+void rb_erase_equal(struct rb_root *rb,
+		    int (*compare)(const struct rb_node *node,
+				   const void *arg),
+		    void (*destroy)(struct rb_node *node, const void *arg),
+		    const void *arg_compare,
+		    const void *arg_destroy)
+{
+	struct rb_node *lower, *upper;
+	struct rb_root range;
+
+	rb_lower_upper_bound(rb, compare, arg_compare, &lower, &upper);
+	rb_detach_range(lower, upper, rb, &range);
+	rb_clear(&range, destroy, arg_destroy);
+}
+
+/* join ops, see bstree-join.h */
+static struct __bst_tree __rb_tree_make(struct bst_link *link)
 {
+	struct __bst_tree tree = { link, __rb_black_height((void*)link) };
+
+	return tree;
+}
+
+static void __rb_tree_expose(struct __bst_tree tree,
+			     struct __bst_tree *left,
+			     struct __bst_tree *right)
+{
+	struct bst_link *link = tree.link;
+
+	left->link = link->left;
+	right->link = link->right;
+	left->aux = right->aux = tree.aux - rb_is_black((struct rb_node*)link);
+
+	if (link->left)
+		bstlink_set_parent(link->left, NULL);
+	if (link->right)
+		bstlink_set_parent(link->right, NULL);
+}
+
+static void __rb_tree_split(struct __bst_tree tree,
+			    bstlink_compare_t compare,
+			    const void *arg,
+			    struct __bst_tree *left,
+			    struct __bst_tree *right)
+{
+	__rb_split((struct rb_node*)tree.link, tree.aux, compare, arg,
+		   (struct rb_node**)&left->link, &left->aux,
+		   (struct rb_node**)&right->link, &right->aux);
+}
+
+static struct __bst_tree __rb_tree_join(struct __bst_tree left,
+					struct bst_link *pivot,
+					struct __bst_tree right)
+{
+	struct __bst_tree tree;
+
+	tree.link = (struct bst_link*)
+		    __rb_join((struct rb_node*)left.link, left.aux,
+			      (struct rb_node*)pivot,
+			      (struct rb_node*)right.link, right.aux,
+			      &tree.aux);
+
+	return tree;
+}
+
+static struct __bst_tree __rb_tree_concat(struct __bst_tree left,
+					  struct __bst_tree right)
+{
+	struct __bst_tree tree;
+
+	tree.link = (struct bst_link*)
+		    __rb_concat((struct rb_node*)left.link, left.aux,
+				(struct rb_node*)right.link, right.aux,
+				&tree.aux);
+
+	return tree;
+}
+
+const struct __bst_join_ops __rb_join_ops = {
+	.make	= __rb_tree_make,
+	.expose	= __rb_tree_expose,
+	.split	= __rb_tree_split,
+	.join	= __rb_tree_join,
+	.concat	= __rb_tree_concat,
+};
+
+static void
+__rb_setop(enum __bst_setop op,
+	   struct rb_root *rb,
+	   struct rb_root *rb1,
+	   struct rb_root *rb2,
+	   int (*compare_link)(const struct rb_node *node1,
+			       const struct rb_node *node2,
+			       const void *arg),
+	   void (*destroy)(struct rb_node *node, const void *arg),
+	   const void *arg_compare,
+	   const void *arg_destroy,
+	   unsigned nthreads)
+{
+	struct bst_link *link1 = (struct bst_link*)rb1->node;
+	struct bst_link *link2 = (struct bst_link*)rb2->node;
+
+	rb1->node = rb2->node = NULL;
+	rb->node = (struct rb_node*)
+		   __bst_setop(&__rb_join_ops, op, link1, link2,
+			       (bstlink_compare_link_t)compare_link,
+			       (bstlink_destroy_t)destroy,
+			       arg_compare, arg_destroy, nthreads);
+	if (rb->node)
+		rb_set_black(rb->node);
+}
+
+void rb_union(struct rb_root *rb,
+	      struct rb_root *rb1,
+	      struct rb_root *rb2,
+	      int (*compare_link)(const struct rb_node *node1,
+				  const struct rb_node *node2,
+				  const void *arg),
+	      void (*destroy)(struct rb_node *node, const void *arg),
+	      const void *arg_compare,
+	      const void *arg_destroy,
+	      unsigned nthreads)
+{
+	__rb_setop(__BST_SETOP_UNION, rb, rb1, rb2, compare_link, destroy,
+		   arg_compare, arg_destroy, nthreads);
+}
+
+void rb_intersection(struct rb_root *rb,
+		     struct rb_root *rb1,
+		     struct rb_root *rb2,
+		     int (*compare_link)(const struct rb_node *node1,
+					 const struct rb_node *node2,
+					 const void *arg),
+		     void (*destroy)(struct rb_node *node, const void *arg),
+		     const void *arg_compare,
+		     const void *arg_destroy,
+		     unsigned nthreads)
+{
+	__rb_setop(__BST_SETOP_INTERSECTION, rb, rb1, rb2, compare_link,
+		   destroy, arg_compare, arg_destroy, nthreads);
+}
+
+void rb_difference(struct rb_root *rb,
+		   struct rb_root *rb1,
+		   struct rb_root *rb2,
+		   int (*compare_link)(const struct rb_node *node1,
+				       const struct rb_node *node2,
+				       const void *arg),
+		   void (*destroy)(struct rb_node *node, const void *arg),
+		   const void *arg_compare,
+		   const void *arg_destroy,
+		   unsigned nthreads)
+{
+	__rb_setop(__BST_SETOP_DIFFERENCE, rb, rb1, rb2, compare_link,
+		   destroy, arg_compare, arg_destroy, nthreads);
+}
+
+static void __rb_build(struct rb_node *node,
+		       size_t depth,
+		       size_t height,
+		       const void *arg)
+{
+	/*
+	 * All null links lie on the last two levels, so painting the
+	 * non-root nodes of the last level red balances black-heights.
+	 */
+	if (depth && depth + 1 == *(const size_t*)arg)
+		rb_set_red(node);
+	else
+		rb_set_black(node);
+}
+
+void rb_build_sorted(struct rb_root *rb, struct rb_node **nodes, size_t num)
+{
+	size_t levels = bstlink_build_height(num);
+
+	rb->node = __BSTLINK_BUILD_SORTED(nodes, num, __rb_build, &levels,
+					  struct rb_node);
+}
+
+struct rb_root *rb_alloc(size_t num)
+{
+	struct rb_root *rb = malloc(num * sizeof(*rb));
+	size_t i;
+
+	for (i = 0; rb && i < num; ++i)
+		rb_init(&rb[i]);
+
+	return rb;
+}
+
+void rb_free(struct rb_root *rb,
+	     size_t num,
+	     void (*destroy)(struct rb_node *rb, const void *arg),
+	     const void *arg)
+{
+	size_t i;
+
+	for (i = 0; destroy && i < num; ++i)
+		rb_clear(&rb[i], destroy, arg);
+
+	free(rb);
+}
+
+struct __rb_clone_ctx
+{
+	struct rb_node *(*node_clone)(const struct rb_node *node,
+				      const void *arg);
+	void (*node_destroy)(struct rb_node *node, const void *arg);
+	const void *arg_clone;
+	const void *arg_destroy;
+	unsigned fork_depth;
+};
+
+struct __rb_clone_task
+{
+	const struct __rb_clone_ctx *ctx;
+	const struct rb_node *src;
+	struct rb_node *node;
+	unsigned depth;
+	bool ok;
+};
+
+/* a clone of 'src' with its color and size but no link */
+static struct rb_node *__rb_clone_node(const struct __rb_clone_ctx *ctx,
+				       const struct rb_node *src)
+{
+	struct rb_node *node = ctx->node_clone(src, ctx->arg_clone);
+
+	if (node) {
+		rb_set_parent(node, NULL);
+		rb_set_color(node, rb_color(src));
+		node->left = node->right = NULL;
+#ifdef	BSTLINK_SIZE
+		node->size = src->size;
+#endif
+	}
+
+	return node;
+}
+
+static void __rb_clone_destroy(const struct __rb_clone_ctx *ctx,
+			       struct rb_node *node)
+{
+	if (ctx->node_destroy)
+		__BSTLINK_DESTROY(node, ctx->node_destroy, ctx->arg_destroy);
+}
+
+/*
+ * clone the subtree 'src' in its shape without recursion: the source
+ * and the clone are walked in step, the parent links of the clone lead
+ * back up.  On failure the nodes cloned so far are destroyed.
+ */
+static bool __rb_clone_serial(const struct __rb_clone_ctx *ctx,
+			      const struct rb_node *src,
+			      struct rb_node **pnode)
+{
+	const struct rb_node *s = src;
+	struct rb_node *root, *node, *child;
+
+	*pnode = NULL;
+	if (!src)
+		return true;
+
+	if (!(root = node = __rb_clone_node(ctx, src)))
+		return false;
+
+	for (;;) {
+		if (s->left && !node->left) {
+			if (!(child = __rb_clone_node(ctx, s->left)))
+				goto fail;
+			rb_set_parent(child, node);
+			node->left = child;
+			s = s->left;
+		} else if (s->right && !node->right) {
+			if (!(child = __rb_clone_node(ctx, s->right)))
+				goto fail;
+			rb_set_parent(child, node);
+			node->right = child;
+			s = s->right;
+		} else if (s != src) {
+			s = rb_parent(s);
+			child = rb_parent(node);
+		} else {
+			break;
+		}
+		node = child;
+	}
+
+	*pnode = root;
 	return true;
+
+fail:
+	__rb_clone_destroy(ctx, root);
+	return false;
+}
+
+static void __rb_clone_run(struct __rb_clone_task *task);
+
+static void *__rb_clone_thread(void *arg)
+{
+	__rb_clone_run(arg);
+
+	return NULL;
+}
+
+/* the left subtree goes to a new thread, the right one stays here */
+static void __rb_clone_run(struct __rb_clone_task *task)
+{
+	const struct __rb_clone_ctx *ctx = task->ctx;
+	const struct rb_node *src = task->src;
+	struct __rb_clone_task left, right;
+	struct rb_node *node;
+	bool forked = false;
+	pthread_t tid;
+
+	if (!__bst_should_fork((const struct bst_link*)src, task->depth,
+			       ctx->fork_depth)) {
+		task->ok = __rb_clone_serial(ctx, src, &task->node);
+		return;
+	}
+
+	left.ctx = right.ctx = ctx;
+	left.src = src->left;
+	right.src = src->right;
+	left.depth = right.depth = task->depth + 1;
+
+	if (!pthread_create(&tid, NULL, __rb_clone_thread, &left))
+		forked = true;
+	else
+		__rb_clone_run(&left);
+	__rb_clone_run(&right);
+	node = __rb_clone_node(ctx, src);
+	if (forked)
+		pthread_join(tid, NULL);
+
+	if (!node || !left.ok || !right.ok) {
+		__rb_clone_destroy(ctx, left.node);
+		__rb_clone_destroy(ctx, right.node);
+		__rb_clone_destroy(ctx, node);
+		task->node = NULL;
+		task->ok = false;
+		return;
+	}
+
+	if ((node->left = left.node))
+		rb_set_parent(left.node, node);
+	if ((node->right = right.node))
+		rb_set_parent(right.node, node);
+	task->node = node;
+	task->ok = true;
+}
+
+static bool __rb_clone(struct rb_root *rb,
+		       const struct rb_root *rb_src,
+		       struct rb_node *(*node_clone)(const struct rb_node *node,
+						     const void *arg),
+		       void (*node_destroy)(struct rb_node *node,
+					    const void *arg),
+		       const void *arg_clone,
+		       const void *arg_destroy,
+		       unsigned nthreads)
+{
+	struct __rb_clone_ctx ctx;
+	struct __rb_clone_task task;
+
+	ctx.node_clone = node_clone;
+	ctx.node_destroy = node_destroy;
+	ctx.arg_clone = arg_clone;
+	ctx.arg_destroy = arg_destroy;
+	ctx.fork_depth = __bst_fork_depth(nthreads);
+
+	task.ctx = &ctx;
+	task.src = rb_src->node;
+	task.depth = 0;
+	__rb_clone_run(&task);
+	if (!task.ok)
+		return false;
+
+	rb->node = task.node;
+	return true;
+}
+
+bool rb_clone(struct rb_root *rb,
+	      const struct rb_root *rb_src,
+	      struct rb_node *(*node_clone)(const struct rb_node *node,
+					    const void *arg),
+	      void (*node_destroy)(struct rb_node *node, const void *arg),
+	      const void *arg_clone,
+	      const void *arg_destroy)
+{
+	return __rb_clone(rb, rb_src, node_clone, node_destroy,
+			  arg_clone, arg_destroy, 1);
+}
+
+bool rb_clone_parallel(struct rb_root *rb,
+		       const struct rb_root *rb_src,
+		       struct rb_node *(*node_clone)(const struct rb_node *node,
+						     const void *arg),
+		       void (*node_destroy)(struct rb_node *node,
+					    const void *arg),
+		       const void *arg_clone,
+		       const void *arg_destroy,
+		       unsigned nthreads)
+{
+	return __rb_clone(rb, rb_src, node_clone, node_destroy,
+			  arg_clone, arg_destroy, nthreads);
+}
+
+/* a range has no shape to mirror, the clones are built as sorted */
+bool rb_clone_range(struct rb_root *rb,
+		    const struct rb_node *beg,
+		    const struct rb_node *end,
+		    struct rb_node *(*node_clone)(const struct rb_node *node,
+						  const void *arg),
+		    void (*node_destroy)(struct rb_node *node,
+					 const void *arg),
+		    const void *arg_clone,
+		    const void *arg_destroy)
+{
+	const struct rb_node *src;
+	struct rb_node **nodes;
+	size_t num = 0, i;
+
+	for (src = beg; src != end; src = rb_next(src))
+		++num;
+
+	if (!num) {
+		rb_init(rb);
+		return true;
+	}
+
+	if (!(nodes = malloc(num * sizeof(*nodes))))
+		return false;
+
+	for (i = 0, src = beg; i < num; ++i, src = rb_next(src)) {
+		if (!(nodes[i] = node_clone(src, arg_clone))) {
+			while (node_destroy && i--)
+				node_destroy(nodes[i], arg_destroy);
+			free(nodes);
+			return false;
+		}
+	}
+
+	rb_build_sorted(rb, nodes, num);
+	free(nodes);
+
+	return true;
+}
+
+#ifndef NDEBUG
+#include <ycc/debug.h>
+/* return black-height of root, or 0 if invalid */
+static size_t __rb_isvalid(struct rb_node *root)
+{
+	size_t left, right;
+
+	if (!root)
+		return 1;
+
+	if (rb_is_red(root) &&
+	    ((root->left && rb_is_red(root->left)) ||
+	     (root->right && rb_is_red(root->right)))) {
+		dprintf("red node has red child\n");
+		return 0;
+	}
+
+	if ((root->left && rb_parent(root->left) != root) ||
+	    (root->right && rb_parent(root->right) != root)) {
+		dprintf("bad parent link\n");
+		return 0;
+	}
+
+#ifdef	BSTLINK_SIZE
+	if (root->size != bstlink_size((struct bst_link*)root->left) +
+			  bstlink_size((struct bst_link*)root->right) + 1) {
+		dprintf("bad subtree size %zu\n", root->size);
+		return 0;
+	}
+#endif
+
+	left = __rb_isvalid(root->left);
+	right = __rb_isvalid(root->right);
+	if (!left || !right)
+		return 0;
+
+	if (left != right) {
+		dprintf("black-height: left = %zu, right = %zu\n", left, right);
+		return 0;
+	}
+
+	return left + rb_is_black(root);
 }
 
 bool rb_isvalid(struct rb_root *rb)
 {
-	return __rb_isvalid(rb->node);
+	if (rb->node && (rb_parent(rb->node) || rb_is_red(rb->node)))
+		return false;
+
+	return __rb_isvalid(rb->node) != 0;
 }
 #endif
 
@@ -0,0 +1,374 @@
+/*
+ * skiplist.c -- Lock-Free Skip Lists
+ *
+ * Copyright (C) 2012-2013 yanyg (cppgp@qq.com)
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING, if not see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * The inserter links the upper levels after level 0, so an eraser may
+ * mark the node and unlink it while the inserter still links a level
+ * of it.  Either of them finishes by setting its flag in 'state', the
+ * one which sees the flag of the other set searches the node once more,
+ * which unlinks it from every level for good, and retires it.
+ *
+ * That search goes past the nodes of equal key: a node inserted after
+ * the erase may have been linked in front of the erased one, at a level
+ * that was not marked yet when the inserter passed by.
+ */
+
+#include <ycc/algos/skiplist.h>
+#include <ycc/debug.h>
+
+#define SKL_LEVEL_MASK	0xfful
+#define SKL_LINKED	0x100ul
+#define SKL_ERASED	0x200ul
+
+#define __skl_marked(p)		((unsigned long)(p) & 1ul)
+#define __skl_mark(p)		((struct skl_node*)((unsigned long)(p) | 1ul))
+#define __skl_strip(p)		((struct skl_node*)((unsigned long)(p) & ~1ul))
+#define __skl_load(pp)		__atomic_load_n((pp), __ATOMIC_ACQUIRE)
+#define __skl_cas(pp, old, new)						\
+	__atomic_compare_exchange_n((pp), &(old), (new), false,		\
+				    __ATOMIC_SEQ_CST, __ATOMIC_ACQUIRE)
+
+/* the key searched, a key argument or a node */
+struct __skl_key
+{
+	int (*compare)(const struct skl_node *node, const void *arg);
+	int (*compare_link)(const struct skl_node *node1,
+			    const struct skl_node *node2,
+			    const void *arg);
+	const struct skl_node *node;
+	const void *arg;
+	bool unlink;
+};
+
+static inline int __skl_compare(const struct __skl_key *key,
+				const struct skl_node *node)
+{
+	return key->node ? key->compare_link(node, key->node, key->arg) :
+			   key->compare(node, key->arg);
+}
+
+/* 'state' takes flags concurrently, every read is atomic */
+static inline unsigned long __skl_state(const struct skl_node *node)
+{
+	return __atomic_load_n(&node->state, __ATOMIC_RELAXED);
+}
+
+static inline unsigned __skl_level(const struct skl_node *node)
+{
+	return __skl_state(node) & SKL_LEVEL_MASK;
+}
+
+/* one more level with probability 1/4, the seed is per thread */
+static unsigned __skl_random_level(void)
+{
+	static __thread unsigned long seed = 0;
+	unsigned long x = seed;
+	unsigned level = 1;
+
+	if (!x)
+		x = (unsigned long)&seed | 1;
+
+	/* xorshift64 */
+	x ^= x << 13;
+	x ^= x >> 7;
+	x ^= x << 17;
+	seed = x;
+
+	while (level < SKL_MAX_LEVEL && !(x & 3)) {
+		++level;
+		x >>= 2;
+	}
+
+	return level;
+}
+
+void skl_init(struct skl_root *skl,
+	      struct epoch_domain *domain,
+	      void (*release)(struct epoch_entry *entry))
+{
+	int i;
+
+	for (i = 0; i < SKL_MAX_LEVEL; ++i)
+		skl->head.next[i] = NULL;
+	skl->head.state = SKL_MAX_LEVEL | SKL_LINKED;
+	skl->domain = domain;
+	skl->release = release;
+}
+
+/*
+ * fill the predecessors and successors of 'key' at every level,
+ * unlinking the marked nodes on the way.  The successor is the first
+ * node not less than 'key', or greater than it for 'unlink'.
+ */
+static void __skl_search(struct skl_root *skl,
+			 const struct __skl_key *key,
+			 struct skl_node **preds,
+			 struct skl_node **succs)
+{
+	int level, cmp;
+	struct skl_node *pred, *curr, *succ;
+
+retry:
+	pred = &skl->head;
+	for (level = SKL_MAX_LEVEL - 1; level >= 0; --level) {
+		curr = __skl_strip(__skl_load(&pred->next[level]));
+		while (curr) {
+			succ = __skl_load(&curr->next[level]);
+			if (__skl_marked(succ)) {
+				/* fails if 'pred' is marked or changed */
+				if (!__skl_cas(&pred->next[level], curr,
+					       __skl_strip(succ)))
+					goto retry;
+				curr = __skl_strip(succ);
+				continue;
+			}
+			cmp = __skl_compare(key, curr);
+			if (cmp > 0 || (!cmp && !key->unlink))
+				break;
+			pred = curr;
+			curr = succ;
+		}
+		preds[level] = pred;
+		succs[level] = curr;
+	}
+}
+
+/* the last one of the inserter and the eraser unlinks and retires */
+static void __skl_finish(struct skl_node *node,
+			 struct skl_root *skl,
+			 const struct __skl_key *key,
+			 unsigned long flag)
+{
+	struct skl_node *preds[SKL_MAX_LEVEL], *succs[SKL_MAX_LEVEL];
+	struct __skl_key unlink = *key;
+	unsigned long state = __atomic_fetch_or(&node->state, flag,
+						__ATOMIC_SEQ_CST);
+
+	if (!(state & (SKL_LINKED | SKL_ERASED) & ~flag))
+		return;
+
+	unlink.unlink = true;
+	__skl_search(skl, &unlink, preds, succs);
+	epoch_retire(skl->domain, &node->entry, skl->release);
+}
+
+struct skl_node *skl_next(const struct skl_node *node)
+{
+	struct skl_node *next = __skl_strip(__skl_load(&node->next[0]));
+
+	while (next && __skl_marked(__skl_load(&next->next[0])))
+		next = __skl_strip(__skl_load(&next->next[0]));
+
+	return next;
+}
+
+static struct skl_node *__skl_lower_bound(const struct skl_root *skl,
+					  const struct __skl_key *key)
+{
+	int level;
+	const struct skl_node *pred = &skl->head;
+	struct skl_node *curr = NULL, *succ;
+
+	for (level = SKL_MAX_LEVEL - 1; level >= 0; --level) {
+		curr = __skl_strip(__skl_load(&pred->next[level]));
+		while (curr) {
+			succ = __skl_load(&curr->next[level]);
+			if (__skl_marked(succ)) {
+				/* skip, leave the unlink to the writers */
+				curr = __skl_strip(succ);
+				continue;
+			}
+			if (__skl_compare(key, curr) >= 0)
+				break;
+			pred = curr;
+			curr = succ;
+		}
+	}
+
+	return curr;
+}
+
+struct skl_node *skl_find(const struct skl_root *skl,
+			  int (*compare)(const struct skl_node *node,
+					 const void *arg),
+			  const void *arg)
+{
+	struct __skl_key key = { compare, NULL, NULL, arg, false };
+	struct skl_node *node = __skl_lower_bound(skl, &key);
+
+	return node && !compare(node, arg) ? node : NULL;
+}
+
+struct skl_node *skl_lower_bound(const struct skl_root *skl,
+				 int (*compare)(const struct skl_node *node,
+						const void *arg),
+				 const void *arg)
+{
+	struct __skl_key key = { compare, NULL, NULL, arg, false };
+
+	return __skl_lower_bound(skl, &key);
+}
+
+struct skl_node *skl_insert_unique(struct skl_node *node,
+				   struct skl_root *skl,
+				   int (*compare_link)(
+					const struct skl_node *node1,
+					const struct skl_node *node2,
+					const void *arg),
+				   const void *arg)
+{
+	struct __skl_key key = { NULL, compare_link, node, arg, false };
+	struct skl_node *preds[SKL_MAX_LEVEL], *succs[SKL_MAX_LEVEL];
+	struct skl_node *succ, *old;
+	unsigned level, i;
+
+	level = __skl_random_level();
+	node->state = level;
+
+	for (;;) {
+		__skl_search(skl, &key, preds, succs);
+		if (succs[0] && !compare_link(succs[0], node, arg))
+			return succs[0];
+
+		for (i = 0; i < level; ++i)
+			node->next[i] = succs[i];
+
+		succ = succs[0];
+		if (__skl_cas(&preds[0]->next[0], succ, node))
+			break;
+	}
+
+	/* level 0 published, the node may be erased from now on */
+	for (i = 1; i < level; ++i) {
+		for (;;) {
+			old = __skl_load(&node->next[i]);
+			if (__skl_marked(old))
+				goto out;
+			if (old != succs[i] &&
+			    !__skl_cas(&node->next[i], old, succs[i]))
+				continue;
+
+			succ = succs[i];
+			if (__skl_cas(&preds[i]->next[i], succ, node))
+				break;
+
+			__skl_search(skl, &key, preds, succs);
+		}
+	}
+
+out:
+	__skl_finish(node, skl, &key, SKL_LINKED);
+	return NULL;
+}
+
+bool skl_erase(struct skl_node *node,
+	       struct skl_root *skl,
+	       int (*compare_link)(const struct skl_node *node1,
+				   const struct skl_node *node2,
+				   const void *arg),
+	       const void *arg)
+{
+	struct __skl_key key = { NULL, compare_link, node, arg, false };
+	struct skl_node *succ;
+	int level;
+
+	for (level = (int)__skl_level(node) - 1; level >= 0; --level) {
+		succ = __skl_load(&node->next[level]);
+		while (!__skl_marked(succ)) {
+			if (__skl_cas(&node->next[level], succ,
+				      __skl_mark(succ))) {
+				if (!level)
+					goto erased;
+				break;
+			}
+		}
+	}
+
+	/* another eraser marked level 0 first */
+	return false;
+
+erased:
+	__skl_finish(node, skl, &key, SKL_ERASED);
+	return true;
+}
+
+void skl_clear(struct skl_root *skl)
+{
+	int i;
+	struct skl_node *node, *next;
+
+	for (node = skl->head.next[0]; node; node = next) {
+		next = __skl_strip(node->next[0]);
+		if (!__skl_marked(node->next[0]))
+			skl->release(&node->entry);
+	}
+
+	for (i = 0; i < SKL_MAX_LEVEL; ++i)
+		skl->head.next[i] = NULL;
+}
+
+#ifndef NDEBUG
+bool skl_isvalid(const struct skl_root *skl,
+		 int (*compare_link)(const struct skl_node *node1,
+				     const struct skl_node *node2,
+				     const void *arg),
+		 const void *arg)
+{
+	int level;
+	const struct skl_node *node, *lower;
+
+	for (level = 0; level < SKL_MAX_LEVEL; ++level) {
+		/* every level is a sorted sublist of the one below */
+		lower = skl->head.next[level ? level - 1 : 0];
+		for (node = skl->head.next[level]; node;
+		     node = node->next[level]) {
+			if (__skl_marked(node->next[level])) {
+				dprintf("level %d: erased node linked\n",
+					level);
+				return false;
+			}
+			if (__skl_level(node) <= (unsigned)level ||
+			    !(__skl_state(node) & SKL_LINKED)) {
+				dprintf("level %d: bad node state %lx\n",
+					level, __skl_state(node));
+				return false;
+			}
+			if (node->next[level] &&
+			    compare_link(node, node->next[level], arg) >= 0) {
+				dprintf("level %d: disorder\n", level);
+				return false;
+			}
+			if (!level)
+				continue;
+			while (lower && lower != node)
+				lower = lower->next[level - 1];
+			if (!lower) {
+				dprintf("level %d: node not in level %d\n",
+					level, level - 1);
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+#endif
+
+/* eof */
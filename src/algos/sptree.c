@@ -23,8 +23,8 @@
 void __spt_splay(struct spt_node *node, struct spt_node **proot)
 {
 	while (node != *proot) {
-		struct spt_node *parent = node->parent;
-		struct spt_node *gparent = parent->parent;
+		struct spt_node *parent = spt_parent(node);
+		struct spt_node *gparent = spt_parent(parent);
 
 		if (node == parent->left) {
 			if (!gparent) {
@@ -56,8 +56,249 @@ void __spt_splay(struct spt_node *node, struct spt_node **proot)
 	}
 }
 
+/*
+ * semi-splay: zig-zag as splay, zig-zig rotates the parent over the
+ * grandparent only and goes on from the parent
+ */
+void __spt_semisplay(struct spt_node *node, struct spt_node **proot)
+{
+	while (node != *proot) {
+		struct spt_node *parent = spt_parent(node);
+		struct spt_node *gparent = spt_parent(parent);
+
+		if (node == parent->left) {
+			if (!gparent) {
+				__BSTLINK_ROTATE_RIGHT(parent, proot);
+				break;
+			}
+
+			if (parent == gparent->left) {
+				__BSTLINK_ROTATE_RIGHT(gparent, proot);
+				node = parent;
+			} else {
+				__BSTLINK_ROTATE_RIGHT(parent, proot);
+				__BSTLINK_ROTATE_LEFT(gparent, proot);
+			}
+		} else {
+			if (!gparent) {
+				__BSTLINK_ROTATE_LEFT(parent, proot);
+				break;
+			}
+
+			if (parent == gparent->right) {
+				__BSTLINK_ROTATE_LEFT(gparent, proot);
+				node = parent;
+			} else {
+				__BSTLINK_ROTATE_LEFT(parent, proot);
+				__BSTLINK_ROTATE_RIGHT(gparent, proot);
+			}
+		}
+	}
+}
+
+static inline bool __spt_goleft(const struct spt_node *node,
+				int (*compare)(const struct spt_node *node,
+					       const void *arg),
+				const void *arg,
+				bool bequal)
+{
+	int icmp = compare(node, arg);
+
+	return icmp > 0 || (!icmp && bequal);
+}
+
+/*
+ * Top-down splay: the nodes passed by on the left hang on the right
+ * spine of tree 'l', the ones on the right on the left spine of 'r'.
+ * The path turns into the two spines as the search goes down, a zig-zig
+ * rotates first.  The bound is the last node turned left at, either
+ * the last one of the search or the last one hung on 'r'.
+ */
+struct spt_node *__spt_splay_bound(struct spt_node **proot,
+				   int (*compare)(const struct spt_node *node,
+						  const void *arg),
+				   const void *arg,
+				   bool bequal)
+{
+	struct spt_node *t = *proot, *child, *bound;
+	struct spt_node *l = NULL, *lmax = NULL, *r = NULL, *rmin = NULL;
+	bool left;
+
+	if (!t)
+		return NULL;
+
+	left = __spt_goleft(t, compare, arg, bequal);
+	for (;;) {
+		if (left) {
+			if (!(child = t->left))
+				break;
+			left = __spt_goleft(child, compare, arg, bequal);
+			if (left && child->left) {
+				/* zig-zig, rotate right */
+				t->left = child->right;
+				if (t->left)
+					spt_set_parent(t->left, t);
+				child->right = t;
+				spt_set_parent(t, child);
+#ifdef	BSTLINK_SIZE
+				bstlink_size_update((struct bst_link*)t);
+#endif
+				t = child;
+				child = t->left;
+				left = __spt_goleft(child, compare, arg,
+						    bequal);
+			}
+			/* hang 't' on 'r' */
+			if (rmin) {
+				rmin->left = t;
+				spt_set_parent(t, rmin);
+			} else
+				r = t;
+			rmin = t;
+		} else {
+			if (!(child = t->right))
+				break;
+			left = __spt_goleft(child, compare, arg, bequal);
+			if (!left && child->right) {
+				/* zig-zig, rotate left */
+				t->right = child->left;
+				if (t->right)
+					spt_set_parent(t->right, t);
+				child->left = t;
+				spt_set_parent(t, child);
+#ifdef	BSTLINK_SIZE
+				bstlink_size_update((struct bst_link*)t);
+#endif
+				t = child;
+				child = t->right;
+				left = __spt_goleft(child, compare, arg,
+						    bequal);
+			}
+			/* hang 't' on 'l' */
+			if (lmax) {
+				lmax->right = t;
+				spt_set_parent(t, lmax);
+			} else
+				l = t;
+			lmax = t;
+		}
+		t = child;
+	}
+
+	if (left || !rmin) {
+		/* 't' is the bound, or there is none and it is the last */
+		bound = left ? t : NULL;
+		if (lmax) {
+			lmax->right = t->left;
+			if (t->left)
+				spt_set_parent(t->left, lmax);
+			t->left = l;
+		}
+		if (rmin) {
+			rmin->left = t->right;
+			if (t->right)
+				spt_set_parent(t->right, rmin);
+			t->right = r;
+		}
+	} else {
+		/* 't' goes to 'l', 'rmin' off 'r' is the bound */
+		bound = rmin;
+		if (lmax) {
+			lmax->right = t;
+			spt_set_parent(t, lmax);
+		} else
+			l = t;
+		lmax = t;
+
+		if (rmin == r)
+			r = rmin->right;
+		else {
+			rmin = spt_parent(rmin);
+			rmin->left = bound->right;
+			if (rmin->left)
+				spt_set_parent(rmin->left, rmin);
+		}
+		bound->left = l;
+		bound->right = r;
+		t = bound;
+	}
+
+	if (t->left)
+		spt_set_parent(t->left, t);
+	if (t->right)
+		spt_set_parent(t->right, t);
+	spt_set_parent(t, NULL);
+	*proot = t;
+
+	/* the spines counted bottom-up, 't' last */
+	if (lmax)
+		__BSTLINK_SIZE_FIXUP(lmax);
+	if (rmin && rmin != bound)
+		__BSTLINK_SIZE_FIXUP(rmin);
+	__BSTLINK_SIZE_FIXUP(t);
+
+	return bound;
+}
+
+struct __spt_link_arg
+{
+	int (*compare_link)(const struct spt_node *node1,
+			    const struct spt_node *node2,
+			    const void *arg);
+	const struct spt_node *node;
+	const void *arg;
+};
+
+static int __spt_compare_link(const struct spt_node *node, const void *arg)
+{
+	const struct __spt_link_arg *p = arg;
+
+	return p->compare_link(node, p->node, p->arg);
+}
+
+bool __spt_insert_topdown(struct spt_node *node,
+			  struct spt_root *spt,
+			  int (*compare_link)(const struct spt_node *node1,
+					      const struct spt_node *node2,
+					      const void *arg),
+			  const void *arg,
+			  bool bunique)
+{
+	struct __spt_link_arg link_arg = { compare_link, node, arg };
+	struct spt_node *root, *bound;
+
+	/* before the first equal if unique, else after the last one */
+	bound = __spt_splay_bound(&spt->node, __spt_compare_link, &link_arg,
+				  bunique);
+	if (bound && bunique && !compare_link(bound, node, arg))
+		return false;
+
+	root = spt->node;
+	__BSTLINK_INIT(node, NULL, &spt->node);
+	if (!root)
+		return true;
+
+	if (bound) {
+		node->left = root->left;
+		node->right = root;
+		root->left = NULL;
+	} else {
+		node->left = root;
+	}
+	if (node->left)
+		spt_set_parent(node->left, node);
+	spt_set_parent(root, node);
+#ifdef	BSTLINK_SIZE
+	bstlink_size_update((struct bst_link*)root);
+	bstlink_size_update((struct bst_link*)node);
+#endif
+
+	return true;
+}
+
 #define __BSTLINK_TYPE struct spt_node
-#define __BSTLINK_ERASE_SPECIALIZE_DO(child, parent, proot)	\
+#define __BSTLINK_ERASE_SPECIALIZE_DO(child, parent, proot,		\
+				      augment, once)			\
 	if (parent)						\
 		__spt_splay(parent, proot);
 #include "bstree-internal.h"
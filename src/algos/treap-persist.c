@@ -0,0 +1,450 @@
+/*
+ * treap-persist.c -- Persistent Treaps
+ *
+ * Copyright (C) 2012-2013 yanyg (cppgp@qq.com)
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING, if not see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#include <errno.h>
+#include <stdlib.h>
+
+#include <ycc/debug.h>
+#include <ycc/algos/treap.h>
+#include <ycc/algos/treap-persist.h>
+
+/*
+ * The nodes of a version are shared by the later ones, only the counts
+ * change, and they change on any thread putting a snapshot.
+ */
+static inline struct ptreap_node *__ptreap_get(struct ptreap_node *node)
+{
+	if (node)
+		__atomic_add_fetch(&node->ref, 1, __ATOMIC_RELAXED);
+
+	return node;
+}
+
+static void __ptreap_put(struct ptreap_root *pt, struct ptreap_node *node)
+{
+	while (node && !__atomic_sub_fetch(&node->ref, 1, __ATOMIC_ACQ_REL)) {
+		struct ptreap_node *left = node->left, *right = node->right;
+
+		pt->release(node, pt->arg);
+		__ptreap_put(pt, left);
+		node = right;
+	}
+}
+
+/* a private copy of 'node' without links, to be linked by the caller */
+static struct ptreap_node *__ptreap_copy(struct ptreap_root *pt,
+					 const struct ptreap_node *node)
+{
+	struct ptreap_node *copy = pt->copy(node, pt->arg);
+
+	if (copy) {
+		copy->left = copy->right = NULL;
+		copy->priority = node->priority;
+		copy->ref = 1;
+	}
+
+	return copy;
+}
+
+static void __ptreap_publish(struct ptreap_root *pt, struct ptreap_node *node)
+{
+	struct ptreap_node *old = pt->node;
+
+	pthread_mutex_lock(&pt->version_lock);
+	pt->node = node;
+	pthread_mutex_unlock(&pt->version_lock);
+
+	__ptreap_put(pt, old);
+}
+
+/*
+ * split the subtree 'node' into new '<= node1' ('equal') or '< node1'
+ * and the others, 'node' is left as it is.  The paths are copied into
+ * the right spine of 'left' and the left spine of 'right'.
+ */
+static int __ptreap_split(struct ptreap_root *pt,
+			  const struct ptreap_node *node,
+			  const struct ptreap_node *node1,
+			  int (*compare_link)(const struct ptreap_node *node1,
+					      const struct ptreap_node *node2,
+					      const void *arg),
+			  const void *arg,
+			  bool equal,
+			  struct ptreap_node **pleft,
+			  struct ptreap_node **pright)
+{
+	struct ptreap_node **left = pleft, **right = pright, *copy;
+
+	*pleft = *pright = NULL;
+	while (node) {
+		int icmp = compare_link(node, node1, arg);
+
+		if (!(copy = __ptreap_copy(pt, node))) {
+			__ptreap_put(pt, *pleft);
+			__ptreap_put(pt, *pright);
+			*pleft = *pright = NULL;
+			return -1;
+		}
+
+		if (icmp < 0 || (!icmp && equal)) {
+			*left = copy;
+			copy->left = __ptreap_get(node->left);
+			left = &copy->right;
+			node = node->right;
+		} else {
+			*right = copy;
+			copy->right = __ptreap_get(node->right);
+			right = &copy->left;
+			node = node->left;
+		}
+	}
+
+	return 0;
+}
+
+/* merge new of 'left' and 'right', the spines on the way are copied */
+static int __ptreap_merge(struct ptreap_root *pt,
+			  const struct ptreap_node *left,
+			  const struct ptreap_node *right,
+			  struct ptreap_node **pnode)
+{
+	struct ptreap_node **link = pnode, *copy;
+
+	*pnode = NULL;
+	while (left && right) {
+		if (left->priority <= right->priority) {
+			if (!(copy = __ptreap_copy(pt, left)))
+				goto fail;
+			copy->left = __ptreap_get(left->left);
+			*link = copy;
+			link = &copy->right;
+			left = left->right;
+		} else {
+			if (!(copy = __ptreap_copy(pt, right)))
+				goto fail;
+			copy->right = __ptreap_get(right->right);
+			*link = copy;
+			link = &copy->left;
+			right = right->left;
+		}
+	}
+	*link = __ptreap_get((struct ptreap_node*)(left ? left : right));
+
+	return 0;
+
+fail:
+	__ptreap_put(pt, *pnode);
+	*pnode = NULL;
+	return -1;
+}
+
+void ptreap_init(struct ptreap_root *pt,
+		 struct ptreap_node *(*copy)(const struct ptreap_node *node,
+					     const void *arg),
+		 void (*release)(struct ptreap_node *node, const void *arg),
+		 const void *arg)
+{
+	pt->node = NULL;
+	pthread_mutex_init(&pt->lock, NULL);
+	pthread_mutex_init(&pt->version_lock, NULL);
+	pt->copy = copy;
+	pt->release = release;
+	pt->arg = arg;
+}
+
+void ptreap_destroy(struct ptreap_root *pt)
+{
+	__ptreap_put(pt, pt->node);
+	pt->node = NULL;
+	pthread_mutex_destroy(&pt->lock);
+	pthread_mutex_destroy(&pt->version_lock);
+}
+
+void ptreap_snapshot(struct ptreap_root *pt, struct ptreap_snap *snap)
+{
+	/* the version may not be put between the load and the count */
+	pthread_mutex_lock(&pt->version_lock);
+	snap->node = __ptreap_get(pt->node);
+	pthread_mutex_unlock(&pt->version_lock);
+}
+
+void ptreap_put_snapshot(struct ptreap_root *pt, struct ptreap_snap *snap)
+{
+	__ptreap_put(pt, snap->node);
+	snap->node = NULL;
+}
+
+int ptreap_insert(struct ptreap_root *pt,
+		  struct ptreap_node *node,
+		  int (*compare_link)(const struct ptreap_node *node1,
+				      const struct ptreap_node *node2,
+				      const void *arg),
+		  const void *arg)
+{
+	struct ptreap_node *root, **link = &root, *copy;
+	const struct ptreap_node *p;
+
+	node->priority = treap_rand();
+	node->ref = 1;
+
+	pthread_mutex_lock(&pt->lock);
+
+	/* copy the path down to where 'node' is above by priority */
+	for (p = pt->node; p && p->priority <= node->priority; ) {
+		if (!(copy = __ptreap_copy(pt, p)))
+			goto fail;
+		*link = copy;
+		if (compare_link(node, p, arg) < 0) {
+			copy->right = __ptreap_get(p->right);
+			link = &copy->left;
+			p = p->left;
+		} else {
+			copy->left = __ptreap_get(p->left);
+			link = &copy->right;
+			p = p->right;
+		}
+	}
+
+	if (__ptreap_split(pt, p, node, compare_link, arg, true,
+			   &node->left, &node->right))
+		goto fail;
+	*link = node;
+
+	__ptreap_publish(pt, root);
+	pthread_mutex_unlock(&pt->lock);
+
+	return 0;
+
+fail:
+	*link = NULL;
+	__ptreap_put(pt, root);
+	pthread_mutex_unlock(&pt->lock);
+	errno = ENOMEM;
+
+	return -1;
+}
+
+int ptreap_erase(struct ptreap_root *pt,
+		 int (*compare)(const struct ptreap_node *node,
+				const void *arg),
+		 const void *arg)
+{
+	struct ptreap_node *root, **link = &root, *copy, *victim;
+	const struct ptreap_node *p;
+	struct ptreap_snap snap;
+	int icmp;
+
+	pthread_mutex_lock(&pt->lock);
+
+	snap.node = pt->node;
+	if (!(victim = ptreap_find(&snap, compare, arg))) {
+		pthread_mutex_unlock(&pt->lock);
+		errno = ENOENT;
+		return -1;
+	}
+
+	/* the equals before 'victim' are on the left */
+	for (p = pt->node; p != victim; ) {
+		if (!(copy = __ptreap_copy(pt, p)))
+			goto fail;
+		*link = copy;
+		icmp = compare(p, arg);
+		if (icmp >= 0) {
+			copy->right = __ptreap_get(p->right);
+			link = &copy->left;
+			p = p->left;
+		} else {
+			copy->left = __ptreap_get(p->left);
+			link = &copy->right;
+			p = p->right;
+		}
+	}
+
+	if (__ptreap_merge(pt, victim->left, victim->right, link))
+		goto fail;
+
+	__ptreap_publish(pt, root);
+	pthread_mutex_unlock(&pt->lock);
+
+	return 0;
+
+fail:
+	*link = NULL;
+	__ptreap_put(pt, root);
+	pthread_mutex_unlock(&pt->lock);
+	errno = ENOMEM;
+
+	return -1;
+}
+
+struct ptreap_node *ptreap_find(const struct ptreap_snap *snap,
+				int (*compare)(const struct ptreap_node *node,
+					       const void *arg),
+				const void *arg)
+{
+	struct ptreap_node *node = snap->node, *r = NULL;
+
+	while (node) {
+		int icmp = compare(node, arg);
+
+		if (icmp < 0) {
+			node = node->right;
+		} else {
+			if (!icmp)
+				r = node;
+			node = node->left;
+		}
+	}
+
+	return r;
+}
+
+struct ptreap_node *
+ptreap_lower_bound(const struct ptreap_snap *snap,
+		   int (*compare)(const struct ptreap_node *node,
+				  const void *arg),
+		   const void *arg)
+{
+	struct ptreap_node *node = snap->node, *r = NULL;
+
+	while (node) {
+		if (compare(node, arg) < 0) {
+			node = node->right;
+		} else {
+			r = node;
+			node = node->left;
+		}
+	}
+
+	return r;
+}
+
+static bool
+__ptreap_visit_cond(const struct ptreap_node *node,
+		    bool (*visit_cond)(const struct ptreap_node *node,
+				       const void *arg),
+		    const void *arg)
+{
+	while (node) {
+		if (!__ptreap_visit_cond(node->left, visit_cond, arg) ||
+		    !visit_cond(node, arg))
+			return false;
+		node = node->right;
+	}
+
+	return true;
+}
+
+bool ptreap_visit_cond(const struct ptreap_snap *snap,
+		       bool (*visit_cond)(const struct ptreap_node *node,
+					  const void *arg),
+		       const void *arg)
+{
+	return __ptreap_visit_cond(snap->node, visit_cond, arg);
+}
+
+static bool
+__ptreap_visit_from(const struct ptreap_node *node,
+		    int (*compare)(const struct ptreap_node *node,
+				   const void *arg),
+		    const void *arg,
+		    bool (*visit_cond)(const struct ptreap_node *node,
+				       const void *arg),
+		    const void *arg_visit)
+{
+	while (node) {
+		if (compare(node, arg) < 0) {
+			node = node->right;
+			continue;
+		}
+
+		return __ptreap_visit_from(node->left, compare, arg,
+					   visit_cond, arg_visit) &&
+		       visit_cond(node, arg_visit) &&
+		       __ptreap_visit_cond(node->right, visit_cond, arg_visit);
+	}
+
+	return true;
+}
+
+bool ptreap_visit_from(const struct ptreap_snap *snap,
+		       int (*compare)(const struct ptreap_node *node,
+				      const void *arg),
+		       const void *arg,
+		       bool (*visit_cond)(const struct ptreap_node *node,
+					  const void *arg),
+		       const void *arg_visit)
+{
+	return __ptreap_visit_from(snap->node, compare, arg,
+				   visit_cond, arg_visit);
+}
+
+#ifndef NDEBUG
+struct __ptreap_check
+{
+	int (*compare_link)(const struct ptreap_node *node1,
+			    const struct ptreap_node *node2,
+			    const void *arg);
+	const void *arg;
+	const struct ptreap_node *prev;
+};
+
+static bool __ptreap_isvalid(const struct ptreap_node *node,
+			     struct __ptreap_check *check)
+{
+	while (node) {
+		if (!node->ref) {
+			dprintf("ptreap: node %p is linked but released\n",
+				node);
+			return false;
+		}
+		if ((node->left && node->left->priority < node->priority) ||
+		    (node->right && node->right->priority < node->priority)) {
+			dprintf("ptreap: priority %u above a child of less\n",
+				node->priority);
+			return false;
+		}
+		if (!__ptreap_isvalid(node->left, check))
+			return false;
+		if (check->prev &&
+		    check->compare_link(check->prev, node, check->arg) > 0) {
+			dprintf("ptreap: node %p out of order\n", node);
+			return false;
+		}
+		check->prev = node;
+		node = node->right;
+	}
+
+	return true;
+}
+
+bool ptreap_isvalid(const struct ptreap_snap *snap,
+		    int (*compare_link)(const struct ptreap_node *node1,
+					const struct ptreap_node *node2,
+					const void *arg),
+		    const void *arg)
+{
+	struct __ptreap_check check = { compare_link, arg, NULL };
+
+	return __ptreap_isvalid(snap->node, &check);
+}
+#endif
+
+/* eof */
@@ -20,12 +20,40 @@
 
 #include <ycc/algos/treap.h>
 
+#include "bstree-join.h"
+
+unsigned treap_rand(void)
+{
+	static __thread uint64_t seed = 0;
+	uint64_t x;
+
+	if (!seed)
+		seed = (uint64_t)(unsigned long)&seed;
+
+	/* wyrand */
+	seed += 0xa0761d6478bd642fULL;
+#ifdef	__SIZEOF_INT128__
+	{
+		__uint128_t m = (__uint128_t)seed *
+				(seed ^ 0xe7037ed1a0b428dbULL);
+
+		x = (uint64_t)(m >> 64) ^ (uint64_t)m;
+	}
+#else
+	x = seed ^ seed >> 32;
+	x *= 0xe7037ed1a0b428dbULL;
+	x ^= x >> 29;
+#endif
+
+	return (unsigned)x;
+}
+
 void treap_insert_rebalance(struct treap_node *node, struct treap_root *treap)
 {
 	struct treap_node **proot = &treap->node;
 
 	while (node != *proot) {
-		struct treap_node *parent = node->parent;
+		struct treap_node *parent = treap_parent(node);
 
 		if (node->priority >= parent->priority)
 			return;
@@ -37,10 +65,274 @@ void treap_insert_rebalance(struct treap_node *node, struct treap_root *treap)
 	}
 }
 
-#include "bstree-internal.h"
+/* merge detached 'left' and 'right', all of 'left' order before 'right' */
+static struct treap_node *__treap_merge(struct treap_node *left,
+					struct treap_node *right)
+{
+	struct treap_node *root = NULL, *parent = NULL;
+	struct treap_node **plink = &root;
+
+	while (left && right) {
+		if (treap_priority(left) <= treap_priority(right)) {
+			*plink = left;
+			treap_set_parent(left, parent);
+			parent = left;
+			plink = &left->right;
+			left = left->right;
+		} else {
+			*plink = right;
+			treap_set_parent(right, parent);
+			parent = right;
+			plink = &right->left;
+			right = right->left;
+		}
+	}
+
+	if ((*plink = left ? left : right))
+		treap_set_parent(*plink, parent);
+	/* from the tail, a pivot of join may come with a stale size */
+	__BSTLINK_SIZE_FIXUP(*plink ? *plink : parent);
+
+	return root;
+}
+
+/* split the detached subtree 'node' into '< arg' and '>= arg' */
+static void __treap_split(struct treap_node *node,
+			  bstlink_compare_t compare, const void *arg,
+			  struct treap_node **pleft, struct treap_node **pright)
+{
+	struct treap_node *left_parent = NULL, *right_parent = NULL;
+
+	/* the search path is cut into the right spine of 'left' and
+	 * the left spine of 'right', heap order is kept along both */
+	while (node) {
+		if (compare((struct bst_link*)node, arg) < 0) {
+			*pleft = node;
+			treap_set_parent(node, left_parent);
+			left_parent = node;
+			pleft = &node->right;
+			node = node->right;
+		} else {
+			*pright = node;
+			treap_set_parent(node, right_parent);
+			right_parent = node;
+			pright = &node->left;
+			node = node->left;
+		}
+	}
+
+	*pleft = *pright = NULL;
+	__BSTLINK_SIZE_FIXUP(left_parent);
+	__BSTLINK_SIZE_FIXUP(right_parent);
+}
+
+void treap_split(struct treap_root *treap,
+		 int (*compare)(const struct treap_node *node,
+				const void *arg),
+		 const void *arg,
+		 struct treap_root *left,
+		 struct treap_root *right)
+{
+	struct treap_node *node = treap->node;
+
+	treap->node = NULL;
+	__treap_split(node, (bstlink_compare_t)compare, arg,
+		      &left->node, &right->node);
+}
+
+void treap_join(struct treap_root *treap,
+		struct treap_root *left,
+		struct treap_node *pivot,
+		struct treap_root *right)
+{
+	struct treap_node *l = left->node, *r = right->node;
+
+	left->node = right->node = NULL;
+	treap_set_parent(pivot, NULL);
+	pivot->left = pivot->right = NULL;
+	treap->node = __treap_merge(__treap_merge(l, pivot), r);
+}
+
+void treap_concat(struct treap_root *treap,
+		  struct treap_root *left,
+		  struct treap_root *right)
+{
+	struct treap_node *l = left->node, *r = right->node;
+
+	left->node = right->node = NULL;
+	treap->node = __treap_merge(l, r);
+}
+
+/* join ops, see bstree-join.h */
+static struct __bst_tree __treap_tree_make(struct bst_link *link)
+{
+	struct __bst_tree tree = { link, 0 };
+
+	return tree;
+}
+
+static void __treap_tree_expose(struct __bst_tree tree,
+				struct __bst_tree *left,
+				struct __bst_tree *right)
+{
+	struct bst_link *link = tree.link;
+
+	*left = __treap_tree_make(link->left);
+	*right = __treap_tree_make(link->right);
+
+	if (link->left)
+		bstlink_set_parent(link->left, NULL);
+	if (link->right)
+		bstlink_set_parent(link->right, NULL);
+}
+
+static void __treap_tree_split(struct __bst_tree tree,
+			       bstlink_compare_t compare,
+			       const void *arg,
+			       struct __bst_tree *left,
+			       struct __bst_tree *right)
+{
+	struct treap_node *l, *r;
+
+	__treap_split((struct treap_node*)tree.link, compare, arg, &l, &r);
+	*left = __treap_tree_make((struct bst_link*)l);
+	*right = __treap_tree_make((struct bst_link*)r);
+}
+
+static struct __bst_tree __treap_tree_join(struct __bst_tree left,
+					   struct bst_link *pivot,
+					   struct __bst_tree right)
+{
+	struct treap_node *node = (struct treap_node*)pivot;
+
+	treap_set_parent(node, NULL);
+	node->left = node->right = NULL;
+	node = __treap_merge((struct treap_node*)left.link, node);
+
+	return __treap_tree_make((struct bst_link*)
+				 __treap_merge(node,
+					(struct treap_node*)right.link));
+}
+
+static struct __bst_tree __treap_tree_concat(struct __bst_tree left,
+					     struct __bst_tree right)
+{
+	return __treap_tree_make((struct bst_link*)
+				 __treap_merge((struct treap_node*)left.link,
+					(struct treap_node*)right.link));
+}
+
+const struct __bst_join_ops __treap_join_ops = {
+	.make	= __treap_tree_make,
+	.expose	= __treap_tree_expose,
+	.split	= __treap_tree_split,
+	.join	= __treap_tree_join,
+	.concat	= __treap_tree_concat,
+};
+
+static void
+__treap_setop(enum __bst_setop op,
+	      struct treap_root *treap,
+	      struct treap_root *treap1,
+	      struct treap_root *treap2,
+	      int (*compare_link)(const struct treap_node *node1,
+			       const struct treap_node *node2,
+			       const void *arg),
+	      void (*destroy)(struct treap_node *node, const void *arg),
+	      const void *arg_compare,
+	      const void *arg_destroy,
+	      unsigned nthreads)
+{
+	struct bst_link *link1 = (struct bst_link*)treap1->node;
+	struct bst_link *link2 = (struct bst_link*)treap2->node;
+
+	treap1->node = treap2->node = NULL;
+	treap->node = (struct treap_node*)
+		   __bst_setop(&__treap_join_ops, op, link1, link2,
+			       (bstlink_compare_link_t)compare_link,
+			       (bstlink_destroy_t)destroy,
+			       arg_compare, arg_destroy, nthreads);
+}
+
+void treap_union(struct treap_root *treap,
+		 struct treap_root *treap1,
+		 struct treap_root *treap2,
+		 int (*compare_link)(const struct treap_node *node1,
+				     const struct treap_node *node2,
+				     const void *arg),
+		 void (*destroy)(struct treap_node *node, const void *arg),
+		 const void *arg_compare,
+		 const void *arg_destroy,
+		 unsigned nthreads)
+{
+	__treap_setop(__BST_SETOP_UNION, treap, treap1, treap2,
+		      compare_link, destroy, arg_compare, arg_destroy,
+		      nthreads);
+}
+
+void treap_intersection(struct treap_root *treap,
+			struct treap_root *treap1,
+			struct treap_root *treap2,
+			int (*compare_link)(const struct treap_node *node1,
+					    const struct treap_node *node2,
+					    const void *arg),
+			void (*destroy)(struct treap_node *node,
+					const void *arg),
+			const void *arg_compare,
+			const void *arg_destroy,
+			unsigned nthreads)
+{
+	__treap_setop(__BST_SETOP_INTERSECTION, treap, treap1, treap2,
+		      compare_link, destroy, arg_compare, arg_destroy,
+		      nthreads);
+}
+
+void treap_difference(struct treap_root *treap,
+		      struct treap_root *treap1,
+		      struct treap_root *treap2,
+		      int (*compare_link)(const struct treap_node *node1,
+					  const struct treap_node *node2,
+					  const void *arg),
+		      void (*destroy)(struct treap_node *node, const void *arg),
+		      const void *arg_compare,
+		      const void *arg_destroy,
+		      unsigned nthreads)
+{
+	__treap_setop(__BST_SETOP_DIFFERENCE, treap, treap1, treap2,
+		      compare_link, destroy, arg_compare, arg_destroy,
+		      nthreads);
+}
+
+static void __treap_build(struct treap_node *node,
+			  size_t depth,
+			  size_t height,
+			  const void *arg)
+{
+	unsigned slice = *(const unsigned*)arg;
+
+	/* level 'depth' draws from [depth * slice, (depth + 1) * slice) */
+	treap_init_priority(node);
+	treap_set_priority(node, depth * slice + treap_priority(node) % slice);
+}
+
+void treap_build_sorted(struct treap_root *treap,
+			struct treap_node **nodes,
+			size_t num)
+{
+	size_t levels = bstlink_build_height(num);
+	unsigned slice = 1;
+
+	if (levels && (unsigned)-1 / levels)
+		slice = (unsigned)-1 / levels;
+
+	treap->node = __BSTLINK_BUILD_SORTED(nodes, num, __treap_build, &slice,
+					     struct treap_node);
+}
+
 #define __BSTLINK_TYPE struct treap_node
 #define __BSTLINK_ERASE_SPECIALIZE_BOTH(node, scor)		\
 		treap_set_priority(scor, treap_priority(node))
+#include "bstree-internal.h"
 void treap_erase(struct treap_node *node, struct treap_root *treap)
 {
 	__BSTLINK_ERASE(node, &treap->node);
@@ -54,6 +346,12 @@ static bool __treap_isvalid(struct treap_node *root)
 	if (!root)
 		return true;
 
+#ifdef	BSTLINK_SIZE
+	if (root->size != bstlink_size((struct bst_link*)root->left) +
+			  bstlink_size((struct bst_link*)root->right) + 1)
+		return false;
+#endif
+
 	if (root->left)
 		priority = root->left->priority;
 
@@ -0,0 +1,229 @@
+/*
+ * wavltree.c -- Weak AVL Trees
+ *
+ * Copyright (C) 2012-2013 yanyg (cppgp@qq.com)
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING, if not see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+#include <ycc/algos/wavltree.h>
+
+/*
+ * A promotion or a demotion adds or takes one rank, it flips the
+ * parity.  The double rotation of the erase moves ranks by two, which
+ * keeps it.
+ */
+static inline void __wavl_flip(struct wavl_node *node)
+{
+	wavl_set_parity(node, __wavl_parity(node) ^ 1);
+}
+
+/* rank difference of 'child' (may be NULL), known to be 1 or 2 */
+static inline bool __wavl_is2(const struct wavl_node *child,
+			      const struct wavl_node *parent)
+{
+	return wavl_parity(child) == __wavl_parity(parent);
+}
+
+/*
+ * 'node' was linked of rank 0, the ranks are valid but for 'node' which
+ * may be a 0-child.  Promote up while the sibling is a 1-child, then at
+ * most one single or double rotation.
+ */
+void wavl_insert_rebalance(struct wavl_node *node, struct wavl_root *wavl)
+{
+	struct wavl_node **proot = &wavl->node;
+	struct wavl_node *parent, *sibling, *inner;
+
+	/* a 0-child has the parity of its parent, a 1-child not */
+	while ((parent = wavl_parent(node)) &&
+	       __wavl_parity(node) == __wavl_parity(parent)) {
+		bool left = node == parent->left;
+
+		sibling = left ? parent->right : parent->left;
+		if (!__wavl_is2(sibling, parent)) {
+			/* 0,1: promote */
+			__wavl_flip(parent);
+			node = parent;
+			continue;
+		}
+
+		/* 0,2: 'node' is 1,2 or 2,1 after a promotion */
+		inner = left ? node->right : node->left;
+		if (__wavl_is2(inner, node)) {
+			if (left)
+				__BSTLINK_ROTATE_RIGHT(parent, proot);
+			else
+				__BSTLINK_ROTATE_LEFT(parent, proot);
+			__wavl_flip(parent);
+		} else {
+			if (left) {
+				__BSTLINK_ROTATE_LEFT(node, proot);
+				__BSTLINK_ROTATE_RIGHT(parent, proot);
+			} else {
+				__BSTLINK_ROTATE_RIGHT(node, proot);
+				__BSTLINK_ROTATE_LEFT(parent, proot);
+			}
+			__wavl_flip(inner);
+			__wavl_flip(node);
+			__wavl_flip(parent);
+		}
+		return;
+	}
+}
+
+/*
+ * A node under 'parent', on the 'left' side or not, lost one rank or
+ * was erased, it may be a 3-child ('node' may be NULL).  Demote up
+ * while the sibling is a 2-child or a 2,2 node, then at most one single
+ * or double rotation.
+ */
+static void __wavl_erase_rebalance(struct wavl_node *node,
+				   struct wavl_node *parent,
+				   struct wavl_node **proot)
+{
+	struct wavl_node *sibling, *outer;
+	bool left;
+
+	/* a leaf of rank 1 is 2,2, demote it to 0 first */
+	if (!parent->left && !parent->right) {
+		__wavl_flip(parent);
+		node = parent;
+		if (!(parent = wavl_parent(node)))
+			return;
+	}
+
+	left = node ? node == parent->left : !parent->left;
+
+	/* a 3-child has the other parity than its parent, a 2-child not */
+	while (wavl_parity(node) != __wavl_parity(parent)) {
+		sibling = left ? parent->right : parent->left;
+		if (__wavl_is2(sibling, parent)) {
+			/* 3,2: demote */
+			__wavl_flip(parent);
+		} else if (__wavl_is2(sibling->left, sibling) &&
+			   __wavl_is2(sibling->right, sibling)) {
+			/* 3,1 with a 2,2 sibling: demote both */
+			__wavl_flip(sibling);
+			__wavl_flip(parent);
+		} else
+			break;
+
+		node = parent;
+		if (!(parent = wavl_parent(node)))
+			return;
+		left = node == parent->left;
+	}
+
+	if (wavl_parity(node) == __wavl_parity(parent))
+		return;
+
+	/* 3,1 and the sibling is not 2,2 */
+	sibling = left ? parent->right : parent->left;
+	outer = left ? sibling->right : sibling->left;
+	if (!__wavl_is2(outer, sibling)) {
+		if (left)
+			__BSTLINK_ROTATE_LEFT(parent, proot);
+		else
+			__BSTLINK_ROTATE_RIGHT(parent, proot);
+		/* promote 'sibling', demote 'parent' once, twice if a leaf */
+		__wavl_flip(sibling);
+		if (parent->left || parent->right)
+			__wavl_flip(parent);
+	} else {
+		if (left) {
+			__BSTLINK_ROTATE_RIGHT(sibling, proot);
+			__BSTLINK_ROTATE_LEFT(parent, proot);
+		} else {
+			__BSTLINK_ROTATE_LEFT(sibling, proot);
+			__BSTLINK_ROTATE_RIGHT(parent, proot);
+		}
+		/* the inner child up two, 'parent' down two, 'sibling' one */
+		__wavl_flip(sibling);
+	}
+}
+
+/* erase specialized */
+#define __BSTLINK_TYPE struct wavl_node
+#define __BSTLINK_ERASE_SPECIALIZE_BOTH(node, scor)		\
+	wavl_set_parity(scor, __wavl_parity(node))
+#define __BSTLINK_ERASE_SPECIALIZE_DO(child, parent, proot,		\
+				      augment, once)			\
+	if (parent)						\
+		__wavl_erase_rebalance(child, parent, proot);
+
+#include "bstree-internal.h"
+void wavl_erase(struct wavl_node *node, struct wavl_root *wavl)
+{
+	__BSTLINK_ERASE(node, &wavl->node);
+}
+
+#ifndef NDEBUG
+#include <ycc/debug.h>
+/* returns the rank of 'root', -1 if NULL, or -2 if invalid */
+static int __wavl_isvalid(const struct wavl_node *root)
+{
+	int rleft, rright;
+
+	if (!root)
+		return -1;
+
+#ifdef	BSTLINK_SIZE
+	if (root->size != bstlink_size((struct bst_link*)root->left) +
+			  bstlink_size((struct bst_link*)root->right) + 1) {
+		dprintf("bad subtree size %zu\n", root->size);
+		return -2;
+	}
+#endif
+
+	if ((root->left && wavl_parent(root->left) != root) ||
+	    (root->right && wavl_parent(root->right) != root)) {
+		dprintf("bad parent link\n");
+		return -2;
+	}
+
+	if ((rleft = __wavl_isvalid(root->left)) < -1 ||
+	    (rright = __wavl_isvalid(root->right)) < -1)
+		return -2;
+
+	/* the parities tell the rank differences, they MUST agree */
+	rleft += __wavl_is2(root->left, root) ? 2 : 1;
+	rright += __wavl_is2(root->right, root) ? 2 : 1;
+	if (rleft != rright) {
+		dprintf("rank %d by the left, %d by the right\n",
+			rleft, rright);
+		return -2;
+	}
+
+	if (!root->left && !root->right && rleft) {
+		dprintf("leaf of rank %d\n", rleft);
+		return -2;
+	}
+
+	return rleft;
+}
+
+bool wavl_isvalid(struct wavl_root *wavl)
+{
+	if (wavl->node && wavl_parent(wavl->node)) {
+		dprintf("root has a parent\n");
+		return false;
+	}
+
+	return __wavl_isvalid(wavl->node) >= -1;
+}
+#endif
+
+/* eof */
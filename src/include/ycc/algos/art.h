@@ -0,0 +1,243 @@
+/*
+ * art.h -- Adaptive Radix Trees
+ *
+ * Copyright (C) 2012-2013 yanyg (cppgp@qq.com)
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING, if not see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * An adaptive radix tree branches on one key byte per level, a lookup
+ * takes at most one node per key byte and no key compare but the last
+ * one, whatever the number of keys.  An inner node is sized to its
+ * children, 4, 16, 48 or 256 of them, and grows or shrinks on insert
+ * and erase.  A chain of one-child nodes is compressed into a prefix
+ * of the node below.
+ *
+ * A key is any run of bytes with its length, '\0' is a byte as the
+ * others.  The tree branches on the unsigned value of one byte after
+ * the other, which is the order of the iteration too, and a key which
+ * ends where longer ones go on hangs on the inner node it ends at,
+ * before them.  Integer keys are stored big-endian to keep their
+ * order, see art_key_u64.
+ *
+ * An inner node stores the first 9 bytes of its compressed path only.
+ * A search skips the bytes past them and compares the whole key once
+ * at the leaf, insert and erase read them from a leaf below the node.
+ * So the leaves keep a pointer to the key, not a copy, and the key
+ * MUST stay unchanged while the leaf is linked.
+ *
+ * The leaves are intrusive as the nodes of the binary trees: embed an
+ * art_leaf in the entry and get the entry back by art_entry.  The inner
+ * nodes are allocated by the tree, so art_insert may fail and the tree
+ * goes to art_clear at last, an art_root takes none of the routines of
+ * the binary trees.  Keys are unique.
+ *
+ * Example as follows
+ */
+
+#if 0
+struct item {
+	struct art_leaf leaf;
+	unsigned char key[8];
+	...
+};
+
+	ART_DECLARE(art);
+
+	art_leaf_init(&item->leaf, art_key_u64(item->key, id), 8);
+	if (art_insert(&art, &item->leaf))
+		return -1;
+	...
+	unsigned char key[8];
+	struct art_leaf *leaf = art_find(&art, art_key_u64(key, id), 8);
+	if (leaf)
+		item = art_entry(leaf, struct item, leaf);
+#endif
+
+#ifndef __YC_ALGOS_ART_H_
+#define __YC_ALGOS_ART_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <ycc/compiler.h>
+
+__BEGIN_DECLS
+
+struct art_leaf
+{
+	const unsigned char *key;
+	size_t len;
+};
+
+/* 'node' is an inner node or a tagged leaf */
+struct art_root
+{
+	void *node;
+	size_t count;
+};
+
+#define art_entry(ptr, type, member)	container_of(ptr, type, member)
+
+#define ART_DECLARE(name)	struct art_root name = { NULL, 0 }
+#define ART_INIT(name)							\
+	do {								\
+		(name).node = NULL;					\
+		(name).count = 0;					\
+	} while (0)
+static inline void art_init(struct art_root *art)
+{
+	ART_INIT(*art);
+}
+
+static inline bool art_empty(const struct art_root *art)
+{
+	return !art->count;
+}
+
+static inline size_t art_count(const struct art_root *art)
+{
+	return art->count;
+}
+
+static inline void art_leaf_init(struct art_leaf *leaf,
+				 const void *key, size_t len)
+{
+	leaf->key = (const unsigned char*)key;
+	leaf->len = len;
+}
+
+/* 'key' into 'buf' big-endian, returns 'buf' */
+static inline unsigned char *art_key_u64(unsigned char buf[8],
+					 uint64_t key)
+{
+	int i;
+
+	for (i = 7; i >= 0; --i, key >>= 8)
+		buf[i] = (unsigned char)key;
+
+	return buf;
+}
+
+static inline unsigned char *art_key_u32(unsigned char buf[4],
+					 uint32_t key)
+{
+	int i;
+
+	for (i = 3; i >= 0; --i, key >>= 8)
+		buf[i] = (unsigned char)key;
+
+	return buf;
+}
+
+/*
+ * art_insert  --  link 'leaf' by its key
+ *
+ * Return value
+ *	0 on success, otherwise -1 and errno is set to EEXIST if an equal
+ *	key is linked, or ENOMEM.  The tree is unchanged on failure.
+ */
+int art_insert(struct art_root *art, struct art_leaf *leaf);
+
+/*
+ * art_erase  --  unlink the leaf of 'key'
+ *
+ * Description
+ *	The leaf is not freed, a node left with too few children is
+ *	replaced by a smaller one if the allocation succeeds.
+ *
+ * Return value
+ *	The leaf unlinked, or NULL if 'key' is not found.
+ */
+struct art_leaf *art_erase(struct art_root *art,
+			   const void *key, size_t len);
+
+/*
+ * art_find, art_lower_bound, art_upper_bound  --  search 'key'
+ *
+ * Return value
+ *	The leaf of 'key', of the first key not less than 'key' or of
+ *	the first key greater than 'key', NULL if there is none.
+ */
+struct art_leaf *art_find(const struct art_root *art,
+			  const void *key, size_t len);
+struct art_leaf *art_lower_bound(const struct art_root *art,
+				 const void *key, size_t len);
+struct art_leaf *art_upper_bound(const struct art_root *art,
+				 const void *key, size_t len);
+
+/*
+ * art_first, art_last, art_next  --  iterate in key order
+ *
+ * Description
+ *	The leaves have no links, art_next searches the key of 'leaf'
+ *	again, it takes one descent.  art_visit is cheaper for a walk.
+ *
+ * Return value
+ *	The leaf, or NULL if there is none.
+ */
+struct art_leaf *art_first(const struct art_root *art);
+struct art_leaf *art_last(const struct art_root *art);
+
+static inline struct art_leaf *art_next(const struct art_root *art,
+					const struct art_leaf *leaf)
+{
+	return art_upper_bound(art, leaf->key, leaf->len);
+}
+
+/*
+ * art_visit, art_visit_cond  --  visit the leaves in key order
+ *
+ * Description
+ *	art_visit_cond stops at the first leaf 'visit_cond' returns
+ *	false for.
+ *
+ * Return value
+ *	art_visit_cond returns false if it stopped, otherwise true.
+ */
+void art_visit(const struct art_root *art,
+	       void (*visit)(const struct art_leaf *leaf, const void *arg),
+	       const void *arg);
+bool art_visit_cond(const struct art_root *art,
+		    bool (*visit_cond)(const struct art_leaf *leaf,
+				       const void *arg),
+		    const void *arg);
+
+/*
+ * art_clear  --  unlink all leaves and free the inner nodes
+ *
+ * Description
+ *	'destroy' may be NULL, otherwise it is called for every leaf in
+ *	key order, after which the leaf is not touched again.
+ */
+void art_clear(struct art_root *art,
+	       void (*destroy)(struct art_leaf *leaf, const void *arg),
+	       const void *arg);
+
+/* valid check */
+#ifndef NDEBUG
+bool art_isvalid(const struct art_root *art);
+#else
+static inline bool art_isvalid(const struct art_root *art)
+{
+	return true;
+}
+#endif
+
+__END_DECLS
+
+#endif /* __YC_ALGOS_ART_H_ */
@@ -0,0 +1,92 @@
+/*
+ * avltree-key.h -- AVL Trees on Inline Integer and Double Keys
+ *
+ * Copyright (C) 2012-2013 yanyg (cppgp@qq.com)
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING, if not see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * An avl_u32_node, avl_u64_node or avl_f64_node is an avl_node with
+ * its key right after the links.  A search reads the key from the node
+ * it walks through anyway and compares it inline, it touches no other
+ * memory: AVL_GENERATE on a key elsewhere in the entry costs one more
+ * cache line per level, avl_find a call too.
+ *
+ * The routines below are AVL_GENERATE cores, see avltree.h for the
+ * rest.  A double key MUST NOT be NaN, it orders against no other.
+ *
+ * Example as follows
+ */
+
+#if 0
+struct item {
+	struct avl_u64_node knode;
+	char value[64];
+};
+
+	item->knode.key = 5;
+	avl_u64_insert(&root, &item->knode);
+	...
+	struct avl_u64_node *found = avl_u64_find(&root, 5);
+	if (found)
+		item = container_of(found, struct item, knode);
+	...
+	avl_erase(&found->node, &root);
+#endif
+
+#ifndef __YC_ALGOS_AVLTREE_KEY_H_
+#define __YC_ALGOS_AVLTREE_KEY_H_
+
+#include <stdint.h>
+
+#include <ycc/algos/avltree.h>
+
+__BEGIN_DECLS
+
+struct avl_u32_node
+{
+	struct avl_node node;
+	uint32_t key;
+};
+
+struct avl_u64_node
+{
+	struct avl_node node;
+	uint64_t key;
+};
+
+struct avl_f64_node
+{
+	struct avl_node node;
+	double key;
+};
+
+/*
+ * avl_u64_find, avl_u64_lower_bound, avl_u64_upper_bound,
+ * avl_u64_insert, avl_u64_insert_unique  --  and the same of u32, f64
+ *
+ * They behave as avl_find, avl_lower_bound, ... on the key by value.
+ */
+__BSTLINK_KEY_GENERATE(avl_u32, struct avl_root, struct avl_node,
+		       struct avl_u32_node, uint32_t, __avl_insert_rest)
+__BSTLINK_KEY_GENERATE(avl_u64, struct avl_root, struct avl_node,
+		       struct avl_u64_node, uint64_t, __avl_insert_rest)
+__BSTLINK_KEY_GENERATE(avl_f64, struct avl_root, struct avl_node,
+		       struct avl_f64_node, double, __avl_insert_rest)
+
+__END_DECLS
+
+#endif /* __YC_ALGOS_AVLTREE_KEY_H_ */
@@ -19,14 +19,32 @@
  */
 
 /*
- * To use avltrees you'll have to implement your own insert and search cores.
- * This will avoid us to use callbacks and to drop drammatically performances.
+ * The avl_find/avl_insert family calls a compare routine through a pointer for
+ * every level, it is convenient but drops performances dramatically.
+ * AVL_GENERATE emits insert and search cores with the comparator inlined.
+ * They work on a plain avl_root, the other routines of this file apply
+ * to the tree as they are: avl_erase, avl_first, avl_next, avl_clear ...
  *
  * Example of insert and search as follows
  */
 
 #if 0
-Example of insert and search routines.
+struct item {
+	int key;
+	struct avl_node node;
+};
+
+static inline int item_cmp(const struct item *a, const struct item *b)
+{
+	return a->key < b->key ? -1 : a->key > b->key;
+}
+
+AVL_GENERATE(item_tree, struct item, node, item_cmp)
+
+	item_tree_insert(&root, item);
+	...
+	struct item key = { .key = 5 };
+	struct item *found = item_tree_find(&root, &key);
 #endif
 
 #ifndef __YC_ALGOS_AVLTREE_H_
@@ -39,7 +57,9 @@ __BEGIN_DECLS
 struct avl_node
 {
 	__BST_LINK_MEMBER(struct avl_node);
-	unsigned depth;
+#ifndef	BSTLINK_COMPACT
+	int balance;
+#endif
 } __aligned(sizeof(void*));
 
 struct avl_root
@@ -47,10 +67,28 @@ struct avl_root
 	struct avl_node *node;
 };
 
-#define avl_depth(n)	((n)->depth)
-#define avl_set_depth(n,_depth)	((n)->depth = _depth)
+/* balance factor: height(right) - height(left), one of -1, 0 and 1 */
+#ifdef	BSTLINK_COMPACT
+#define avl_balance(n)	((int)(__BSTLINK_BITS(n) ^ 2) - 2)
+#define avl_set_balance(n, bal)						\
+		__BSTLINK_SET_BITS(n, (bal) & __BSTLINK_PARENT_BITS)
+#else
+#define avl_balance(n)	((n)->balance)
+#define avl_set_balance(n, bal)	((n)->balance = (bal))
+#endif
 #define avl_entry(ptr, type, member)	container_of(ptr, type, member)
 
+static inline struct avl_node *avl_parent(const struct avl_node *node)
+{
+	return __BSTLINK_PARENT(node, struct avl_node);
+}
+
+static inline void avl_set_parent(struct avl_node *node,
+				  struct avl_node *parent)
+{
+	__BSTLINK_SET_PARENT(node, parent);
+}
+
 #define AVL_DECLARE(name)	struct avl_root name =  { NULL, }
 #define AVL_INIT(name)	do { (name).node = NULL; } while (0)
 static inline void avl_init(struct avl_root *avl)
@@ -63,7 +101,7 @@ static inline void avl_link_node(struct avl_node *node,
 				struct avl_node **pnode)
 {
 	__BSTLINK_INIT(node, parent, pnode);
-	node->depth = 1;
+	avl_set_balance(node, 0);
 }
 
 static inline struct avl_node *avl_first(const struct avl_root *avl)
@@ -89,6 +127,85 @@ static inline struct avl_node *avl_prev(const struct avl_node* node)
 void avl_insert_rebalance(struct avl_node *node, struct avl_root *avl);
 void avl_erase(struct avl_node *node, struct avl_root *avl);
 
+/*
+ * avl_build_sorted  --  build avl from 'nodes[0..num)' in O(num)
+ *
+ * 'nodes' MUST be sorted already, no compare routine is called.
+ * The old content of 'avl' is dropped.
+ */
+void avl_build_sorted(struct avl_root *avl,
+		      struct avl_node **nodes,
+		      size_t num);
+
+/*
+ * avl_split  --  split avl by 'arg' in O(log n)
+ *
+ * Nodes less than 'arg' (compare returns < 0) go to 'left', the others
+ * go to 'right'.  'avl' is emptied, it may be the same as 'left' or
+ * 'right'.
+ */
+void avl_split(struct avl_root *avl,
+	       int (*compare)(const struct avl_node *node, const void *arg),
+	       const void *arg,
+	       struct avl_root *left,
+	       struct avl_root *right);
+
+/*
+ * avl_join  --  join 'left', 'pivot' and 'right' into avl in O(log n)
+ *
+ * All nodes of 'left' MUST order before 'pivot', all nodes of 'right'
+ * after it.  'left' and 'right' are emptied, either may be 'avl'.
+ */
+void avl_join(struct avl_root *avl,
+	      struct avl_root *left,
+	      struct avl_node *pivot,
+	      struct avl_root *right);
+
+/* avl_concat  --  avl_join without pivot */
+void avl_concat(struct avl_root *avl,
+		struct avl_root *left,
+		struct avl_root *right);
+
+/*
+ * avl_union, avl_intersection, avl_difference  --  set algorithms
+ *
+ * 'avl1' and 'avl2' are consumed and the result goes to 'avl', which may be
+ * either of them.  Nodes of 'avl1' are kept on equal keys, every node
+ * dropped from either tree goes to 'destroy', which may run on any
+ * thread.  It costs O(m log(n/m + 1)) for trees of m <= n nodes and
+ * forks onto up to 'nthreads' threads, 0 means one per online cpu.
+ */
+void avl_union(struct avl_root *avl,
+	       struct avl_root *avl1,
+	       struct avl_root *avl2,
+	       int (*compare_link)(const struct avl_node *node1,
+				   const struct avl_node *node2,
+				   const void *arg),
+	       void (*destroy)(struct avl_node *node, const void *arg),
+	       const void *arg_compare,
+	       const void *arg_destroy,
+	       unsigned nthreads);
+void avl_intersection(struct avl_root *avl,
+		      struct avl_root *avl1,
+		      struct avl_root *avl2,
+		      int (*compare_link)(const struct avl_node *node1,
+					  const struct avl_node *node2,
+					  const void *arg),
+		      void (*destroy)(struct avl_node *node, const void *arg),
+		      const void *arg_compare,
+		      const void *arg_destroy,
+		      unsigned nthreads);
+void avl_difference(struct avl_root *avl,
+		    struct avl_root *avl1,
+		    struct avl_root *avl2,
+		    int (*compare_link)(const struct avl_node *node1,
+					const struct avl_node *node2,
+					const void *arg),
+		    void (*destroy)(struct avl_node *node, const void *arg),
+		    const void *arg_compare,
+		    const void *arg_destroy,
+		    unsigned nthreads);
+
 
 /* helper routine */
 static inline struct avl_node *
@@ -118,6 +235,35 @@ avl_upper_bound(const struct avl_root *avl,
 	return __BSTLINK_UPPER_BOUND(avl->node, compare, arg, struct avl_node);
 }
 
+/*
+ * avl_find_batch, avl_lower_bound_batch  --  batched search
+ *
+ * 'results[i]' is set to the node avl_find (avl_lower_bound) returns
+ * for 'args[i]'.  The searches share the memory latency, see
+ * bstlink_find_batch.
+ */
+static inline void
+avl_find_batch(const struct avl_root *avl,
+	       int (*compare)(const struct avl_node *node,
+			      const void *arg),
+	       const void * const *args,
+	       size_t num,
+	       struct avl_node **results)
+{
+	__BSTLINK_FIND_BATCH(avl->node, compare, args, num, results);
+}
+
+static inline void
+avl_lower_bound_batch(const struct avl_root *avl,
+		      int (*compare)(const struct avl_node *node,
+				     const void *arg),
+		      const void * const *args,
+		      size_t num,
+		      struct avl_node **results)
+{
+	__BSTLINK_LOWER_BOUND_BATCH(avl->node, compare, args, num, results);
+}
+
 static inline void
 avl_lower_upper_bound(const struct avl_root *avl,
 		     int (*compare)(const struct avl_node *node,
@@ -133,7 +279,7 @@ avl_lower_upper_bound(const struct avl_root *avl,
 static inline void
 __avl_insert_rest(struct avl_node *node, struct avl_root *avl)
 {
-	avl_set_depth(node, 1);
+	avl_set_balance(node, 0);
 	avl_insert_rebalance(node, avl);
 }
 
@@ -160,7 +306,7 @@ avl_insert_unique(struct avl_node *node,
 {
 	
 	if (__BSTLINK_INSERT(node, &avl->node, compare_link,
-				       arg, false))
+				       arg, true))
 	{
 		__avl_insert_rest(node, avl);
 		return true;
@@ -169,11 +315,37 @@ avl_insert_unique(struct avl_node *node,
 	return false;
 }
 
+/*
+ * avl_insert_hint  --  avl_insert searching from 'hint'
+ *
+ * 'hint' is a node of 'avl' near the new one, typically the last node
+ * inserted, or NULL.  An ascending (descending) stream hinted with the
+ * last node costs O(1) compares per insert, see bstlink_insert_hint.
+ */
+static inline void
+avl_insert_hint(struct avl_node *node,
+		struct avl_node *hint,
+		struct avl_root *avl,
+		int (*compare_link)(const struct avl_node *node1,
+				    const struct avl_node *node2,
+				    const void *arg),
+		const void *arg)
+{
+	__BSTLINK_INSERT_HINT(node, hint, &avl->node, compare_link, arg);
+	__avl_insert_rest(node, avl);
+}
+
+/* comparator-inlined cores, see the example at the top of this file */
+#define AVL_GENERATE(name, type, member, cmp)				\
+	__BSTLINK_GENERATE(name, struct avl_root, struct avl_node,	\
+			   type, member, cmp,				\
+			   __BSTLINK_NOP, __avl_insert_rest)
+
 static inline void
 avl_replace(struct avl_node *victim, struct avl_node *new, struct avl_root *avl)
 {
 	__BSTLINK_REPLACE(victim, new, &avl->node);
-	avl_set_depth(new, victim->depth);
+	avl_set_balance(new, avl_balance(victim));
 }
 
 static inline void avl_erase_range(struct avl_node *beg,
@@ -203,6 +375,71 @@ avl_count(const struct avl_root *avl,
 	return __BSTLINK_COUNT(avl->node, compare, arg);
 }
 
+#ifdef	BSTLINK_SIZE
+/*
+ * avl_select, avl_rank, avl_count_range  --  order statistics
+ *
+ * avl_select returns the k-th (0 based) node or NULL, avl_rank returns
+ * the count of nodes before 'node'.  avl_count_range counts the nodes
+ * in ['arg_lo', 'arg_hi') as judged by 'compare'.  All cost O(log n).
+ */
+static inline struct avl_node *
+avl_select(const struct avl_root *avl, size_t k)
+{
+	return __BSTLINK_SELECT(avl->node, k, struct avl_node);
+}
+
+static inline size_t avl_rank(const struct avl_node *node)
+{
+	return __BSTLINK_RANK(node);
+}
+
+static inline size_t
+avl_count_range(const struct avl_root *avl,
+		int (*compare)(const struct avl_node *node,
+			       const void *arg),
+		const void *arg_lo,
+		const void *arg_hi)
+{
+	size_t lo = __BSTLINK_COUNT_LESS(avl->node, compare, arg_lo, false);
+	size_t hi = __BSTLINK_COUNT_LESS(avl->node, compare, arg_hi, false);
+
+	return hi > lo ? hi - lo : 0;
+}
+#endif
+
+/*
+ * avl_freeze  --  build a read-only search array of avl
+ *
+ * 'key' MUST not decrease in tree order.  avl_frozen_find and
+ * avl_frozen_lower_bound return the left-most node whose key is
+ * equal to (not less than) 'key', or NULL.  See struct bst_frozen.
+ */
+static inline int
+avl_freeze(struct bst_frozen *frz,
+	   const struct avl_root *avl,
+	   unsigned long (*key)(const struct avl_node *node))
+{
+	return __BSTLINK_FREEZE(frz, avl->node, key);
+}
+
+static inline struct avl_node *
+avl_frozen_find(const struct bst_frozen *frz, unsigned long key)
+{
+	return __BSTLINK_FROZEN_FIND(frz, key, struct avl_node);
+}
+
+static inline struct avl_node *
+avl_frozen_lower_bound(const struct bst_frozen *frz, unsigned long key)
+{
+	return __BSTLINK_FROZEN_LOWER_BOUND(frz, key, struct avl_node);
+}
+
+static inline void avl_frozen_destroy(struct bst_frozen *frz)
+{
+	bstlink_frozen_destroy(frz);
+}
+
 static inline void
 avl_clear(struct avl_root *avl,
 	 void (*destroy)(struct avl_node *node, const void *arg),
@@ -0,0 +1,273 @@
+/*
+ * bptree.h -- B+ Trees
+ *
+ * Copyright (C) 2012-2013 yanyg (cppgp@qq.com)
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING, if not see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * The binary trees take one pointer chase, and likely one cache miss,
+ * per level.  The B+ tree keeps up to BPT_LEAF_ORDER keys per node in a
+ * plain array which is searched in-node, so a lookup touches about
+ * log(n)/log(BPT_INNER_ORDER) nodes.  Values live in the leaves only,
+ * the leaves are linked for range scans.
+ *
+ * Unlike the binary trees it is not intrusive: it maps 'unsigned long'
+ * keys to 'void *' values and allocates its nodes.  Equal keys are
+ * allowed, bpt_insert puts a key after its equals.  Any insert or
+ * erase invalidates the iterators except the one given to bpt_erase.
+ *
+ * Example of insert and range scan as follows
+ */
+
+#if 0
+	BPT_DECLARE(bpt);
+	struct bpt_iter iter;
+
+	if (bpt_insert(&bpt, key, item))
+		return -1;
+	...
+	for (bpt_lower_bound(&bpt, lo, &iter);
+	     !bpt_iter_end(&iter) && bpt_iter_key(&iter) < hi;
+	     bpt_next(&iter))
+		use(bpt_iter_value(&iter));
+#endif
+
+#ifndef __YC_ALGOS_BPTREE_H_
+#define __YC_ALGOS_BPTREE_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include <ycc/compiler.h>
+
+__BEGIN_DECLS
+
+/* bytes per node, a multiple of the cache line, 4096 for page nodes */
+#ifndef BPT_NODE_SIZE
+#define BPT_NODE_SIZE	256
+#endif
+#define BPT_CACHE_LINE	64
+
+struct bpt_inner;
+
+struct bpt_node
+{
+	struct bpt_inner *parent;
+	unsigned short num;	/* keys in use */
+	unsigned short leaf;
+};
+
+#define BPT_LEAF_ORDER							\
+	((BPT_NODE_SIZE - sizeof(struct bpt_node) - 2 * sizeof(void*)) /	\
+	 (sizeof(unsigned long) + sizeof(void*)))
+#define BPT_INNER_ORDER							\
+	((BPT_NODE_SIZE - sizeof(struct bpt_node) - sizeof(void*)) /	\
+	 (sizeof(unsigned long) + sizeof(void*)))
+
+struct bpt_leaf
+{
+	struct bpt_node node;
+	struct bpt_leaf *prev, *next;
+	unsigned long keys[BPT_LEAF_ORDER];
+	void *values[BPT_LEAF_ORDER];
+} __aligned(BPT_CACHE_LINE);
+
+/* keys[i] separates children[i] (keys <= it) and children[i+1] (>= it) */
+struct bpt_inner
+{
+	struct bpt_node node;
+	unsigned long keys[BPT_INNER_ORDER];
+	struct bpt_node *children[BPT_INNER_ORDER + 1];
+} __aligned(BPT_CACHE_LINE);
+
+struct bpt_root
+{
+	struct bpt_node *node;
+	struct bpt_leaf *first, *last;
+	size_t count;
+};
+
+/* a position in the tree, 'leaf' is NULL past the last key */
+struct bpt_iter
+{
+	struct bpt_leaf *leaf;
+	unsigned pos;
+};
+
+#define BPT_DECLARE(name)	struct bpt_root name = { NULL, NULL, NULL, 0 }
+#define BPT_INIT(name)							\
+	do {								\
+		(name).node = NULL;					\
+		(name).first = (name).last = NULL;			\
+		(name).count = 0;					\
+	} while (0)
+static inline void bpt_init(struct bpt_root *bpt)
+{
+	BPT_INIT(*bpt);
+}
+
+static inline bool bpt_empty(const struct bpt_root *bpt)
+{
+	return !bpt->count;
+}
+
+static inline size_t bpt_count(const struct bpt_root *bpt)
+{
+	return bpt->count;
+}
+
+static inline bool bpt_iter_end(const struct bpt_iter *iter)
+{
+	return !iter->leaf;
+}
+
+static inline unsigned long bpt_iter_key(const struct bpt_iter *iter)
+{
+	return iter->leaf->keys[iter->pos];
+}
+
+static inline void *bpt_iter_value(const struct bpt_iter *iter)
+{
+	return iter->leaf->values[iter->pos];
+}
+
+static inline void bpt_iter_set_value(const struct bpt_iter *iter,
+				      void *value)
+{
+	iter->leaf->values[iter->pos] = value;
+}
+
+/*
+ * bpt_first, bpt_last, bpt_next, bpt_prev  --  iterate in key order
+ *
+ * Return value
+ *	false and an end iterator if there is no such key.
+ */
+static inline bool bpt_first(const struct bpt_root *bpt,
+			     struct bpt_iter *iter)
+{
+	iter->leaf = bpt->first;
+	iter->pos = 0;
+	return iter->leaf != NULL;
+}
+
+static inline bool bpt_last(const struct bpt_root *bpt,
+			    struct bpt_iter *iter)
+{
+	iter->leaf = bpt->last;
+	iter->pos = iter->leaf ? iter->leaf->node.num - 1u : 0;
+	return iter->leaf != NULL;
+}
+
+static inline bool bpt_next(struct bpt_iter *iter)
+{
+	if (++iter->pos == iter->leaf->node.num) {
+		iter->leaf = iter->leaf->next;
+		iter->pos = 0;
+	}
+	return iter->leaf != NULL;
+}
+
+static inline bool bpt_prev(struct bpt_iter *iter)
+{
+	if (iter->pos--)
+		return true;
+
+	iter->leaf = iter->leaf->prev;
+	iter->pos = iter->leaf ? iter->leaf->node.num - 1u : 0;
+	return iter->leaf != NULL;
+}
+
+/*
+ * bpt_insert, bpt_insert_unique  --  insert 'key' mapping to 'value'
+ *
+ * Description
+ *	bpt_insert puts 'key' after the equal keys, bpt_insert_unique
+ *	refuses it if an equal key exists.
+ *
+ * Return value
+ *	0 on success, otherwise -1 and errno is set to ENOMEM, or
+ *	EEXIST by bpt_insert_unique.
+ */
+int bpt_insert(struct bpt_root *bpt, unsigned long key, void *value);
+int bpt_insert_unique(struct bpt_root *bpt, unsigned long key, void *value);
+
+/*
+ * bpt_find, bpt_lower_bound, bpt_upper_bound  --  search 'key'
+ *
+ * Description
+ *	bpt_find finds the first key equal to 'key', bpt_lower_bound the
+ *	first key not less than 'key' and bpt_upper_bound the first key
+ *	greater than 'key'.
+ *
+ * Return value
+ *	true if found, otherwise false and 'iter' is the end.
+ */
+bool bpt_find(const struct bpt_root *bpt, unsigned long key,
+	      struct bpt_iter *iter);
+bool bpt_lower_bound(const struct bpt_root *bpt, unsigned long key,
+		     struct bpt_iter *iter);
+bool bpt_upper_bound(const struct bpt_root *bpt, unsigned long key,
+		     struct bpt_iter *iter);
+
+/*
+ * bpt_erase  --  erase the key at 'iter'
+ *
+ * Description
+ *	The function erases the key at 'iter' and moves 'iter' to the
+ *	key following it, the other iterators are invalidated.
+ */
+void bpt_erase(struct bpt_root *bpt, struct bpt_iter *iter);
+
+/*
+ * bpt_erase_range  --  erase keys of [beg, end)
+ *
+ * Description
+ *	'end' may be an end iterator, both are invalid on return.
+ *
+ * Return value
+ *	The number of erased keys.
+ */
+size_t bpt_erase_range(struct bpt_root *bpt,
+		       const struct bpt_iter *beg,
+		       const struct bpt_iter *end);
+
+/*
+ * bpt_clear  --  erase all keys
+ *
+ * Description
+ *	'destroy' may be NULL, otherwise it is called for every key in
+ *	order.
+ */
+void bpt_clear(struct bpt_root *bpt,
+	       void (*destroy)(unsigned long key, void *value,
+			       const void *arg),
+	       const void *arg);
+
+/* valid check */
+#ifndef NDEBUG
+bool bpt_isvalid(const struct bpt_root *bpt);
+#else
+static inline bool bpt_isvalid(const struct bpt_root *bpt)
+{
+	return true;
+}
+#endif
+
+__END_DECLS
+
+#endif /* __YC_ALGOS_BPTREE_H_ */
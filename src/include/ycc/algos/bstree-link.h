@@ -34,26 +34,190 @@
 
 __BEGIN_DECLS
 
-/* bstlink: Binary Search Tree Link */
+/*
+ * bstlink: Binary Search Tree Link
+ *
+ * With BSTLINK_SIZE (configure --enable-bstlink-size) every link also
+ * keeps the node count of its subtree, which makes select, rank and
+ * count O(log n).  Every tree keeps it up to date in insert, erase,
+ * rotations, split and join.
+ *
+ * With BSTLINK_COMPACT (configure --enable-bstlink-compact) the parent
+ * link is a word whose low two bits belong to the tree, rb keeps its
+ * color and avl its balance there, so neither needs an extra member.
+ * Always go through the *_parent and *_set_parent accessors.
+ */
+#ifdef	BSTLINK_COMPACT
+#define __BST_LINK_PARENT(type)	unsigned long __parent
+#define __BSTLINK_PARENT_BITS	3UL
+#define __BSTLINK_PARENT(link, type)					\
+		((type*)((link)->__parent & ~__BSTLINK_PARENT_BITS))
+#define __BSTLINK_SET_PARENT(link, p)					\
+		((link)->__parent = (unsigned long)(p) |		\
+				    ((link)->__parent & __BSTLINK_PARENT_BITS))
+#define __BSTLINK_BITS(link)						\
+		((unsigned)((link)->__parent & __BSTLINK_PARENT_BITS))
+#define __BSTLINK_SET_BITS(link, bits)					\
+		((link)->__parent = ((link)->__parent &			\
+				     ~__BSTLINK_PARENT_BITS) | (bits))
+#else
+#define __BST_LINK_PARENT(type)	type *parent
+#define __BSTLINK_PARENT(link, type)	((type*)(link)->parent)
+#define __BSTLINK_SET_PARENT(link, p)	((link)->parent = (p))
+#endif
+
+#ifdef	BSTLINK_SIZE
+#define __BST_LINK_MEMBER(type)	\
+	__BST_LINK_PARENT(type); type *left, *right; size_t size
+#else
 #define __BST_LINK_MEMBER(type)	\
-	type *parent, *left, *right
+	__BST_LINK_PARENT(type); type *left, *right
+#endif
+
+/* the shared routines access every tree node as a bst_link */
 struct bst_link
 {
 	__BST_LINK_MEMBER(struct bst_link);
-}__aligned(sizeof(void*));
+} __attribute__((__may_alias__)) __aligned(sizeof(void*));
+
+static inline struct bst_link *bstlink_parent(const struct bst_link *link)
+{
+	return __BSTLINK_PARENT(link, struct bst_link);
+}
+
+static inline void bstlink_set_parent(struct bst_link *link,
+				      struct bst_link *parent)
+{
+	__BSTLINK_SET_PARENT(link, parent);
+}
+
+#ifdef	BSTLINK_SIZE
+static inline size_t bstlink_size(const struct bst_link *link)
+{
+	return link ? link->size : 0;
+}
+
+static inline void bstlink_size_update(struct bst_link *link)
+{
+	link->size = bstlink_size(link->left) + bstlink_size(link->right) + 1;
+}
+#endif
+
+/* recount 'link' and its ancestors after its children changed */
+static inline void bstlink_size_fixup(struct bst_link *link)
+{
+#ifdef	BSTLINK_SIZE
+	for (; link; link = bstlink_parent(link))
+		bstlink_size_update(link);
+#endif
+}
+
+/* add 'delta' (may wrap to subtract) to 'link' and its ancestors */
+static inline void bstlink_size_add(struct bst_link *link, size_t delta)
+{
+#ifdef	BSTLINK_SIZE
+	for (; link; link = bstlink_parent(link))
+		link->size += delta;
+#endif
+}
+
+/*
+ * __BSTLINK_STORE  --  store a child or root link
+ *
+ * 'once' makes it a single store, as WRITE_ONCE of the kernel, for a
+ * tree searched without lock while it changes (rbtree-seq.h).  It is
+ * a constant at every call, the other trees keep the plain store.
+ */
+#define __BSTLINK_STORE(lhs, value, once)				\
+	do {								\
+		if (once)						\
+			__atomic_store_n(&(lhs), (value),		\
+					 __ATOMIC_RELAXED);		\
+		else							\
+			(lhs) = (value);				\
+	} while (0)
 
 void bstlink_rotate_left(struct bst_link *link, struct bst_link **pproot);
 void bstlink_rotate_right(struct bst_link *link, struct bst_link **proot);
 
+/* the same with the links stored by __BSTLINK_STORE(.., true) */
+void bstlink_rotate_left_once(struct bst_link *link, struct bst_link **proot);
+void bstlink_rotate_right_once(struct bst_link *link,
+			       struct bst_link **proot);
+
 struct bst_link *bstlink_first(const struct bst_link *link);
 struct bst_link *bstlink_last(const struct bst_link *link);
 struct bst_link *bstlink_next(const struct bst_link *link);
 struct bst_link *bstlink_prev(const struct bst_link *link);
 
+/*
+ * bstlink_next_preorder, bstlink_next_inorder, bstlink_next_postorder
+ *	--  iterate the subtree 'root' without stack
+ *
+ * Description
+ *	The functions step to the node after 'link' in the subtree
+ *	'root' by the child and parent links only, no node above 'root'
+ *	is touched.  The first node is 'root' itself in preorder,
+ *	bstlink_first(root) in inorder, and bstlink_first_postorder(root)
+ *	in postorder.  A postorder step does not read the children of
+ *	'link' again, 'link' may be freed once the next one is known.
+ *
+ * Return value
+ *	The next node, or NULL after the last one.
+ */
+struct bst_link *bstlink_next_preorder(const struct bst_link *link,
+				       const struct bst_link *root);
+struct bst_link *bstlink_next_inorder(const struct bst_link *link,
+				      const struct bst_link *root);
+struct bst_link *bstlink_first_postorder(const struct bst_link *root);
+struct bst_link *bstlink_next_postorder(const struct bst_link *link,
+					const struct bst_link *root);
+
 void bstlink_replace(struct bst_link *victim,
 		     struct bst_link *new,
 		     struct bst_link **proot);
 
+/*
+ * bstlink_augment  --  keep a per-node aggregate of the subtree
+ *
+ *	propagate	: recompute from 'link' up to, but not including,
+ *			  'stop' (NULL for the root), it may return as soon
+ *			  as a value does not change
+ *	copy		: 'new' takes the place of 'old', copy the value
+ *	rotate		: 'new' became the parent of 'old' by a rotation,
+ *			  it takes the value of 'old' and 'old' recomputes
+ */
+struct bstlink_augment
+{
+	void (*propagate)(struct bst_link *link, struct bst_link *stop);
+	void (*copy)(struct bst_link *old, struct bst_link *new);
+	void (*rotate)(struct bst_link *old, struct bst_link *new);
+};
+
+static inline void
+bstlink_rotate_left_augment(struct bst_link *link,
+			    struct bst_link **proot,
+			    const struct bstlink_augment *augment)
+{
+	struct bst_link *right = link->right;
+
+	bstlink_rotate_left(link, proot);
+	if (augment)
+		augment->rotate(link, right);
+}
+
+static inline void
+bstlink_rotate_right_augment(struct bst_link *link,
+			     struct bst_link **proot,
+			     const struct bstlink_augment *augment)
+{
+	struct bst_link *left = link->left;
+
+	bstlink_rotate_right(link, proot);
+	if (augment)
+		augment->rotate(link, left);
+}
+
 /* auto-convert macros */
 #define __BSTLINK_ROTATE_LEFT(link, pproot)				\
 		bstlink_rotate_left					\
@@ -69,6 +233,36 @@ void bstlink_replace(struct bst_link *victim,
 			(struct bst_link**)pproot			\
 		)
 
+#define __BSTLINK_ROTATE_LEFT_ONCE(link, pproot)			\
+		bstlink_rotate_left_once				\
+		(							\
+			(struct bst_link*)link,				\
+			(struct bst_link**)pproot			\
+		)
+
+#define __BSTLINK_ROTATE_RIGHT_ONCE(link, pproot)			\
+		bstlink_rotate_right_once				\
+		(							\
+			(struct bst_link*)link,				\
+			(struct bst_link**)pproot			\
+		)
+
+#define __BSTLINK_ROTATE_LEFT_AUGMENT(link, pproot, augment)		\
+		bstlink_rotate_left_augment				\
+		(							\
+			(struct bst_link*)link,				\
+			(struct bst_link**)pproot,			\
+			(const struct bstlink_augment*)(augment)	\
+		)
+
+#define __BSTLINK_ROTATE_RIGHT_AUGMENT(link, pproot, augment)		\
+		bstlink_rotate_right_augment				\
+		(							\
+			(struct bst_link*)link,				\
+			(struct bst_link**)pproot,			\
+			(const struct bstlink_augment*)(augment)	\
+		)
+
 #define __BSTLINK_FIRST(link, type)					\
 		(type*)							\
 		bstlink_first						\
@@ -119,14 +313,26 @@ typedef int (*bstlink_compare_link_t)(const struct bst_link *link1,
 typedef void (*bstlink_visit_t)(const struct bst_link *link, const void *arg);
 typedef bool (*bstlink_visit_cond_t)(const struct bst_link *link,
 				     const void *arg);
+typedef void (*bstlink_build_t)(struct bst_link *link,
+				size_t depth,
+				size_t height,
+				const void *arg);
 
 static inline void bstlink_init(struct bst_link *link,
 				struct bst_link *parent,
 				struct bst_link **plink)
 {
+#ifdef	BSTLINK_COMPACT
+	link->__parent = (unsigned long)parent;
+#else
 	link->parent = parent;
+#endif
 	link->left = link->right = NULL;
 	*plink = link;
+#ifdef	BSTLINK_SIZE
+	link->size = 1;
+	bstlink_size_add(parent, 1);
+#endif
 }
 
 /*
@@ -199,12 +405,67 @@ void bstlink_lower_upper_bound(const struct bst_link *link,
 			       struct bst_link **plb,
 			       struct bst_link **pub);
 
+/*
+ * bstlink_find_batch, bstlink_lower_bound_batch  --  search many args
+ *
+ * Description
+ *	The functions do bstlink_find (bstlink_lower_bound) for every
+ *	'args[i]' and store the node into 'results[i]'.  The searches
+ *	walk the tree in lockstep and prefetch every node before it is
+ *	compared, so on trees larger than the cache the misses of one
+ *	search overlap those of the others.  Batches of 64 or more
+ *	work best.
+ */
+void bstlink_find_batch(const struct bst_link *link,
+			bstlink_compare_t compare,
+			const void * const *args,
+			size_t num,
+			struct bst_link **results);
+void bstlink_lower_bound_batch(const struct bst_link *link,
+			       bstlink_compare_t compare,
+			       const void * const *args,
+			       size_t num,
+			       struct bst_link **results);
+
 bool bstlink_insert(struct bst_link *link,
 		    struct bst_link **proot,
 		    bstlink_compare_link_t compare_link,
 		    const void *arg,
 		    bool bunique);
 
+/*
+ * bstlink_insert_once  --  bstlink_insert for a tree searched without lock
+ *
+ * Description
+ *	'link' is stored into its parent by a release store, whatever
+ *	was written to it before (the key too) is visible to a search
+ *	which reaches it.
+ */
+bool bstlink_insert_once(struct bst_link *link,
+			 struct bst_link **proot,
+			 bstlink_compare_link_t compare_link,
+			 const void *arg,
+			 bool bunique);
+
+/*
+ * bstlink_insert_hint  --  insert starting from a nearby node
+ *
+ * Description
+ *	The function links 'link' where bstlink_insert (not unique)
+ *	would, but searches from 'hint' instead of the root: it costs
+ *	O(log d) compares for a position d nodes away from 'hint'.
+ *	With 'hint' the last node inserted, an ascending stream costs
+ *	O(1) compares per insert.
+ *
+ * Parameters
+ *	hint	: a node of the tree, NULL to search from the root
+ */
+void bstlink_insert_hint(struct bst_link *link,
+			 struct bst_link *hint,
+			 struct bst_link **proot,
+			 bstlink_compare_link_t compare_link,
+			 const void *arg);
+
 static inline void bstlink_erase_range(struct bst_link *beg,
 				       struct bst_link *end,
 				       bstlink_erase_t erase,
@@ -245,6 +506,44 @@ size_t bstlink_count(const struct bst_link *link,
 		   bstlink_compare_t compare,
 		   const void *arg);
 
+#ifdef	BSTLINK_SIZE
+/*
+ * bstlink_select  --  find the k-th node
+ *
+ * Description
+ *	The function finds the node which has 'k' nodes before it in
+ *	the 'link' subtree, it costs O(height).
+ *
+ * Return value
+ *	The k-th (0 based) node or NULL if 'k' is out of range.
+ */
+struct bst_link *bstlink_select(const struct bst_link *link, size_t k);
+
+/* bstlink_rank  --  count of nodes before 'link' in the whole tree */
+size_t bstlink_rank(const struct bst_link *link);
+
+/*
+ * bstlink_count_less  --  count of nodes which value less than
+ *
+ * Description
+ *	The function counts the nodes of the 'link' subtree for which
+ *	'compare' is negative, or non-positive if 'bequal' is true.
+ *	It costs O(height).
+ */
+size_t bstlink_count_less(const struct bst_link *link,
+			  bstlink_compare_t compare,
+			  const void *arg,
+			  bool bequal);
+#endif
+
+/*
+ * The traversals below neither recurse nor allocate.  They keep the
+ * last 64 ancestors on the way down, enough for any balanced tree, and
+ * go deeper by climbing the parent links (visit, height) or by
+ * rotations (destroy).  bstlink_destroy does not read the parent links,
+ * it calls 'destroy' on the nodes in order.
+ */
+
 /* destroy all link and its descendant */
 void bstlink_destroy(struct bst_link *link,
 		   bstlink_destroy_t destroy,
@@ -260,6 +559,88 @@ bool bstlink_visit_cond(struct bst_link *link,
 
 size_t bstlink_height(const struct bst_link *link, bool bmax);
 
+/*
+ * bstlink_build_sorted  --  link sorted nodes into a balanced tree
+ *
+ * Description
+ *	The function links 'links[0..num)', which MUST be sorted already,
+ *	into a tree whose null links all lie on the last two levels.
+ *	It runs in O(num) and calls no compare routine, 'build' is
+ *	called on every link after its subtree is linked so the caller
+ *	can set up colors, depths, priorities, etc.  The calls go in
+ *	post-order, the left subtree, the right one, and then the link.
+ *
+ * Parameters
+ *	links	: the sorted nodes
+ *	num	: count of links
+ *	build	: called with the link's depth (root is 0) and the height
+ *		  of its subtree (leaf is 1), can be NULL
+ *	arg	: transfer to 'build' transparently
+ *
+ * Return value
+ *	The root of the new tree, or NULL if num is 0.
+ */
+struct bst_link *bstlink_build_sorted(struct bst_link **links,
+				      size_t num,
+				      bstlink_build_t build,
+				      const void *arg);
+
+/* the levels of a tree built by bstlink_build_sorted from 'num' nodes */
+static inline size_t bstlink_build_height(size_t num)
+{
+	size_t h = 0;
+
+	while (num) {
+		++h;
+		num >>= 1;
+	}
+
+	return h;
+}
+
+/*
+ * struct bst_frozen  --  read-only search array of a tree
+ *
+ * bstlink_freeze copies the keys of a tree in Eytzinger order into a
+ * cache-line aligned array, next to the links they came from.  Lookups
+ * on it are branch-free and prefetch ahead, and since nothing changes
+ * after the build any number of threads may search it without locks.
+ * It does not follow later changes of the tree, and the nodes MUST
+ * outlive it.
+ */
+struct bst_frozen
+{
+	size_t num;
+	unsigned long *keys;		/* keys[1..num] */
+	struct bst_link **links;	/* links[1..num] */
+};
+
+typedef unsigned long (*bstlink_key_t)(const struct bst_link *link);
+
+/*
+ * bstlink_freeze  --  build a frozen search array of 'link'
+ *
+ * Parameters
+ *	frz	: the array to build
+ *	link	: the root of the tree, may be NULL
+ *	key	: the key of a link, MUST not decrease in tree order
+ *
+ * Return value
+ *	0 on success, 'frz' is then freed by bstlink_frozen_destroy.
+ *	Otherwise -1 and errno is set to ENOMEM if the arrays of keys and
+ *	links cannot be allocated, nothing is left to destroy.
+ */
+int bstlink_freeze(struct bst_frozen *frz,
+		   const struct bst_link *link,
+		   bstlink_key_t key);
+void bstlink_frozen_destroy(struct bst_frozen *frz);
+
+/* the left-most link whose key is equal to (not less than) 'key' */
+struct bst_link *bstlink_frozen_find(const struct bst_frozen *frz,
+				     unsigned long key);
+struct bst_link *bstlink_frozen_lower_bound(const struct bst_frozen *frz,
+					    unsigned long key);
+
 #define __BSTLINK_INIT(link, parent, plink)				\
 		bstlink_init						\
 		(							\
@@ -316,6 +697,27 @@ size_t bstlink_height(const struct bst_link *link, bool bmax);
 			(bunique)					\
 		)
 
+#define __BSTLINK_INSERT_ONCE(link, proot,				\
+			      compare_link, arg, bunique)		\
+		bstlink_insert_once					\
+		(							\
+			(struct bst_link*)(link),			\
+			(struct bst_link**)(proot),			\
+			(bstlink_compare_link_t)(compare_link),		\
+			(const void*)(arg),				\
+			(bunique)					\
+		)
+
+#define __BSTLINK_INSERT_HINT(link, hint, proot, compare_link, arg)	\
+		bstlink_insert_hint					\
+		(							\
+			(struct bst_link*)(link),			\
+			(struct bst_link*)(hint),			\
+			(struct bst_link**)(proot),			\
+			(bstlink_compare_link_t)(compare_link),		\
+			(const void*)(arg)				\
+		)
+
 #define __BSTLINK_ERASE_RANGE(beg, end, erase, arg)			\
 		bstlink_erase_range					\
 		(							\
@@ -346,6 +748,35 @@ size_t bstlink_height(const struct bst_link *link, bool bmax);
 			(const void*)(arg)				\
 		)
 
+#define __BSTLINK_SELECT(link, k, type)					\
+		(type*)							\
+		bstlink_select						\
+		(							\
+			(const struct bst_link*)(link),			\
+			(k)						\
+		)
+
+#define __BSTLINK_RANK(link)						\
+		bstlink_rank						\
+		(							\
+			(const struct bst_link*)(link)			\
+		)
+
+#define __BSTLINK_COUNT_LESS(link, compare, arg, bequal)		\
+		bstlink_count_less					\
+		(							\
+			(const struct bst_link*)(link),			\
+			(bstlink_compare_t)(compare),			\
+			(const void*)(arg),				\
+			(bequal)					\
+		)
+
+#define __BSTLINK_SIZE_FIXUP(link)					\
+		bstlink_size_fixup					\
+		(							\
+			(struct bst_link*)(link)			\
+		)
+
 #define __BSTLINK_DESTROY(link, destroy, arg)				\
 		bstlink_destroy						\
 		(							\
@@ -377,6 +808,267 @@ size_t bstlink_height(const struct bst_link *link, bool bmax);
 			(bmax)						\
 		)
 
+#define __BSTLINK_BUILD_SORTED(links, num, build, arg, type)		\
+		(type*)							\
+		bstlink_build_sorted					\
+		(							\
+			(struct bst_link**)(links),			\
+			(num),						\
+			(bstlink_build_t)(build),			\
+			(const void*)(arg)				\
+		)
+
+#define __BSTLINK_FIND_BATCH(link, compare, args, num, results)		\
+		bstlink_find_batch					\
+		(							\
+			(const struct bst_link*)(link),			\
+			(bstlink_compare_t)(compare),			\
+			(args),						\
+			(num),						\
+			(struct bst_link**)(results)			\
+		)
+
+#define __BSTLINK_LOWER_BOUND_BATCH(link, compare, args, num, results)	\
+		bstlink_lower_bound_batch				\
+		(							\
+			(const struct bst_link*)(link),			\
+			(bstlink_compare_t)(compare),			\
+			(args),						\
+			(num),						\
+			(struct bst_link**)(results)			\
+		)
+
+#define __BSTLINK_FREEZE(frz, link, key)				\
+		bstlink_freeze						\
+		(							\
+			(frz),						\
+			(const struct bst_link*)(link),			\
+			(bstlink_key_t)(key)				\
+		)
+
+#define __BSTLINK_FROZEN_FIND(frz, key, type)				\
+		(type*)bstlink_frozen_find(frz, key)
+
+#define __BSTLINK_FROZEN_LOWER_BOUND(frz, key, type)			\
+		(type*)bstlink_frozen_lower_bound(frz, key)
+
+/*
+ * __BSTLINK_GENERATE  --  emit comparator-inlined search/insert cores
+ *
+ * Description
+ *	The macro emits static inline routines
+ *		name##_find, name##_lower_bound, name##_upper_bound,
+ *		name##_insert and name##_insert_unique
+ *	for entries of 'type' which embed a tree node as 'member'.
+ *	'cmp(const type *a, const type *b)' returns <0, 0 or >0 and is
+ *	expanded in place, so a static inline comparator is folded into
+ *	the tree walk instead of being called through a pointer.
+ *	Lookups take a 'type' entry with the key fields filled in.
+ *
+ *	You always need not to use this macro directly, use the tree
+ *	specific wrappers (RB_GENERATE, AVL_GENERATE, ...) instead.
+ *
+ * Parameters
+ *	root_type, node_type	: the tree root and node types
+ *	access	: called as access(node, root) on a found node
+ *	rest	: called as rest(node, root) after a node is linked
+ */
+#define __BSTLINK_NOP(node, root)	do { } while (0)
+
+#define __BSTLINK_GENERATE(name, root_type, node_type, type, member,	\
+			   cmp, access, rest)				\
+static inline type *							\
+name##_lower_bound(const root_type *root, const type *key)		\
+{									\
+	const node_type *link = root->node;				\
+	type *lb = NULL;						\
+									\
+	while (link) {							\
+		type *entry = container_of(link, type, member);		\
+									\
+		if (cmp(entry, key) >= 0) {				\
+			lb = entry;					\
+			link = link->left;				\
+		} else							\
+			link = link->right;				\
+	}								\
+									\
+	return lb;							\
+}									\
+									\
+static inline type *							\
+name##_upper_bound(const root_type *root, const type *key)		\
+{									\
+	const node_type *link = root->node;				\
+	type *ub = NULL;						\
+									\
+	while (link) {							\
+		type *entry = container_of(link, type, member);		\
+									\
+		if (cmp(entry, key) > 0) {				\
+			ub = entry;					\
+			link = link->left;				\
+		} else							\
+			link = link->right;				\
+	}								\
+									\
+	return ub;							\
+}									\
+									\
+static inline type *							\
+name##_find(const root_type *root, const type *key)			\
+{									\
+	type *entry = name##_lower_bound(root, key);			\
+									\
+	if (!entry || cmp(entry, key))					\
+		return NULL;						\
+									\
+	access(&entry->member, root);					\
+	return entry;							\
+}									\
+									\
+static inline bool							\
+__##name##_insert(root_type *root, type *entry, bool bunique)		\
+{									\
+	node_type *parent = NULL, **plink = &root->node;		\
+									\
+	while (*plink) {						\
+		int icmp;						\
+									\
+		parent = *plink;					\
+		icmp = cmp(container_of(parent, type, member), entry);	\
+		if (icmp > 0)						\
+			plink = &parent->left;				\
+		else {							\
+			if (!icmp && bunique)				\
+				return false;				\
+			plink = &parent->right;				\
+		}							\
+	}								\
+									\
+	__BSTLINK_INIT(&entry->member, parent, plink);			\
+	rest(&entry->member, root);					\
+									\
+	return true;							\
+}									\
+									\
+static inline void							\
+name##_insert(root_type *root, type *entry)				\
+{									\
+	(void)__##name##_insert(root, entry, false);			\
+}									\
+									\
+static inline bool							\
+name##_insert_unique(root_type *root, type *entry)			\
+{									\
+	return __##name##_insert(root, entry, true);			\
+}
+
+/*
+ * __BSTLINK_KEY_GENERATE  --  emit search/insert cores on inline keys
+ *
+ * Description
+ *	The macro emits static inline routines
+ *		name##_find, name##_lower_bound, name##_upper_bound,
+ *		name##_insert and name##_insert_unique
+ *	for nodes of 'type', which are a tree node 'node' followed by an
+ *	arithmetic 'key'.  The walk reads the key from the node it
+ *	reaches anyway and compares it with < and ==, lookups take the
+ *	key by value.
+ *
+ *	You always need not to use this macro directly, see
+ *	rbtree-key.h and avltree-key.h.
+ *
+ * Parameters
+ *	root_type, node_type	: the tree root and node types
+ *	key_type	: the type of 'key'
+ *	rest	: called as rest(node, root) after a node is linked
+ */
+#define __BSTLINK_KEY_GENERATE(name, root_type, node_type, type,	\
+			       key_type, rest)				\
+static inline type *							\
+name##_lower_bound(const root_type *root, key_type key)		\
+{									\
+	const node_type *link = root->node;				\
+	type *lb = NULL;						\
+									\
+	while (link) {							\
+		type *entry = container_of(link, type, node);		\
+									\
+		if (!(entry->key < key)) {				\
+			lb = entry;					\
+			link = link->left;				\
+		} else							\
+			link = link->right;				\
+	}								\
+									\
+	return lb;							\
+}									\
+									\
+static inline type *							\
+name##_upper_bound(const root_type *root, key_type key)		\
+{									\
+	const node_type *link = root->node;				\
+	type *ub = NULL;						\
+									\
+	while (link) {							\
+		type *entry = container_of(link, type, node);		\
+									\
+		if (key < entry->key) {					\
+			ub = entry;					\
+			link = link->left;				\
+		} else							\
+			link = link->right;				\
+	}								\
+									\
+	return ub;							\
+}									\
+									\
+static inline type *							\
+name##_find(const root_type *root, key_type key)			\
+{									\
+	type *entry = name##_lower_bound(root, key);			\
+									\
+	return entry && entry->key == key ? entry : NULL;		\
+}									\
+									\
+static inline bool							\
+__##name##_insert(root_type *root, type *entry, bool bunique)		\
+{									\
+	node_type *parent = NULL, **plink = &root->node;		\
+									\
+	while (*plink) {						\
+		const type *p;						\
+									\
+		parent = *plink;					\
+		p = container_of(parent, type, node);			\
+		if (entry->key < p->key)				\
+			plink = &parent->left;				\
+		else {							\
+			if (bunique && entry->key == p->key)		\
+				return false;				\
+			plink = &parent->right;				\
+		}							\
+	}								\
+									\
+	__BSTLINK_INIT(&entry->node, parent, plink);			\
+	rest(&entry->node, root);					\
+									\
+	return true;							\
+}									\
+									\
+static inline void							\
+name##_insert(root_type *root, type *entry)				\
+{									\
+	(void)__##name##_insert(root, entry, false);			\
+}									\
+									\
+static inline bool							\
+name##_insert_unique(root_type *root, type *entry)			\
+{									\
+	return __##name##_insert(root, entry, true);			\
+}
+
 __END_DECLS
 
 #endif	/* __YCALGOS_BSTREE_LINK_H_ */
@@ -37,6 +37,17 @@ struct bst_root
 
 #define bst_entry(ptr, type, member)	container_of(ptr, type, member)
 
+static inline struct bst_node *bst_parent(const struct bst_node *node)
+{
+	return __BSTLINK_PARENT(node, struct bst_node);
+}
+
+static inline void bst_set_parent(struct bst_node *node,
+				  struct bst_node *parent)
+{
+	__BSTLINK_SET_PARENT(node, parent);
+}
+
 #define BST_DECLARE(name)	struct bst_root name =  { NULL, }
 #define BST_INIT(name)	do { (name).node = NULL; } while (0)
 static inline void bst_init(struct bst_root *bst)
@@ -101,6 +112,35 @@ bst_upper_bound(const struct bst_root *bst,
 	return __BSTLINK_UPPER_BOUND(bst->node, compare, arg, struct bst_node);
 }
 
+/*
+ * bst_find_batch, bst_lower_bound_batch  --  batched search
+ *
+ * 'results[i]' is set to the node bst_find (bst_lower_bound) returns
+ * for 'args[i]'.  The searches share the memory latency, see
+ * bstlink_find_batch.
+ */
+static inline void
+bst_find_batch(const struct bst_root *bst,
+	       int (*compare)(const struct bst_node *node,
+			      const void *arg),
+	       const void * const *args,
+	       size_t num,
+	       struct bst_node **results)
+{
+	__BSTLINK_FIND_BATCH(bst->node, compare, args, num, results);
+}
+
+static inline void
+bst_lower_bound_batch(const struct bst_root *bst,
+		      int (*compare)(const struct bst_node *node,
+				     const void *arg),
+		      const void * const *args,
+		      size_t num,
+		      struct bst_node **results)
+{
+	__BSTLINK_LOWER_BOUND_BATCH(bst->node, compare, args, num, results);
+}
+
 static inline void
 bst_lower_upper_bound(const struct bst_root *bst,
 		     int (*compare)(const struct bst_node *node,
@@ -135,9 +175,18 @@ bst_insert_unique(struct bst_node *node,
 {
 	
 	return __BSTLINK_INSERT(node, &bst->node, compare_link,
-					arg, false);
+					arg, true);
 }
 
+/*
+ * comparator-inlined cores: name##_find, name##_lower_bound, ...
+ * cmp(const type *a, const type *b) returns <0, 0 or >0
+ */
+#define BST_GENERATE(name, type, member, cmp)				\
+	__BSTLINK_GENERATE(name, struct bst_root, struct bst_node,	\
+			   type, member, cmp,				\
+			   __BSTLINK_NOP, __BSTLINK_NOP)
+
 static inline void
 bst_replace(struct bst_node *victim, struct bst_node *new, struct bst_root *bst)
 {
@@ -171,6 +220,38 @@ bst_count(const struct bst_root *bst,
 	return __BSTLINK_COUNT(bst->node, compare, arg);
 }
 
+/*
+ * bst_freeze  --  build a read-only search array of bst
+ *
+ * 'key' MUST not decrease in tree order.  bst_frozen_find and
+ * bst_frozen_lower_bound return the left-most node whose key is
+ * equal to (not less than) 'key', or NULL.  See struct bst_frozen.
+ */
+static inline int
+bst_freeze(struct bst_frozen *frz,
+	   const struct bst_root *bst,
+	   unsigned long (*key)(const struct bst_node *node))
+{
+	return __BSTLINK_FREEZE(frz, bst->node, key);
+}
+
+static inline struct bst_node *
+bst_frozen_find(const struct bst_frozen *frz, unsigned long key)
+{
+	return __BSTLINK_FROZEN_FIND(frz, key, struct bst_node);
+}
+
+static inline struct bst_node *
+bst_frozen_lower_bound(const struct bst_frozen *frz, unsigned long key)
+{
+	return __BSTLINK_FROZEN_LOWER_BOUND(frz, key, struct bst_node);
+}
+
+static inline void bst_frozen_destroy(struct bst_frozen *frz)
+{
+	bstlink_frozen_destroy(frz);
+}
+
 static inline void
 bst_clear(struct bst_root *bst,
 	 void (*destroy)(struct bst_node *node, const void *arg),
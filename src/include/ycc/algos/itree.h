@@ -0,0 +1,111 @@
+/*
+ * itree.h -- Interval Trees
+ *
+ * Copyright (C) 2012-2013 yanyg (cppgp@qq.com)
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING, if not see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * The interval tree is an augmented rbtree ordered by 'start', every
+ * node keeps the max 'last' of its subtree so an overlap query skips
+ * the subtrees which end before it.  Intervals are closed: [start, last].
+ *
+ * Example of finding all overlaps as follows
+ */
+
+#if 0
+struct lease {
+	int owner;
+	struct itree_node node;
+};
+
+	struct itree_node *node;
+
+	for (node = itree_iter_first(&itree, start, last); node;
+	     node = itree_iter_next(node, start, last)) {
+		struct lease *p = itree_entry(node, struct lease, node);
+		...
+	}
+#endif
+
+#ifndef __YC_ALGOS_ITREE_H_
+#define __YC_ALGOS_ITREE_H_
+
+#include <ycc/algos/rbtree.h>
+
+__BEGIN_DECLS
+
+struct itree_node
+{
+	struct rb_node rb_node;
+	unsigned long start, last;
+	unsigned long subtree_last;
+} __aligned(sizeof(void*));
+
+struct itree_root
+{
+	struct rb_root rb;
+};
+
+#define itree_entry(ptr, type, member)	container_of(ptr, type, member)
+
+#define ITREE_DECLARE(name)	struct itree_root name = { { NULL, } }
+#define ITREE_INIT(name)	RB_INIT((name).rb)
+static inline void itree_init(struct itree_root *itree)
+{
+	ITREE_INIT(*itree);
+}
+
+static inline bool itree_empty(const struct itree_root *itree)
+{
+	return !itree->rb.node;
+}
+
+/* 'node->start' and 'node->last' MUST be set, 'start <= last' */
+void itree_insert(struct itree_node *node, struct itree_root *itree);
+void itree_erase(struct itree_node *node, struct itree_root *itree);
+
+/*
+ * itree_iter_first, itree_iter_next  --  iterate overlaps
+ *
+ * Description
+ *	The functions iterate, in order of 'start', the nodes which
+ *	overlap [start, last].  Finding all k overlaps costs
+ *	O(log n + k), the tree MUST not change during iteration.
+ *
+ * Return value
+ *	The next overlapping node or NULL if there is no more.
+ */
+struct itree_node *itree_iter_first(const struct itree_root *itree,
+				    unsigned long start,
+				    unsigned long last);
+struct itree_node *itree_iter_next(const struct itree_node *node,
+				   unsigned long start,
+				   unsigned long last);
+
+/* valid check */
+#ifndef NDEBUG
+bool itree_isvalid(struct itree_root *itree);
+#else
+static inline bool itree_isvalid(struct itree_root *itree)
+{
+	return true;
+}
+#endif
+
+__END_DECLS
+
+#endif /* __YC_ALGOS_ITREE_H_ */
@@ -0,0 +1,181 @@
+/*
+ * rbtree-hash.h -- Hash Tables of Red-Black Trees
+ *
+ * Copyright (C) 2012-2013 yanyg (cppgp@qq.com)
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING, if not see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * A hash table whose buckets are rb trees ordered by 'compare_link'.
+ * The lookups are O(1) on average, and O(log n) at worst even if all
+ * the keys collide, so keys chosen by an attacker cannot turn it into
+ * a list.  The hashes are keyed by a random seed drawn per table, see
+ * rbh_hash, which keeps an attacker from predicting collisions in the
+ * first place.
+ *
+ * The table doubles past two nodes per bucket and halves under one per
+ * eight.  It resizes incrementally: the buckets move a few at a time on
+ * every insert and erase, split or merged in order without a compare,
+ * so no update pays for the whole table.
+ *
+ * Example as follows
+ */
+
+#if 0
+static uint64_t item_hash(const struct rbh_root *rbh,
+			  const struct rb_node *node)
+{
+	const struct item *p = rb_entry(node, struct item, node);
+
+	return rbh_hash(rbh, p->name, strlen(p->name));
+}
+
+	if (rbh_init(&rbh, 0, item_hash, item_compare_link, NULL))
+		return -1;
+	...
+	rbh_insert_unique(&rbh, &item->node);
+	...
+	node = rbh_find(&rbh, rbh_hash(&rbh, name, strlen(name)),
+			item_compare, name);
+	...
+	rbh_destroy(&rbh, item_destroy, NULL);
+#endif
+
+#ifndef __YC_ALGOS_RBTREE_HASH_H_
+#define __YC_ALGOS_RBTREE_HASH_H_
+
+#include <stdint.h>
+
+#include <ycc/algos/rbtree.h>
+
+__BEGIN_DECLS
+
+/* buckets moved on each insert and erase while resizing */
+#ifndef RBH_MIGRATE
+#define RBH_MIGRATE	4
+#endif
+
+struct rbh_root
+{
+	struct rb_root *buckets;	/* 'num' buckets */
+	struct rb_root *old;		/* 'old_num' buckets, NULL if none */
+	size_t num, old_num;
+	size_t moved;			/* buckets of the smaller one done */
+	size_t count;
+	size_t min;
+	uint64_t seed[2];
+	uint64_t (*hash)(const struct rbh_root *rbh,
+			 const struct rb_node *node);
+	int (*compare_link)(const struct rb_node *node1,
+			    const struct rb_node *node2,
+			    const void *arg);
+	const void *arg;
+};
+
+/*
+ * rbh_init  --  initialize an empty 'rbh'
+ *
+ * Description
+ *	'num' buckets at least, never fewer, rounded up to a power of 2.
+ *	'hash' MUST hash the key of 'node' by rbh_hash, or by another
+ *	hash keyed by 'rbh->seed'.  The nodes of equal keys MUST hash
+ *	equal, 'compare_link' orders them in a bucket.
+ *
+ * Return value
+ *	0 on success, otherwise -1 and errno is set to ENOMEM if the
+ *	buckets cannot be allocated, 'rbh' is not to be used then.
+ */
+int rbh_init(struct rbh_root *rbh,
+	     size_t num,
+	     uint64_t (*hash)(const struct rbh_root *rbh,
+			      const struct rb_node *node),
+	     int (*compare_link)(const struct rb_node *node1,
+				 const struct rb_node *node2,
+				 const void *arg),
+	     const void *arg);
+
+/* rbh_destroy  --  free the buckets, 'destroy' may be NULL */
+void rbh_destroy(struct rbh_root *rbh,
+		 void (*destroy)(struct rb_node *node, const void *arg),
+		 const void *arg);
+
+/*
+ * rbh_set_seed  --  replace the random seed
+ *
+ * Description
+ *	For reproducible tables, 'rbh' MUST be empty.
+ */
+void rbh_set_seed(struct rbh_root *rbh, const uint64_t seed[2]);
+
+/*
+ * rbh_hash  --  SipHash-2-4 of [data, data + len) keyed by 'rbh'
+ */
+uint64_t rbh_hash(const struct rbh_root *rbh, const void *data, size_t len);
+
+/*
+ * rbh_insert, rbh_insert_unique  --  insert 'node'
+ *
+ * Return value
+ *	rbh_insert_unique returns false if an equal node exists.
+ */
+void rbh_insert(struct rbh_root *rbh, struct rb_node *node);
+bool rbh_insert_unique(struct rbh_root *rbh, struct rb_node *node);
+
+/* rbh_erase  --  erase 'node' of 'rbh' */
+void rbh_erase(struct rbh_root *rbh, struct rb_node *node);
+
+/*
+ * rbh_find  --  the first node equal to 'arg' whose key hashes 'hash'
+ *
+ * Description
+ *	The lookups move no bucket, they may run in parallel as long as
+ *	no update does.
+ */
+struct rb_node *rbh_find(const struct rbh_root *rbh,
+			 uint64_t hash,
+			 int (*compare)(const struct rb_node *node,
+					const void *arg),
+			 const void *arg);
+
+/*
+ * rbh_visit_cond  --  visit every node, in no order
+ *
+ * Return value
+ *	false if 'visit_cond' stopped the visit.
+ */
+bool rbh_visit_cond(const struct rbh_root *rbh,
+		    bool (*visit_cond)(const struct rb_node *node,
+				       const void *arg),
+		    const void *arg);
+
+static inline size_t rbh_count(const struct rbh_root *rbh)
+{
+	return rbh->count;
+}
+
+/* valid check */
+#ifndef NDEBUG
+bool rbh_isvalid(const struct rbh_root *rbh);
+#else
+static inline bool rbh_isvalid(const struct rbh_root *rbh)
+{
+	return true;
+}
+#endif
+
+__END_DECLS
+
+#endif /* __YC_ALGOS_RBTREE_HASH_H_ */
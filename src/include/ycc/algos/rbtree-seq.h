@@ -0,0 +1,162 @@
+/*
+ * rbtree-seq.h -- Red-Black Trees with lockless readers
+ *
+ * Copyright (C) 2012-2013 yanyg (cppgp@qq.com)
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING, if not see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * A read-mostly rb tree.  The writers serialize on a mutex and make the
+ * sequence counter odd while they change the tree.  The readers take no
+ * lock and write nothing shared: they walk the child pointers, and walk
+ * again if the counter was odd or has moved meanwhile.  A walk racing a
+ * rotation may go wrong or even around a transient cycle, so it is cut
+ * at the deepest a red-black tree can be and retried.  The writers store
+ * the child pointers single (relaxed atomic) and a new node by a release
+ * store, a reader loads each one whole.
+ *
+ * The nodes a reader stands on are not freed under it: the readers run
+ * between epoch_enter and epoch_exit, the writers hand the erased nodes
+ * to epoch_retire after rb_seq_write_unlock, see ycc/epoch.h.
+ *
+ * Example as follows
+ */
+
+#if 0
+	/* writer */
+	rb_seq_write_lock(&root);
+	rb_seq_insert(&item->node, &root, item_compare_link, NULL);
+	...
+	rb_seq_erase(&old->node, &root);
+	rb_seq_write_unlock(&root);
+	epoch_retire(&domain, &old->entry, item_free);
+
+	/* readers */
+	epoch_enter(thr);
+	node = rb_seq_find(&root, item_compare, &key);
+	if (node)
+		use(rb_entry(node, struct item, node));
+	epoch_exit(thr);
+#endif
+
+#ifndef __YC_ALGOS_RBTREE_SEQ_H_
+#define __YC_ALGOS_RBTREE_SEQ_H_
+
+#include <pthread.h>
+
+#include <ycc/epoch.h>
+#include <ycc/algos/rbtree.h>
+
+__BEGIN_DECLS
+
+struct rb_seq_root
+{
+	struct rb_root rb;
+	unsigned long seq;	/* odd while a writer changes 'rb' */
+	pthread_mutex_t lock;
+};
+
+#define RB_SEQ_DECLARE(name)						\
+	struct rb_seq_root name = { { NULL, }, 0, PTHREAD_MUTEX_INITIALIZER }
+static inline void rb_seq_init(struct rb_seq_root *root)
+{
+	RB_INIT(root->rb);
+	root->seq = 0;
+	pthread_mutex_init(&root->lock, NULL);
+}
+
+/*
+ * rb_seq_write_lock, rb_seq_write_unlock  --  write side
+ *
+ * Description
+ *	rb_seq_insert, rb_seq_insert_unique and rb_seq_erase go between
+ *	them, they are the only changes of 'root->rb' the readers allow.
+ *	The readers spin while a writer holds the lock, keep the sections
+ *	short.
+ */
+static inline void rb_seq_write_lock(struct rb_seq_root *root)
+{
+	pthread_mutex_lock(&root->lock);
+	__atomic_store_n(&root->seq, root->seq + 1, __ATOMIC_RELAXED);
+	/* the odd counter is visible before any change of the tree */
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
+
+static inline void rb_seq_write_unlock(struct rb_seq_root *root)
+{
+	__atomic_store_n(&root->seq, root->seq + 1, __ATOMIC_RELEASE);
+	pthread_mutex_unlock(&root->lock);
+}
+
+/* 'node' is published by a release store, its key is visible first */
+static inline void
+rb_seq_insert(struct rb_node *node,
+	      struct rb_seq_root *root,
+	      int (*compare_link)(const struct rb_node *node1,
+				  const struct rb_node *node2,
+				  const void *arg),
+	      const void *arg)
+{
+	(void)__BSTLINK_INSERT_ONCE(node, &root->rb.node, compare_link,
+				    arg, false);
+	rb_set_red(node);
+	rb_insert_rebalance_once(node, &root->rb);
+}
+
+static inline bool
+rb_seq_insert_unique(struct rb_node *node,
+		     struct rb_seq_root *root,
+		     int (*compare_link)(const struct rb_node *node1,
+					 const struct rb_node *node2,
+					 const void *arg),
+		     const void *arg)
+{
+	if (!__BSTLINK_INSERT_ONCE(node, &root->rb.node, compare_link,
+				   arg, true))
+		return false;
+
+	rb_set_red(node);
+	rb_insert_rebalance_once(node, &root->rb);
+
+	return true;
+}
+
+/* 'node' may still be read until the epoch it is retired in is over */
+static inline void rb_seq_erase(struct rb_node *node, struct rb_seq_root *root)
+{
+	rb_erase_once(node, &root->rb);
+}
+
+/*
+ * rb_seq_find, rb_seq_lower_bound  --  lockless search
+ *
+ * Description
+ *	Same as rb_find and rb_lower_bound on 'root->rb', without lock.
+ *	Called between epoch_enter and epoch_exit, the node returned is
+ *	valid until epoch_exit.
+ */
+struct rb_node *rb_seq_find(const struct rb_seq_root *root,
+			    int (*compare)(const struct rb_node *node,
+					   const void *arg),
+			    const void *arg);
+struct rb_node *rb_seq_lower_bound(const struct rb_seq_root *root,
+				   int (*compare)(const struct rb_node *node,
+						  const void *arg),
+				   const void *arg);
+
+__END_DECLS
+
+#endif /* __YC_ALGOS_RBTREE_SEQ_H_ */
@@ -0,0 +1,197 @@
+/*
+ * rbtree-shard.h -- Range-Sharded Red-Black Trees
+ *
+ * Copyright (C) 2012-2013 yanyg (cppgp@qq.com)
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING, if not see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * An ordered map shared by threads, between one global lock and a
+ * lock-free structure.  The key space is cut in 'num' ranges, each one
+ * an rb tree with its own mutex, so the threads working on distinct
+ * ranges do not contend.  The keys are 'unsigned long', given by the
+ * 'key' routine of the nodes, equal keys are allowed.
+ *
+ * Shard i holds the keys in [lo of i, lo of i + 1).  When a shard grows
+ * twice as large as a neighbour, half of the difference moves to the
+ * neighbour by rb_split and rb_concat, in O(log n) plus the walk that
+ * picks the new boundary.  A boundary only changes under the locks of
+ * the two shards it separates, so a thread routes a key without lock
+ * and checks the range again once it holds the shard.
+ *
+ * Example as follows
+ */
+
+#if 0
+static unsigned long item_key(const struct rb_node *node)
+{
+	return rb_entry(node, struct item, node)->key;
+}
+
+static bool item_print(const struct rb_node *node, const void *arg)
+{
+	printf("%lu\n", item_key(node));
+	return true;
+}
+
+	if (rbs_init(&rbs, 16, item_key, 0, max_key))
+		return -1;
+	...
+	rbs_insert(&rbs, &item->node);
+	...
+	rbs_scan(&rbs, lo, hi, item_print, NULL);
+	...
+	rbs_destroy(&rbs, item_destroy, NULL);
+#endif
+
+#ifndef __YC_ALGOS_RBTREE_SHARD_H_
+#define __YC_ALGOS_RBTREE_SHARD_H_
+
+#include <pthread.h>
+
+#include <ycc/algos/rbtree.h>
+
+__BEGIN_DECLS
+
+/* a shard smaller than this is never rebalanced by the inserts */
+#ifndef RBS_BALANCE_MIN
+#define RBS_BALANCE_MIN	64
+#endif
+
+struct rbs_shard
+{
+	pthread_mutex_t lock;
+	struct rb_root rb;
+	size_t count;
+	unsigned long lo;	/* the first key of the range */
+} __aligned(64);
+
+struct rbs_root
+{
+	struct rbs_shard *shards;
+	unsigned num;
+	unsigned long (*key)(const struct rb_node *node);
+};
+
+/*
+ * rbs_init  --  initialize 'rbs' with 'num' shards
+ *
+ * Description
+ *	[lo, hi] is cut evenly among the shards at first, the keys out of
+ *	it go to the first or the last shard.  The boundaries follow the
+ *	keys afterwards.
+ *
+ * Return value
+ *	0 on success, otherwise -1 and errno is set to EINVAL if 'num' is
+ *	0 or 'lo' is above 'hi', or to ENOMEM if the shards cannot be
+ *	allocated.
+ */
+int rbs_init(struct rbs_root *rbs,
+	     unsigned num,
+	     unsigned long (*key)(const struct rb_node *node),
+	     unsigned long lo,
+	     unsigned long hi);
+
+/*
+ * rbs_destroy  --  free the shards
+ *
+ * Description
+ *	No other thread may use 'rbs'.  'destroy' may be NULL, otherwise
+ *	it is called for every node.
+ */
+void rbs_destroy(struct rbs_root *rbs,
+		 void (*destroy)(struct rb_node *node, const void *arg),
+		 const void *arg);
+
+/*
+ * rbs_insert, rbs_insert_unique  --  insert 'node'
+ *
+ * Description
+ *	rbs_insert puts 'node' after its equals, rbs_insert_unique
+ *	refuses it if an equal key exists.
+ *
+ * Return value
+ *	rbs_insert_unique returns false if 'node' is not inserted.
+ */
+void rbs_insert(struct rbs_root *rbs, struct rb_node *node);
+bool rbs_insert_unique(struct rbs_root *rbs, struct rb_node *node);
+
+/*
+ * rbs_find  --  find the first node of 'key'
+ *
+ * Description
+ *	The node returned is not locked, the callers agree on when it
+ *	may be erased.
+ */
+struct rb_node *rbs_find(struct rbs_root *rbs, unsigned long key);
+
+/* rbs_erase  --  erase 'node' of 'rbs' */
+void rbs_erase(struct rbs_root *rbs, struct rb_node *node);
+
+/*
+ * rbs_erase_key  --  erase the first node of 'key'
+ *
+ * Return value
+ *	The node erased, which belongs to the caller now, NULL if none.
+ */
+struct rb_node *rbs_erase_key(struct rbs_root *rbs, unsigned long key);
+
+/*
+ * rbs_scan  --  ordered visit of the keys in [lo, hi]
+ *
+ * Description
+ *	The shards are locked one after another and 'visit_cond' is
+ *	called under the lock, it MUST NOT call the rbs routines.  The
+ *	scan stops when 'visit_cond' returns false.  It is not a
+ *	snapshot: a node inserted or erased meanwhile in a shard not
+ *	visited yet is seen or not, but each node is visited at most
+ *	once and in order, even if the boundaries move.
+ *
+ * Return value
+ *	false if 'visit_cond' stopped the scan.
+ */
+bool rbs_scan(struct rbs_root *rbs,
+	      unsigned long lo,
+	      unsigned long hi,
+	      bool (*visit_cond)(const struct rb_node *node, const void *arg),
+	      const void *arg);
+
+/* rbs_count  --  the number of nodes, not atomic across shards */
+size_t rbs_count(const struct rbs_root *rbs);
+
+/*
+ * rbs_rebalance  --  even out the shards
+ *
+ * Description
+ *	The inserts rebalance a shard with a neighbour as it grows, this
+ *	routine balances every pair of neighbours until no move is
+ *	worth it, e.g. after bulk erases.
+ */
+void rbs_rebalance(struct rbs_root *rbs);
+
+/* valid check, no other thread may use 'rbs' */
+#ifndef NDEBUG
+bool rbs_isvalid(struct rbs_root *rbs);
+#else
+static inline bool rbs_isvalid(struct rbs_root *rbs)
+{
+	return true;
+}
+#endif
+
+__END_DECLS
+
+#endif /* __YC_ALGOS_RBTREE_SHARD_H_ */
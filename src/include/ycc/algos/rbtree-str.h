@@ -0,0 +1,149 @@
+/*
+ * rbtree-str.h -- Red Black Trees on String Keys with Cached Prefixes
+ *
+ * Copyright (C) 2012-2013 yanyg (cppgp@qq.com)
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING, if not see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * An rb_str_node keeps, next to the links, the first 8 bytes of its key
+ * as a big-endian integer and the key length.  Two prefixes compare as
+ * integers in the order of the bytes, so most compares end there, and
+ * the key itself is read only when the first 8 bytes tie.  A compare
+ * through a callback reads the entry and then the key at every level.
+ *
+ * The node points to its key and its length, the key is not copied and
+ * MUST stay while the node is linked, see rb_str_cmp for the order.
+ * The routines below are RB_GENERATE cores on an rb_root, see rbtree.h.
+ *
+ * Example as follows
+ */
+
+#if 0
+struct item {
+	struct rb_str_node snode;
+	char *name;
+};
+
+	rb_str_node_init(&item->snode, item->name, strlen(item->name));
+	rb_str_insert_unique(&root, &item->snode);
+	...
+	struct rb_str_node *found = rb_str_find(&root, "foo", 3);
+	if (found)
+		item = container_of(found, struct item, snode);
+#endif
+
+#ifndef __YC_ALGOS_RBTREE_STR_H_
+#define __YC_ALGOS_RBTREE_STR_H_
+
+#include <stdint.h>
+#include <string.h>
+
+#include <ycc/algos/rbtree.h>
+
+__BEGIN_DECLS
+
+struct rb_str_node
+{
+	struct rb_node node;
+	uint64_t prefix;
+	size_t len;
+	const char *key;
+};
+
+/* the first 8 bytes of 'key' big-endian, zero padded */
+static inline uint64_t rb_str_prefix(const char *key, size_t len)
+{
+	const unsigned char *p = (const unsigned char*)key;
+	uint64_t prefix = 0;
+	size_t i;
+
+	for (i = 0; i < 8; ++i)
+		prefix = prefix << 8 | (i < len ? p[i] : 0);
+
+	return prefix;
+}
+
+static inline void rb_str_node_init(struct rb_str_node *node,
+				    const char *key, size_t len)
+{
+	node->prefix = rb_str_prefix(key, len);
+	node->len = len;
+	node->key = key;
+}
+
+/*
+ * rb_str_cmp  --  order of the keys
+ *
+ * Description
+ *	Bytes compare unsigned, as memcmp does, and a key goes before the
+ *	longer ones starting with it; '\0' is a byte like the others.
+ *	The zero padding does not tell "ab" from "ab\0", the lengths do:
+ *	if the prefixes tie, the shorter key is all in the prefix or the
+ *	bytes after it decide.
+ */
+static inline int rb_str_cmp(const struct rb_str_node *a,
+			     const struct rb_str_node *b)
+{
+	size_t len = a->len < b->len ? a->len : b->len;
+	int icmp;
+
+	if (a->prefix != b->prefix)
+		return a->prefix < b->prefix ? -1 : 1;
+
+	if (len > 8 && (icmp = memcmp(a->key + 8, b->key + 8, len - 8)))
+		return icmp;
+
+	return a->len < b->len ? -1 : a->len > b->len;
+}
+
+RB_GENERATE(__rb_str, struct rb_str_node, node, rb_str_cmp)
+
+/*
+ * rb_str_find, rb_str_lower_bound, rb_str_upper_bound  --  search by key
+ *
+ * They behave as rb_find, rb_lower_bound and rb_upper_bound on the
+ * 'len' bytes of 'key'.
+ */
+#define __RB_STR_SEARCH(what)						\
+static inline struct rb_str_node *					\
+rb_str_##what(const struct rb_root *rb, const char *key, size_t len)	\
+{									\
+	struct rb_str_node probe;					\
+									\
+	rb_str_node_init(&probe, key, len);				\
+	return __rb_str_##what(rb, &probe);				\
+}
+
+__RB_STR_SEARCH(find)
+__RB_STR_SEARCH(lower_bound)
+__RB_STR_SEARCH(upper_bound)
+
+/* 'node' MUST be set up by rb_str_node_init */
+static inline void rb_str_insert(struct rb_root *rb, struct rb_str_node *node)
+{
+	__rb_str_insert(rb, node);
+}
+
+static inline bool rb_str_insert_unique(struct rb_root *rb,
+					struct rb_str_node *node)
+{
+	return __rb_str_insert_unique(rb, node);
+}
+
+__END_DECLS
+
+#endif /* __YC_ALGOS_RBTREE_STR_H_ */
@@ -19,14 +19,32 @@
  */
 
 /*
- * To use rbtrees you'll have to implement your own insert and search cores.
- * This will avoid us to use callbacks and to drop drammatically performances.
+ * The rb_find/rb_insert family calls a compare routine through a pointer for
+ * every level, it is convenient but drops performances dramatically.
+ * RB_GENERATE emits insert and search cores with the comparator inlined.
+ * They work on a plain rb_root, the other routines of this file apply
+ * to the tree as they are: rb_erase, rb_first, rb_next, rb_clear ...
  *
  * Example of insert and search as follows
  */
 
 #if 0
-Example of insert and search routines.
+struct item {
+	int key;
+	struct rb_node node;
+};
+
+static inline int item_cmp(const struct item *a, const struct item *b)
+{
+	return a->key < b->key ? -1 : a->key > b->key;
+}
+
+RB_GENERATE(item_tree, struct item, node, item_cmp)
+
+	item_tree_insert(&root, item);
+	...
+	struct item key = { .key = 5 };
+	struct item *found = item_tree_find(&root, &key);
 #endif
 
 #ifndef __YCC_ALGOS_RBTREE_H_
@@ -39,7 +57,9 @@ __BEGIN_DECLS
 struct rb_node
 {
 	__BST_LINK_MEMBER(struct rb_node);
+#ifndef	BSTLINK_COMPACT
 	unsigned color;
+#endif
 #define RB_COLOR_RED 0
 #define RB_COLOR_BLACK 1
 } __aligned(sizeof(void*));
@@ -49,15 +69,30 @@ struct rb_root
 	struct rb_node *node;
 };
 
+#ifdef	BSTLINK_COMPACT
+#define rb_color(r)	__BSTLINK_BITS(r)
+#define rb_set_color(r, val)	do { __BSTLINK_SET_BITS(r, val); } while(0)
+#else
 #define rb_color(r)	((r)->color)
+#define rb_set_color(r, val)	do { (r)->color = (val); } while(0)
+#endif
 #define rb_is_red(r)	(!rb_color(r))
 #define rb_is_black(r)	rb_color(r)
-#define rb_set_color(r, val)	do { (r)->color = (val); } while(0)
 #define rb_set_red(r)	rb_set_color((r), RB_COLOR_RED)
 #define rb_set_black(r)	rb_set_color((r), RB_COLOR_BLACK)
 
 #define rb_entry(ptr, type, member)	container_of(ptr, type, member)
 
+static inline struct rb_node *rb_parent(const struct rb_node *node)
+{
+	return __BSTLINK_PARENT(node, struct rb_node);
+}
+
+static inline void rb_set_parent(struct rb_node *node, struct rb_node *parent)
+{
+	__BSTLINK_SET_PARENT(node, parent);
+}
+
 #define RB_DECLARE(name)	struct rb_root name =  { NULL, }
 #define RB_INIT(name)	do { (name).node = NULL; } while (0)
 static inline void rb_init(struct rb_root *rb)
@@ -70,7 +105,7 @@ static inline void rb_link_node(struct rb_node *node,
 				struct rb_node **pnode)
 {
 	__BSTLINK_INIT(node, parent, pnode);
-	node->color = RB_COLOR_RED;
+	rb_set_red(node);
 }
 
 static inline struct rb_node *rb_first(const struct rb_root *rb)
@@ -96,6 +131,150 @@ static inline struct rb_node *rb_prev(const struct rb_node* node)
 void rb_insert_rebalance(struct rb_node *node, struct rb_root *rb);
 void rb_erase(struct rb_node *node, struct rb_root *rb);
 
+/*
+ * rb_insert_rebalance_once, rb_erase_once  --  for rbtree-seq.h
+ *
+ * Same as rb_insert_rebalance and rb_erase, but the child and root
+ * links are stored single, a search without lock may load them.
+ */
+void rb_insert_rebalance_once(struct rb_node *node, struct rb_root *rb);
+void rb_erase_once(struct rb_node *node, struct rb_root *rb);
+
+/*
+ * Augmented rbtree
+ *
+ * Every node keeps a value aggregated over its subtree (interval tree
+ * keeps the max end, for example), the callbacks keep it up to date,
+ * see struct bstlink_augment for their contracts.  RB_AUGMENT_CALLBACKS
+ * emits them for a value computed from a node and its two children.
+ */
+struct rb_augment_callbacks
+{
+	void (*propagate)(struct rb_node *node, struct rb_node *stop);
+	void (*copy)(struct rb_node *old, struct rb_node *new);
+	void (*rotate)(struct rb_node *old, struct rb_node *new);
+};
+
+/*
+ * rb_insert_augmented  --  rb_insert_rebalance with augmented callbacks
+ *
+ * 'node' is linked by rb_link_node already, and its value is set up as
+ * a single node subtree, the ancestors are updated here.
+ */
+void rb_insert_augmented(struct rb_node *node,
+			 struct rb_root *rb,
+			 const struct rb_augment_callbacks *augment);
+void rb_erase_augmented(struct rb_node *node,
+			struct rb_root *rb,
+			const struct rb_augment_callbacks *augment);
+
+#define RB_AUGMENT_CALLBACKS(name, type, member, vtype, value, compute)	\
+static void name##_propagate(struct rb_node *node, struct rb_node *stop) \
+{									\
+	while (node != stop) {						\
+		type *entry = rb_entry(node, type, member);		\
+		vtype v = compute(entry);				\
+									\
+		if (entry->value == v)					\
+			break;						\
+		entry->value = v;					\
+		node = rb_parent(node);					\
+	}								\
+}									\
+									\
+static void name##_copy(struct rb_node *old, struct rb_node *new)	\
+{									\
+	rb_entry(new, type, member)->value =				\
+		rb_entry(old, type, member)->value;			\
+}									\
+									\
+static void name##_rotate(struct rb_node *old, struct rb_node *new)	\
+{									\
+	type *o = rb_entry(old, type, member);				\
+									\
+	rb_entry(new, type, member)->value = o->value;			\
+	o->value = compute(o);						\
+}									\
+									\
+static const struct rb_augment_callbacks name = {			\
+	name##_propagate, name##_copy, name##_rotate			\
+};
+
+/*
+ * rb_build_sorted  --  build rb from 'nodes[0..num)' in O(num)
+ *
+ * 'nodes' MUST be sorted already, no compare routine is called.
+ * The old content of 'rb' is dropped.
+ */
+void rb_build_sorted(struct rb_root *rb, struct rb_node **nodes, size_t num);
+
+/*
+ * rb_split  --  split rb by 'arg' in O(log n)
+ *
+ * Nodes less than 'arg' (compare returns < 0) go to 'left', the others
+ * go to 'right'.  'rb' is emptied, it may be the same as 'left' or
+ * 'right'.
+ */
+void rb_split(struct rb_root *rb,
+	      int (*compare)(const struct rb_node *node, const void *arg),
+	      const void *arg,
+	      struct rb_root *left,
+	      struct rb_root *right);
+
+/*
+ * rb_join  --  join 'left', 'pivot' and 'right' into rb in O(log n)
+ *
+ * All nodes of 'left' MUST order before 'pivot', all nodes of 'right'
+ * after it.  'left' and 'right' are emptied, either may be 'rb'.
+ */
+void rb_join(struct rb_root *rb,
+	     struct rb_root *left,
+	     struct rb_node *pivot,
+	     struct rb_root *right);
+
+/* rb_concat  --  rb_join without pivot */
+void rb_concat(struct rb_root *rb, struct rb_root *left, struct rb_root *right);
+
+/*
+ * rb_union, rb_intersection, rb_difference  --  set algorithms
+ *
+ * 'rb1' and 'rb2' are consumed and the result goes to 'rb', which may be
+ * either of them.  Nodes of 'rb1' are kept on equal keys, every node
+ * dropped from either tree goes to 'destroy', which may run on any
+ * thread.  It costs O(m log(n/m + 1)) for trees of m <= n nodes and
+ * forks onto up to 'nthreads' threads, 0 means one per online cpu.
+ */
+void rb_union(struct rb_root *rb,
+	      struct rb_root *rb1,
+	      struct rb_root *rb2,
+	      int (*compare_link)(const struct rb_node *node1,
+				  const struct rb_node *node2,
+				  const void *arg),
+	      void (*destroy)(struct rb_node *node, const void *arg),
+	      const void *arg_compare,
+	      const void *arg_destroy,
+	      unsigned nthreads);
+void rb_intersection(struct rb_root *rb,
+		     struct rb_root *rb1,
+		     struct rb_root *rb2,
+		     int (*compare_link)(const struct rb_node *node1,
+					 const struct rb_node *node2,
+					 const void *arg),
+		     void (*destroy)(struct rb_node *node, const void *arg),
+		     const void *arg_compare,
+		     const void *arg_destroy,
+		     unsigned nthreads);
+void rb_difference(struct rb_root *rb,
+		   struct rb_root *rb1,
+		   struct rb_root *rb2,
+		   int (*compare_link)(const struct rb_node *node1,
+				       const struct rb_node *node2,
+				       const void *arg),
+		   void (*destroy)(struct rb_node *node, const void *arg),
+		   const void *arg_compare,
+		   const void *arg_destroy,
+		   unsigned nthreads);
+
 
 /* helper routine */
 static inline struct rb_node *
@@ -125,6 +304,35 @@ rb_upper_bound(const struct rb_root *rb,
 	return __BSTLINK_UPPER_BOUND(rb->node, compare, arg, struct rb_node);
 }
 
+/*
+ * rb_find_batch, rb_lower_bound_batch  --  batched search
+ *
+ * 'results[i]' is set to the node rb_find (rb_lower_bound) returns
+ * for 'args[i]'.  The searches share the memory latency, see
+ * bstlink_find_batch.
+ */
+static inline void
+rb_find_batch(const struct rb_root *rb,
+	      int (*compare)(const struct rb_node *node,
+			     const void *arg),
+	      const void * const *args,
+	      size_t num,
+	      struct rb_node **results)
+{
+	__BSTLINK_FIND_BATCH(rb->node, compare, args, num, results);
+}
+
+static inline void
+rb_lower_bound_batch(const struct rb_root *rb,
+		     int (*compare)(const struct rb_node *node,
+				    const void *arg),
+		     const void * const *args,
+		     size_t num,
+		     struct rb_node **results)
+{
+	__BSTLINK_LOWER_BOUND_BATCH(rb->node, compare, args, num, results);
+}
+
 static inline void
 rb_lower_upper_bound(const struct rb_root *rb,
 		     int (*compare)(const struct rb_node *node,
@@ -167,7 +375,7 @@ rb_insert_unique(struct rb_node *node,
 {
 	
 	if (__BSTLINK_INSERT(node, &rb->node, compare_link,
-				       arg, false))
+				       arg, true))
 	{
 		__rb_insert_rest(node, rb);
 		return true;
@@ -176,31 +384,72 @@ rb_insert_unique(struct rb_node *node,
 	return false;
 }
 
+/*
+ * rb_insert_hint  --  rb_insert searching from 'hint'
+ *
+ * 'hint' is a node of 'rb' near the new one, typically the last node
+ * inserted, or NULL.  An ascending (descending) stream hinted with the
+ * last node costs O(1) compares per insert, see bstlink_insert_hint.
+ */
 static inline void
-rb_replace(struct rb_node *victim, struct rb_node *new, struct rb_root *rb)
+rb_insert_hint(struct rb_node *node,
+	       struct rb_node *hint,
+	       struct rb_root *rb,
+	       int (*compare_link)(const struct rb_node *node1,
+				   const struct rb_node *node2,
+				   const void *arg),
+	       const void *arg)
 {
-	__BSTLINK_REPLACE(victim, new, &rb->node);
-	rb_set_color(new, victim->color);
+	__BSTLINK_INSERT_HINT(node, hint, &rb->node, compare_link, arg);
+	__rb_insert_rest(node, rb);
 }
 
-static inline void rb_erase_range(struct rb_node *beg,
-				  struct rb_node *end,
-				  struct rb_root *rb)
-{
-	__BSTLINK_ERASE_RANGE(beg, end, rb_erase, rb);
-}
+/* comparator-inlined cores, see the example at the top of this file */
+#define RB_GENERATE(name, type, member, cmp)				\
+	__BSTLINK_GENERATE(name, struct rb_root, struct rb_node,	\
+			   type, member, cmp,				\
+			   __BSTLINK_NOP, __rb_insert_rest)
 
 static inline void
-rb_erase_equal(struct rb_root *rb,
-	       int (*compare)(const struct rb_node *node, const void *arg),
-	       void (*destroy)(struct rb_node *node, const void *arg),
-	       const void *arg_compare,
-	       const void *arg_destroy)
+rb_replace(struct rb_node *victim, struct rb_node *new, struct rb_root *rb)
 {
-	__BSTLINK_ERASE_EQUAL(rb->node, compare, rb_erase, destroy,
-			      arg_compare, rb, arg_destroy);
+	__BSTLINK_REPLACE(victim, new, &rb->node);
+	rb_set_color(new, rb_color(victim));
 }
 
+/*
+ * rb_detach_range  --  move the nodes of [beg, end) into 'range'
+ *
+ * Description
+ *	The function splits rb before 'beg' and before 'end' and
+ *	concatenates the outer parts back, no node is rebalanced on
+ *	its own: it costs O(log n) however many nodes are detached.
+ *	'end' is NULL for all nodes from 'beg' on, and MUST NOT order
+ *	before 'beg'.  'range' MUST NOT be 'rb', its old content is
+ *	dropped.
+ */
+void rb_detach_range(struct rb_node *beg,
+		     struct rb_node *end,
+		     struct rb_root *rb,
+		     struct rb_root *range);
+
+/*
+ * rb_erase_range, rb_erase_equal  --  erase a range in O(log n)
+ *
+ * rb_erase_range unlinks [beg, end), see rb_detach_range.
+ * rb_erase_equal detaches the nodes equal to 'arg_compare' and hands
+ * them to 'destroy' in one pass.
+ */
+void rb_erase_range(struct rb_node *beg,
+		    struct rb_node *end,
+		    struct rb_root *rb);
+void rb_erase_equal(struct rb_root *rb,
+		    int (*compare)(const struct rb_node *node,
+				   const void *arg),
+		    void (*destroy)(struct rb_node *node, const void *arg),
+		    const void *arg_compare,
+		    const void *arg_destroy);
+
 static inline size_t
 rb_count(const struct rb_root *rb,
 	 int (*compare)(const struct rb_node *node1,
@@ -210,6 +459,71 @@ rb_count(const struct rb_root *rb,
 	return __BSTLINK_COUNT(rb->node, compare, arg);
 }
 
+#ifdef	BSTLINK_SIZE
+/*
+ * rb_select, rb_rank, rb_count_range  --  order statistics
+ *
+ * rb_select returns the k-th (0 based) node or NULL, rb_rank returns
+ * the count of nodes before 'node'.  rb_count_range counts the nodes
+ * in ['arg_lo', 'arg_hi') as judged by 'compare'.  All cost O(log n).
+ */
+static inline struct rb_node *
+rb_select(const struct rb_root *rb, size_t k)
+{
+	return __BSTLINK_SELECT(rb->node, k, struct rb_node);
+}
+
+static inline size_t rb_rank(const struct rb_node *node)
+{
+	return __BSTLINK_RANK(node);
+}
+
+static inline size_t
+rb_count_range(const struct rb_root *rb,
+	       int (*compare)(const struct rb_node *node,
+			      const void *arg),
+	       const void *arg_lo,
+	       const void *arg_hi)
+{
+	size_t lo = __BSTLINK_COUNT_LESS(rb->node, compare, arg_lo, false);
+	size_t hi = __BSTLINK_COUNT_LESS(rb->node, compare, arg_hi, false);
+
+	return hi > lo ? hi - lo : 0;
+}
+#endif
+
+/*
+ * rb_freeze  --  build a read-only search array of rb
+ *
+ * 'key' MUST not decrease in tree order.  rb_frozen_find and
+ * rb_frozen_lower_bound return the left-most node whose key is
+ * equal to (not less than) 'key', or NULL.  See struct bst_frozen.
+ */
+static inline int
+rb_freeze(struct bst_frozen *frz,
+	  const struct rb_root *rb,
+	  unsigned long (*key)(const struct rb_node *node))
+{
+	return __BSTLINK_FREEZE(frz, rb->node, key);
+}
+
+static inline struct rb_node *
+rb_frozen_find(const struct bst_frozen *frz, unsigned long key)
+{
+	return __BSTLINK_FROZEN_FIND(frz, key, struct rb_node);
+}
+
+static inline struct rb_node *
+rb_frozen_lower_bound(const struct bst_frozen *frz, unsigned long key)
+{
+	return __BSTLINK_FROZEN_LOWER_BOUND(frz, key, struct rb_node);
+}
+
+static inline void rb_frozen_destroy(struct bst_frozen *frz)
+{
+	bstlink_frozen_destroy(frz);
+}
+
 static inline void
 rb_clear(struct rb_root *rb,
 	 void (*destroy)(struct rb_node *node, const void *arg),
@@ -253,12 +567,27 @@ static inline bool rb_isvalid(struct rb_root *rb)
 }
 #endif
 
+/*
+ * rb_alloc, rb_free  --  an array of 'num' trees
+ *
+ * rb_alloc returns them empty, NULL if out of memory.  rb_free clears
+ * every tree by 'destroy' unless NULL and frees the array.
+ */
 struct rb_root *rb_alloc(size_t num);
 void rb_free(struct rb_root *rb,
 	     size_t num,
 	     void (*destroy)(struct rb_node *rb, const void *arg),
 	     const void *arg);
 
+/*
+ * rb_clone  --  copy 'rb_src' into 'rb' in O(n)
+ *
+ * The copy has the shape and colors of 'rb_src', no compare routine is
+ * called.  'node_clone' returns a new node with the content of 'node',
+ * the links are set here, or NULL if it fails.  Then the nodes cloned
+ * so far go to 'node_destroy' and false is returned, 'rb' is left as
+ * it is.  The old content of 'rb' is dropped on success.
+ */
 bool rb_clone(struct rb_root *rb,
 	      const struct rb_root *rb_src,
 	      struct rb_node *(*node_clone)(const struct rb_node *node,
@@ -267,7 +596,24 @@ bool rb_clone(struct rb_root *rb,
 	      const void *arg_clone,
 	      const void *arg_destroy);
 
-/* clone range: [beg, end) */
+/*
+ * rb_clone_parallel  --  rb_clone forking onto up to 'nthreads' threads
+ *
+ * The subtrees of the upper levels are cloned by threads of their own,
+ * 0 means one per online cpu.  'node_clone' and 'node_destroy' run on
+ * any thread.  It pays for millions of nodes.
+ */
+bool rb_clone_parallel(struct rb_root *rb,
+		       const struct rb_root *rb_src,
+		       struct rb_node *(*node_clone)(const struct rb_node *node,
+						     const void *arg),
+		       void (*node_destroy)(struct rb_node *node,
+					    const void *arg),
+		       const void *arg_clone,
+		       const void *arg_destroy,
+		       unsigned nthreads);
+
+/* clone range: [beg, end), built as by rb_build_sorted */
 bool rb_clone_range(struct rb_root *rb,
 		    const struct rb_node *beg,
 		    const struct rb_node *end,
@@ -0,0 +1,220 @@
+/*
+ * skiplist.h -- Lock-Free Skip Lists
+ *
+ * Copyright (C) 2012-2013 yanyg (cppgp@qq.com)
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING, if not see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * An ordered set of unique keys that threads share without a lock.
+ * Every level is a sorted list linked by compare-and-swap, a node is
+ * erased by marking the low bit of its next pointers, top level first,
+ * the mark of level 0 decides which eraser wins.  The marked nodes are
+ * unlinked by the searches passing by.  See Herlihy and Shavit, "The
+ * Art of Multiprocessor Programming", 14.4.
+ *
+ * An erased node may still be read by the other threads, so it is not
+ * given back at once: the skip list hands it to epoch_retire and the
+ * 'release' routine of skl_init is called when no thread can see it
+ * any more.  So every routine, except skl_init and skl_clear, MUST be
+ * called between epoch_enter and epoch_exit of the domain given to
+ * skl_init, and a node returned is valid until epoch_exit.
+ *
+ * Example as follows
+ */
+
+#if 0
+struct item
+{
+	int key;
+	struct skl_node skl;
+};
+
+static int item_compare(const struct skl_node *node, const void *arg)
+{
+	return skl_entry(node, struct item, skl)->key - *(const int*)arg;
+}
+
+static int item_compare_link(const struct skl_node *node1,
+			     const struct skl_node *node2,
+			     const void *arg)
+{
+	return item_compare(node1, &skl_entry(node2, struct item, skl)->key);
+}
+
+static void item_release(struct epoch_entry *entry)
+{
+	free(skl_entry(skl_epoch_entry(entry), struct item, skl));
+}
+
+	skl_init(&skl, &domain, item_release);
+	...
+	epoch_enter(thr);
+	if (skl_insert_unique(&item->skl, &skl, item_compare_link, NULL))
+		free(item);	/* never published */
+	...
+	node = skl_find(&skl, item_compare, &key);
+	if (node)
+		skl_erase(node, &skl, item_compare_link, NULL);
+	epoch_exit(thr);
+#endif
+
+#ifndef __YC_ALGOS_SKIPLIST_H_
+#define __YC_ALGOS_SKIPLIST_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include <ycc/compiler.h>
+#include <ycc/epoch.h>
+
+__BEGIN_DECLS
+
+/*
+ * levels per node, a node gets one more level with probability 1/4, so
+ * 12 levels keep O(log n) searches up to 4^12 (16M) nodes.
+ */
+#ifndef SKL_MAX_LEVEL
+#define SKL_MAX_LEVEL	12
+#endif
+
+struct skl_node
+{
+	struct skl_node *next[SKL_MAX_LEVEL];	/* low bit: erased */
+	unsigned long state;			/* level and SKL_* flags */
+	struct epoch_entry entry;
+};
+
+struct skl_root
+{
+	struct skl_node head;
+	struct epoch_domain *domain;
+	void (*release)(struct epoch_entry *entry);
+};
+
+#define skl_entry(ptr, type, member)	container_of(ptr, type, member)
+#define skl_epoch_entry(entry)	container_of(entry, struct skl_node, entry)
+
+/* 'release' is given to epoch_retire with the 'entry' of erased nodes */
+void skl_init(struct skl_root *skl,
+	      struct epoch_domain *domain,
+	      void (*release)(struct epoch_entry *entry));
+
+/*
+ * skl_first, skl_next  --  ordered iteration
+ *
+ * Description
+ *	The nodes erased are skipped, the iteration is not a snapshot:
+ *	the nodes inserted or erased meanwhile may or may not be seen.
+ *
+ * Return value
+ *	NULL past the last node.
+ */
+struct skl_node *skl_next(const struct skl_node *node);
+static inline struct skl_node *skl_first(const struct skl_root *skl)
+{
+	return skl_next(&skl->head);
+}
+
+static inline bool skl_empty(const struct skl_root *skl)
+{
+	return !skl_first(skl);
+}
+
+/*
+ * skl_find, skl_lower_bound  --  search
+ *
+ * Description
+ *	'compare' returns negative, zero or positive if 'node' is less
+ *	than, equal to or greater than the key 'arg'.  skl_find returns
+ *	the node equal to 'arg', skl_lower_bound the first node not less
+ *	than 'arg'.  Neither writes the shared memory.
+ *
+ * Return value
+ *	NULL if none.
+ */
+struct skl_node *skl_find(const struct skl_root *skl,
+			  int (*compare)(const struct skl_node *node,
+					 const void *arg),
+			  const void *arg);
+struct skl_node *skl_lower_bound(const struct skl_root *skl,
+				 int (*compare)(const struct skl_node *node,
+						const void *arg),
+				 const void *arg);
+
+/*
+ * skl_insert_unique  --  insert 'node' unless its key exists
+ *
+ * Return value
+ *	NULL if 'node' is inserted, otherwise the node of equal key and
+ *	'node' is untouched by the other threads.
+ */
+struct skl_node *skl_insert_unique(struct skl_node *node,
+				   struct skl_root *skl,
+				   int (*compare_link)(
+					const struct skl_node *node1,
+					const struct skl_node *node2,
+					const void *arg),
+				   const void *arg);
+
+/*
+ * skl_erase  --  erase 'node'
+ *
+ * Description
+ *	'node' is a node found or inserted.  When several threads erase
+ *	the same node, one wins.  The node is released in a later epoch.
+ *
+ * Return value
+ *	true if the caller erased it, false if another thread did.
+ */
+bool skl_erase(struct skl_node *node,
+	       struct skl_root *skl,
+	       int (*compare_link)(const struct skl_node *node1,
+				   const struct skl_node *node2,
+				   const void *arg),
+	       const void *arg);
+
+/*
+ * skl_clear  --  release all nodes
+ *
+ * Description
+ *	No other thread may use 'skl'.  The nodes erased but not yet
+ *	released are left to the epoch domain.
+ */
+void skl_clear(struct skl_root *skl);
+
+/* valid check, no other thread may use 'skl' */
+#ifndef NDEBUG
+bool skl_isvalid(const struct skl_root *skl,
+		 int (*compare_link)(const struct skl_node *node1,
+				     const struct skl_node *node2,
+				     const void *arg),
+		 const void *arg);
+#else
+static inline bool skl_isvalid(const struct skl_root *skl,
+			       int (*compare_link)(
+					const struct skl_node *node1,
+					const struct skl_node *node2,
+					const void *arg),
+			       const void *arg)
+{
+	return true;
+}
+#endif
+
+__END_DECLS
+
+#endif /* __YC_ALGOS_SKIPLIST_H_ */
@@ -1,5 +1,5 @@
 /*
- * bstree.h -- Splay Trees
+ * sptree.h -- Splay Trees
  *
  * Copyright (C) 2012-2013 yanyg (cppgp@qq.com)
  *
@@ -18,8 +18,8 @@
  * <http://www.gnu.org/licenses/>.
  */
 
-#ifndef __YC_ALGOS_BSTREE_H_
-#define __YC_ALGOS_BSTREE_H_
+#ifndef __YC_ALGOS_SPTREE_H_
+#define __YC_ALGOS_SPTREE_H_
 
 #include <ycc/algos/bstree-link.h>
 
@@ -30,20 +30,55 @@ struct spt_node
 	__BST_LINK_MEMBER(struct spt_node);
 } __aligned(sizeof(void*));
 
+/*
+ * The splay modes of a tree, 0 by default
+ *
+ *	SPT_TOPDOWN	: the keyed accesses (find, bounds and inserts)
+ *			  splay top-down, in the one pass that searches
+ *	SPT_SEMI	: the bottom-up splays semi-splay, a zig-zig step
+ *			  rotates once and goes on from the parent, which
+ *			  halves the writes but leaves the node lower
+ *	SPT_BOUNDS	: spt_lower_bound and spt_upper_bound splay the
+ *			  bound they return, so range scans adapt too
+ *
+ * The erases and the SPT_GENERATE cores always splay bottom-up.
+ */
+#define SPT_TOPDOWN	1U
+#define SPT_SEMI	2U
+#define SPT_BOUNDS	4U
+
 struct spt_root
 {
 	struct spt_node *node;
+	unsigned mode;
 };
 
 #define spt_entry(ptr, type, member)	container_of(ptr, type, member)
 
+static inline struct spt_node *spt_parent(const struct spt_node *node)
+{
+	return __BSTLINK_PARENT(node, struct spt_node);
+}
+
+static inline void spt_set_parent(struct spt_node *node,
+				  struct spt_node *parent)
+{
+	__BSTLINK_SET_PARENT(node, parent);
+}
+
 #define SPT_DECLARE(name)	struct spt_root name =  { NULL, }
-#define SPT_INIT(name)	do { (name).node = NULL; } while (0)
+#define SPT_INIT(name)	do { (name).node = NULL; (name).mode = 0; } while (0)
 static inline void spt_init(struct spt_root *spt)
 {
 	SPT_INIT(*spt);
 }
 
+/* spt_set_mode  --  'mode' is an OR of SPT_TOPDOWN, SPT_SEMI, SPT_BOUNDS */
+static inline void spt_set_mode(struct spt_root *spt, unsigned mode)
+{
+	spt->mode = mode;
+}
+
 static inline void spt_link_node(struct spt_node *node,
 				struct spt_node *parent,
 				struct spt_node **pnode)
@@ -72,6 +107,51 @@ static inline struct spt_node *spt_prev(const struct spt_node* node)
 }
 
 void __spt_splay(struct spt_node *node, struct spt_node **proot);
+void __spt_semisplay(struct spt_node *node, struct spt_node **proot);
+
+/*
+ * __spt_splay_bound  --  top-down splay of a bound
+ *
+ * Description
+ *	One pass from the root looks for the first node 'compare' finds
+ *	not less than 'arg' ('bequal') or greater than it (!'bequal'),
+ *	and makes it the root.  If there is none the last node is the
+ *	root.
+ *
+ * Return value
+ *	The bound or NULL.
+ */
+struct spt_node *__spt_splay_bound(struct spt_node **proot,
+				   int (*compare)(const struct spt_node *node,
+						  const void *arg),
+				   const void *arg,
+				   bool bequal);
+
+/*
+ * __spt_insert_topdown  --  insert 'node' as the root, top-down
+ *
+ * Return value
+ *	false if 'bunique' and an equal node exists, 'node' is not linked.
+ */
+bool __spt_insert_topdown(struct spt_node *node,
+			  struct spt_root *spt,
+			  int (*compare_link)(const struct spt_node *node1,
+					      const struct spt_node *node2,
+					      const void *arg),
+			  const void *arg,
+			  bool bunique);
+
+/* splay an accessed 'node' the way the mode of 'spt' says */
+static inline void __spt_access(struct spt_node *node,
+				const struct spt_root *spt)
+{
+	struct spt_node **proot = (struct spt_node**)&spt->node;
+
+	if (spt->mode & SPT_SEMI)
+		__spt_semisplay(node, proot);
+	else
+		__spt_splay(node, proot);
+}
 
 void spt_erase(struct spt_node *node, struct spt_root *spt);
 
@@ -82,11 +162,17 @@ spt_find(const struct spt_root *spt,
 		       const void *arg),
         const void *arg)
 {
-	struct spt_node *p = __BSTLINK_FIND(spt->node, compare, arg,
-					    struct spt_node);
+	struct spt_node *p;
 
+	if (spt->mode & SPT_TOPDOWN) {
+		p = __spt_splay_bound((struct spt_node**)&spt->node,
+				      compare, arg, true);
+		return p && !compare(p, arg) ? p : NULL;
+	}
+
+	p = __BSTLINK_FIND(spt->node, compare, arg, struct spt_node);
 	if (p)
-		__spt_splay(p, (struct spt_node**)&spt->node);
+		__spt_access(p, spt);
 
 	return p;
 }
@@ -97,7 +183,18 @@ spt_lower_bound(const struct spt_root *spt,
 			      const void *arg),
 	       const void *arg)
 {
-	return __BSTLINK_LOWER_BOUND(spt->node, compare, arg, struct spt_node);
+	struct spt_node *p;
+
+	if ((spt->mode & (SPT_BOUNDS | SPT_TOPDOWN)) ==
+	    (SPT_BOUNDS | SPT_TOPDOWN))
+		return __spt_splay_bound((struct spt_node**)&spt->node,
+					 compare, arg, true);
+
+	p = __BSTLINK_LOWER_BOUND(spt->node, compare, arg, struct spt_node);
+	if (p && (spt->mode & SPT_BOUNDS))
+		__spt_access(p, spt);
+
+	return p;
 }
 
 static inline struct spt_node *
@@ -106,7 +203,18 @@ spt_upper_bound(const struct spt_root *spt,
 			      const void *arg),
 	       const void *arg)
 {
-	return __BSTLINK_UPPER_BOUND(spt->node, compare, arg, struct spt_node);
+	struct spt_node *p;
+
+	if ((spt->mode & (SPT_BOUNDS | SPT_TOPDOWN)) ==
+	    (SPT_BOUNDS | SPT_TOPDOWN))
+		return __spt_splay_bound((struct spt_node**)&spt->node,
+					 compare, arg, false);
+
+	p = __BSTLINK_UPPER_BOUND(spt->node, compare, arg, struct spt_node);
+	if (p && (spt->mode & SPT_BOUNDS))
+		__spt_access(p, spt);
+
+	return p;
 }
 
 static inline void
@@ -129,8 +237,13 @@ spt_insert(struct spt_node *node,
 			      const void *arg),
 	  const void *arg)
 {
+	if (spt->mode & SPT_TOPDOWN) {
+		(void)__spt_insert_topdown(node, spt, compare_link, arg, false);
+		return;
+	}
+
 	(void)__BSTLINK_INSERT(node, &spt->node, compare_link, arg, false);
-	__spt_splay(node, &spt->node);
+	__spt_access(node, spt);
 }
 
 static inline bool
@@ -141,20 +254,33 @@ spt_insert_unique(struct spt_node *node,
 				     const void *arg),
 		 const void *arg)
 {
-	
-	if (__BSTLINK_INSERT(node, &spt->node, compare_link, arg, false)) {
-		__spt_splay(node, &spt->node);
+	if (spt->mode & SPT_TOPDOWN)
+		return __spt_insert_topdown(node, spt, compare_link, arg, true);
+
+	if (__BSTLINK_INSERT(node, &spt->node, compare_link, arg, true)) {
+		__spt_access(node, spt);
 		return true;
 	}
 
 	return false;
 }
 
+/*
+ * comparator-inlined cores: name##_find, name##_lower_bound, ...
+ * cmp(const type *a, const type *b) returns <0, 0 or >0,
+ * found and inserted nodes are splayed bottom-up, semi-splayed under
+ * SPT_SEMI.
+ */
+#define SPT_GENERATE(name, type, member, cmp)				\
+	__BSTLINK_GENERATE(name, struct spt_root, struct spt_node,	\
+			   type, member, cmp,				\
+			   __spt_access, __spt_access)
+
 static inline void
 spt_replace(struct spt_node *victim, struct spt_node *new, struct spt_root *spt)
 {
 	__BSTLINK_REPLACE(victim, new, &spt->node);
-	__spt_splay(new, &spt->node);
+	__spt_access(new, spt);
 }
 
 static inline void spt_erase_range(struct spt_node *beg,
@@ -251,4 +377,4 @@ static inline void spt_swap(struct spt_root *spt1, struct spt_root *spt2)
 
 __END_DECLS
 
-#endif /* __YC_ALGOS_sptTREE_H_ */
+#endif /* __YC_ALGOS_SPTREE_H_ */
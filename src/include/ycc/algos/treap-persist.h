@@ -0,0 +1,230 @@
+/*
+ * treap-persist.h -- Persistent Treaps
+ *
+ * Copyright (C) 2012-2013 yanyg (cppgp@qq.com)
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING, if not see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * A treap whose nodes never change once linked.  An insert or an erase
+ * copies the O(log n) nodes of its path by the 'copy' routine, shares
+ * the rest with the former version and publishes a new version.  A
+ * reader takes a snapshot, the version current at that time, and then
+ * searches or scans it without any lock as long as it likes, while the
+ * writers go on.
+ *
+ * Every node counts its parents plus the versions rooted at it, the
+ * 'release' routine is called when the count drops to zero, on the
+ * thread dropping the last reference.  The nodes have no parent link,
+ * the scans go through ptreap_visit_cond and ptreap_visit_from.
+ *
+ * Example as follows
+ */
+
+#if 0
+static struct ptreap_node *item_copy(const struct ptreap_node *node,
+				     const void *arg)
+{
+	struct item *p = malloc(sizeof(*p));
+
+	/* the payload, not 'node' */
+	if (p)
+		p->key = ptreap_entry(node, struct item, node)->key;
+	return p ? &p->node : NULL;
+}
+
+	ptreap_init(&pt, item_copy, item_release, NULL);
+
+	/* writers */
+	if (ptreap_insert(&pt, &item->node, item_compare_link, NULL))
+		return -1;
+	...
+	ptreap_erase(&pt, item_compare, &key);
+
+	/* readers */
+	ptreap_snapshot(&pt, &snap);
+	node = ptreap_find(&snap, item_compare, &key);
+	ptreap_visit_from(&snap, item_compare, &lo, item_visit, &sum);
+	ptreap_put_snapshot(&pt, &snap);
+#endif
+
+#ifndef __YC_ALGOS_TREAP_PERSIST_H_
+#define __YC_ALGOS_TREAP_PERSIST_H_
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include <ycc/compiler.h>
+
+__BEGIN_DECLS
+
+struct ptreap_node
+{
+	struct ptreap_node *left, *right;
+	unsigned priority;
+	/*
+	 * the parents and the versions, counted by atomics while the
+	 * node is shared, 'copy' MUST NOT read it nor the links
+	 */
+	unsigned long ref;
+} __aligned(sizeof(void*));
+
+struct ptreap_root
+{
+	struct ptreap_node *node;	/* the current version */
+	pthread_mutex_t lock;		/* serializes the writers */
+	pthread_mutex_t version_lock;	/* 'node' as a snapshot is taken */
+	struct ptreap_node *(*copy)(const struct ptreap_node *node,
+				    const void *arg);
+	void (*release)(struct ptreap_node *node, const void *arg);
+	const void *arg;
+};
+
+/* a version, immutable */
+struct ptreap_snap
+{
+	struct ptreap_node *node;
+};
+
+#define ptreap_entry(ptr, type, member)	container_of(ptr, type, member)
+
+/*
+ * ptreap_init  --  initialize an empty 'pt'
+ *
+ * Description
+ *	'copy' returns a new node with the content of 'node' apart from
+ *	the links, or NULL if out of memory.  It copies the payload of
+ *	the entry only, the library sets the links, the priority and
+ *	'ref' of the copy.
+ *	'release' frees a node unreachable from any version, the inserted
+ *	ones and the copies alike.  'arg' goes to both.
+ */
+void ptreap_init(struct ptreap_root *pt,
+		 struct ptreap_node *(*copy)(const struct ptreap_node *node,
+					     const void *arg),
+		 void (*release)(struct ptreap_node *node, const void *arg),
+		 const void *arg);
+
+/*
+ * ptreap_destroy  --  drop the current version
+ *
+ * Description
+ *	The nodes held by snapshots are released as they are put.
+ */
+void ptreap_destroy(struct ptreap_root *pt);
+
+/*
+ * ptreap_snapshot, ptreap_put_snapshot  --  hold and drop a version
+ *
+ * Description
+ *	The snapshot keeps all its nodes alive and unchanged until it is
+ *	put, put the snapshots before ptreap_destroy returns the nodes
+ *	to 'release'.  A snapshot may be copied to another thread.
+ */
+void ptreap_snapshot(struct ptreap_root *pt, struct ptreap_snap *snap);
+void ptreap_put_snapshot(struct ptreap_root *pt, struct ptreap_snap *snap);
+
+/*
+ * ptreap_insert  --  publish a version with 'node' after its equals
+ *
+ * Description
+ *	'node' belongs to 'pt' on success, it MUST NOT change since.
+ *
+ * Return value
+ *	0 on success, otherwise -1 and errno is set to ENOMEM if 'copy'
+ *	failed, the version is unchanged and 'node' is the caller's.
+ */
+int ptreap_insert(struct ptreap_root *pt,
+		  struct ptreap_node *node,
+		  int (*compare_link)(const struct ptreap_node *node1,
+				      const struct ptreap_node *node2,
+				      const void *arg),
+		  const void *arg);
+
+/*
+ * ptreap_erase  --  publish a version without the first node of 'arg'
+ *
+ * Return value
+ *	0 on success, otherwise -1 and errno is set to ENOENT if there is
+ *	no such node, ENOMEM if 'copy' failed.
+ */
+int ptreap_erase(struct ptreap_root *pt,
+		 int (*compare)(const struct ptreap_node *node,
+				const void *arg),
+		 const void *arg);
+
+/*
+ * ptreap_find, ptreap_lower_bound  --  search a snapshot
+ *
+ * Description
+ *	The first node equal to 'arg', or the first node not less than
+ *	'arg', NULL if none.  It stays valid until the snapshot is put.
+ */
+struct ptreap_node *ptreap_find(const struct ptreap_snap *snap,
+				int (*compare)(const struct ptreap_node *node,
+					       const void *arg),
+				const void *arg);
+struct ptreap_node *
+ptreap_lower_bound(const struct ptreap_snap *snap,
+		   int (*compare)(const struct ptreap_node *node,
+				  const void *arg),
+		   const void *arg);
+
+/*
+ * ptreap_visit_cond, ptreap_visit_from  --  ordered scan of a snapshot
+ *
+ * Description
+ *	ptreap_visit_from begins at the lower bound of 'arg'.  The scan
+ *	stops when 'visit_cond' returns false.
+ *
+ * Return value
+ *	false if 'visit_cond' stopped the scan.
+ */
+bool ptreap_visit_cond(const struct ptreap_snap *snap,
+		       bool (*visit_cond)(const struct ptreap_node *node,
+					  const void *arg),
+		       const void *arg);
+bool ptreap_visit_from(const struct ptreap_snap *snap,
+		       int (*compare)(const struct ptreap_node *node,
+				      const void *arg),
+		       const void *arg,
+		       bool (*visit_cond)(const struct ptreap_node *node,
+					  const void *arg),
+		       const void *arg_visit);
+
+/* valid check */
+#ifndef NDEBUG
+bool ptreap_isvalid(const struct ptreap_snap *snap,
+		    int (*compare_link)(const struct ptreap_node *node1,
+					const struct ptreap_node *node2,
+					const void *arg),
+		    const void *arg);
+#else
+static inline bool
+ptreap_isvalid(const struct ptreap_snap *snap,
+	       int (*compare_link)(const struct ptreap_node *node1,
+				   const struct ptreap_node *node2,
+				   const void *arg),
+	       const void *arg)
+{
+	return true;
+}
+#endif
+
+__END_DECLS
+
+#endif /* __YC_ALGOS_TREAP_PERSIST_H_ */
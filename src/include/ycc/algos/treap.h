@@ -19,19 +19,36 @@
  */
 
 /*
- * To use treaptrees you'll have to implement your own insert and search cores.
- * This will avoid us to use callbacks and to drop drammatically performances.
+ * The treap_find/treap_insert family calls a compare routine through a pointer for
+ * every level, it is convenient but drops performances dramatically.
+ * TREAP_GENERATE emits insert and search cores with the comparator inlined.
  *
  * Example of insert and search as follows
  */
 
 #if 0
-Example of insert and search routines.
+struct item {
+	int key;
+	struct treap_node node;
+};
+
+static inline int item_cmp(const struct item *a, const struct item *b)
+{
+	return a->key < b->key ? -1 : a->key > b->key;
+}
+
+TREAP_GENERATE(item_tree, struct item, node, item_cmp)
+
+	item_tree_insert(&root, item);
+	...
+	struct item key = { .key = 5 };
+	struct item *found = item_tree_find(&root, &key);
 #endif
 
 #ifndef __YC_ALGOS_TREAPTREE_H_
 #define __YC_ALGOS_TREAPTREE_H_
 
+#include <stdint.h>
 #include <stdlib.h>
 
 #include <ycc/algos/bstree-link.h>
@@ -49,12 +66,53 @@ struct treap_root
 	struct treap_node *node;
 };
 
+/*
+ * treap_rand  --  a random priority
+ *
+ * Description
+ *	wyrand on a state per thread, threads inserting into treaps of
+ *	their own share nothing, unlike rand() which takes a global lock.
+ */
+unsigned treap_rand(void);
+
+/*
+ * treap_hash_priority  --  a priority derived from a key
+ *
+ * Description
+ *	The bits of 'key', an integer key or a hash of it, mixed as the
+ *	splitmix64 finalizer does.  A treap inserted with these by
+ *	treap_insert_with_priority takes one shape for a set of distinct
+ *	keys, whatever order they come in.  Keys an attacker chooses
+ *	SHOULD be hashed with a secret seed first.
+ */
+static inline unsigned treap_hash_priority(uint64_t key)
+{
+	key ^= key >> 30;
+	key *= 0xbf58476d1ce4e5b9ULL;
+	key ^= key >> 27;
+	key *= 0x94d049bb133111ebULL;
+	key ^= key >> 31;
+
+	return (unsigned)(key >> 32);
+}
+
 #define treap_priority(r)			((r)->priority)
 #define treap_set_priority(r, _priority)	((r)->priority = (_priority))
-#define treap_init_priority(r)			((r)->priority = (unsigned)rand())
+#define treap_init_priority(r)			((r)->priority = treap_rand())
 
 #define treap_entry(ptr, type, member)	container_of(ptr, type, member)
 
+static inline struct treap_node *treap_parent(const struct treap_node *node)
+{
+	return __BSTLINK_PARENT(node, struct treap_node);
+}
+
+static inline void treap_set_parent(struct treap_node *node,
+				    struct treap_node *parent)
+{
+	__BSTLINK_SET_PARENT(node, parent);
+}
+
 #define TREAP_DECLARE(name)	struct treap_root name =  { NULL, }
 #define TREAP_INIT(name)	do { (name).node = NULL; } while (0)
 static inline void treap_init(struct treap_root *treap)
@@ -93,6 +151,88 @@ static inline struct treap_node *treap_prev(const struct treap_node* node)
 void treap_insert_rebalance(struct treap_node *node, struct treap_root *treap);
 void treap_erase(struct treap_node *node, struct treap_root *treap);
 
+/*
+ * treap_build_sorted  --  build treap from 'nodes[0..num)' in O(num)
+ *
+ * 'nodes' MUST be sorted already, no compare routine is called.
+ * Priorities are drawn per level, so they grow from root to leaves.
+ * The old content of 'treap' is dropped.
+ */
+void treap_build_sorted(struct treap_root *treap,
+			struct treap_node **nodes,
+			size_t num);
+
+/*
+ * treap_split  --  split treap by 'arg' in O(log n)
+ *
+ * Nodes less than 'arg' (compare returns < 0) go to 'left', the others
+ * go to 'right'.  'treap' is emptied, it may be the same as 'left' or
+ * 'right'.
+ */
+void treap_split(struct treap_root *treap,
+		 int (*compare)(const struct treap_node *node,
+				const void *arg),
+		 const void *arg,
+		 struct treap_root *left,
+		 struct treap_root *right);
+
+/*
+ * treap_join  --  join 'left', 'pivot' and 'right' into treap in O(log n)
+ *
+ * All nodes of 'left' MUST order before 'pivot', all nodes of 'right'
+ * after it.  'left' and 'right' are emptied, either may be 'treap'.
+ */
+void treap_join(struct treap_root *treap,
+		struct treap_root *left,
+		struct treap_node *pivot,
+		struct treap_root *right);
+
+/* treap_concat  --  treap_join without pivot */
+void treap_concat(struct treap_root *treap,
+		  struct treap_root *left,
+		  struct treap_root *right);
+
+/*
+ * treap_union, treap_intersection, treap_difference  --  set algorithms
+ *
+ * 'treap1' and 'treap2' are consumed and the result goes to 'treap',
+ * which may be either of them.  Nodes of 'treap1' are kept on equal
+ * keys, every node dropped from either tree goes to 'destroy', which
+ * may run on any thread.  It costs O(m log(n/m + 1)) for trees of m <= n nodes and
+ * forks onto up to 'nthreads' threads, 0 means one per online cpu.
+ */
+void treap_union(struct treap_root *treap,
+		 struct treap_root *treap1,
+		 struct treap_root *treap2,
+		 int (*compare_link)(const struct treap_node *node1,
+				     const struct treap_node *node2,
+				     const void *arg),
+		 void (*destroy)(struct treap_node *node, const void *arg),
+		 const void *arg_compare,
+		 const void *arg_destroy,
+		 unsigned nthreads);
+void treap_intersection(struct treap_root *treap,
+			struct treap_root *treap1,
+			struct treap_root *treap2,
+			int (*compare_link)(const struct treap_node *node1,
+					    const struct treap_node *node2,
+					    const void *arg),
+			void (*destroy)(struct treap_node *node,
+					const void *arg),
+			const void *arg_compare,
+			const void *arg_destroy,
+			unsigned nthreads);
+void treap_difference(struct treap_root *treap,
+		      struct treap_root *treap1,
+		      struct treap_root *treap2,
+		      int (*compare_link)(const struct treap_node *node1,
+					  const struct treap_node *node2,
+					  const void *arg),
+		      void (*destroy)(struct treap_node *node, const void *arg),
+		      const void *arg_compare,
+		      const void *arg_destroy,
+		      unsigned nthreads);
+
 
 /* helper routine */
 static inline struct treap_node *
@@ -122,6 +262,35 @@ treap_upper_bound(const struct treap_root *treap,
 	return __BSTLINK_UPPER_BOUND(treap->node, compare, arg, struct treap_node);
 }
 
+/*
+ * treap_find_batch, treap_lower_bound_batch  --  batched search
+ *
+ * 'results[i]' is set to the node treap_find (treap_lower_bound) returns
+ * for 'args[i]'.  The searches share the memory latency, see
+ * bstlink_find_batch.
+ */
+static inline void
+treap_find_batch(const struct treap_root *treap,
+		 int (*compare)(const struct treap_node *node,
+				const void *arg),
+		 const void * const *args,
+		 size_t num,
+		 struct treap_node **results)
+{
+	__BSTLINK_FIND_BATCH(treap->node, compare, args, num, results);
+}
+
+static inline void
+treap_lower_bound_batch(const struct treap_root *treap,
+			int (*compare)(const struct treap_node *node,
+				       const void *arg),
+			const void * const *args,
+			size_t num,
+			struct treap_node **results)
+{
+	__BSTLINK_LOWER_BOUND_BATCH(treap->node, compare, args, num, results);
+}
+
 static inline void
 treap_lower_upper_bound(const struct treap_root *treap,
 		     int (*compare)(const struct treap_node *node,
@@ -164,7 +333,7 @@ treap_insert_unique(struct treap_node *node,
 {
 	
 	if (__BSTLINK_INSERT(node, &treap->node, compare_link,
-				       arg, false))
+				       arg, true))
 	{
 		__treap_insert_rest(node, treap);
 		return true;
@@ -173,6 +342,74 @@ treap_insert_unique(struct treap_node *node,
 	return false;
 }
 
+/*
+ * treap_insert_with_priority, treap_insert_unique_with_priority
+ *	--  insert 'node' of 'priority' instead of a random one
+ *
+ * Description
+ *	See treap_hash_priority.  The lower priorities are nearer to the
+ *	root, the priorities SHOULD be spread as random ones are or the
+ *	treap loses its balance.
+ */
+static inline void
+treap_insert_with_priority(struct treap_node *node,
+			   struct treap_root *treap,
+			   unsigned priority,
+			   int (*compare_link)(const struct treap_node *node1,
+					       const struct treap_node *node2,
+					       const void *arg),
+			   const void *arg)
+{
+	(void)__BSTLINK_INSERT(node, &treap->node, compare_link, arg, false);
+	treap_set_priority(node, priority);
+	treap_insert_rebalance(node, treap);
+}
+
+static inline bool
+treap_insert_unique_with_priority(struct treap_node *node,
+				  struct treap_root *treap,
+				  unsigned priority,
+				  int (*compare_link)(
+					const struct treap_node *node1,
+					const struct treap_node *node2,
+					const void *arg),
+				  const void *arg)
+{
+	if (__BSTLINK_INSERT(node, &treap->node, compare_link, arg, true)) {
+		treap_set_priority(node, priority);
+		treap_insert_rebalance(node, treap);
+		return true;
+	}
+
+	return false;
+}
+
+/*
+ * treap_insert_hint  --  treap_insert searching from 'hint'
+ *
+ * 'hint' is a node of 'treap' near the new one, typically the last node
+ * inserted, or NULL.  An ascending (descending) stream hinted with the
+ * last node costs O(1) compares per insert, see bstlink_insert_hint.
+ */
+static inline void
+treap_insert_hint(struct treap_node *node,
+		  struct treap_node *hint,
+		  struct treap_root *treap,
+		  int (*compare_link)(const struct treap_node *node1,
+				      const struct treap_node *node2,
+				      const void *arg),
+		  const void *arg)
+{
+	__BSTLINK_INSERT_HINT(node, hint, &treap->node, compare_link, arg);
+	__treap_insert_rest(node, treap);
+}
+
+/* comparator-inlined cores, see the example at the top of this file */
+#define TREAP_GENERATE(name, type, member, cmp)				\
+	__BSTLINK_GENERATE(name, struct treap_root, struct treap_node,	\
+			   type, member, cmp,				\
+			   __BSTLINK_NOP, __treap_insert_rest)
+
 static inline void
 treap_replace(struct treap_node *victim, struct treap_node *new, struct treap_root *treap)
 {
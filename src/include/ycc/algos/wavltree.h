@@ -0,0 +1,338 @@
+/*
+ * wavltree.h -- Weak AVL Trees
+ *
+ * Copyright (C) 2012-2013 yanyg (cppgp@qq.com)
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING, if not see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * A weak AVL tree is rank-balanced: every node has a rank, a missing
+ * node -1, a child is one or two ranks below its parent and a leaf is
+ * of rank 0.  Built by inserts only it is an AVL tree, the rank is the
+ * height.  An erase demotes up the path but rotates at most twice, the
+ * rebalance of avl_erase may rotate at every level, and rb_erase
+ * recolors far more often.  The height stays under 2 log2(n) anyway.
+ *
+ * A rank difference is 1 or 2, so the parity of the rank tells it, and
+ * one bit per node is enough.  It goes in the parent word with
+ * BSTLINK_COMPACT.
+ *
+ * Example of insert and search as follows
+ */
+
+#if 0
+struct item {
+	int key;
+	struct wavl_node node;
+};
+
+static inline int item_cmp(const struct item *a, const struct item *b)
+{
+	return a->key < b->key ? -1 : a->key > b->key;
+}
+
+WAVL_GENERATE(item_tree, struct item, node, item_cmp)
+
+	item_tree_insert(&root, item);
+	...
+	struct item key = { .key = 5 };
+	struct item *found = item_tree_find(&root, &key);
+	...
+	wavl_erase(&found->node, &root);
+#endif
+
+#ifndef __YC_ALGOS_WAVLTREE_H_
+#define __YC_ALGOS_WAVLTREE_H_
+
+#include <ycc/algos/bstree-link.h>
+
+__BEGIN_DECLS
+
+struct wavl_node
+{
+	__BST_LINK_MEMBER(struct wavl_node);
+#ifndef	BSTLINK_COMPACT
+	unsigned parity;
+#endif
+} __aligned(sizeof(void*));
+
+struct wavl_root
+{
+	struct wavl_node *node;
+};
+
+/* the parity of the rank, a missing node (rank -1) is odd */
+#ifdef	BSTLINK_COMPACT
+#define __wavl_parity(n)	(__BSTLINK_BITS(n) & 1)
+#define wavl_set_parity(n, par)	__BSTLINK_SET_BITS(n, (par) & 1)
+#else
+#define __wavl_parity(n)	((n)->parity)
+#define wavl_set_parity(n, par)	((n)->parity = (par))
+#endif
+#define wavl_parity(n)		((n) ? __wavl_parity(n) : 1U)
+
+#define wavl_entry(ptr, type, member)	container_of(ptr, type, member)
+
+static inline struct wavl_node *wavl_parent(const struct wavl_node *node)
+{
+	return __BSTLINK_PARENT(node, struct wavl_node);
+}
+
+static inline void wavl_set_parent(struct wavl_node *node,
+				   struct wavl_node *parent)
+{
+	__BSTLINK_SET_PARENT(node, parent);
+}
+
+#define WAVL_DECLARE(name)	struct wavl_root name =  { NULL, }
+#define WAVL_INIT(name)	do { (name).node = NULL; } while (0)
+static inline void wavl_init(struct wavl_root *wavl)
+{
+	WAVL_INIT(*wavl);
+}
+
+/* a new leaf is of rank 0 */
+static inline void wavl_link_node(struct wavl_node *node,
+				  struct wavl_node *parent,
+				  struct wavl_node **pnode)
+{
+	__BSTLINK_INIT(node, parent, pnode);
+	wavl_set_parity(node, 0);
+}
+
+static inline struct wavl_node *wavl_first(const struct wavl_root *wavl)
+{
+	return __BSTLINK_FIRST(wavl->node, struct wavl_node);
+}
+
+static inline struct wavl_node *wavl_last(const struct wavl_root *wavl)
+{
+	return __BSTLINK_LAST(wavl->node, struct wavl_node);
+}
+
+static inline struct wavl_node *wavl_next(const struct wavl_node* node)
+{
+	return __BSTLINK_NEXT(node, struct wavl_node);
+}
+
+static inline struct wavl_node *wavl_prev(const struct wavl_node* node)
+{
+	return __BSTLINK_PREV(node, struct wavl_node);
+}
+
+void wavl_insert_rebalance(struct wavl_node *node, struct wavl_root *wavl);
+void wavl_erase(struct wavl_node *node, struct wavl_root *wavl);
+
+/* helper routine */
+static inline struct wavl_node *
+wavl_find(const struct wavl_root *wavl,
+	  int (*compare)(const struct wavl_node *node,
+			 const void *arg),
+	  const void *arg)
+{
+	return __BSTLINK_FIND(wavl->node, compare, arg, struct wavl_node);
+}
+
+static inline struct wavl_node *
+wavl_lower_bound(const struct wavl_root *wavl,
+		 int (*compare)(const struct wavl_node *node,
+				const void *arg),
+		 const void *arg)
+{
+	return __BSTLINK_LOWER_BOUND(wavl->node, compare, arg,
+				     struct wavl_node);
+}
+
+static inline struct wavl_node *
+wavl_upper_bound(const struct wavl_root *wavl,
+		 int (*compare)(const struct wavl_node *node,
+				const void *arg),
+		 const void *arg)
+{
+	return __BSTLINK_UPPER_BOUND(wavl->node, compare, arg,
+				     struct wavl_node);
+}
+
+static inline void
+wavl_lower_upper_bound(const struct wavl_root *wavl,
+		       int (*compare)(const struct wavl_node *node,
+				      const void *arg),
+		       const void *arg,
+		       struct wavl_node **plower,
+		       struct wavl_node **pupper)
+{
+	return __BSTLINK_LOWER_UPPER_BOUND(wavl->node, compare, arg,
+					   plower, pupper);
+}
+
+static inline void
+__wavl_insert_rest(struct wavl_node *node, struct wavl_root *wavl)
+{
+	wavl_set_parity(node, 0);
+	wavl_insert_rebalance(node, wavl);
+}
+
+static inline void
+wavl_insert(struct wavl_node *node,
+	    struct wavl_root *wavl,
+	    int (*compare_link)(const struct wavl_node *node1,
+				const struct wavl_node *node2,
+				const void *arg),
+	    const void *arg)
+{
+	(void)__BSTLINK_INSERT(node, &wavl->node, compare_link, arg, false);
+	__wavl_insert_rest(node, wavl);
+}
+
+static inline bool
+wavl_insert_unique(struct wavl_node *node,
+		   struct wavl_root *wavl,
+		   int (*compare_link)(const struct wavl_node *node1,
+				       const struct wavl_node *node2,
+				       const void *arg),
+		   const void *arg)
+{
+	if (__BSTLINK_INSERT(node, &wavl->node, compare_link, arg, true)) {
+		__wavl_insert_rest(node, wavl);
+		return true;
+	}
+
+	return false;
+}
+
+/*
+ * wavl_insert_hint  --  wavl_insert searching from 'hint'
+ *
+ * 'hint' is a node of 'wavl' near the new one, typically the last node
+ * inserted, or NULL, see bstlink_insert_hint.
+ */
+static inline void
+wavl_insert_hint(struct wavl_node *node,
+		 struct wavl_node *hint,
+		 struct wavl_root *wavl,
+		 int (*compare_link)(const struct wavl_node *node1,
+				     const struct wavl_node *node2,
+				     const void *arg),
+		 const void *arg)
+{
+	__BSTLINK_INSERT_HINT(node, hint, &wavl->node, compare_link, arg);
+	__wavl_insert_rest(node, wavl);
+}
+
+/* comparator-inlined cores, see the example at the top of this file */
+#define WAVL_GENERATE(name, type, member, cmp)				\
+	__BSTLINK_GENERATE(name, struct wavl_root, struct wavl_node,	\
+			   type, member, cmp,				\
+			   __BSTLINK_NOP, __wavl_insert_rest)
+
+static inline void
+wavl_replace(struct wavl_node *victim,
+	     struct wavl_node *new,
+	     struct wavl_root *wavl)
+{
+	__BSTLINK_REPLACE(victim, new, &wavl->node);
+	wavl_set_parity(new, __wavl_parity(victim));
+}
+
+static inline void wavl_erase_range(struct wavl_node *beg,
+				    struct wavl_node *end,
+				    struct wavl_root *wavl)
+{
+	__BSTLINK_ERASE_RANGE(beg, end, wavl_erase, wavl);
+}
+
+static inline void
+wavl_erase_equal(struct wavl_root *wavl,
+		 int (*compare)(const struct wavl_node *node,
+				const void *arg),
+		 void (*destroy)(struct wavl_node *node, const void *arg),
+		 const void *arg_compare,
+		 const void *arg_destroy)
+{
+	__BSTLINK_ERASE_EQUAL(wavl->node, compare, wavl_erase, destroy,
+			      arg_compare, wavl, arg_destroy);
+}
+
+static inline size_t
+wavl_count(const struct wavl_root *wavl,
+	   int (*compare)(const struct wavl_node *node,
+			  const void *arg),
+	   const void *arg)
+{
+	return __BSTLINK_COUNT(wavl->node, compare, arg);
+}
+
+#ifdef	BSTLINK_SIZE
+/* wavl_select, wavl_rank  --  order statistics, see avl_select */
+static inline struct wavl_node *
+wavl_select(const struct wavl_root *wavl, size_t k)
+{
+	return __BSTLINK_SELECT(wavl->node, k, struct wavl_node);
+}
+
+static inline size_t wavl_rank(const struct wavl_node *node)
+{
+	return __BSTLINK_RANK(node);
+}
+#endif
+
+static inline void
+wavl_clear(struct wavl_root *wavl,
+	   void (*destroy)(struct wavl_node *node, const void *arg),
+	   const void *arg)
+{
+	__BSTLINK_DESTROY(wavl->node, destroy, arg);
+	wavl->node = NULL;
+}
+
+static inline void
+wavl_visit(const struct wavl_root *wavl,
+	   void (*visit)(const struct wavl_node *node, const void *arg),
+	   const void *arg)
+{
+	__BSTLINK_VISIT(wavl->node, visit, arg);
+}
+
+static inline bool
+wavl_visit_cond(const struct wavl_root *wavl,
+		bool (*visit_cond)(const struct wavl_node *node,
+				   const void *arg),
+		const void *arg)
+{
+	return __BSTLINK_VISIT_COND(wavl->node, visit_cond, arg);
+}
+
+static inline size_t
+wavl_height(struct wavl_root *wavl, bool bmax)
+{
+	return __BSTLINK_HEIGHT(wavl->node, bmax);
+}
+#define wavl_height_max(wavl)	wavl_height(wavl, true)
+#define wavl_height_min(wavl)	wavl_height(wavl, false)
+
+/* valid check */
+#ifndef NDEBUG
+bool wavl_isvalid(struct wavl_root *wavl);
+#else
+static inline bool wavl_isvalid(struct wavl_root *wavl)
+{
+	return true;
+}
+#endif
+
+__END_DECLS
+
+#endif /* __YC_ALGOS_WAVLTREE_H_ */
@@ -0,0 +1,164 @@
+/*
+ * epoch.h -- epoch based memory reclamation
+ *
+ * Copyright (C) 2012-2013 yanyg (cppgp@qq.com)
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING, if not see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Lock-free containers unlink an object while other threads may still
+ * be reading it.  The readers run between epoch_enter and epoch_exit,
+ * the writer hands the unlinked object to epoch_retire, and it is freed
+ * once every reader that might have seen it has left: the global epoch
+ * advances only when all the active threads have observed it, and an
+ * object retired in epoch e is freed on the advance to e + 2.  See
+ * Fraser, "Practical lock-freedom".
+ *
+ * Example as follows
+ */
+
+#if 0
+	struct epoch_domain domain;
+	struct epoch_thread *thr;
+
+	epoch_init(&domain);
+	...
+	/* in each thread */
+	thr = epoch_register(&domain);
+	epoch_enter(thr);
+	item = lookup(...);
+	if (unlink(item))
+		epoch_retire(&domain, &item->entry, item_free);
+	epoch_exit(thr);
+	...
+	epoch_unregister(thr);
+	...
+	epoch_destroy(&domain);
+#endif
+
+#ifndef __YCC_EPOCH_H_
+#define __YCC_EPOCH_H_
+
+#include <stdbool.h>
+
+#include <ycc/compiler.h>
+
+__BEGIN_DECLS
+
+/* epoch_exit tries to advance the epoch once per EPOCH_INTERVAL exits */
+#ifndef EPOCH_INTERVAL
+#define EPOCH_INTERVAL	64
+#endif
+
+struct epoch_entry
+{
+	struct epoch_entry *next;
+	void (*free)(struct epoch_entry *entry);
+};
+
+struct epoch_thread
+{
+	struct epoch_thread *next;
+	struct epoch_domain *domain;
+	unsigned long epoch;	/* local epoch << 1 | active */
+	unsigned long count;
+	bool used;
+} __aligned(64);
+
+struct epoch_domain
+{
+	unsigned long epoch;
+	struct epoch_thread *threads;
+	struct epoch_entry *limbo[3];
+};
+
+void epoch_init(struct epoch_domain *domain);
+
+/*
+ * epoch_destroy  --  free all the retired objects
+ *
+ * Description
+ *	No thread may use 'domain' any more, the thread records are
+ *	freed too.
+ */
+void epoch_destroy(struct epoch_domain *domain);
+
+/*
+ * epoch_register, epoch_unregister  --  get or put a thread record
+ *
+ * Description
+ *	A thread record is used by one thread at a time, the records put
+ *	back are reused by later registers.
+ *
+ * Return value
+ *	epoch_register returns NULL and sets errno to ENOMEM on failure.
+ */
+struct epoch_thread *epoch_register(struct epoch_domain *domain);
+void epoch_unregister(struct epoch_thread *thr);
+
+/*
+ * epoch_enter, epoch_exit  --  read side critical section
+ *
+ * Description
+ *	The objects reached between them are not freed before epoch_exit.
+ *	They do not nest.
+ */
+static inline void epoch_enter(struct epoch_thread *thr)
+{
+	unsigned long epoch = __atomic_load_n(&thr->domain->epoch,
+					      __ATOMIC_RELAXED);
+
+	/* the store MUST be visible before any read of the section */
+	__atomic_store_n(&thr->epoch, epoch << 1 | 1, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
+
+bool __epoch_advance(struct epoch_thread *thr);
+static inline void epoch_exit(struct epoch_thread *thr)
+{
+	if (!(++thr->count % EPOCH_INTERVAL))
+		(void)__epoch_advance(thr);
+
+	__atomic_store_n(&thr->epoch, thr->epoch & ~1ul, __ATOMIC_RELEASE);
+}
+
+/*
+ * epoch_retire  --  free 'entry' after the readers left
+ *
+ * Description
+ *	'entry' MUST be unreachable for the threads entering from now,
+ *	'free' is called in a later epoch_exit, epoch_reclaim or
+ *	epoch_destroy of any thread.
+ */
+void epoch_retire(struct epoch_domain *domain,
+		  struct epoch_entry *entry,
+		  void (*free)(struct epoch_entry *entry));
+
+/*
+ * epoch_reclaim  --  try to advance the epoch now
+ *
+ * Description
+ *	Called outside of a critical section.  Two successful calls in a
+ *	row free everything retired before the first one.
+ *
+ * Return value
+ *	true if the epoch advanced, false if an active thread lags.
+ */
+bool epoch_reclaim(struct epoch_thread *thr);
+
+__END_DECLS
+
+#endif /* __YCC_EPOCH_H_ */
@@ -0,0 +1,162 @@
+/*
+ * epoch.c -- epoch based memory reclamation
+ *
+ * Copyright (C) 2012-2013 yanyg (cppgp@qq.com)
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; see the file COPYING, if not see
+ * <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * The retired objects go to one of three lock-free lists, indexed by
+ * the epoch read after unlinking them.  The thread that advances the
+ * epoch from e to e + 1 takes the list of e - 1: every thread active
+ * now has observed e, so none entered before those objects were
+ * unlinked.  The advancer is active in e itself, the epoch can not
+ * reach e + 2 and refill that list before it is taken.
+ */
+
+#include <errno.h>
+#include <stdlib.h>
+
+#include <ycc/epoch.h>
+
+void epoch_init(struct epoch_domain *domain)
+{
+	domain->epoch = 0;
+	domain->threads = NULL;
+	domain->limbo[0] = domain->limbo[1] = domain->limbo[2] = NULL;
+}
+
+static void __epoch_free(struct epoch_entry *entry)
+{
+	struct epoch_entry *next;
+
+	for (; entry; entry = next) {
+		next = entry->next;
+		entry->free(entry);
+	}
+}
+
+void epoch_destroy(struct epoch_domain *domain)
+{
+	int i;
+	struct epoch_thread *thr, *next;
+
+	for (i = 0; i < 3; ++i) {
+		__epoch_free(domain->limbo[i]);
+		domain->limbo[i] = NULL;
+	}
+
+	for (thr = domain->threads; thr; thr = next) {
+		next = thr->next;
+		free(thr);
+	}
+	domain->threads = NULL;
+}
+
+struct epoch_thread *epoch_register(struct epoch_domain *domain)
+{
+	struct epoch_thread *thr;
+
+	for (thr = __atomic_load_n(&domain->threads, __ATOMIC_ACQUIRE);
+	     thr; thr = thr->next) {
+		if (!__atomic_exchange_n(&thr->used, true, __ATOMIC_ACQUIRE))
+			return thr;
+	}
+
+	/* the records are only freed by epoch_destroy */
+	if (posix_memalign((void**)&thr, sizeof(*thr), sizeof(*thr))) {
+		errno = ENOMEM;
+		return NULL;
+	}
+
+	thr->domain = domain;
+	thr->epoch = 0;
+	thr->count = 0;
+	thr->used = true;
+	thr->next = __atomic_load_n(&domain->threads, __ATOMIC_RELAXED);
+	while (!__atomic_compare_exchange_n(&domain->threads, &thr->next, thr,
+					    true, __ATOMIC_RELEASE,
+					    __ATOMIC_RELAXED))
+		;
+
+	return thr;
+}
+
+void epoch_unregister(struct epoch_thread *thr)
+{
+	__atomic_store_n(&thr->epoch, 0, __ATOMIC_RELAXED);
+	__atomic_store_n(&thr->used, false, __ATOMIC_RELEASE);
+}
+
+void epoch_retire(struct epoch_domain *domain,
+		  struct epoch_entry *entry,
+		  void (*free)(struct epoch_entry *entry))
+{
+	/* read after the unlink, see the top of this file */
+	unsigned long epoch = __atomic_load_n(&domain->epoch,
+					      __ATOMIC_SEQ_CST);
+	struct epoch_entry **plist = &domain->limbo[epoch % 3];
+
+	entry->free = free;
+	entry->next = __atomic_load_n(plist, __ATOMIC_RELAXED);
+	while (!__atomic_compare_exchange_n(plist, &entry->next, entry,
+					    true, __ATOMIC_RELEASE,
+					    __ATOMIC_RELAXED))
+		;
+}
+
+/* called in a critical section */
+bool __epoch_advance(struct epoch_thread *thr)
+{
+	struct epoch_domain *domain = thr->domain;
+	unsigned long epoch = __atomic_load_n(&domain->epoch,
+					      __ATOMIC_SEQ_CST);
+	struct epoch_thread *p;
+
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	for (p = __atomic_load_n(&domain->threads, __ATOMIC_ACQUIRE);
+	     p; p = p->next) {
+		unsigned long local = __atomic_load_n(&p->epoch,
+						      __ATOMIC_RELAXED);
+
+		if ((local & 1) && (local >> 1) != epoch)
+			return false;
+	}
+	__atomic_thread_fence(__ATOMIC_ACQUIRE);
+
+	if (!__atomic_compare_exchange_n(&domain->epoch, &epoch, epoch + 1,
+					 false, __ATOMIC_SEQ_CST,
+					 __ATOMIC_RELAXED))
+		return false;
+
+	__epoch_free(__atomic_exchange_n(&domain->limbo[(epoch + 2) % 3],
+					 NULL, __ATOMIC_ACQUIRE));
+
+	return true;
+}
+
+bool epoch_reclaim(struct epoch_thread *thr)
+{
+	bool advanced;
+
+	epoch_enter(thr);
+	advanced = __epoch_advance(thr);
+	epoch_exit(thr);
+
+	return advanced;
+}
+
+/* eof */
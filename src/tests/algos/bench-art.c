@@ -0,0 +1,154 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <ycc/algos/art.h>
+#include <ycc/algos/bptree.h>
+#include <ycc/algos/rbtree-key.h>
+#include <ycc/algos/rbtree-str.h>
+
+#ifndef SIZE
+#define SIZE (1024*1024)
+#endif
+
+struct item {
+	struct rb_u64_node knode;
+	struct rb_str_node snode;
+	struct art_leaf leaf;
+	unsigned char key[8];
+	char *name;
+};
+
+static struct item items[SIZE];
+static int lookups[SIZE];
+
+static double now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static uint64_t rand64(void)
+{
+	return (uint64_t)rand() << 42 ^ (uint64_t)rand() << 21 ^ rand();
+}
+
+/* dense keys are 0 to SIZE - 1 in random order, sparse ones random */
+static void run_u64(const char *name, bool dense)
+{
+	struct rb_root rb = { NULL, };
+	unsigned char key[8];
+	ART_DECLARE(art);
+	BPT_DECLARE(bpt);
+	struct bpt_iter iter;
+	size_t found = 0;
+	double t[4];
+	uint64_t tmp;
+	int i, j;
+
+	for (i = 0; i < SIZE; ++i) {
+		items[i].knode.key = dense ? (uint64_t)i : rand64();
+		lookups[i] = rand() % SIZE;
+	}
+	for (i = SIZE - 1; dense && i > 0; --i) {
+		j = rand() % (i + 1);
+		tmp = items[i].knode.key;
+		items[i].knode.key = items[j].knode.key;
+		items[j].knode.key = tmp;
+	}
+	for (i = 0; i < SIZE; ++i) {
+		struct item *p = &items[i];
+
+		if (!rb_u64_insert_unique(&rb, &p->knode))
+			continue;
+		bpt_insert(&bpt, p->knode.key, p);
+		art_leaf_init(&p->leaf, art_key_u64(p->key, p->knode.key), 8);
+		art_insert(&art, &p->leaf);
+	}
+
+	t[0] = now();
+	for (i = 0; i < SIZE; ++i)
+		found += !!rb_u64_find(&rb, items[lookups[i]].knode.key);
+	t[1] = now();
+	for (i = 0; i < SIZE; ++i)
+		found += bpt_find(&bpt, items[lookups[i]].knode.key, &iter);
+	t[2] = now();
+	for (i = 0; i < SIZE; ++i)
+		found += !!art_find(&art, art_key_u64(key,
+					items[lookups[i]].knode.key), 8);
+	t[3] = now();
+
+	printf("%-22s %8.1f %8.1f %8.1f\n", name,
+	       (t[1] - t[0]) * 1e9 / SIZE, (t[2] - t[1]) * 1e9 / SIZE,
+	       (t[3] - t[2]) * 1e9 / SIZE);
+
+	if (found != 3 * (size_t)SIZE)
+		printf("error: %zu found\n", found);
+	bpt_clear(&bpt, NULL, NULL);
+	art_clear(&art, NULL, NULL);
+}
+
+static void run_str(const char *fmt)
+{
+	struct rb_root rbs = { NULL, };
+	ART_DECLARE(art);
+	size_t found = 0;
+	double t[3];
+	char buf[64];
+	int i;
+
+	for (i = 0; i < SIZE; ++i) {
+		struct item *p = &items[i];
+		size_t len;
+
+		snprintf(buf, sizeof(buf), fmt, rand());
+		len = strlen(buf);
+		p->name = strdup(buf);
+		rb_str_node_init(&p->snode, p->name, len);
+		art_leaf_init(&p->leaf, p->name, len);
+		if (rb_str_insert_unique(&rbs, &p->snode))
+			art_insert(&art, &p->leaf);
+		lookups[i] = rand() % SIZE;
+	}
+
+	t[0] = now();
+	for (i = 0; i < SIZE; ++i) {
+		const char *name = items[lookups[i]].name;
+
+		found += !!rb_str_find(&rbs, name, strlen(name));
+	}
+	t[1] = now();
+	for (i = 0; i < SIZE; ++i) {
+		const char *name = items[lookups[i]].name;
+
+		found += !!art_find(&art, name, strlen(name));
+	}
+	t[2] = now();
+
+	printf("%-22s %8.1f %17.1f\n", fmt, (t[1] - t[0]) * 1e9 / SIZE,
+	       (t[2] - t[1]) * 1e9 / SIZE);
+
+	art_clear(&art, NULL, NULL);
+	for (i = 0; i < SIZE; ++i)
+		free(items[i].name);
+	if (found != 2 * (size_t)SIZE)
+		printf("error: %zu found\n", found);
+}
+
+int main()
+{
+	srand( (unsigned int)time(NULL) );
+
+	printf("find of %d keys, ns/op\n", SIZE);
+	printf("keys                   rb/inline   bptree      art\n");
+	run_u64("u64 dense", true);
+	run_u64("u64 sparse", false);
+	run_str("%x.example.com");
+	run_str("user:%010d");
+	run_str("/usr/share/doc/%x");
+
+	return 0;
+}
@@ -0,0 +1,91 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <ycc/algos/rbtree.h>
+
+#ifndef SIZE
+#define SIZE (1024*1024*8)
+#endif
+
+#ifndef BATCH
+#define BATCH 256
+#endif
+
+struct node {
+	int val;
+	struct rb_node rb_node;
+};
+
+static int compare(const struct rb_node *rb_node, const void *arg)
+{
+	struct node *p = rb_entry(rb_node, struct node, rb_node);
+
+	return p->val < *(int*)arg ? -1 : p->val > *(int*)arg;
+}
+
+static int compare_link(const struct rb_node *rb_node1,
+			const struct rb_node *rb_node2,
+			const void *arg)
+{
+	return compare(rb_node1,
+		       &rb_entry(rb_node2, struct node, rb_node)->val);
+}
+
+static double now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int main()
+{
+	int i, j;
+	size_t found;
+	double t;
+	struct node *nodes;
+	int *keys;
+	const void *args[BATCH];
+	struct rb_node *results[BATCH];
+
+	RB_DECLARE(rb);
+
+	nodes = malloc(sizeof(*nodes) * SIZE);
+	keys = malloc(sizeof(*keys) * SIZE);
+	if (!nodes || !keys)
+		return 1;
+
+	srand( (unsigned int)time(NULL) );
+	for (i = 0; i < SIZE; ++i) {
+		nodes[i].val = rand();
+		rb_insert(&nodes[i].rb_node, &rb, compare_link, NULL);
+	}
+	for (i = 0; i < SIZE; ++i)
+		keys[i] = nodes[rand() % SIZE].val;
+
+	found = 0;
+	t = now();
+	for (i = 0; i < SIZE; ++i)
+		found += !!rb_find(&rb, compare, &keys[i]);
+	printf("rb_find loop    : %6.1f ns/op (%zu)\n",
+	       (now() - t) * 1e9 / SIZE, found);
+
+	found = 0;
+	t = now();
+	for (i = 0; i + BATCH <= SIZE; i += BATCH) {
+		for (j = 0; j < BATCH; ++j)
+			args[j] = &keys[i + j];
+		rb_find_batch(&rb, compare, args, BATCH, results);
+		for (j = 0; j < BATCH; ++j)
+			found += !!results[j];
+	}
+	printf("rb_find_batch %d: %6.1f ns/op (%zu)\n", BATCH,
+	       (now() - t) * 1e9 / i, found);
+
+	free(keys);
+	free(nodes);
+
+	return 0;
+}
@@ -0,0 +1,101 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <ycc/algos/rbtree.h>
+#include <ycc/algos/bptree.h>
+
+#ifndef SIZE
+#define SIZE (1024*1024*4)
+#endif
+
+struct node {
+	unsigned long key;
+	struct rb_node rb_node;
+};
+
+static inline int node_cmp(const struct node *p1, const struct node *p2)
+{
+	return p1->key < p2->key ? -1 : p1->key > p2->key;
+}
+
+RB_GENERATE(node_tree, struct node, rb_node, node_cmp)
+
+static double now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int main()
+{
+	int i;
+	size_t found, sum;
+	double t;
+	struct node *nodes, key;
+	struct rb_node *rb_node;
+	struct bpt_iter iter;
+
+	RB_DECLARE(rb);
+	BPT_DECLARE(bpt);
+
+	nodes = malloc(sizeof(*nodes) * SIZE);
+	if (!nodes)
+		return 1;
+
+	srand( (unsigned int)time(NULL) );
+	for (i = 0; i < SIZE; ++i)
+		nodes[i].key = rand();
+
+	printf("bpt: %zu keys per leaf, %zu per inner node\n",
+	       (size_t)BPT_LEAF_ORDER, (size_t)BPT_INNER_ORDER);
+
+	t = now();
+	for (i = 0; i < SIZE; ++i)
+		node_tree_insert(&rb, &nodes[i]);
+	printf("rb  insert: %6.1f ns/op\n", (now() - t) * 1e9 / SIZE);
+
+	t = now();
+	for (i = 0; i < SIZE; ++i) {
+		if (bpt_insert(&bpt, nodes[i].key, &nodes[i]))
+			return 1;
+	}
+	printf("bpt insert: %6.1f ns/op\n", (now() - t) * 1e9 / SIZE);
+
+	found = 0;
+	t = now();
+	for (i = 0; i < SIZE; ++i) {
+		key.key = nodes[SIZE - 1 - i].key;
+		found += !!node_tree_find(&rb, &key);
+	}
+	printf("rb  find  : %6.1f ns/op (%zu)\n",
+	       (now() - t) * 1e9 / SIZE, found);
+
+	found = 0;
+	t = now();
+	for (i = 0; i < SIZE; ++i)
+		found += bpt_find(&bpt, nodes[SIZE - 1 - i].key, &iter);
+	printf("bpt find  : %6.1f ns/op (%zu)\n",
+	       (now() - t) * 1e9 / SIZE, found);
+
+	sum = 0;
+	t = now();
+	for (rb_node = rb_first(&rb); rb_node; rb_node = rb_next(rb_node))
+		sum += rb_entry(rb_node, struct node, rb_node)->key;
+	printf("rb  scan  : %6.1f ns/key (%zu)\n",
+	       (now() - t) * 1e9 / SIZE, sum);
+
+	sum = 0;
+	t = now();
+	for (bpt_first(&bpt, &iter); !bpt_iter_end(&iter); bpt_next(&iter))
+		sum += bpt_iter_key(&iter);
+	printf("bpt scan  : %6.1f ns/key (%zu)\n",
+	       (now() - t) * 1e9 / SIZE, sum);
+
+	bpt_clear(&bpt, NULL, NULL);
+	free(nodes);
+
+	return 0;
+}
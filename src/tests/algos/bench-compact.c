@@ -0,0 +1,117 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <ycc/algos/rbtree.h>
+#include <ycc/algos/avltree.h>
+
+#ifndef SIZE
+#define SIZE (1024*1024*4)
+#endif
+
+struct rb_entry {
+	int val;
+	struct rb_node node;
+};
+
+struct avl_entry {
+	int val;
+	struct avl_node node;
+};
+
+static inline int rb_entry_cmp(const struct rb_entry *p1,
+			       const struct rb_entry *p2)
+{
+	return p1->val < p2->val ? -1 : p1->val > p2->val;
+}
+
+static inline int avl_entry_cmp(const struct avl_entry *p1,
+				const struct avl_entry *p2)
+{
+	return p1->val < p2->val ? -1 : p1->val > p2->val;
+}
+
+RB_GENERATE(rb_tree, struct rb_entry, node, rb_entry_cmp)
+AVL_GENERATE(avl_tree, struct avl_entry, node, avl_entry_cmp)
+
+static double now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* one bench per tree, 'name' is the prefix of the tree routines */
+#define DEFINE_BENCH(name)						\
+static int name##_bench(const int *keys)				\
+{									\
+	int i;								\
+	size_t found = 0;						\
+	double t;							\
+	struct name##_entry *nodes, key;				\
+	struct name##_root root = { NULL };				\
+									\
+	nodes = malloc(sizeof(*nodes) * SIZE);				\
+	if (!nodes)							\
+		return 1;						\
+	for (i = 0; i < SIZE; ++i)					\
+		nodes[i].val = keys[i];					\
+									\
+	t = now();							\
+	for (i = 0; i < SIZE; ++i)					\
+		name##_tree_insert(&root, &nodes[i]);			\
+	printf(#name " insert: %6.1f ns/op\n", (now() - t) * 1e9 / SIZE); \
+									\
+	t = now();							\
+	for (i = 0; i < SIZE; ++i) {					\
+		key.val = keys[SIZE - 1 - i];				\
+		found += !!name##_tree_find(&root, &key);		\
+	}								\
+	printf(#name " find  : %6.1f ns/op (%zu)\n",			\
+	       (now() - t) * 1e9 / SIZE, found);			\
+									\
+	if (!name##_isvalid(&root)) {					\
+		printf(#name "_isvalid failed !\n");			\
+		return 1;						\
+	}								\
+									\
+	t = now();							\
+	for (i = 0; i < SIZE; ++i)					\
+		name##_erase(&nodes[i].node, &root);			\
+	printf(#name " erase : %6.1f ns/op\n", (now() - t) * 1e9 / SIZE); \
+									\
+	free(nodes);							\
+	return root.node != NULL;					\
+}
+
+DEFINE_BENCH(rb)
+DEFINE_BENCH(avl)
+
+int main()
+{
+	int i, *keys;
+
+#ifdef	BSTLINK_COMPACT
+	printf("compact links\n");
+#else
+	printf("plain links\n");
+#endif
+	printf("sizeof(struct rb_node) = %zu, sizeof(struct avl_node) = %zu\n",
+	       sizeof(struct rb_node), sizeof(struct avl_node));
+
+	keys = malloc(sizeof(*keys) * SIZE);
+	if (!keys)
+		return 1;
+
+	srand( (unsigned int)time(NULL) );
+	for (i = 0; i < SIZE; ++i)
+		keys[i] = rand();
+
+	if (rb_bench(keys) || avl_bench(keys))
+		return 1;
+
+	free(keys);
+
+	return 0;
+}
@@ -0,0 +1,109 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <ycc/algos/rbtree.h>
+
+#ifndef SIZE
+#define SIZE (1024*1024*4)
+#endif
+
+struct node {
+	int val;
+	struct rb_node rb_node;
+};
+
+static inline int node_cmp(const struct node *p1, const struct node *p2)
+{
+	return p1->val < p2->val ? -1 : p1->val > p2->val;
+}
+
+RB_GENERATE(node_tree, struct node, rb_node, node_cmp)
+
+static int compare(const struct rb_node *rb_node, const void *arg)
+{
+	struct node *p = rb_entry(rb_node, struct node, rb_node);
+
+	return node_cmp(p, (const struct node*)arg);
+}
+
+static int compare_link(const struct rb_node *rb_node1,
+			const struct rb_node *rb_node2,
+			const void *arg)
+{
+	struct node *p1 = rb_entry(rb_node1, struct node, rb_node);
+	struct node *p2 = rb_entry(rb_node2, struct node, rb_node);
+
+	return node_cmp(p1, p2);
+}
+
+static double now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int main()
+{
+	int i;
+	size_t found;
+	double t;
+	struct node *nodes1, *nodes2, key;
+	int *keys;
+
+	RB_DECLARE(rb1);
+	RB_DECLARE(rb2);
+
+	nodes1 = malloc(sizeof(*nodes1) * SIZE);
+	nodes2 = malloc(sizeof(*nodes2) * SIZE);
+	keys = malloc(sizeof(*keys) * SIZE);
+	if (!nodes1 || !nodes2 || !keys)
+		return 1;
+
+	srand( (unsigned int)time(NULL) );
+	for (i = 0; i < SIZE; ++i) {
+		keys[i] = rand();
+		nodes1[i].val = nodes2[i].val = keys[i];
+	}
+
+	t = now();
+	for (i = 0; i < SIZE; ++i)
+		rb_insert(&nodes1[i].rb_node, &rb1, compare_link, NULL);
+	printf("insert callback : %6.1f ns/op\n", (now() - t) * 1e9 / SIZE);
+
+	t = now();
+	for (i = 0; i < SIZE; ++i)
+		node_tree_insert(&rb2, &nodes2[i]);
+	printf("insert generated: %6.1f ns/op\n", (now() - t) * 1e9 / SIZE);
+
+	found = 0;
+	t = now();
+	for (i = 0; i < SIZE; ++i) {
+		key.val = keys[SIZE - 1 - i];
+		found += !!rb_find(&rb1, compare, &key);
+	}
+	printf("find callback   : %6.1f ns/op (%zu)\n",
+	       (now() - t) * 1e9 / SIZE, found);
+
+	found = 0;
+	t = now();
+	for (i = 0; i < SIZE; ++i) {
+		key.val = keys[SIZE - 1 - i];
+		found += !!node_tree_find(&rb2, &key);
+	}
+	printf("find generated  : %6.1f ns/op (%zu)\n",
+	       (now() - t) * 1e9 / SIZE, found);
+
+	if (!rb_isvalid(&rb2)) {
+		printf("rb_isvalid failed !\n");
+		return 1;
+	}
+
+	free(keys);
+	free(nodes2);
+	free(nodes1);
+
+	return 0;
+}
@@ -0,0 +1,138 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <ycc/algos/avltree-key.h>
+#include <ycc/algos/rbtree-key.h>
+
+#ifndef SIZE
+#define SIZE (1024*1024)
+#endif
+
+/* the usual intrusive entries: the key, a payload, then the links */
+struct rb_item {
+	uint64_t key;
+	char value[48];
+	struct rb_node node;
+};
+
+struct avl_item {
+	uint64_t key;
+	char value[48];
+	struct avl_node node;
+};
+
+/* the key next to the links */
+struct rb_kitem {
+	struct rb_u64_node knode;
+	char value[48];
+};
+
+struct avl_kitem {
+	struct avl_u64_node knode;
+	char value[48];
+};
+
+#define ITEM_CMP(type)							\
+static inline int type##_cmp(const struct type *a, const struct type *b)\
+{									\
+	return a->key < b->key ? -1 : a->key > b->key;			\
+}
+
+ITEM_CMP(rb_item)
+ITEM_CMP(avl_item)
+RB_GENERATE(rb_item_tree, struct rb_item, node, rb_item_cmp)
+AVL_GENERATE(avl_item_tree, struct avl_item, node, avl_item_cmp)
+
+static int rb_compare(const struct rb_node *node, const void *arg)
+{
+	return rb_item_cmp(rb_entry(node, struct rb_item, node), arg);
+}
+
+static int avl_compare(const struct avl_node *node, const void *arg)
+{
+	return avl_item_cmp(avl_entry(node, struct avl_item, node), arg);
+}
+
+static struct rb_item rb_items[SIZE];
+static struct avl_item avl_items[SIZE];
+static struct rb_kitem rb_kitems[SIZE];
+static struct avl_kitem avl_kitems[SIZE];
+static uint64_t keys[SIZE];
+
+static double now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static uint64_t rand64(void)
+{
+	return (uint64_t)rand() << 33 ^ (uint64_t)rand() << 11 ^ rand();
+}
+
+/* 'num' lookups of 'k' among the keys linked, ns/op */
+#define BENCH_FIND(found)						\
+({									\
+	double __t = now();						\
+	int __i;							\
+									\
+	for (__i = 0; __i < num; ++__i) {				\
+		uint64_t k = keys[lookups[__i]];			\
+									\
+		n += !!(found);						\
+	}								\
+	(now() - __t) * 1e9 / num;					\
+})
+
+int main()
+{
+	static int lookups[SIZE];
+	struct rb_root rb = { NULL, }, rbk = { NULL, };
+	struct avl_root avl = { NULL, }, avlk = { NULL, };
+	struct rb_item rkey;
+	struct avl_item akey;
+	int size, i, num = SIZE;
+	size_t n = 0;
+
+	srand( (unsigned int)time(NULL) );
+	for (i = 0; i < SIZE; ++i)
+		keys[i] = rand64();
+
+	printf("find of random u64 keys, ns/op\n");
+	printf("nodes     tree  callback  generated  inline key\n");
+	for (size = 16 * 1024; size <= SIZE; size *= 8) {
+		rb.node = rbk.node = NULL;
+		avl.node = avlk.node = NULL;
+		for (i = 0; i < size; ++i) {
+			rb_items[i].key = avl_items[i].key = keys[i];
+			rb_kitems[i].knode.key = keys[i];
+			avl_kitems[i].knode.key = keys[i];
+			rb_item_tree_insert(&rb, &rb_items[i]);
+			avl_item_tree_insert(&avl, &avl_items[i]);
+			rb_u64_insert(&rbk, &rb_kitems[i].knode);
+			avl_u64_insert(&avlk, &avl_kitems[i].knode);
+		}
+		for (i = 0; i < num; ++i)
+			lookups[i] = rand() % size;
+
+		printf("%7d   rb   %8.1f   %8.1f    %8.1f\n", size,
+		       BENCH_FIND((rkey.key = k,
+				   rb_find(&rb, rb_compare, &rkey))),
+		       BENCH_FIND((rkey.key = k,
+				   rb_item_tree_find(&rb, &rkey))),
+		       BENCH_FIND(rb_u64_find(&rbk, k)));
+		printf("%7d   avl  %8.1f   %8.1f    %8.1f\n", size,
+		       BENCH_FIND((akey.key = k,
+				   avl_find(&avl, avl_compare, &akey))),
+		       BENCH_FIND((akey.key = k,
+				   avl_item_tree_find(&avl, &akey))),
+		       BENCH_FIND(avl_u64_find(&avlk, k)));
+	}
+
+	/* every key looked up is there */
+	return n % num != 0;
+}
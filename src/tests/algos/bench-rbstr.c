@@ -0,0 +1,99 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <ycc/algos/rbtree-str.h>
+
+#ifndef SIZE
+#define SIZE (1024*1024)
+#endif
+
+/* the usual entry, the key is a string of its own */
+struct item {
+	char *name;
+	struct rb_node node;
+};
+
+struct sitem {
+	struct rb_str_node snode;
+	char *name;
+};
+
+static int compare(const struct rb_node *node, const void *arg)
+{
+	return strcmp(rb_entry(node, struct item, node)->name, arg);
+}
+
+static int compare_link(const struct rb_node *node1,
+			const struct rb_node *node2,
+			const void *arg)
+{
+	return strcmp(rb_entry(node1, struct item, node)->name,
+		      rb_entry(node2, struct item, node)->name);
+}
+
+static struct item items[SIZE];
+static struct sitem sitems[SIZE];
+static char *names[SIZE];
+static int lookups[SIZE];
+
+static double now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* 'fmt' takes one random number, a long fixed head ties the prefixes */
+static void run(const char *fmt)
+{
+	struct rb_root rb = { NULL, }, rbs = { NULL, };
+	size_t found = 0;
+	double t[3];
+	char buf[64];
+	int i;
+
+	for (i = 0; i < SIZE; ++i) {
+		snprintf(buf, sizeof(buf), fmt, rand());
+		names[i] = strdup(buf);
+		items[i].name = sitems[i].name = names[i];
+		rb_str_node_init(&sitems[i].snode, names[i], strlen(names[i]));
+		rb_insert(&items[i].node, &rb, compare_link, NULL);
+		rb_str_insert(&rbs, &sitems[i].snode);
+		lookups[i] = rand() % SIZE;
+	}
+
+	t[0] = now();
+	for (i = 0; i < SIZE; ++i)
+		found += !!rb_find(&rb, compare, names[lookups[i]]);
+	t[1] = now();
+	for (i = 0; i < SIZE; ++i) {
+		const char *name = names[lookups[i]];
+
+		found += !!rb_str_find(&rbs, name, strlen(name));
+	}
+	t[2] = now();
+
+	printf("%-22s %8.1f %8.1f\n", fmt, (t[1] - t[0]) * 1e9 / SIZE,
+	       (t[2] - t[1]) * 1e9 / SIZE);
+
+	for (i = 0; i < SIZE; ++i)
+		free(names[i]);
+	if (found != 2 * (size_t)SIZE)
+		printf("error: %zu found\n", found);
+}
+
+int main()
+{
+	srand( (unsigned int)time(NULL) );
+
+	printf("find of %d string keys, ns/op\n", SIZE);
+	printf("keys                   strcmp   rb_str\n");
+	run("%x.example.com");
+	run("user:%010d");
+	run("/usr/share/doc/%x");
+
+	return 0;
+}
@@ -0,0 +1,198 @@
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <ycc/algos/rbtree.h>
+#include <ycc/algos/skiplist.h>
+
+#ifndef SIZE
+#define SIZE (1024*1024)
+#endif
+
+#ifndef OPS
+#define OPS (256*1024)
+#endif
+
+/* percent of the operations which insert, the same again erase */
+#ifndef UPDATE
+#define UPDATE 5
+#endif
+
+#define MAX_THREADS 32
+
+struct node {
+	int val;
+	struct rb_node rb_node;
+	struct skl_node skl_node;
+};
+
+static struct rb_root rb;
+static pthread_mutex_t rb_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct epoch_domain domain;
+static struct skl_root skl;
+
+static int rb_compare(const struct rb_node *rb_node, const void *arg)
+{
+	struct node *p = rb_entry(rb_node, struct node, rb_node);
+
+	return p->val < *(int*)arg ? -1 : p->val > *(int*)arg;
+}
+
+static int rb_compare_link(const struct rb_node *rb_node1,
+			   const struct rb_node *rb_node2,
+			   const void *arg)
+{
+	return rb_compare(rb_node1,
+			  &rb_entry(rb_node2, struct node, rb_node)->val);
+}
+
+static int skl_compare(const struct skl_node *skl_node, const void *arg)
+{
+	struct node *p = skl_entry(skl_node, struct node, skl_node);
+
+	return p->val < *(int*)arg ? -1 : p->val > *(int*)arg;
+}
+
+static int skl_compare_link(const struct skl_node *skl_node1,
+			    const struct skl_node *skl_node2,
+			    const void *arg)
+{
+	return skl_compare(skl_node1,
+			   &skl_entry(skl_node2, struct node, skl_node)->val);
+}
+
+static void skl_release(struct epoch_entry *entry)
+{
+	free(skl_entry(skl_epoch_entry(entry), struct node, skl_node));
+}
+
+static double now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void *rb_worker(void *arg)
+{
+	unsigned int seed = (unsigned int)(unsigned long)arg;
+	struct rb_node *rb_node;
+	struct node *p;
+	int i, op, key;
+
+	for (i = 0; i < OPS; ++i) {
+		key = rand_r(&seed) % (SIZE * 2);
+		op = rand_r(&seed) % 100;
+		p = op < UPDATE ? malloc(sizeof(*p)) : NULL;
+
+		pthread_mutex_lock(&rb_lock);
+		if (p) {
+			p->val = key;
+			if (!rb_insert_unique(&p->rb_node, &rb,
+					      rb_compare_link, NULL))
+				free(p);
+		} else {
+			rb_node = rb_find(&rb, rb_compare, &key);
+			if (rb_node && op < 2 * UPDATE) {
+				rb_erase(rb_node, &rb);
+				free(rb_entry(rb_node, struct node, rb_node));
+			}
+		}
+		pthread_mutex_unlock(&rb_lock);
+	}
+
+	return NULL;
+}
+
+static void *skl_worker(void *arg)
+{
+	unsigned int seed = (unsigned int)(unsigned long)arg;
+	struct epoch_thread *thr = epoch_register(&domain);
+	struct skl_node *skl_node;
+	struct node *p;
+	int i, op, key;
+
+	for (i = 0; i < OPS; ++i) {
+		key = rand_r(&seed) % (SIZE * 2);
+		op = rand_r(&seed) % 100;
+		p = op < UPDATE ? malloc(sizeof(*p)) : NULL;
+
+		epoch_enter(thr);
+		if (p) {
+			p->val = key;
+			if (skl_insert_unique(&p->skl_node, &skl,
+					      skl_compare_link, NULL))
+				free(p);
+		} else {
+			skl_node = skl_find(&skl, skl_compare, &key);
+			if (skl_node && op < 2 * UPDATE)
+				skl_erase(skl_node, &skl, skl_compare_link,
+					  NULL);
+		}
+		epoch_exit(thr);
+	}
+
+	epoch_unregister(thr);
+
+	return NULL;
+}
+
+static double run(void *(*worker)(void *), int nthreads)
+{
+	int i;
+	double t;
+	pthread_t tids[MAX_THREADS];
+
+	t = now();
+	for (i = 0; i < nthreads; ++i)
+		pthread_create(&tids[i], NULL, worker,
+			       (void*)(unsigned long)rand());
+	for (i = 0; i < nthreads; ++i)
+		pthread_join(tids[i], NULL);
+
+	return (double)OPS * nthreads / (now() - t) / 1e6;
+}
+
+int main()
+{
+	int i, nthreads;
+	long ncpus = sysconf(_SC_NPROCESSORS_ONLN);
+	struct node *p;
+	struct epoch_thread *thr;
+
+	srand( (unsigned int)time(NULL) );
+
+	epoch_init(&domain);
+	skl_init(&skl, &domain, skl_release);
+	thr = epoch_register(&domain);
+	for (i = 0; i < SIZE; ++i) {
+		p = malloc(sizeof(*p));
+		p->val = rand() % (SIZE * 2);
+		if (!rb_insert_unique(&p->rb_node, &rb, rb_compare_link, NULL))
+			free(p);
+	}
+	epoch_enter(thr);
+	for (i = 0; i < SIZE; ++i) {
+		p = malloc(sizeof(*p));
+		p->val = rand() % (SIZE * 2);
+		if (skl_insert_unique(&p->skl_node, &skl, skl_compare_link,
+				      NULL))
+			free(p);
+	}
+	epoch_exit(thr);
+	epoch_unregister(thr);
+
+	printf("%d%% insert, %d%% erase, Mops/s\n", UPDATE, UPDATE);
+	printf("threads     rb+mutex    skiplist\n");
+	/* up to the cores, one mutex shows no contention beyond */
+	for (nthreads = 1; nthreads <= MAX_THREADS &&
+	     (nthreads == 1 || nthreads <= ncpus); nthreads *= 2) {
+		printf("%7d    %9.2f   %9.2f\n", nthreads,
+		       run(rb_worker, nthreads), run(skl_worker, nthreads));
+	}
+
+	return 0;
+}
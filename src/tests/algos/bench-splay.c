@@ -0,0 +1,140 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <ycc/algos/sptree.h>
+
+#ifndef SIZE
+#define SIZE (256*1024)
+#endif
+
+#ifndef OPS
+#define OPS (2*1024*1024)
+#endif
+
+struct node {
+	int val;
+	struct spt_node spt_node;
+};
+
+static struct node nodes[SIZE];
+static int keys[SIZE];
+static int queries[OPS];
+static double cdf[SIZE];
+
+static int compare(const struct spt_node *spt_node, const void *arg)
+{
+	int val = spt_entry(spt_node, struct node, spt_node)->val;
+
+	return val < *(const int*)arg ? -1 : val > *(const int*)arg;
+}
+
+static int compare_link(const struct spt_node *spt_node1,
+			const struct spt_node *spt_node2,
+			const void *arg)
+{
+	int val = spt_entry(spt_node2, struct node, spt_node)->val;
+
+	return compare(spt_node1, &val);
+}
+
+static double now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* the key of rank r is keys[r], rank r comes with p ~ 1 / (r + 1)^s */
+static void zipf(double s)
+{
+	double sum = 0;
+	int i, lo, hi, mid;
+
+	for (i = 0; i < SIZE; ++i)
+		cdf[i] = sum += 1 / pow(i + 1, s);
+
+	for (i = 0; i < OPS; ++i) {
+		double u = (double)rand() / RAND_MAX * sum;
+
+		for (lo = 0, hi = SIZE - 1; lo < hi; ) {
+			mid = (lo + hi) / 2;
+			if (cdf[mid] < u)
+				lo = mid + 1;
+			else
+				hi = mid;
+		}
+		queries[i] = keys[lo];
+	}
+}
+
+/* Mops/s of finds, or of lower bounds one below the keys */
+static double run(unsigned mode, bool bound)
+{
+	struct spt_root spt;
+	struct spt_node *spt_node;
+	double t;
+	int i, key;
+	long sum = 0;
+
+	spt_init(&spt);
+	spt_set_mode(&spt, mode);
+	for (i = 0; i < SIZE; ++i) {
+		nodes[i].val = keys[i];
+		spt_insert_unique(&nodes[i].spt_node, &spt, compare_link, NULL);
+	}
+
+	t = now();
+	for (i = 0; i < OPS; ++i) {
+		key = queries[i] - bound;
+		spt_node = bound ? spt_lower_bound(&spt, compare, &key)
+				 : spt_find(&spt, compare, &key);
+		sum += spt_node != NULL;
+	}
+	t = now() - t;
+
+	if (sum != OPS)
+		printf("error: %ld of %d found\n", sum, OPS);
+
+	return OPS / t / 1e6;
+}
+
+int main()
+{
+	static const double s[] = { 0.8, 1.0, 1.2 };
+	int i, j, tmp;
+
+	srand( (unsigned int)time(NULL) );
+
+	/* even keys, ranked in random order */
+	for (i = 0; i < SIZE; ++i)
+		keys[i] = 2 * i + 2;
+	for (i = SIZE - 1; i > 0; --i) {
+		j = rand() % (i + 1);
+		tmp = keys[i];
+		keys[i] = keys[j];
+		keys[j] = tmp;
+	}
+
+	printf("%d keys, %d Zipf accesses, Mops/s\n", SIZE, OPS);
+	printf("find      bottom-up   semi   top-down\n");
+	for (i = 0; i < (int)(sizeof(s) / sizeof(s[0])); ++i) {
+		zipf(s[i]);
+		printf("s=%.1f     %9.2f %6.2f %10.2f\n", s[i],
+		       run(0, false), run(SPT_SEMI, false),
+		       run(SPT_TOPDOWN, false));
+	}
+
+	printf("bound     no splay  bottom-up   semi   top-down\n");
+	for (i = 0; i < (int)(sizeof(s) / sizeof(s[0])); ++i) {
+		zipf(s[i]);
+		printf("s=%.1f     %8.2f %10.2f %6.2f %10.2f\n", s[i],
+		       run(0, true), run(SPT_BOUNDS, true),
+		       run(SPT_BOUNDS | SPT_SEMI, true),
+		       run(SPT_BOUNDS | SPT_TOPDOWN, true));
+	}
+
+	return 0;
+}
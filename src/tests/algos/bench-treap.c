@@ -0,0 +1,111 @@
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <ycc/algos/treap.h>
+
+#ifndef SIZE
+#define SIZE (256*1024)
+#endif
+
+#define MAX_THREADS 16
+
+struct node {
+	int val;
+	struct treap_node treap_node;
+};
+
+/* the priorities of the inserts */
+enum { PRIO_RAND, PRIO_TREAP_RAND, PRIO_HASH };
+
+struct worker_arg {
+	int prio;
+	unsigned seed;
+	struct node *nodes;
+};
+
+static int compare_link(const struct treap_node *treap_node1,
+			const struct treap_node *treap_node2,
+			const void *arg)
+{
+	int val1 = treap_entry(treap_node1, struct node, treap_node)->val;
+	int val2 = treap_entry(treap_node2, struct node, treap_node)->val;
+
+	return val1 < val2 ? -1 : val1 > val2;
+}
+
+static double now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* every thread fills a treap of its own */
+static void *worker(void *arg)
+{
+	struct worker_arg *w = arg;
+	struct treap_root treap;
+	struct node *p;
+	unsigned priority;
+	int i;
+
+	treap_init(&treap);
+	for (i = 0; i < SIZE; ++i) {
+		p = &w->nodes[i];
+		p->val = rand_r(&w->seed);
+		if (w->prio == PRIO_RAND)
+			priority = (unsigned)rand();
+		else if (w->prio == PRIO_TREAP_RAND)
+			priority = treap_rand();
+		else
+			priority = treap_hash_priority((unsigned)p->val);
+		treap_insert_with_priority(&p->treap_node, &treap, priority,
+					   compare_link, NULL);
+	}
+
+	return NULL;
+}
+
+static double run(int prio, int nthreads)
+{
+	static struct worker_arg args[MAX_THREADS];
+	pthread_t tids[MAX_THREADS];
+	double t;
+	int i;
+
+	for (i = 0; i < nthreads; ++i) {
+		args[i].prio = prio;
+		args[i].seed = (unsigned)rand();
+		if (!args[i].nodes)
+			args[i].nodes = malloc(sizeof(struct node) * SIZE);
+	}
+
+	t = now();
+	for (i = 0; i < nthreads; ++i)
+		pthread_create(&tids[i], NULL, worker, &args[i]);
+	for (i = 0; i < nthreads; ++i)
+		pthread_join(tids[i], NULL);
+
+	return (double)SIZE * nthreads / (now() - t) / 1e6;
+}
+
+int main()
+{
+	int nthreads;
+
+	srand( (unsigned int)time(NULL) );
+
+	printf("%d inserts per thread into its own treap, Mops/s\n", SIZE);
+	printf("threads       rand()  treap_rand  treap_hash_priority\n");
+	for (nthreads = 1; nthreads <= MAX_THREADS; nthreads *= 2) {
+		printf("%7d    %9.2f   %9.2f   %18.2f\n", nthreads,
+		       run(PRIO_RAND, nthreads),
+		       run(PRIO_TREAP_RAND, nthreads),
+		       run(PRIO_HASH, nthreads));
+	}
+
+	return 0;
+}
@@ -0,0 +1,110 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <ycc/algos/avltree.h>
+#include <ycc/algos/rbtree.h>
+#include <ycc/algos/wavltree.h>
+
+#ifndef SIZE
+#define SIZE (256*1024)
+#endif
+
+#ifndef OPS
+#define OPS (2*1024*1024)
+#endif
+
+struct node {
+	int val;
+	struct avl_node avl_node;
+	struct rb_node rb_node;
+	struct wavl_node wavl_node;
+};
+
+static inline int cmp(const struct node *a, const struct node *b)
+{
+	return a->val < b->val ? -1 : a->val > b->val;
+}
+
+AVL_GENERATE(avl_tree, struct node, avl_node, cmp)
+RB_GENERATE(rb_tree, struct node, rb_node, cmp)
+WAVL_GENERATE(wavl_tree, struct node, wavl_node, cmp)
+
+/* the slot of a key, 'nodes[key]' is linked if 'linked[key]' */
+static struct node nodes[SIZE * 2];
+static bool linked[SIZE * 2];
+static int keys[OPS], drain_keys[SIZE];
+
+static double now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+#define BENCH_TREE(tree, root_type, member, erase)			\
+static double tree##_run(const int *seq, int num)			\
+{									\
+	root_type root = { NULL, };					\
+	double t;							\
+	int i, key;							\
+									\
+	for (i = 0; i < SIZE * 2; ++i)					\
+		linked[i] = false;					\
+	for (i = 0; i < SIZE * 2; i += 2) {				\
+		tree##_insert(&root, &nodes[i]);			\
+		linked[i] = true;					\
+	}								\
+									\
+	t = now();							\
+	for (i = 0; i < num; ++i) {					\
+		key = seq[i];						\
+		if (linked[key]) {					\
+			erase(&nodes[key].member, &root);		\
+			linked[key] = false;				\
+		} else {						\
+			tree##_insert(&root, &nodes[key]);		\
+			linked[key] = true;				\
+		}							\
+	}								\
+									\
+	return num / (now() - t) / 1e6;					\
+}
+
+BENCH_TREE(avl_tree, struct avl_root, avl_node, avl_erase)
+BENCH_TREE(rb_tree, struct rb_root, rb_node, rb_erase)
+BENCH_TREE(wavl_tree, struct wavl_root, wavl_node, wavl_erase)
+
+int main()
+{
+	int i, j, tmp;
+
+	srand( (unsigned int)time(NULL) );
+
+	for (i = 0; i < SIZE * 2; ++i)
+		nodes[i].val = i;
+	for (i = 0; i < OPS; ++i)
+		keys[i] = rand() % (SIZE * 2);
+
+	/* the linked keys, the even ones, in random order */
+	for (i = 0; i < SIZE; ++i)
+		drain_keys[i] = 2 * i;
+	for (i = SIZE - 1; i > 0; --i) {
+		j = rand() % (i + 1);
+		tmp = drain_keys[i];
+		drain_keys[i] = drain_keys[j];
+		drain_keys[j] = tmp;
+	}
+
+	/* mixed: a random key flips in or out, about half of them erase */
+	printf("%d of %d keys linked, Mops/s\n", SIZE, SIZE * 2);
+	printf("workload        avl       rb     wavl\n");
+	printf("mixed      %8.2f %8.2f %8.2f\n", avl_tree_run(keys, OPS),
+	       rb_tree_run(keys, OPS), wavl_tree_run(keys, OPS));
+	printf("drain      %8.2f %8.2f %8.2f\n",
+	       avl_tree_run(drain_keys, SIZE), rb_tree_run(drain_keys, SIZE),
+	       wavl_tree_run(drain_keys, SIZE));
+
+	return 0;
+}
@@ -0,0 +1,343 @@
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <ycc/algos/art.h>
+
+#define NUM	(16*1024)
+
+struct item {
+	struct art_leaf leaf;
+	bool linked;
+	size_t len;
+	unsigned char key[32];
+};
+
+static struct item items[NUM];
+static struct art_leaf nested[NUM];
+static unsigned char nested_key[NUM];
+static struct item *sorted[NUM];
+static int nsorted, node_cnt;
+
+/* long shared runs, past the stored prefix, and '\0' in keys */
+static const unsigned char stems[3][20] = {
+	"abcdefghijklmnopqrs",
+	"abcdefghijklmnopXYZ",
+	"\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0\0",
+};
+
+static size_t gen_key(unsigned char *key, int width)
+{
+	size_t len = 0, n;
+
+	if (rand() % 4) {
+		n = rand() % 20;
+		memcpy(key, stems[rand() % 3], n);
+		len = n;
+	}
+	for (n = rand() % 5; n; --n)
+		key[len++] = (unsigned char)(rand() % width * (256 / width));
+
+	return len;
+}
+
+static int key_cmp(const unsigned char *a, size_t alen,
+		   const unsigned char *b, size_t blen)
+{
+	int cmp = memcmp(a, b, alen < blen ? alen : blen);
+
+	return cmp ? cmp : (alen > blen) - (alen < blen);
+}
+
+static int item_cmp(const void *a, const void *b)
+{
+	const struct item *x = *(struct item *const*)a;
+	const struct item *y = *(struct item *const*)b;
+
+	return key_cmp(x->key, x->len, y->key, y->len);
+}
+
+static void rebuild_sorted(void)
+{
+	int i;
+
+	for (i = nsorted = 0; i < NUM; ++i)
+		if (items[i].linked)
+			sorted[nsorted++] = &items[i];
+	qsort(sorted, nsorted, sizeof(*sorted), item_cmp);
+}
+
+/* the index of the first key >= key, > key if 'upper' */
+static int ref_bound(const unsigned char *key, size_t len, bool upper)
+{
+	int lo = 0, hi = nsorted, mid, cmp;
+
+	while (lo < hi) {
+		mid = (lo + hi) / 2;
+		cmp = key_cmp(sorted[mid]->key, sorted[mid]->len, key, len);
+		if (cmp < 0 || (upper && !cmp))
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	return lo;
+}
+
+static struct art_leaf *ref_leaf(int i)
+{
+	return i < nsorted ? &sorted[i]->leaf : NULL;
+}
+
+static void visit(const struct art_leaf *leaf, const void *arg)
+{
+	int *pos = (int*)arg;
+
+	if (*pos >= nsorted || leaf != &sorted[*pos]->leaf)
+		printf("error: art_visit order at %d\n", *pos);
+	++*pos;
+}
+
+static bool visit_cond(const struct art_leaf *leaf, const void *arg)
+{
+	return ++*(int*)arg < 100;
+}
+
+static void visit_nested(const struct art_leaf *leaf, const void *arg)
+{
+	size_t *len = (size_t*)arg;
+
+	if (leaf->len <= *len)
+		printf("error: nested key of %zu after %zu\n", leaf->len, *len);
+	*len = leaf->len;
+}
+
+static void destroy_nested(struct art_leaf *leaf, const void *arg)
+{
+	--node_cnt;
+}
+
+static void destroy(struct art_leaf *leaf, const void *arg)
+{
+	art_entry(leaf, struct item, leaf)->linked = false;
+	--node_cnt;
+}
+
+static int check(struct art_root *art, int width)
+{
+	unsigned char key[32];
+	struct art_leaf *leaf;
+	size_t len;
+	int i, pos;
+
+	rebuild_sorted();
+	if (!art_isvalid(art) || art_count(art) != (size_t)nsorted) {
+		printf("art_isvalid failed !\n");
+		return 1;
+	}
+
+	for (i = 0; i < NUM; ++i) {
+		leaf = art_find(art, items[i].key, items[i].len);
+		if (items[i].linked ? leaf != &items[i].leaf :
+		    leaf == &items[i].leaf) {
+			printf("error: art_find %d\n", i);
+			return 1;
+		}
+	}
+
+	for (i = 0; i < 1024; ++i) {
+		len = gen_key(key, width);
+		if (art_lower_bound(art, key, len) !=
+		    ref_leaf(ref_bound(key, len, false)) ||
+		    art_upper_bound(art, key, len) !=
+		    ref_leaf(ref_bound(key, len, true))) {
+			printf("error: art bounds\n");
+			return 1;
+		}
+		pos = ref_bound(key, len, false);
+		if (art_find(art, key, len) !=
+		    (pos < nsorted && !key_cmp(sorted[pos]->key,
+					       sorted[pos]->len, key, len) ?
+		     &sorted[pos]->leaf : NULL)) {
+			printf("error: art_find probe\n");
+			return 1;
+		}
+	}
+
+	for (pos = 0, leaf = art_first(art); leaf;
+	     leaf = art_next(art, leaf), ++pos)
+		if (leaf != ref_leaf(pos)) {
+			printf("error: art_next order at %d\n", pos);
+			return 1;
+		}
+	if (pos != nsorted || art_last(art) != ref_leaf(nsorted - 1)) {
+		printf("error: art_next or art_last\n");
+		return 1;
+	}
+
+	pos = 0;
+	art_visit(art, visit, &pos);
+	if (pos != nsorted)
+		printf("error: art_visit %d of %d\n", pos, nsorted);
+	pos = 0;
+	if (art_visit_cond(art, visit_cond, &pos) != (nsorted < 100) ||
+	    pos != (nsorted < 100 ? nsorted : 100))
+		printf("error: art_visit_cond\n");
+
+	return 0;
+}
+
+int main()
+{
+	static const int widths[] = { 3, 24, 64, 256 };
+	ART_DECLARE(art);
+	struct art_leaf *leaf;
+	int i, w, round, width;
+
+	srand( (unsigned int)time(NULL) );
+
+	if (art_first(&art) || art_find(&art, "", 0) ||
+	    art_lower_bound(&art, "", 0) || art_erase(&art, "", 0))
+		printf("error: empty art\n");
+
+	/* a compressed path of 16 bytes split past the bytes it stores */
+	{
+		static const char *keys[] = {
+			"abcdefghijklmnopqrs", "abcdefghijklmnopXYZ",
+			"abcdefghijklmZ", "abcdefghijklm", "abcdefghijkl",
+		};
+
+		for (i = 0; i < 5; ++i) {
+			items[i].len = strlen(keys[i]);
+			memcpy(items[i].key, keys[i], items[i].len);
+			art_leaf_init(&items[i].leaf, items[i].key,
+				      items[i].len);
+			if (art_insert(&art, &items[i].leaf) ||
+			    !art_isvalid(&art))
+				printf("error: art_insert %s\n", keys[i]);
+			items[i].linked = true;
+			++node_cnt;
+		}
+		if (check(&art, 3))
+			return 1;
+	}
+
+	/* width 256 grows node256, 24 and 64 node16 and node48 */
+	for (w = 0; w < 4; ++w) {
+		width = widths[w];
+		for (round = 0; round < 4; ++round) {
+			for (i = 0; i < NUM; ++i) {
+				struct item *p = &items[i];
+
+				if (p->linked || rand() % 2)
+					continue;
+				p->len = gen_key(p->key, width);
+				art_leaf_init(&p->leaf, p->key, p->len);
+				leaf = art_find(&art, p->key, p->len);
+				if (!art_insert(&art, &p->leaf)) {
+					p->linked = true;
+					++node_cnt;
+				} else if (errno != EEXIST || !leaf) {
+					printf("error: art_insert\n");
+					return 1;
+				}
+			}
+			if (check(&art, width))
+				return 1;
+
+			/* erase about half, some through a copy of the key */
+			for (i = 0; i < NUM; ++i) {
+				unsigned char key[32];
+				struct item *p = &items[i];
+
+				if (!p->linked || rand() % 2)
+					continue;
+				memcpy(key, p->key, p->len);
+				if (art_erase(&art, key, p->len) != &p->leaf ||
+				    art_erase(&art, key, p->len)) {
+					printf("error: art_erase\n");
+					return 1;
+				}
+				p->linked = false;
+				--node_cnt;
+			}
+			if (check(&art, width))
+				return 1;
+		}
+		printf("%d node_cnt: %d\n", w + 1, node_cnt);
+	}
+
+	/* drain one by one down to the empty tree */
+	rebuild_sorted();
+	for (i = 0; i < nsorted; ++i) {
+		if (art_erase(&art, sorted[i]->key, sorted[i]->len) !=
+		    &sorted[i]->leaf) {
+			printf("error: art_erase drain\n");
+			return 1;
+		}
+		sorted[i]->linked = false;
+		--node_cnt;
+		if (i % 256 == 0 && !art_isvalid(&art)) {
+			printf("art_isvalid failed in drain !\n");
+			return 1;
+		}
+	}
+	if (art.node || !art_empty(&art))
+		printf("error: art not empty\n");
+
+	/*
+	 * "a", "aa", "aaa" ... nest one inner node per key, the walks go
+	 * far deeper than their ring of ancestors
+	 */
+	{
+		size_t len = 0;
+		int cnt = 0;
+
+		memset(nested_key, 'a', NUM);
+		for (i = 0; i < NUM; ++i) {
+			art_leaf_init(&nested[i], nested_key, i + 1);
+			if (art_insert(&art, &nested[i]))
+				printf("error: art_insert nested %d\n", i);
+			++node_cnt;
+		}
+		art_visit(&art, visit_nested, &len);
+		if (len != NUM || !art_isvalid(&art) ||
+		    art_visit_cond(&art, visit_cond, &cnt) || cnt != 100)
+			printf("error: art_visit nested\n");
+
+		for (i = 0; i < NUM; i += 2)
+			if (art_erase(&art, nested_key, i + 1) != &nested[i])
+				printf("error: art_erase nested %d\n", i);
+			else
+				--node_cnt;
+		len = 0;
+		art_visit(&art, visit_nested, &len);
+		if (len != NUM || !art_isvalid(&art) ||
+		    art_next(&art, &nested[NUM - 3]) != &nested[NUM - 1])
+			printf("error: art nested after erase\n");
+
+		art_clear(&art, destroy_nested, NULL);
+		printf("5 node_cnt: %d\n", node_cnt);
+	}
+
+	/* dense integer keys, then clear */
+	for (i = 0; i < NUM; ++i) {
+		items[i].len = 8;
+		art_key_u64(items[i].key, (uint64_t)i * 3);
+		art_leaf_init(&items[i].leaf, items[i].key, 8);
+		if (art_insert(&art, &items[i].leaf))
+			printf("error: art_insert u64 %d\n", i);
+		items[i].linked = true;
+		++node_cnt;
+	}
+	if (check(&art, 256))
+		return 1;
+	art_clear(&art, destroy, NULL);
+	printf("6 node_cnt: %d\n", node_cnt);
+	if (art.node || art_count(&art))
+		printf("error: art_clear\n");
+
+	return 0;
+}
@@ -105,5 +105,101 @@ int main()
 	}
 
 
+	/* build from sorted nodes */
+	{
+		struct avl_node **nodes = malloc(sizeof(*nodes) * 1000);
+
+		if (!nodes)
+			return 1;
+
+		for (i = 0; i < 1000; ++i)
+			nodes[i] = &node_alloc(i)->avl_node;
+		avl_build_sorted(&avl, nodes, 1000);
+		free(nodes);
+
+		if (!avl_isvalid(&avl)) {
+			printf("avl_build_sorted: avl_isvalid failed !\n");
+			return 1;
+		}
+
+		i = 0;
+		avl_node = avl_first(&avl);
+		while (avl_node) {
+			p = avl_entry(avl_node, struct node, avl_node);
+			if (p->val != i++)
+				printf("error: avl_build_sorted order\n");
+			avl_node = avl_next(avl_node);
+		}
+		printf("4 node_cnt: %d\n", node_cnt);
+	}
+
+#ifdef	BSTLINK_SIZE
+	/* order statistics */
+	{
+		int lo = 250, hi = 750;
+
+		for (i = 0; i < 1000; ++i) {
+			avl_node = avl_select(&avl, i);
+			if (!avl_node || avl_rank(avl_node) != (size_t)i ||
+			    avl_entry(avl_node, struct node, avl_node)->val != i)
+				printf("error: avl_select/avl_rank %d\n", i);
+		}
+		if (avl_select(&avl, 1000))
+			printf("error: avl_select out of range\n");
+		if (avl_count_range(&avl, compare, &lo, &hi) != 500 ||
+		    avl_count_range(&avl, compare, &hi, &lo) != 0)
+			printf("error: avl_count_range\n");
+
+		/* erase the odd ones and take them back */
+		for (i = 1; i < 1000; i += 2) {
+			avl_node = avl_select(&avl, (i + 1) / 2);
+			avl_erase(avl_node, &avl);
+			avl_insert(avl_node, &avl, compare_link, NULL);
+			avl_erase(avl_node, &avl);
+			destroy(avl_node, NULL);
+		}
+		if (!avl_isvalid(&avl) ||
+		    avl_count_range(&avl, compare, &lo, &hi) != 250 ||
+		    avl_entry(avl_select(&avl, 100), struct node,
+			      avl_node)->val != 200)
+			printf("error: avl order statistics after erase\n");
+
+		for (i = 1; i < 1000; i += 2) {
+			p = node_alloc(i);
+			avl_insert(&p->avl_node, &avl, compare_link, NULL);
+		}
+	}
+#endif
+
+	/* split and join */
+	{
+		struct avl_root left, right;
+
+		i = 500;
+		avl_split(&avl, compare, &i, &left, &right);
+		if (!avl_isvalid(&left) || !avl_isvalid(&right)) {
+			printf("avl_split: avl_isvalid failed !\n");
+			return 1;
+		}
+
+		avl_node = avl_last(&left);
+		if (avl_entry(avl_node, struct node, avl_node)->val != 499)
+			printf("error: avl_split left\n");
+		avl_node = avl_first(&right);
+		if (avl_entry(avl_node, struct node, avl_node)->val != 500)
+			printf("error: avl_split right\n");
+
+		avl_erase(avl_node, &right);
+		avl_join(&avl, &left, avl_node, &right);
+		if (!avl_isvalid(&avl) ||
+		    avl_count(&avl, compare, &i) != 1) {
+			printf("avl_join failed !\n");
+			return 1;
+		}
+
+		avl_clear(&avl, destroy, NULL);
+		printf("5 node_cnt: %d\n", node_cnt);
+	}
+
 	return 0;
 }
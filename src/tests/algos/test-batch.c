@@ -0,0 +1,99 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <ycc/algos/rbtree.h>
+#include <ycc/algos/avltree.h>
+#include <ycc/algos/bstree.h>
+#include <ycc/algos/treap.h>
+
+#include "test-tree.h"
+
+#define SIZE	100000
+#define RANGE	(SIZE * 2)
+#define BATCH	1000
+
+struct node {
+	int val;
+	struct rb_node rb;
+	struct avl_node avl;
+	struct bst_node bst;
+	struct treap_node treap;
+};
+
+static struct node nodes[SIZE];
+static int vals[BATCH];
+static const void *args[BATCH];
+
+TEST_TREE_COMPARE(rb, struct node, rb, int, val)
+TEST_TREE_COMPARE(avl, struct node, avl, int, val)
+TEST_TREE_COMPARE(bst, struct node, bst, int, val)
+TEST_TREE_COMPARE(treap, struct node, treap, int, val)
+
+/* the batched answers MUST be those of the single searches */
+#define BATCH_TEST(name)						\
+static int name##_test(void)						\
+{									\
+	int i;								\
+	struct name##_node *found[BATCH], *lower[BATCH];		\
+	struct name##_root root = { NULL };				\
+									\
+	name##_find_batch(&root, name##_compare, args, BATCH, found);	\
+	for (i = 0; i < BATCH; ++i) {					\
+		if (found[i]) {						\
+			printf(#name ": found in an empty tree\n");	\
+			return 1;					\
+		}							\
+	}								\
+									\
+	for (i = 0; i < SIZE; ++i)					\
+		name##_insert(&nodes[i].name, &root,			\
+			      name##_compare_link, NULL);		\
+									\
+	name##_find_batch(&root, name##_compare, args, BATCH, found);	\
+	name##_lower_bound_batch(&root, name##_compare, args, BATCH,	\
+				 lower);				\
+	for (i = 0; i < BATCH; ++i) {					\
+		if (found[i] != name##_find(&root, name##_compare,	\
+					    args[i]) ||			\
+		    lower[i] != name##_lower_bound(&root,		\
+						   name##_compare,	\
+						   args[i])) {		\
+			printf(#name ": batch search of %d failed\n",	\
+			       vals[i]);				\
+			return 1;					\
+		}							\
+	}								\
+									\
+	return 0;							\
+}
+
+BATCH_TEST(rb)
+BATCH_TEST(avl)
+BATCH_TEST(bst)
+BATCH_TEST(treap)
+
+int main()
+{
+	int i;
+
+	srand( (unsigned int)time(NULL) );
+
+	for (i = 0; i < SIZE; ++i)
+		nodes[i].val = rand() % RANGE;
+
+	/* hits, misses and both ends */
+	for (i = 0; i < BATCH; ++i) {
+		vals[i] = i & 1 ? nodes[rand() % SIZE].val : rand() % RANGE;
+		args[i] = &vals[i];
+	}
+	vals[0] = -1;
+	vals[1] = RANGE;
+
+	if (rb_test() || avl_test() || bst_test() || treap_test())
+		return 1;
+
+	printf("batch ok\n");
+
+	return 0;
+}
@@ -0,0 +1,210 @@
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <ycc/algos/bptree.h>
+
+#define SIZE	200000
+#define RANGE	50000
+
+static int cnt[RANGE];
+static size_t total = 0;
+
+/* the number of keys less than 'key' */
+static size_t expect_rank(unsigned long key)
+{
+	size_t n = 0;
+	unsigned long i;
+
+	for (i = 0; i < key && i < RANGE; ++i)
+		n += cnt[i];
+
+	return n;
+}
+
+static int check_order(struct bpt_root *bpt)
+{
+	struct bpt_iter iter;
+	unsigned long prev_key = 0;
+	unsigned long prev_seq = 0;
+	size_t num = 0;
+
+	for (bpt_first(bpt, &iter); !bpt_iter_end(&iter); bpt_next(&iter)) {
+		unsigned long key = bpt_iter_key(&iter);
+		unsigned long seq = (unsigned long)bpt_iter_value(&iter);
+
+		if (num && (key < prev_key ||
+			    (key == prev_key && seq < prev_seq))) {
+			printf("error: %lu(%lu) after %lu(%lu)\n",
+			       key, seq, prev_key, prev_seq);
+			return 1;
+		}
+		prev_key = key;
+		prev_seq = seq;
+		++num;
+	}
+
+	if (num != total || bpt_count(bpt) != total) {
+		printf("error: %zu keys, expect %zu\n", num, total);
+		return 1;
+	}
+
+	num = 0;
+	for (bpt_last(bpt, &iter); !bpt_iter_end(&iter); bpt_prev(&iter))
+		++num;
+	if (num != total) {
+		printf("error: %zu keys backward, expect %zu\n", num, total);
+		return 1;
+	}
+
+	return 0;
+}
+
+/* position of 'iter' counted from the first key */
+static size_t rank_of(struct bpt_root *bpt, const struct bpt_iter *iter)
+{
+	struct bpt_iter it;
+	size_t n = 0;
+
+	if (bpt_iter_end(iter))
+		return total;
+
+	for (bpt_first(bpt, &it);
+	     it.leaf != iter->leaf || it.pos != iter->pos; bpt_next(&it))
+		++n;
+
+	return n;
+}
+
+static int check_bounds(struct bpt_root *bpt)
+{
+	int i;
+
+	for (i = 0; i < 100; ++i) {
+		unsigned long key = rand() % (RANGE + 10);
+		struct bpt_iter lower, upper, find;
+		bool found = bpt_find(bpt, key, &find);
+
+		bpt_lower_bound(bpt, key, &lower);
+		bpt_upper_bound(bpt, key, &upper);
+
+		if (rank_of(bpt, &lower) != expect_rank(key) ||
+		    rank_of(bpt, &upper) != expect_rank(key + 1) ||
+		    found != (key < RANGE && cnt[key]) ||
+		    (found && (find.leaf != lower.leaf ||
+			       find.pos != lower.pos))) {
+			printf("error: bounds of %lu\n", key);
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+static size_t destroyed = 0;
+
+static void destroy(unsigned long key, void *value, const void *arg)
+{
+	++destroyed;
+}
+
+int main()
+{
+	int i;
+	unsigned long key, lo, hi;
+	size_t n;
+	struct bpt_iter iter, end;
+
+	BPT_DECLARE(bpt);
+
+	srand( (unsigned int)time(NULL) );
+
+	for (i = 0; i < SIZE; ++i) {
+		key = rand() % RANGE;
+		if (bpt_insert(&bpt, key, (void*)(unsigned long)i)) {
+			printf("bpt_insert failed !\n");
+			return 1;
+		}
+		++cnt[key];
+		++total;
+	}
+
+	if (!bpt_isvalid(&bpt) || check_order(&bpt) || check_bounds(&bpt)) {
+		printf("bpt_insert: check failed !\n");
+		return 1;
+	}
+
+	for (key = 0; key < RANGE; ++key) {
+		if (!cnt[key])
+			continue;
+		if (!bpt_insert_unique(&bpt, key, NULL) || errno != EEXIST) {
+			printf("bpt_insert_unique: %lu inserted twice\n", key);
+			return 1;
+		}
+	}
+
+	for (i = 0; i < SIZE / 2; ++i) {
+		key = rand() % RANGE;
+		if (bpt_find(&bpt, key, &iter)) {
+			bpt_erase(&bpt, &iter);
+			--cnt[key];
+			--total;
+			if (!bpt_iter_end(&iter) && bpt_iter_key(&iter) < key) {
+				printf("bpt_erase: bad next iterator\n");
+				return 1;
+			}
+		}
+	}
+
+	if (!bpt_isvalid(&bpt) || check_order(&bpt) || check_bounds(&bpt)) {
+		printf("bpt_erase: check failed !\n");
+		return 1;
+	}
+
+	for (i = 0; i < 20; ++i) {
+		lo = rand() % RANGE;
+		hi = lo + rand() % (RANGE / 10);
+		bpt_lower_bound(&bpt, lo, &iter);
+		bpt_lower_bound(&bpt, hi, &end);
+		n = bpt_erase_range(&bpt, &iter, &end);
+		if (n != expect_rank(hi) - expect_rank(lo)) {
+			printf("bpt_erase_range: erased %zu\n", n);
+			return 1;
+		}
+		for (key = lo; key < hi && key < RANGE; ++key)
+			cnt[key] = 0;
+		total -= n;
+
+		if (!bpt_isvalid(&bpt) || check_order(&bpt)) {
+			printf("bpt_erase_range: check failed !\n");
+			return 1;
+		}
+	}
+
+	if (check_bounds(&bpt))
+		return 1;
+
+	bpt_clear(&bpt, destroy, NULL);
+	if (destroyed != total || !bpt_empty(&bpt) || !bpt_isvalid(&bpt)) {
+		printf("bpt_clear: %zu destroyed, expect %zu\n",
+		       destroyed, total);
+		return 1;
+	}
+
+	/* fill and drain through the iterator */
+	for (i = 0; i < SIZE; ++i)
+		bpt_insert(&bpt, i, NULL);
+	bpt_first(&bpt, &iter);
+	end.leaf = NULL;
+	end.pos = 0;
+	n = bpt_erase_range(&bpt, &iter, &end);
+	if (n != SIZE || !bpt_empty(&bpt) || !bpt_isvalid(&bpt)) {
+		printf("bpt_erase_range: drained %zu\n", n);
+		return 1;
+	}
+
+	printf("bptree ok\n");
+
+	return 0;
+}
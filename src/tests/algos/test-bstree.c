@@ -54,6 +54,17 @@ static void destroy(struct bst_node *node, const void *arg)
 	node_free(bst_entry(node, struct node, bst_node));
 }
 
+static void visit_count(const struct bst_node *node, const void *arg)
+{
+	++*(size_t*)arg;
+}
+
+/* stops at the 1000th node */
+static bool visit_cond_count(const struct bst_node *node, const void *arg)
+{
+	return ++*(size_t*)arg < 1000;
+}
+
 int main()
 {
 	int i, val;
@@ -88,6 +99,25 @@ int main()
 	}
 	bst_node = bst_first(&bst);
 	printf("1 node_cnt: %d\n", node_cnt);
+
+	/* every order walks all nodes, postorder ends at the root */
+	{
+		struct bst_link *root = (struct bst_link*)bst.node, *link;
+		int pre = 0, post = 0;
+
+		for (link = root; link;
+		     link = bstlink_next_preorder(link, root))
+			++pre;
+		for (link = bstlink_first_postorder(root); link;
+		     link = bstlink_next_postorder(link, root)) {
+			if (++post == node_cnt && link != root)
+				printf("error: postorder ends off the root\n");
+		}
+		if (pre != node_cnt || post != node_cnt)
+			printf("error: preorder %d, postorder %d of %d\n",
+			       pre, post, node_cnt);
+	}
+
 	i = 105;
 	bst_erase_equal(&bst, compare, destroy, &i, NULL);
 	printf("2 node_cnt: %d\n", node_cnt);
@@ -98,6 +128,42 @@ int main()
 		printf("error: bst_node should be null\n");
 	}
 
+	/*
+	 * a left chain 1M deep, as by descending inserts, walked without
+	 * stack.  It is linked bottom-up, every node on top of the last.
+	 */
+	{
+		struct bst_node *last = NULL;
+		size_t cnt = 0;
+
+		for (i = 0; i < 1024*1024; ++i) {
+			p = node_alloc(i);
+			bst_link_node(&p->bst_node, NULL, &bst.node);
+			if ((p->bst_node.left = last))
+				bst_set_parent(last, &p->bst_node);
+#ifdef	BSTLINK_SIZE
+			p->bst_node.size = i + 1;
+#endif
+			last = &p->bst_node;
+		}
+
+		bst_visit(&bst, visit_count, &cnt);
+		if (cnt != 1024*1024 || bst_height_max(&bst) != cnt ||
+		    bst_height_min(&bst) != 1) {
+			printf("error: chain of %zu nodes, height {%zu, %zu}\n",
+			       cnt, bst_height_min(&bst), bst_height_max(&bst));
+			return 1;
+		}
+
+		cnt = 0;
+		if (bst_visit_cond(&bst, visit_cond_count, &cnt) ||
+		    cnt != 1000)
+			printf("error: bst_visit_cond stopped at %zu\n", cnt);
+
+		bst_clear(&bst, destroy, NULL);
+		printf("4 node_cnt: %d\n", node_cnt);
+	}
+
 
 	return 0;
 }
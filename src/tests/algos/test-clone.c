@@ -0,0 +1,162 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <ycc/algos/rbtree.h>
+
+#define SIZE	(256*1024)
+#define RANGE	1000
+
+struct node {
+	int val;
+	struct rb_node rb_node;
+};
+
+/* the clones fail once 'budget' reaches 0, never if it is negative */
+static long nalloc, budget = -1;
+
+static int compare_link(const struct rb_node *rb_node1,
+			const struct rb_node *rb_node2,
+			const void *arg)
+{
+	int val1 = rb_entry(rb_node1, struct node, rb_node)->val;
+	int val2 = rb_entry(rb_node2, struct node, rb_node)->val;
+
+	return val1 < val2 ? -1 : val1 > val2;
+}
+
+static struct rb_node *node_clone(const struct rb_node *rb_node,
+				  const void *arg)
+{
+	struct node *p;
+
+	if (!__atomic_sub_fetch(&budget, 1, __ATOMIC_RELAXED) ||
+	    !(p = malloc(sizeof(*p))))
+		return NULL;
+
+	*p = *rb_entry(rb_node, struct node, rb_node);
+	__atomic_add_fetch(&nalloc, 1, __ATOMIC_RELAXED);
+
+	return &p->rb_node;
+}
+
+static void node_destroy(struct rb_node *rb_node, const void *arg)
+{
+	free(rb_entry(rb_node, struct node, rb_node));
+	__atomic_sub_fetch(&nalloc, 1, __ATOMIC_RELAXED);
+}
+
+/* same shape, colors and values */
+static bool same(const struct rb_node *rb_node1, const struct rb_node *rb_node2)
+{
+	while (rb_node1 && rb_node2) {
+		if (rb_color(rb_node1) != rb_color(rb_node2) ||
+		    compare_link(rb_node1, rb_node2, NULL) ||
+		    !same(rb_node1->left, rb_node2->left))
+			return false;
+		rb_node1 = rb_node1->right;
+		rb_node2 = rb_node2->right;
+	}
+
+	return rb_node1 == rb_node2;
+}
+
+static int check(const char *name, struct rb_root *rb, struct rb_root *src)
+{
+	if (!rb_isvalid(rb) || !same(rb->node, src->node)) {
+		printf("%s failed\n", name);
+		return 1;
+	}
+
+	return 0;
+}
+
+int main()
+{
+	int i;
+	long num;
+	struct node *p;
+	struct rb_node *beg, *end, *rb_node, *rb_src;
+	struct rb_root *rbs;
+
+	srand( (unsigned int)time(NULL) );
+
+	rbs = rb_alloc(4);
+	if (!rbs) {
+		printf("rb_alloc failed\n");
+		return 1;
+	}
+
+	if (!rb_clone(&rbs[1], &rbs[0], node_clone, node_destroy, NULL,
+		      NULL) || check("rb_clone empty", &rbs[1], &rbs[0]))
+		return 1;
+
+	for (i = 0; i < SIZE; ++i) {
+		p = malloc(sizeof(*p));
+		p->val = rand() % RANGE;
+		rb_insert(&p->rb_node, &rbs[0], compare_link, NULL);
+		++nalloc;
+	}
+
+	if (!rb_clone(&rbs[1], &rbs[0], node_clone, node_destroy, NULL,
+		      NULL) || check("rb_clone", &rbs[1], &rbs[0]))
+		return 1;
+
+	if (!rb_clone_parallel(&rbs[2], &rbs[0], node_clone, node_destroy,
+			       NULL, NULL, 8) ||
+	    check("rb_clone_parallel", &rbs[2], &rbs[0]))
+		return 1;
+
+	/* the failures roll back and leave the target alone */
+	rb_node = rbs[3].node;
+	num = nalloc;
+	budget = SIZE / 2;
+	if (rb_clone(&rbs[3], &rbs[0], node_clone, node_destroy, NULL, NULL) ||
+	    nalloc != num || rbs[3].node != rb_node) {
+		printf("rb_clone: failure not rolled back\n");
+		return 1;
+	}
+	budget = SIZE / 2;
+	if (rb_clone_parallel(&rbs[3], &rbs[0], node_clone, node_destroy,
+			      NULL, NULL, 8) ||
+	    nalloc != num || rbs[3].node != rb_node) {
+		printf("rb_clone_parallel: failure not rolled back\n");
+		return 1;
+	}
+	budget = -1;
+
+	/* [beg, end): from the first of RANGE / 4 to the first of 3/4 */
+	for (beg = rb_first(&rbs[0]);
+	     rb_entry(beg, struct node, rb_node)->val < RANGE / 4;
+	     beg = rb_next(beg))
+		;
+	for (end = beg; end && rb_entry(end, struct node, rb_node)->val <
+			       RANGE * 3 / 4; end = rb_next(end))
+		;
+	if (!rb_clone_range(&rbs[3], beg, end, node_clone, node_destroy,
+			    NULL, NULL) || !rb_isvalid(&rbs[3])) {
+		printf("rb_clone_range failed\n");
+		return 1;
+	}
+	for (rb_src = beg, rb_node = rb_first(&rbs[3]); rb_src != end;
+	     rb_src = rb_next(rb_src), rb_node = rb_next(rb_node)) {
+		if (!rb_node || compare_link(rb_src, rb_node, NULL)) {
+			printf("rb_clone_range: content differs\n");
+			return 1;
+		}
+	}
+	if (rb_node) {
+		printf("rb_clone_range: extra nodes\n");
+		return 1;
+	}
+
+	rb_free(rbs, 4, node_destroy, NULL);
+	if (nalloc) {
+		printf("rb_free: %ld nodes left\n", nalloc);
+		return 1;
+	}
+
+	printf("clone ok\n");
+
+	return 0;
+}
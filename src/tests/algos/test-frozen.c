@@ -0,0 +1,127 @@
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <ycc/algos/rbtree.h>
+#include <ycc/algos/avltree.h>
+#include <ycc/algos/bstree.h>
+
+#include "test-tree.h"
+
+#define SIZE	100000
+#define RANGE	(SIZE * 2)
+#define THREADS	4
+
+struct node {
+	unsigned long key;
+	struct rb_node rb;
+	struct avl_node avl;
+	struct bst_node bst;
+};
+
+static struct node nodes[SIZE];
+
+TEST_TREE_COMPARE(rb, struct node, rb, unsigned long, key)
+TEST_TREE_COMPARE(avl, struct node, avl, unsigned long, key)
+TEST_TREE_COMPARE(bst, struct node, bst, unsigned long, key)
+
+/* a tree and its frozen array, searched alike */
+#define FROZEN_TEST(name)						\
+static unsigned long name##_key(const struct name##_node *node)		\
+{									\
+	return container_of(node, struct node, name)->key;		\
+}									\
+									\
+static struct name##_root name##_tree;					\
+static struct bst_frozen name##_frozen;					\
+									\
+/* the frozen answers MUST be the very nodes of the tree */		\
+static int name##_check(unsigned long seed)				\
+{									\
+	int i;								\
+									\
+	for (i = 0; i < SIZE; ++i) {					\
+		unsigned long key = (seed + i * 7919UL) % (RANGE + 2);	\
+									\
+		if (name##_frozen_lower_bound(&name##_frozen, key) !=	\
+		    name##_lower_bound(&name##_tree, name##_compare,	\
+				       &key) ||				\
+		    name##_frozen_find(&name##_frozen, key) !=		\
+		    name##_find(&name##_tree, name##_compare, &key)) {	\
+			printf(#name ": frozen search of %lu failed\n",	\
+			       key);					\
+			return 1;					\
+		}							\
+	}								\
+									\
+	return 0;							\
+}
+
+FROZEN_TEST(rb)
+FROZEN_TEST(avl)
+FROZEN_TEST(bst)
+
+static void *reader(void *arg)
+{
+	unsigned long seed = (unsigned long)arg;
+
+	if (rb_check(seed) || avl_check(seed) || bst_check(seed))
+		return (void*)1;
+
+	return NULL;
+}
+
+int main()
+{
+	int i;
+	void *ret;
+	pthread_t tids[THREADS];
+	struct bst_frozen empty;
+
+	srand( (unsigned int)time(NULL) );
+
+	/* an empty tree freezes to an empty array */
+	if (rb_freeze(&empty, &rb_tree, rb_key) ||
+	    rb_frozen_lower_bound(&empty, 0) || rb_frozen_find(&empty, 0)) {
+		printf("empty frozen failed\n");
+		return 1;
+	}
+	rb_frozen_destroy(&empty);
+
+	/* duplicates included */
+	for (i = 0; i < SIZE; ++i) {
+		nodes[i].key = rand() % RANGE;
+		rb_insert(&nodes[i].rb, &rb_tree, rb_compare_link, NULL);
+		avl_insert(&nodes[i].avl, &avl_tree, avl_compare_link, NULL);
+		bst_insert(&nodes[i].bst, &bst_tree, bst_compare_link, NULL);
+	}
+
+	if (rb_freeze(&rb_frozen, &rb_tree, rb_key) ||
+	    avl_freeze(&avl_frozen, &avl_tree, avl_key) ||
+	    bst_freeze(&bst_frozen, &bst_tree, bst_key)) {
+		printf("freeze failed\n");
+		return 1;
+	}
+
+	for (i = 0; i < THREADS; ++i) {
+		if (pthread_create(&tids[i], NULL, reader,
+				   (void*)(unsigned long)rand())) {
+			printf("pthread_create failed\n");
+			return 1;
+		}
+	}
+	for (i = 0; i < THREADS; ++i) {
+		pthread_join(tids[i], &ret);
+		if (ret)
+			return 1;
+	}
+
+	rb_frozen_destroy(&rb_frozen);
+	avl_frozen_destroy(&avl_frozen);
+	bst_frozen_destroy(&bst_frozen);
+
+	printf("frozen ok\n");
+
+	return 0;
+}
@@ -0,0 +1,126 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <ycc/algos/rbtree.h>
+#include <ycc/algos/avltree.h>
+#include <ycc/algos/treap.h>
+
+static size_t ncompare = 0;
+
+#define TEST_TREE_ON_COMPARE()	(++ncompare)
+#include "test-tree.h"
+
+#define SIZE	100000
+#define RANGE	(SIZE / 4)
+
+struct node {
+	int val;
+	int seq;
+	struct rb_node rb;
+	struct avl_node avl;
+	struct treap_node treap;
+};
+
+static struct node nodes[SIZE];
+
+TEST_TREE_COMPARE(rb, struct node, rb, int, val)
+TEST_TREE_COMPARE(avl, struct node, avl, int, val)
+TEST_TREE_COMPARE(treap, struct node, treap, int, val)
+
+/* hinted inserts of ascending, descending and random streams */
+#define HINT_TEST(name)							\
+/* sorted, and equal values in insert order */				\
+static int name##_check(struct name##_root *root, int num)		\
+{									\
+	int n = 0;							\
+	struct node *prev = NULL;					\
+	struct name##_node *node;					\
+									\
+	if (!name##_isvalid(root)) {					\
+		printf(#name "_isvalid failed !\n");			\
+		return 1;						\
+	}								\
+									\
+	for (node = name##_first(root); node; node = name##_next(node)) { \
+		struct node *p = container_of(node, struct node, name); \
+									\
+		if (prev && (p->val < prev->val ||			\
+			     (p->val == prev->val && p->seq < prev->seq))) { \
+			printf(#name ": %d(%d) after %d(%d)\n",		\
+			       p->val, p->seq, prev->val, prev->seq);	\
+			return 1;					\
+		}							\
+		prev = p;						\
+		++n;							\
+	}								\
+									\
+	if (n != num) {							\
+		printf(#name ": %d nodes, expect %d\n", n, num);	\
+		return 1;						\
+	}								\
+									\
+	return 0;							\
+}									\
+									\
+static int name##_test(void)						\
+{									\
+	int i;								\
+	struct name##_root root = { NULL };				\
+	struct name##_node *hint = NULL;				\
+									\
+	/* ascending, hinted with the last one */			\
+	ncompare = 0;							\
+	for (i = 0; i < SIZE; ++i) {					\
+		nodes[i].val = i / 2;					\
+		nodes[i].seq = i;					\
+		name##_insert_hint(&nodes[i].name, hint, &root,		\
+				   name##_compare_link, NULL);		\
+		hint = &nodes[i].name;					\
+	}								\
+	if (ncompare >= SIZE) {						\
+		printf(#name ": %zu compares for %d appends\n",		\
+		       ncompare, SIZE);					\
+		return 1;						\
+	}								\
+	if (name##_check(&root, SIZE))					\
+		return 1;						\
+									\
+	/* descending */						\
+	root.node = hint = NULL;					\
+	for (i = 0; i < SIZE; ++i) {					\
+		nodes[i].val = SIZE - i;				\
+		name##_insert_hint(&nodes[i].name, hint, &root,		\
+				   name##_compare_link, NULL);		\
+		hint = &nodes[i].name;					\
+	}								\
+	if (name##_check(&root, SIZE))					\
+		return 1;						\
+									\
+	/* random values and random hints */				\
+	root.node = NULL;						\
+	for (i = 0; i < SIZE; ++i) {					\
+		nodes[i].val = rand() % RANGE;				\
+		nodes[i].seq = i;					\
+		hint = i ? &nodes[rand() % i].name : NULL;		\
+		name##_insert_hint(&nodes[i].name, hint, &root,		\
+				   name##_compare_link, NULL);		\
+	}								\
+	return name##_check(&root, SIZE);				\
+}
+
+HINT_TEST(rb)
+HINT_TEST(avl)
+HINT_TEST(treap)
+
+int main()
+{
+	srand( (unsigned int)time(NULL) );
+
+	if (rb_test() || avl_test() || treap_test())
+		return 1;
+
+	printf("hint ok\n");
+
+	return 0;
+}
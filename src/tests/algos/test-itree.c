@@ -0,0 +1,107 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <ycc/algos/itree.h>
+
+#define SIZE	10000
+#define RANGE	100000
+
+struct node {
+	int alive;
+	struct itree_node itree_node;
+};
+
+static struct node nodes[SIZE];
+
+static int check(struct itree_root *itree, unsigned long start,
+		 unsigned long last)
+{
+	int i, found = 0, expect = 0;
+	unsigned long prev = 0;
+	struct itree_node *itree_node;
+
+	for (itree_node = itree_iter_first(itree, start, last); itree_node;
+	     itree_node = itree_iter_next(itree_node, start, last)) {
+		struct node *p = itree_entry(itree_node, struct node,
+					     itree_node);
+
+		if (!p->alive || itree_node->start > last ||
+		    itree_node->last < start || itree_node->start < prev) {
+			printf("error: [%lu, %lu] is not in [%lu, %lu]\n",
+			       itree_node->start, itree_node->last,
+			       start, last);
+			return 1;
+		}
+		prev = itree_node->start;
+		++found;
+	}
+
+	for (i = 0; i < SIZE; ++i) {
+		if (nodes[i].alive &&
+		    nodes[i].itree_node.start <= last &&
+		    nodes[i].itree_node.last >= start)
+			++expect;
+	}
+
+	if (found != expect) {
+		printf("error: [%lu, %lu] found %d, expect %d\n",
+		       start, last, found, expect);
+		return 1;
+	}
+
+	return 0;
+}
+
+int main()
+{
+	int i;
+	unsigned long start;
+
+	ITREE_DECLARE(itree);
+
+	srand( (unsigned int)time(NULL) );
+
+	for (i = 0; i < SIZE; ++i) {
+		start = rand() % RANGE;
+		nodes[i].itree_node.start = start;
+		nodes[i].itree_node.last = start + rand() % (RANGE / 100);
+		nodes[i].alive = 1;
+		itree_insert(&nodes[i].itree_node, &itree);
+	}
+
+	if (!itree_isvalid(&itree)) {
+		printf("itree_insert: itree_isvalid failed !\n");
+		return 1;
+	}
+
+	for (i = 0; i < SIZE; i += 2) {
+		itree_erase(&nodes[i].itree_node, &itree);
+		nodes[i].alive = 0;
+	}
+
+	if (!itree_isvalid(&itree)) {
+		printf("itree_erase: itree_isvalid failed !\n");
+		return 1;
+	}
+
+	for (i = 0; i < 1000; ++i) {
+		start = rand() % RANGE;
+		if (check(&itree, start, start + rand() % (RANGE / 50)))
+			return 1;
+	}
+	if (check(&itree, 0, 0) || check(&itree, 0, (unsigned long)-1))
+		return 1;
+
+	for (i = 1; i < SIZE; i += 2)
+		itree_erase(&nodes[i].itree_node, &itree);
+
+	if (!itree_empty(&itree)) {
+		printf("error: itree should be empty\n");
+		return 1;
+	}
+
+	printf("itree ok\n");
+
+	return 0;
+}
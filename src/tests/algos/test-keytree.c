@@ -0,0 +1,134 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <ycc/algos/avltree-key.h>
+#include <ycc/algos/rbtree-key.h>
+
+#define SIZE	(64*1024)
+#define RANGE	4096
+
+/* the keys of the linked nodes, the sorted copy is the reference */
+static int keys[SIZE];
+
+static int key_cmp(const void *a, const void *b)
+{
+	return *(const int*)a - *(const int*)b;
+}
+
+/* the first index of 'keys[0..num)' not less (greater) than 'key' */
+static int bound(int num, int key, bool upper)
+{
+	int lo = 0, hi = num;
+
+	while (lo < hi) {
+		int mid = (lo + hi) / 2;
+
+		if (keys[mid] < key || (upper && keys[mid] == key))
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	return lo;
+}
+
+/*
+ * Link SIZE random keys, one in four unique only, check the bounds and
+ * the equal nodes of every key against the sorted keys, then erase the
+ * odd keys.
+ */
+#define TEST_KEY_TREE(name, root_type, type, key_type,			\
+		      next, erase, isvalid)				\
+static bool test_##name(void)						\
+{									\
+	static type nodes[SIZE];					\
+	static bool linked[SIZE];					\
+	root_type root = { NULL, };					\
+	type *lb, *ub, *p;						\
+	int i, key, num = 0, l, u;					\
+									\
+	for (i = 0; i < SIZE; ++i) {					\
+		nodes[i].key = (key_type)(rand() % RANGE);		\
+		linked[i] = true;					\
+		if (i % 4)						\
+			name##_insert(&root, &nodes[i]);		\
+		else if (!name##_insert_unique(&root, &nodes[i])) {	\
+			if (!name##_find(&root, nodes[i].key))		\
+				return false;				\
+			linked[i] = false;				\
+			continue;					\
+		}							\
+		keys[num++] = (int)nodes[i].key;			\
+	}								\
+	if (!isvalid(&root))						\
+		return false;						\
+	qsort(keys, num, sizeof(keys[0]), key_cmp);			\
+									\
+	for (key = 0; key <= RANGE; ++key) {				\
+		l = bound(num, key, false);				\
+		u = bound(num, key, true);				\
+		lb = name##_lower_bound(&root, (key_type)key);		\
+		ub = name##_upper_bound(&root, (key_type)key);		\
+		if ((l < num ? !lb || (int)lb->key != keys[l] : !!lb) ||\
+		    (u < num ? !ub || (int)ub->key != keys[u] : !!ub) ||\
+		    !name##_find(&root, (key_type)key) != (l == u))	\
+			return false;					\
+									\
+		/* the equal ones are all between the bounds */	\
+		for (p = lb; p != ub && l < u; ++l)			\
+			p = container_of(next(&p->node), type, node);	\
+		if (p != ub || l != u)					\
+			return false;					\
+	}								\
+									\
+	for (i = 0; i < SIZE; ++i) {					\
+		if (linked[i] && (int)nodes[i].key % 2)			\
+			erase(&nodes[i].node, &root);			\
+	}								\
+	for (key = 1; key < RANGE; key += 2) {				\
+		if (name##_find(&root, (key_type)key))			\
+			return false;					\
+	}								\
+									\
+	return isvalid(&root);						\
+}
+
+TEST_KEY_TREE(rb_u32, struct rb_root, struct rb_u32_node, uint32_t,
+	      rb_next, rb_erase, rb_isvalid)
+TEST_KEY_TREE(rb_u64, struct rb_root, struct rb_u64_node, uint64_t,
+	      rb_next, rb_erase, rb_isvalid)
+TEST_KEY_TREE(rb_f64, struct rb_root, struct rb_f64_node, double,
+	      rb_next, rb_erase, rb_isvalid)
+TEST_KEY_TREE(avl_u32, struct avl_root, struct avl_u32_node, uint32_t,
+	      avl_next, avl_erase, avl_isvalid)
+TEST_KEY_TREE(avl_u64, struct avl_root, struct avl_u64_node, uint64_t,
+	      avl_next, avl_erase, avl_isvalid)
+TEST_KEY_TREE(avl_f64, struct avl_root, struct avl_f64_node, double,
+	      avl_next, avl_erase, avl_isvalid)
+
+int main()
+{
+	static const struct {
+		const char *name;
+		bool (*test)(void);
+	} tests[] = {
+		{ "rb_u32", test_rb_u32 }, { "rb_u64", test_rb_u64 },
+		{ "rb_f64", test_rb_f64 }, { "avl_u32", test_avl_u32 },
+		{ "avl_u64", test_avl_u64 }, { "avl_f64", test_avl_f64 },
+	};
+	size_t i;
+
+	srand( (unsigned int)time(NULL) );
+
+	for (i = 0; i < sizeof(tests) / sizeof(tests[0]); ++i) {
+		if (!tests[i].test()) {
+			printf("%s failed !\n", tests[i].name);
+			return 1;
+		}
+	}
+
+	printf("key trees ok\n");
+
+	return 0;
+}
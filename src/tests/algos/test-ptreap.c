@@ -0,0 +1,260 @@
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <ycc/algos/treap-persist.h>
+
+#define SIZE	10000
+#define SNAPS	10
+#define READERS	3
+#define WINDOW	256
+#define OPS	50000
+
+struct node {
+	int key;
+	struct ptreap_node node;
+};
+
+struct scan_state {
+	int next, num;
+	bool bad;
+};
+
+static struct ptreap_root pt;
+static long nalloc, nrelease;
+static int done;
+
+static int compare(const struct ptreap_node *node, const void *arg)
+{
+	int key = ptreap_entry(node, struct node, node)->key;
+
+	return key < *(const int*)arg ? -1 : key > *(const int*)arg;
+}
+
+static int compare_link(const struct ptreap_node *node1,
+			const struct ptreap_node *node2,
+			const void *arg)
+{
+	return compare(node1, &ptreap_entry(node2, struct node, node)->key);
+}
+
+static struct ptreap_node *copy(const struct ptreap_node *node,
+				const void *arg)
+{
+	struct node *p = malloc(sizeof(*p));
+
+	if (!p)
+		return NULL;
+	/* the payload only, 'node.ref' is counted by the readers */
+	p->key = ptreap_entry(node, struct node, node)->key;
+	__atomic_add_fetch(&nalloc, 1, __ATOMIC_RELAXED);
+
+	return &p->node;
+}
+
+static void release(struct ptreap_node *node, const void *arg)
+{
+	struct node *p = ptreap_entry(node, struct node, node);
+
+	/* a released node MUST be unreachable, poison it */
+	p->key = -1;
+	free(p);
+	__atomic_add_fetch(&nrelease, 1, __ATOMIC_RELAXED);
+}
+
+static int insert(int key)
+{
+	struct node *p = malloc(sizeof(*p));
+
+	p->key = key;
+	__atomic_add_fetch(&nalloc, 1, __ATOMIC_RELAXED);
+	if (ptreap_insert(&pt, &p->node, compare_link, NULL)) {
+		free(p);
+		return -1;
+	}
+
+	return 0;
+}
+
+/* the keys in a snapshot MUST run from st->next up by one */
+static bool scan_visit(const struct ptreap_node *node, const void *arg)
+{
+	struct scan_state *st = (struct scan_state*)arg;
+
+	if (ptreap_entry(node, struct node, node)->key != st->next++)
+		st->bad = true;
+	++st->num;
+
+	return !st->bad;
+}
+
+static int test_snapshots(void)
+{
+	static int keys[SIZE];
+	struct ptreap_snap snaps[SNAPS];
+	struct scan_state st;
+	int i, k, key;
+
+	ptreap_init(&pt, copy, release, NULL);
+
+	/* snapshot k holds [0, k * SIZE / SNAPS) */
+	for (i = 0, k = 0; i < SIZE; ++i) {
+		if (i == k * SIZE / SNAPS)
+			ptreap_snapshot(&pt, &snaps[k++]);
+		if (insert(i)) {
+			printf("ptreap_insert failed\n");
+			return 1;
+		}
+	}
+
+	/* erase all but the last one in random order, unseen by snapshots */
+	for (i = 0; i < SIZE - 1; ++i)
+		keys[i] = i;
+	for (i = SIZE - 2; i > 0; --i) {
+		k = rand() % (i + 1);
+		key = keys[i];
+		keys[i] = keys[k];
+		keys[k] = key;
+	}
+	for (i = 0; i < SIZE - 1; ++i) {
+		if (ptreap_erase(&pt, compare, &keys[i]) ||
+		    !ptreap_erase(&pt, compare, &keys[i]) || errno != ENOENT) {
+			printf("ptreap_erase %d failed\n", keys[i]);
+			return 1;
+		}
+	}
+
+	for (k = 0; k < SNAPS; ++k) {
+		st.next = 0;
+		st.num = 0;
+		st.bad = false;
+		if (!ptreap_isvalid(&snaps[k], compare_link, NULL) ||
+		    !ptreap_visit_cond(&snaps[k], scan_visit, &st) ||
+		    st.num != k * SIZE / SNAPS) {
+			printf("snapshot %d: %d nodes, expected %d\n",
+			       k, st.num, k * SIZE / SNAPS);
+			return 1;
+		}
+
+		key = k * SIZE / SNAPS / 2;
+		st.next = key;
+		st.num = 0;
+		if (k && (!ptreap_visit_from(&snaps[k], compare, &key,
+					     scan_visit, &st) ||
+			  st.num != k * SIZE / SNAPS - key ||
+			  !ptreap_find(&snaps[k], compare, &key))) {
+			printf("snapshot %d: visit from %d failed\n", k, key);
+			return 1;
+		}
+		ptreap_put_snapshot(&pt, &snaps[k]);
+	}
+
+	ptreap_snapshot(&pt, &snaps[0]);
+	key = SIZE - 1;
+	if (!snaps[0].node || snaps[0].node->left || snaps[0].node->right ||
+	    ptreap_find(&snaps[0], compare, &key) != snaps[0].node) {
+		printf("ptreap: the last key is lost\n");
+		return 1;
+	}
+	ptreap_put_snapshot(&pt, &snaps[0]);
+
+	ptreap_destroy(&pt);
+	if (nalloc != nrelease) {
+		printf("ptreap: %ld allocated, %ld released\n",
+		       nalloc, nrelease);
+		return 1;
+	}
+
+	return 0;
+}
+
+/* the writer slides a window of keys, every snapshot holds a whole one */
+static void *reader(void *arg)
+{
+	struct ptreap_snap snap;
+	struct ptreap_node *first;
+	struct scan_state st;
+	long scans = 0;
+	int key;
+
+	while (!__atomic_load_n(&done, __ATOMIC_ACQUIRE) || !scans) {
+		ptreap_snapshot(&pt, &snap);
+		first = ptreap_lower_bound(&snap, compare, &(int){ 0 });
+		key = first ? ptreap_entry(first, struct node, node)->key : 0;
+		st.next = key;
+		st.num = 0;
+		st.bad = false;
+		/* one more between the insert and the erase */
+		if (!ptreap_visit_cond(&snap, scan_visit, &st) ||
+		    (key && st.num != WINDOW && st.num != WINDOW + 1)) {
+			printf("ptreap: snapshot of %d nodes from %d\n",
+			       st.num, key);
+			return (void*)1;
+		}
+		ptreap_put_snapshot(&pt, &snap);
+		++scans;
+	}
+
+	return NULL;
+}
+
+static int test_readers(void)
+{
+	pthread_t tids[READERS];
+	void *ret;
+	int i, key, err = 0;
+
+	nalloc = nrelease = 0;
+	ptreap_init(&pt, copy, release, NULL);
+
+	for (i = 0; i < READERS; ++i) {
+		if (pthread_create(&tids[i], NULL, reader, NULL)) {
+			printf("pthread_create failed\n");
+			return 1;
+		}
+	}
+
+	for (i = 0; i < OPS; ++i) {
+		if (insert(i)) {
+			printf("ptreap_insert failed\n");
+			err = 1;
+			break;
+		}
+		key = i - WINDOW;
+		if (i >= WINDOW && ptreap_erase(&pt, compare, &key)) {
+			printf("ptreap_erase %d failed\n", key);
+			err = 1;
+			break;
+		}
+	}
+
+	__atomic_store_n(&done, 1, __ATOMIC_RELEASE);
+	for (i = 0; i < READERS; ++i) {
+		pthread_join(tids[i], &ret);
+		if (ret)
+			err = 1;
+	}
+
+	ptreap_destroy(&pt);
+	if (!err && nalloc != nrelease) {
+		printf("ptreap: %ld allocated, %ld released\n",
+		       nalloc, nrelease);
+		err = 1;
+	}
+
+	return err;
+}
+
+int main()
+{
+	srand( (unsigned int)time(NULL) );
+
+	if (test_snapshots() || test_readers())
+		return 1;
+
+	printf("ptreap ok\n");
+
+	return 0;
+}
@@ -0,0 +1,185 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <ycc/algos/rbtree-hash.h>
+
+#define SIZE	100000
+#define RANGE	(SIZE * 2)
+
+struct node {
+	int val;
+	struct rb_node rb_node;
+};
+
+static int compare(const struct rb_node *rb_node, const void *arg)
+{
+	int val = rb_entry(rb_node, struct node, rb_node)->val;
+
+	return val < *(const int*)arg ? -1 : val > *(const int*)arg;
+}
+
+static int compare_link(const struct rb_node *rb_node1,
+			const struct rb_node *rb_node2,
+			const void *arg)
+{
+	int val = rb_entry(rb_node2, struct node, rb_node)->val;
+
+	return compare(rb_node1, &val);
+}
+
+static uint64_t hash(const struct rbh_root *rbh, const struct rb_node *rb_node)
+{
+	const struct node *p = rb_entry(rb_node, struct node, rb_node);
+
+	return rbh_hash(rbh, &p->val, sizeof(p->val));
+}
+
+/* every key collides, the buckets are still trees */
+static uint64_t hash_flood(const struct rbh_root *rbh,
+			   const struct rb_node *rb_node)
+{
+	return 0;
+}
+
+static uint64_t hash_key(const struct rbh_root *rbh, int val)
+{
+	return rbh->hash == hash ? rbh_hash(rbh, &val, sizeof(val)) : 0;
+}
+
+static void destroy(struct rb_node *rb_node, const void *arg)
+{
+	free(rb_entry(rb_node, struct node, rb_node));
+}
+
+static bool visit(const struct rb_node *rb_node, const void *arg)
+{
+	++*(size_t*)arg;
+	return true;
+}
+
+static int test_siphash(void)
+{
+	/* the vectors of the SipHash paper, key 00..0f and data 00.. */
+	static const uint64_t expect[] = {
+		0x726fdb47dd0e0e31ULL, 0x74f839c593dc67fdULL,
+	};
+	const uint64_t seed[2] = {
+		0x0706050403020100ULL, 0x0f0e0d0c0b0a0908ULL
+	};
+	unsigned char data[16];
+	struct rbh_root rbh;
+	size_t i;
+
+	for (i = 0; i < sizeof(data); ++i)
+		data[i] = (unsigned char)i;
+
+	rbh_set_seed(&rbh, seed);
+	for (i = 0; i < sizeof(expect) / sizeof(expect[0]); ++i) {
+		if (rbh_hash(&rbh, data, i) != expect[i])
+			break;
+	}
+	if (i < sizeof(expect) / sizeof(expect[0]) ||
+	    rbh_hash(&rbh, data, 15) != 0xa129ca6149be45e5ULL) {
+		printf("rbh_hash: SipHash-2-4 vector failed\n");
+		return 1;
+	}
+
+	return 0;
+}
+
+static int test_table(uint64_t (*h)(const struct rbh_root *rbh,
+				    const struct rb_node *rb_node),
+		      int size)
+{
+	static struct node *nodes[RANGE];
+	struct rbh_root rbh;
+	struct rb_node *rb_node;
+	size_t num = 0, peak;
+	int i, val;
+
+	if (rbh_init(&rbh, 0, h, compare_link, NULL)) {
+		printf("rbh_init failed\n");
+		return 1;
+	}
+
+	for (i = 0; i < size; ++i) {
+		struct node *p = malloc(sizeof(*p));
+
+		p->val = val = rand() % RANGE;
+		if (!rbh_insert_unique(&rbh, &p->rb_node)) {
+			free(p);
+			if (!nodes[val]) {
+				printf("rbh_insert_unique %d failed\n", val);
+				return 1;
+			}
+			continue;
+		}
+		nodes[val] = p;
+		++num;
+		if (!(i % 1024) && !rbh_isvalid(&rbh)) {
+			printf("rbh_isvalid on insert failed !\n");
+			return 1;
+		}
+	}
+	peak = rbh.num;
+	if (rbh_count(&rbh) != num || !rbh_isvalid(&rbh) ||
+	    peak * 4 < num) {
+		printf("rbh: %zu nodes in %zu buckets\n", num, peak);
+		return 1;
+	}
+
+	for (val = 0; val < RANGE; ++val) {
+		rb_node = rbh_find(&rbh, hash_key(&rbh, val), compare, &val);
+		if (rb_node != (nodes[val] ? &nodes[val]->rb_node : NULL)) {
+			printf("rbh_find %d failed\n", val);
+			return 1;
+		}
+	}
+
+	/* erase all but a few, the table shrinks step by step */
+	for (val = 0; val < RANGE; ++val) {
+		if (!nodes[val] || num <= 100)
+			continue;
+		rbh_erase(&rbh, &nodes[val]->rb_node);
+		free(nodes[val]);
+		nodes[val] = NULL;
+		--num;
+		if (!(val % 1024) && !rbh_isvalid(&rbh)) {
+			printf("rbh_isvalid on erase failed !\n");
+			return 1;
+		}
+	}
+	if (rbh_count(&rbh) != num || !rbh_isvalid(&rbh) ||
+	    (h == hash && rbh.num >= peak)) {
+		printf("rbh: %zu nodes in %zu buckets of %zu\n",
+		       num, rbh.num, peak);
+		return 1;
+	}
+
+	num = 0;
+	rbh_visit_cond(&rbh, visit, &num);
+	if (num != rbh_count(&rbh)) {
+		printf("rbh_visit_cond: %zu of %zu\n", num, rbh_count(&rbh));
+		return 1;
+	}
+
+	rbh_destroy(&rbh, destroy, NULL);
+	for (val = 0; val < RANGE; ++val)
+		nodes[val] = NULL;
+
+	return 0;
+}
+
+int main()
+{
+	srand( (unsigned int)time(NULL) );
+
+	if (test_siphash() || test_table(hash, SIZE) ||
+	    test_table(hash_flood, SIZE / 10))
+		return 1;
+
+	printf("rbhash ok\n");
+
+	return 0;
+}
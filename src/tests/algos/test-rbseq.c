@@ -0,0 +1,170 @@
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <ycc/algos/rbtree-seq.h>
+
+#define READERS	4
+#define RANGE	4096
+#define WRITES	200000
+#define READS	400000
+
+/* even keys stay in the tree, the writer churns the odd ones */
+struct node {
+	int key;
+	struct rb_node rb;
+	struct epoch_entry entry;
+};
+
+static RB_SEQ_DECLARE(root);
+static struct epoch_domain domain;
+static long nalloc, nrelease;
+
+static int compare(const struct rb_node *node, const void *arg)
+{
+	int key = rb_entry(node, struct node, rb)->key;
+
+	return key < *(const int*)arg ? -1 : key > *(const int*)arg;
+}
+
+static int compare_link(const struct rb_node *node1,
+			const struct rb_node *node2,
+			const void *arg)
+{
+	return compare(node1, &rb_entry(node2, struct node, rb)->key);
+}
+
+static void release(struct epoch_entry *entry)
+{
+	struct node *p = container_of(entry, struct node, entry);
+
+	/* a reader reaching it afterwards sees a wrong key */
+	p->key = -1;
+	free(p);
+	__atomic_add_fetch(&nrelease, 1, __ATOMIC_RELAXED);
+}
+
+static struct node *alloc(int key)
+{
+	struct node *p = malloc(sizeof(*p));
+
+	p->key = key;
+	__atomic_add_fetch(&nalloc, 1, __ATOMIC_RELAXED);
+
+	return p;
+}
+
+static void *writer(void *arg)
+{
+	unsigned int seed = (unsigned int)(unsigned long)arg;
+	struct epoch_thread *thr = epoch_register(&domain);
+	struct rb_node *node;
+	struct node *p;
+	int i, key;
+
+	for (i = 0; i < WRITES; ++i) {
+		key = rand_r(&seed) % (RANGE / 2) * 2 + 1;
+
+		/* the writer reads its own tree without epoch */
+		rb_seq_write_lock(&root);
+		node = rb_find(&root.rb, compare, &key);
+		if (node)
+			rb_seq_erase(node, &root);
+		else
+			rb_seq_insert(&alloc(key)->rb, &root, compare_link,
+				      NULL);
+		rb_seq_write_unlock(&root);
+
+		if (node) {
+			p = rb_entry(node, struct node, rb);
+			epoch_enter(thr);
+			epoch_retire(&domain, &p->entry, release);
+			epoch_exit(thr);
+		}
+	}
+
+	epoch_unregister(thr);
+
+	return NULL;
+}
+
+static void *reader(void *arg)
+{
+	unsigned int seed = (unsigned int)(unsigned long)arg;
+	struct epoch_thread *thr = epoch_register(&domain);
+	struct rb_node *node;
+	int i, key, found;
+
+	for (i = 0; i < READS; ++i) {
+		key = rand_r(&seed) % (RANGE + 2) - 1;
+
+		epoch_enter(thr);
+		node = (key & 1) ? rb_seq_lower_bound(&root, compare, &key) :
+				   rb_seq_find(&root, compare, &key);
+		found = node ? rb_entry(node, struct node, rb)->key : -2;
+		epoch_exit(thr);
+
+		/* an odd key is churned, the next even one is always there */
+		if ((!(key & 1) && key >= 0 && key < RANGE && found != key) ||
+		    (!(key & 1) && (key < 0 || key >= RANGE) && node) ||
+		    ((key & 1) && key < RANGE - 1 && found != key &&
+		     found != key + 1)) {
+			printf("key %d: found %d\n", key, found);
+			return (void*)1;
+		}
+	}
+
+	epoch_unregister(thr);
+
+	return NULL;
+}
+
+int main()
+{
+	int i;
+	void *ret;
+	pthread_t tids[READERS + 1];
+	struct rb_node *node;
+
+	srand( (unsigned int)time(NULL) );
+
+	epoch_init(&domain);
+	for (i = 0; i < RANGE; i += 2) {
+		rb_seq_write_lock(&root);
+		rb_seq_insert(&alloc(i)->rb, &root, compare_link, NULL);
+		rb_seq_write_unlock(&root);
+	}
+
+	for (i = 0; i <= READERS; ++i) {
+		if (pthread_create(&tids[i], NULL, i ? reader : writer,
+				   (void*)(unsigned long)rand())) {
+			printf("pthread_create failed\n");
+			return 1;
+		}
+	}
+	for (i = 0; i <= READERS; ++i) {
+		pthread_join(tids[i], &ret);
+		if (ret)
+			return 1;
+	}
+
+	if (!rb_isvalid(&root.rb)) {
+		printf("rb_isvalid failed !\n");
+		return 1;
+	}
+
+	while ((node = rb_first(&root.rb))) {
+		rb_erase(node, &root.rb);
+		release(&rb_entry(node, struct node, rb)->entry);
+	}
+	epoch_destroy(&domain);
+	if (nrelease != nalloc) {
+		printf("%ld released, %ld allocated\n", nrelease, nalloc);
+		return 1;
+	}
+
+	printf("rbseq ok\n");
+
+	return 0;
+}
@@ -0,0 +1,253 @@
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <ycc/algos/rbtree-shard.h>
+
+#define SHARDS	8
+#define SIZE	20000
+#define THREADS	4
+#define OPS	100000
+#define RANGE	8192
+#define WINDOW	512
+
+struct node {
+	unsigned long key;
+	struct rb_node rb;
+};
+
+static struct rbs_root rbs;
+
+/* per key: successful inserts minus successful erases, 0 or 1 at last */
+static long balance[RANGE];
+
+struct scan_state {
+	unsigned long lo, hi, last;
+	size_t num;
+	bool bad;
+};
+
+static unsigned long node_key(const struct rb_node *rb)
+{
+	return rb_entry(rb, struct node, rb)->key;
+}
+
+static void node_destroy(struct rb_node *rb, const void *arg)
+{
+	free(rb_entry(rb, struct node, rb));
+}
+
+static bool scan_visit(const struct rb_node *rb, const void *arg)
+{
+	struct scan_state *st = (struct scan_state*)arg;
+	unsigned long key = node_key(rb);
+
+	if (key < st->lo || key > st->hi || (st->num && key < st->last))
+		st->bad = true;
+	st->last = key;
+	++st->num;
+
+	return true;
+}
+
+static bool scan_check(unsigned long lo, unsigned long hi, size_t *num)
+{
+	struct scan_state st = { lo, hi, 0, 0, false };
+
+	rbs_scan(&rbs, lo, hi, scan_visit, &st);
+	if (st.bad) {
+		printf("rbs_scan [%lu, %lu] out of order\n", lo, hi);
+		return false;
+	}
+	if (num)
+		*num = st.num;
+
+	return true;
+}
+
+/* the keys crowd into a window sliding up, the shards have to follow */
+static void *worker(void *arg)
+{
+	unsigned int seed = (unsigned int)(unsigned long)arg;
+	struct rb_node *rb;
+	struct node *p;
+	unsigned long key, base;
+	int i;
+
+	for (i = 0; i < OPS; ++i) {
+		base = (unsigned long)i * (RANGE - WINDOW) / OPS;
+		key = base + rand_r(&seed) % WINDOW;
+
+		switch (rand_r(&seed) % 4) {
+		case 0:
+		case 1:
+			p = malloc(sizeof(*p));
+			p->key = key;
+			if (!rbs_insert_unique(&rbs, &p->rb)) {
+				free(p);
+				break;
+			}
+			__atomic_add_fetch(&balance[key], 1, __ATOMIC_RELAXED);
+			break;
+		case 2:
+			rb = rbs_erase_key(&rbs, key);
+			if (rb) {
+				if (node_key(rb) != key) {
+					printf("rbs_erase_key %lu failed\n", key);
+					return (void*)1;
+				}
+				free(rb_entry(rb, struct node, rb));
+				__atomic_sub_fetch(&balance[key], 1,
+						   __ATOMIC_RELAXED);
+			}
+			break;
+		default:
+			if (!scan_check(key, key + WINDOW / 4, NULL))
+				return (void*)1;
+			break;
+		}
+	}
+
+	return NULL;
+}
+
+static int test_single(void)
+{
+	static unsigned long keys[SIZE];
+	struct node *p;
+	size_t i, num, max = 0;
+	unsigned long lo, hi;
+
+	if (rbs_init(&rbs, SHARDS, node_key, 0, RANGE * 1024UL)) {
+		printf("rbs_init failed\n");
+		return 1;
+	}
+
+	/* all in the range of the first shard, with duplicates */
+	for (i = 0; i < SIZE; ++i) {
+		p = malloc(sizeof(*p));
+		p->key = keys[i] = rand() % (SIZE / 2);
+		rbs_insert(&rbs, &p->rb);
+	}
+	if (!rbs_isvalid(&rbs) || rbs_count(&rbs) != SIZE) {
+		printf("rbs_insert failed\n");
+		return 1;
+	}
+
+	rbs_rebalance(&rbs);
+	if (!rbs_isvalid(&rbs)) {
+		printf("rbs_rebalance failed\n");
+		return 1;
+	}
+	for (i = 0; i < SHARDS; ++i) {
+		if (rbs.shards[i].count > max)
+			max = rbs.shards[i].count;
+	}
+	if (max > SIZE / 2) {
+		printf("rbs_rebalance: a shard of %zu in %d\n", max, SIZE);
+		return 1;
+	}
+
+	for (i = 0; i < 100; ++i) {
+		size_t k, expect = 0;
+
+		lo = rand() % (SIZE / 2);
+		hi = lo + rand() % (SIZE / 8);
+		for (k = 0; k < SIZE; ++k)
+			expect += keys[k] >= lo && keys[k] <= hi;
+		if (!scan_check(lo, hi, &num))
+			return 1;
+		if (num != expect) {
+			printf("rbs_scan [%lu, %lu]: %zu of %zu\n",
+			       lo, hi, num, expect);
+			return 1;
+		}
+		if (!rbs_find(&rbs, keys[rand() % SIZE])) {
+			printf("rbs_find failed\n");
+			return 1;
+		}
+	}
+
+	for (i = 0; i < SIZE; ++i) {
+		struct rb_node *rb = rbs_erase_key(&rbs, keys[i]);
+
+		if (!rb || node_key(rb) != keys[i]) {
+			printf("rbs_erase_key %lu failed\n", keys[i]);
+			return 1;
+		}
+		node_destroy(rb, NULL);
+	}
+	if (!rbs_isvalid(&rbs) || rbs_count(&rbs)) {
+		printf("rbs_erase_key failed\n");
+		return 1;
+	}
+
+	rbs_destroy(&rbs, node_destroy, NULL);
+
+	return 0;
+}
+
+static int test_threads(void)
+{
+	int i;
+	size_t num = 0;
+	unsigned long key;
+	void *ret;
+	pthread_t tids[THREADS];
+
+	if (rbs_init(&rbs, SHARDS, node_key, 0, RANGE / 4)) {
+		printf("rbs_init failed\n");
+		return 1;
+	}
+
+	for (i = 0; i < THREADS; ++i) {
+		if (pthread_create(&tids[i], NULL, worker,
+				   (void*)(unsigned long)rand())) {
+			printf("pthread_create failed\n");
+			return 1;
+		}
+	}
+	for (i = 0; i < THREADS; ++i) {
+		pthread_join(tids[i], &ret);
+		if (ret)
+			return 1;
+	}
+
+	if (!rbs_isvalid(&rbs)) {
+		printf("rbs_isvalid failed !\n");
+		return 1;
+	}
+
+	for (key = 0; key < RANGE; ++key) {
+		bool present = rbs_find(&rbs, key) != NULL;
+
+		if (balance[key] != present) {
+			printf("key %lu: balance %ld, present %d\n",
+			       key, balance[key], present);
+			return 1;
+		}
+		num += present;
+	}
+	if (rbs_count(&rbs) != num || !scan_check(0, ~0UL, &num) ||
+	    num != rbs_count(&rbs)) {
+		printf("rbs: %zu nodes, %zu scanned\n", rbs_count(&rbs), num);
+		return 1;
+	}
+
+	rbs_destroy(&rbs, node_destroy, NULL);
+
+	return 0;
+}
+
+int main()
+{
+	srand( (unsigned int)time(NULL) );
+
+	if (test_single() || test_threads())
+		return 1;
+
+	printf("rbshard ok\n");
+
+	return 0;
+}
@@ -0,0 +1,163 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <ycc/algos/rbtree-str.h>
+
+#define SIZE	(16*1024)
+#define PROBES	4096
+#define MAXLEN	20
+
+/* keys of 'a', 'b' and '\0' tie on the prefix often, and hold '\0' */
+struct key {
+	char buf[MAXLEN];
+	size_t len;
+};
+
+static struct key keys[SIZE], probes[PROBES];
+static struct rb_str_node nodes[SIZE];
+
+static void key_rand(struct key *k)
+{
+	static const char alpha[] = { 'a', 'b', '\0' };
+	size_t i;
+
+	k->len = rand() % (MAXLEN + 1);
+	/* long common runs make the prefixes tie */
+	for (i = 0; i < k->len; ++i)
+		k->buf[i] = i < 10 && rand() % 4 ? 'a' : alpha[rand() % 3];
+}
+
+/* the order of rb_str_cmp spelt out */
+static int key_cmp(const char *k1, size_t len1, const char *k2, size_t len2)
+{
+	size_t len = len1 < len2 ? len1 : len2;
+	int icmp = memcmp(k1, k2, len);
+
+	if (icmp)
+		return icmp;
+
+	return len1 < len2 ? -1 : len1 > len2;
+}
+
+static int sign(int v)
+{
+	return v < 0 ? -1 : v > 0;
+}
+
+int main()
+{
+	struct rb_root rb = { NULL, };
+	struct rb_str_node *node, *lb, *ub, *prev;
+	int i, j, num = 0, less, less_equal, cnt;
+
+	srand( (unsigned int)time(NULL) );
+
+	for (i = 0; i < SIZE; ++i) {
+		key_rand(&keys[i]);
+		rb_str_node_init(&nodes[i], keys[i].buf, keys[i].len);
+		if (i % 2)
+			rb_str_insert(&rb, &nodes[i]);
+		else if (!rb_str_insert_unique(&rb, &nodes[i])) {
+			nodes[i].key = NULL;
+			continue;
+		}
+		++num;
+	}
+	for (i = 0; i < PROBES; ++i)
+		key_rand(&probes[i]);
+
+	if (!rb_isvalid(&rb)) {
+		printf("rb_str_insert: rb_isvalid failed !\n");
+		return 1;
+	}
+
+	/* rb_str_cmp agrees with memcmp on the whole keys */
+	for (i = 0; i < PROBES; ++i) {
+		struct rb_str_node a, b;
+
+		j = rand() % SIZE;
+		rb_str_node_init(&a, probes[i].buf, probes[i].len);
+		rb_str_node_init(&b, keys[j].buf, keys[j].len);
+		if (sign(rb_str_cmp(&a, &b)) !=
+		    sign(key_cmp(probes[i].buf, probes[i].len,
+				 keys[j].buf, keys[j].len))) {
+			printf("error: rb_str_cmp of probe %d\n", i);
+			return 1;
+		}
+	}
+
+	/* inorder by key */
+	cnt = 0;
+	prev = NULL;
+	for (node = rb_entry(rb_first(&rb), struct rb_str_node, node); node;
+	     node = rb_entry(rb_next(&node->node), struct rb_str_node, node)) {
+		if (prev && key_cmp(prev->key, prev->len,
+				    node->key, node->len) > 0) {
+			printf("error: rb_str order\n");
+			return 1;
+		}
+		prev = node;
+		++cnt;
+	}
+	if (cnt != num) {
+		printf("error: %d nodes linked of %d\n", cnt, num);
+		return 1;
+	}
+
+	/* the bounds fall after the nodes less (not greater) than a probe */
+	for (i = 0; i < PROBES; ++i) {
+		const struct key *p = &probes[i];
+		int icmp;
+
+		less = less_equal = 0;
+		for (j = 0; j < SIZE; ++j) {
+			if (!nodes[j].key)
+				continue;
+			icmp = key_cmp(nodes[j].key, nodes[j].len,
+				       p->buf, p->len);
+
+			less += icmp < 0;
+			less_equal += icmp <= 0;
+		}
+
+		lb = rb_str_lower_bound(&rb, p->buf, p->len);
+		ub = rb_str_upper_bound(&rb, p->buf, p->len);
+		node = rb_str_find(&rb, p->buf, p->len);
+		for (cnt = 0, prev = lb; prev != ub; ++cnt)
+			prev = rb_entry(rb_next(&prev->node),
+					struct rb_str_node, node);
+		if (cnt != less_equal - less || !node != (cnt == 0) ||
+		    (node && node != lb) ||
+		    (lb && rb_prev(&lb->node) &&
+		     rb_str_cmp(rb_entry(rb_prev(&lb->node),
+					 struct rb_str_node, node), lb) >= 0)) {
+			printf("error: rb_str bounds of probe %d\n", i);
+			return 1;
+		}
+	}
+
+	/* erase the keys under 4 bytes */
+	for (i = 0; i < SIZE; ++i) {
+		if (nodes[i].key && nodes[i].len < 4) {
+			rb_erase(&nodes[i].node, &rb);
+			--num;
+		}
+	}
+	for (i = 0; i < SIZE; ++i) {
+		node = rb_str_find(&rb, keys[i].buf, keys[i].len);
+		if ((keys[i].len < 4) != !node) {
+			printf("error: rb_str_find after erase\n");
+			return 1;
+		}
+	}
+	if (!rb_isvalid(&rb)) {
+		printf("rb_erase: rb_isvalid failed !\n");
+		return 1;
+	}
+
+	printf("rb_str ok, %d nodes\n", num);
+
+	return 0;
+}
@@ -95,5 +95,168 @@ int main()
 	}
 
 
+	/* build from sorted nodes */
+	{
+		struct rb_node **nodes = malloc(sizeof(*nodes) * 1000);
+
+		if (!nodes)
+			return 1;
+
+		for (i = 0; i < 1000; ++i)
+			nodes[i] = &node_alloc(i)->rb_node;
+		rb_build_sorted(&rb, nodes, 1000);
+		free(nodes);
+
+		if (!rb_isvalid(&rb)) {
+			printf("rb_build_sorted: rb_isvalid failed !\n");
+			return 1;
+		}
+
+		i = 0;
+		rb_node = rb_first(&rb);
+		while (rb_node) {
+			p = rb_entry(rb_node, struct node, rb_node);
+			if (p->val != i++)
+				printf("error: rb_build_sorted order\n");
+			rb_node = rb_next(rb_node);
+		}
+		printf("4 node_cnt: %d\n", node_cnt);
+	}
+
+#ifdef	BSTLINK_SIZE
+	/* order statistics */
+	{
+		int lo = 250, hi = 750;
+
+		for (i = 0; i < 1000; ++i) {
+			rb_node = rb_select(&rb, i);
+			if (!rb_node || rb_rank(rb_node) != (size_t)i ||
+			    rb_entry(rb_node, struct node, rb_node)->val != i)
+				printf("error: rb_select/rb_rank %d\n", i);
+		}
+		if (rb_select(&rb, 1000))
+			printf("error: rb_select out of range\n");
+		if (rb_count_range(&rb, compare, &lo, &hi) != 500 ||
+		    rb_count_range(&rb, compare, &hi, &lo) != 0)
+			printf("error: rb_count_range\n");
+
+		/* erase the odd ones and take them back */
+		for (i = 1; i < 1000; i += 2) {
+			rb_node = rb_select(&rb, (i + 1) / 2);
+			rb_erase(rb_node, &rb);
+			rb_insert(rb_node, &rb, compare_link, NULL);
+			rb_erase(rb_node, &rb);
+			destroy(rb_node, NULL);
+		}
+		if (!rb_isvalid(&rb) ||
+		    rb_count_range(&rb, compare, &lo, &hi) != 250 ||
+		    rb_entry(rb_select(&rb, 100), struct node,
+			     rb_node)->val != 200)
+			printf("error: rb order statistics after erase\n");
+
+		for (i = 1; i < 1000; i += 2) {
+			p = node_alloc(i);
+			rb_insert(&p->rb_node, &rb, compare_link, NULL);
+		}
+	}
+#endif
+
+	/* split and join */
+	{
+		struct rb_root left, right;
+
+		i = 500;
+		rb_split(&rb, compare, &i, &left, &right);
+		if (!rb_isvalid(&left) || !rb_isvalid(&right)) {
+			printf("rb_split: rb_isvalid failed !\n");
+			return 1;
+		}
+
+		rb_node = rb_last(&left);
+		if (rb_entry(rb_node, struct node, rb_node)->val != 499)
+			printf("error: rb_split left\n");
+		rb_node = rb_first(&right);
+		if (rb_entry(rb_node, struct node, rb_node)->val != 500)
+			printf("error: rb_split right\n");
+
+		rb_erase(rb_node, &right);
+		rb_join(&rb, &left, rb_node, &right);
+		if (!rb_isvalid(&rb) ||
+		    rb_count(&rb, compare, &i) != 1) {
+			printf("rb_join failed !\n");
+			return 1;
+		}
+
+		rb_clear(&rb, destroy, NULL);
+		printf("5 node_cnt: %d\n", node_cnt);
+	}
+
+	/* range erase, by nodes and by equal keys */
+	{
+		static struct rb_node *erased[64*1024];
+		struct rb_root range;
+		struct rb_node *beg, *end;
+		int lo, hi, n, cnt;
+
+		for (i = 0; i < 64*1024; ++i) {
+			p = node_alloc(rand() % 4096);
+			rb_insert(&p->rb_node, &rb, compare_link, NULL);
+		}
+
+		for (n = 0; n < 256; ++n) {
+			lo = rand() % 4096;
+			hi = lo + rand() % 256;
+			beg = rb_lower_bound(&rb, compare, &lo);
+			end = rb_lower_bound(&rb, compare, &hi);
+			if (beg == end)
+				beg = end = NULL;
+			if (n % 2) {
+				rb_detach_range(beg, end, &rb, &range);
+				if (!rb_isvalid(&range) ||
+				    rb_first(&range) != beg) {
+					printf("rb_detach_range failed !\n");
+					return 1;
+				}
+				rb_clear(&range, destroy, NULL);
+			} else {
+				for (cnt = 0, rb_node = beg; rb_node != end;
+				     rb_node = rb_next(rb_node))
+					erased[cnt++] = rb_node;
+				rb_erase_range(beg, end, &rb);
+				while (cnt)
+					destroy(erased[--cnt], NULL);
+			}
+			if (!rb_isvalid(&rb) ||
+			    (lo < hi && rb_find(&rb, compare, &lo))) {
+				printf("rb_erase_range [%d, %d) failed !\n",
+				       lo, hi);
+				return 1;
+			}
+
+			lo = rand() % 4096;
+			rb_erase_equal(&rb, compare, destroy, &lo, NULL);
+			if (!rb_isvalid(&rb) || rb_find(&rb, compare, &lo)) {
+				printf("rb_erase_equal failed !\n");
+				return 1;
+			}
+
+			/* the nodes left are all that are not destroyed */
+			for (cnt = 0, rb_node = rb_first(&rb); rb_node;
+			     rb_node = rb_next(rb_node))
+				++cnt;
+			if (cnt != node_cnt) {
+				printf("error: %d nodes of %d\n",
+				       cnt, node_cnt);
+				return 1;
+			}
+		}
+
+		rb_detach_range(rb_first(&rb), NULL, &rb, &range);
+		if (rb.node)
+			printf("error: rb_detach_range to the end\n");
+		rb_clear(&range, destroy, NULL);
+		printf("6 node_cnt: %d\n", node_cnt);
+	}
+
 	return 0;
 }
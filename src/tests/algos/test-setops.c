@@ -0,0 +1,183 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <ycc/algos/rbtree.h>
+#include <ycc/algos/avltree.h>
+#include <ycc/algos/treap.h>
+
+#include "test-tree.h"
+
+#define SIZE1	100000
+#define SIZE2	30000
+#define RANGE	(SIZE1 * 4)
+
+/* destroy runs on the set-algorithm threads */
+static int node_cnt = 0;
+
+static unsigned char in1[RANGE], in2[RANGE];
+
+static void fill(unsigned char *in, int num)
+{
+	memset(in, 0, RANGE);
+	while (num) {
+		int val = rand() % RANGE;
+
+		if (!in[val]) {
+			in[val] = 1;
+			--num;
+		}
+	}
+}
+
+static int expect(int op, int val)
+{
+	switch (op) {
+	case 0:
+		return in1[val] || in2[val];
+	case 1:
+		return in1[val] && in2[val];
+	default:
+		return in1[val] && !in2[val];
+	}
+}
+
+/* an entry is linked in one kind of tree at a time */
+struct entry {
+	int val;
+	int tree;
+	struct rb_node rb;
+	struct avl_node avl;
+	struct treap_node treap;
+};
+
+TEST_TREE_COMPARE(rb, struct entry, rb, int, val)
+TEST_TREE_COMPARE(avl, struct entry, avl, int, val)
+TEST_TREE_COMPARE(treap, struct entry, treap, int, val)
+
+/* 'op' of two loaded trees against the reference of expect() */
+#define SETOP_TEST(name)						\
+static void name##_drop(struct name##_node *node, const void *arg)	\
+{									\
+	free(container_of(node, struct entry, name));			\
+	__sync_fetch_and_sub(&node_cnt, 1);				\
+}									\
+									\
+static int name##_load(struct name##_root *root, unsigned char *in,	\
+		       int tree)					\
+{									\
+	int val;							\
+									\
+	for (val = 0; val < RANGE; ++val) {				\
+		struct entry *p;					\
+									\
+		if (!in[val])						\
+			continue;					\
+		if (!(p = malloc(sizeof(*p)))) {			\
+			printf(#name ": out of memory\n");		\
+			return 1;					\
+		}							\
+		p->val = val;						\
+		p->tree = tree;						\
+		__sync_fetch_and_add(&node_cnt, 1);			\
+		name##_insert(&p->name, root,				\
+			      name##_compare_link, NULL);		\
+	}								\
+									\
+	return 0;							\
+}									\
+									\
+static int name##_test(int op, unsigned nthreads)			\
+{									\
+	int val = 0, num = 0;						\
+	struct name##_root root1 = { NULL }, root2 = { NULL };		\
+	struct name##_node *node;					\
+									\
+	if (name##_load(&root1, in1, 1) || name##_load(&root2, in2, 2))	\
+		return 1;						\
+									\
+	if (op == 0)							\
+		name##_union(&root1, &root1, &root2,			\
+			     name##_compare_link, name##_drop,	\
+			     NULL, NULL, nthreads);			\
+	else if (op == 1)						\
+		name##_intersection(&root1, &root1, &root2,		\
+				    name##_compare_link, name##_drop, \
+				    NULL, NULL, nthreads);		\
+	else								\
+		name##_difference(&root1, &root1, &root2,		\
+				  name##_compare_link, name##_drop,	\
+				  NULL, NULL, nthreads);		\
+									\
+	if (root2.node || !name##_isvalid(&root1)) {			\
+		printf(#name " op %d: invalid tree\n", op);		\
+		return 1;						\
+	}								\
+									\
+	for (node = name##_first(&root1); node;				\
+	     node = name##_next(node)) {				\
+		struct entry *p = container_of(node, struct entry, name); \
+									\
+		for (; val < p->val; ++val) {				\
+			if (expect(op, val)) {				\
+				printf(#name " op %d: %d lost\n",	\
+				       op, val);			\
+				return 1;				\
+			}						\
+		}							\
+		if (!expect(op, val++) || (in1[p->val] && p->tree != 1)) { \
+			printf(#name " op %d: %d wrong\n", op, p->val); \
+			return 1;					\
+		}							\
+		++num;							\
+	}								\
+	for (; val < RANGE; ++val) {					\
+		if (expect(op, val)) {					\
+			printf(#name " op %d: %d lost\n", op, val);	\
+			return 1;					\
+		}							\
+	}								\
+									\
+	if (num != node_cnt) {						\
+		printf(#name " op %d: %d nodes, %d alive\n",		\
+		       op, num, node_cnt);				\
+		return 1;						\
+	}								\
+									\
+	name##_clear(&root1, name##_drop, NULL);			\
+	return 0;							\
+}
+
+SETOP_TEST(rb)
+SETOP_TEST(avl)
+SETOP_TEST(treap)
+
+int main()
+{
+	int op;
+	unsigned nthreads;
+
+	srand( (unsigned int)time(NULL) );
+
+	for (nthreads = 1; nthreads <= 4; nthreads += 3) {
+		for (op = 0; op < 3; ++op) {
+			fill(in1, SIZE1);
+			fill(in2, op == 2 ? SIZE1 : SIZE2);
+			if (rb_test(op, nthreads) ||
+			    avl_test(op, nthreads) ||
+			    treap_test(op, nthreads))
+				return 1;
+			printf("op %d with %u threads: ok\n", op, nthreads);
+		}
+	}
+
+	/* an empty operand */
+	memset(in2, 0, RANGE);
+	if (rb_test(1, 4) || avl_test(0, 4) || treap_test(2, 4))
+		return 1;
+
+	printf("node_cnt = %d\n", node_cnt);
+
+	return node_cnt != 0;
+}
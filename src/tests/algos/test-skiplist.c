@@ -0,0 +1,165 @@
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <ycc/algos/skiplist.h>
+
+#define THREADS	8
+#define OPS	200000
+#define RANGE	1000
+
+struct node {
+	int key;
+	struct skl_node skl;
+};
+
+static struct epoch_domain domain;
+static struct skl_root skl;
+
+/* per key: successful inserts minus successful erases, 0 or 1 at last */
+static long balance[RANGE];
+static long nalloc, nrelease;
+
+static int compare(const struct skl_node *node, const void *arg)
+{
+	int key = skl_entry(node, struct node, skl)->key;
+
+	return key < *(const int*)arg ? -1 : key > *(const int*)arg;
+}
+
+static int compare_link(const struct skl_node *node1,
+			const struct skl_node *node2,
+			const void *arg)
+{
+	return compare(node1, &skl_entry(node2, struct node, skl)->key);
+}
+
+static void release(struct epoch_entry *entry)
+{
+	struct node *p = skl_entry(skl_epoch_entry(entry), struct node, skl);
+
+	/* a released node MUST be unreachable, poison it */
+	p->key = -1;
+	free(p);
+	__atomic_add_fetch(&nrelease, 1, __ATOMIC_RELAXED);
+}
+
+static void *worker(void *arg)
+{
+	unsigned int seed = (unsigned int)(unsigned long)arg;
+	struct epoch_thread *thr = epoch_register(&domain);
+	struct skl_node *node;
+	struct node *p;
+	int i, key;
+
+	if (!thr)
+		return (void*)1;
+
+	for (i = 0; i < OPS; ++i) {
+		key = rand_r(&seed) % RANGE;
+
+		epoch_enter(thr);
+		switch (rand_r(&seed) % 4) {
+		case 0:
+			p = malloc(sizeof(*p));
+			p->key = key;
+			__atomic_add_fetch(&nalloc, 1, __ATOMIC_RELAXED);
+			if (skl_insert_unique(&p->skl, &skl, compare_link,
+					      NULL)) {
+				free(p);
+				__atomic_sub_fetch(&nalloc, 1,
+						   __ATOMIC_RELAXED);
+				break;
+			}
+			__atomic_add_fetch(&balance[key], 1,
+					   __ATOMIC_RELAXED);
+			break;
+		case 1:
+			node = skl_find(&skl, compare, &key);
+			if (node && skl_erase(node, &skl, compare_link, NULL))
+				__atomic_sub_fetch(&balance[key], 1,
+						   __ATOMIC_RELAXED);
+			break;
+		default:
+			node = skl_lower_bound(&skl, compare, &key);
+			if (node && skl_entry(node, struct node, skl)->key <
+				    key) {
+				printf("skl_lower_bound of %d failed\n", key);
+				epoch_exit(thr);
+				return (void*)1;
+			}
+			break;
+		}
+		epoch_exit(thr);
+	}
+
+	epoch_unregister(thr);
+
+	return NULL;
+}
+
+int main()
+{
+	int i, key;
+	long num = 0;
+	void *ret;
+	pthread_t tids[THREADS];
+	struct skl_node *node;
+
+	srand( (unsigned int)time(NULL) );
+
+	epoch_init(&domain);
+	skl_init(&skl, &domain, release);
+
+	for (i = 0; i < THREADS; ++i) {
+		if (pthread_create(&tids[i], NULL, worker,
+				   (void*)(unsigned long)rand())) {
+			printf("pthread_create failed\n");
+			return 1;
+		}
+	}
+	for (i = 0; i < THREADS; ++i) {
+		pthread_join(tids[i], &ret);
+		if (ret)
+			return 1;
+	}
+
+	if (!skl_isvalid(&skl, compare_link, NULL)) {
+		printf("skl_isvalid failed !\n");
+		return 1;
+	}
+
+	/* the survivors are exactly the keys inserted once more */
+	for (key = 0, node = skl_first(&skl); key < RANGE; ++key) {
+		bool present = node &&
+			       skl_entry(node, struct node, skl)->key == key;
+
+		if (balance[key] != present) {
+			printf("key %d: balance %ld, present %d\n",
+			       key, balance[key], present);
+			return 1;
+		}
+		if (present) {
+			node = skl_next(node);
+			++num;
+		}
+	}
+	if (node) {
+		printf("skl: extra node %d\n",
+		       skl_entry(node, struct node, skl)->key);
+		return 1;
+	}
+
+	skl_clear(&skl);
+	epoch_destroy(&domain);
+	if (!skl_empty(&skl) || nrelease != nalloc) {
+		printf("skl: %ld released, %ld allocated, %ld left\n",
+		       nrelease, nalloc, num);
+		return 1;
+	}
+
+	printf("skiplist ok\n");
+
+	return 0;
+}
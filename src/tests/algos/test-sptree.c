@@ -54,6 +54,115 @@ static void destroy(struct spt_node *node, const void *arg)
 	node_free(spt_entry(node, struct node, spt_node));
 }
 
+/* the links, the order and the sizes of the subtree, its size or -1 */
+static long check(const struct spt_node *node, const struct spt_node *parent)
+{
+	long left, right;
+
+	if (!node)
+		return 0;
+
+	if (spt_parent(node) != parent ||
+	    (left = check(node->left, node)) < 0 ||
+	    (right = check(node->right, node)) < 0 ||
+	    (node->left && compare_link(node->left, node, NULL) > 0) ||
+	    (node->right && compare_link(node, node->right, NULL) > 0))
+		return -1;
+#ifdef	BSTLINK_SIZE
+	if (node->size != (size_t)(left + right + 1))
+		return -1;
+#endif
+
+	return left + right + 1;
+}
+
+/* 'bound' is the first node over 'val' - 'over', or NULL if none is */
+static bool is_bound(const struct spt_root *spt,
+		     const struct spt_node *bound,
+		     int val,
+		     int over)
+{
+	const struct spt_node *prev = bound ? spt_prev(bound) : spt_last(spt);
+
+	return (!bound || compare(bound, &val) >= over) &&
+	       (!prev || compare(prev, &val) < over);
+}
+
+#define MODE_SIZE	4096
+#define MODE_RANGE	1024
+
+static int test_mode(unsigned mode)
+{
+	static int cnt[MODE_RANGE + 1];
+	struct spt_root spt;
+	struct spt_node *lb, *ub, *found;
+	struct node *p;
+	/* only a semi-splay may leave an accessed node under the root */
+	bool root = (mode & SPT_TOPDOWN) || !(mode & SPT_SEMI);
+	long num = 0;
+	int i, val;
+
+	spt_init(&spt);
+	spt_set_mode(&spt, mode);
+	for (val = 0; val < MODE_RANGE; ++val)
+		cnt[val] = 0;
+
+	for (i = 0; i < MODE_SIZE; ++i) {
+		p = node_alloc(rand() % MODE_RANGE);
+		if (i % 2) {
+			spt_insert(&p->spt_node, &spt, compare_link, NULL);
+		} else if (!spt_insert_unique(&p->spt_node, &spt,
+					      compare_link, NULL)) {
+			if (!cnt[p->val])
+				goto fail;
+			node_free(p);
+			continue;
+		}
+		++cnt[p->val];
+		++num;
+	}
+	if (check(spt.node, NULL) != num)
+		goto fail;
+
+	for (i = 0; i < MODE_SIZE; ++i) {
+		val = rand() % (MODE_RANGE + 1);
+		/* the first of the equal ones */
+		found = spt_find(&spt, compare, &val);
+		lb = found ? spt_prev(found) : NULL;
+		if (!found != !cnt[val] ||
+		    (found && (compare(found, &val) ||
+			       (lb && !compare(lb, &val)) ||
+			       (root && spt.node != found))))
+			goto fail;
+
+		lb = spt_lower_bound(&spt, compare, &val);
+		if (!is_bound(&spt, lb, val, 0))
+			goto fail;
+		ub = spt_upper_bound(&spt, compare, &val);
+		if (!is_bound(&spt, ub, val, 1) ||
+		    ((mode & SPT_BOUNDS) && root && ub && spt.node != ub))
+			goto fail;
+	}
+	if (check(spt.node, NULL) != num)
+		goto fail;
+
+	/* half of the values gone, equal nodes and all */
+	for (val = 0; val < MODE_RANGE; val += 2) {
+		spt_erase_equal(&spt, compare, destroy, &val, NULL);
+		num -= cnt[val];
+		cnt[val] = 0;
+	}
+	if (check(spt.node, NULL) != num)
+		goto fail;
+
+	spt_clear(&spt, destroy, NULL);
+	return 0;
+
+fail:
+	printf("error: splay mode %u\n", mode);
+	return 1;
+}
+
 int main()
 {
 	int i, val;
@@ -107,6 +216,11 @@ int main()
 		printf("error: spt_node should be null\n");
 	}
 
+	for (i = 0; i < 8; ++i) {
+		if (test_mode(i))
+			return 1;
+	}
+	printf("4 node_cnt: %d\n", node_cnt);
 
 	return 0;
 }
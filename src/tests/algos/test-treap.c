@@ -50,6 +50,17 @@ static void destroy(struct treap_node *node, const void *arg)
 	node_free(treap_entry(node, struct node, treap_node));
 }
 
+static bool same_shape(const struct treap_node *node1,
+		       const struct treap_node *node2)
+{
+	if (!node1 || !node2)
+		return node1 == node2;
+
+	return !compare_link(node1, node2, NULL) &&
+	       same_shape(node1->left, node2->left) &&
+	       same_shape(node1->right, node2->right);
+}
+
 int main()
 {
 	int i, val;
@@ -103,5 +114,100 @@ int main()
 	}
 
 
+	/* build from sorted nodes */
+	{
+		struct treap_node **nodes = malloc(sizeof(*nodes) * 1000);
+
+		if (!nodes)
+			return 1;
+
+		for (i = 0; i < 1000; ++i)
+			nodes[i] = &node_alloc(i)->treap_node;
+		treap_build_sorted(&treap, nodes, 1000);
+		free(nodes);
+
+		if (!treap_isvalid(&treap)) {
+			printf("treap_build_sorted: treap_isvalid failed !\n");
+			return 1;
+		}
+
+		i = 0;
+		treap_node = treap_first(&treap);
+		while (treap_node) {
+			p = treap_entry(treap_node, struct node, treap_node);
+			if (p->val != i++)
+				printf("error: treap_build_sorted order\n");
+			treap_node = treap_next(treap_node);
+		}
+		printf("4 node_cnt: %d\n", node_cnt);
+	}
+
+	/* split and join */
+	{
+		struct treap_root left, right;
+
+		i = 500;
+		treap_split(&treap, compare, &i, &left, &right);
+		if (!treap_isvalid(&left) || !treap_isvalid(&right)) {
+			printf("treap_split: treap_isvalid failed !\n");
+			return 1;
+		}
+
+		treap_node = treap_last(&left);
+		if (treap_entry(treap_node, struct node, treap_node)->val != 499)
+			printf("error: treap_split left\n");
+		treap_node = treap_first(&right);
+		if (treap_entry(treap_node, struct node, treap_node)->val != 500)
+			printf("error: treap_split right\n");
+
+		treap_erase(treap_node, &right);
+		treap_join(&treap, &left, treap_node, &right);
+		if (!treap_isvalid(&treap) ||
+		    treap_count(&treap, compare, &i) != 1) {
+			printf("treap_join failed !\n");
+			return 1;
+		}
+
+		treap_clear(&treap, destroy, NULL);
+		printf("5 node_cnt: %d\n", node_cnt);
+	}
+
+	/* priorities of the keys, one shape whatever the insert order */
+	{
+		struct treap_root treap2;
+		unsigned priority;
+
+		treap_init(&treap2);
+		for (i = 0; i < 1000; ++i) {
+			p = node_alloc(i);
+			treap_insert_with_priority(&p->treap_node, &treap,
+						   treap_hash_priority(i),
+						   compare_link, NULL);
+			p = node_alloc(999 - i);
+			priority = treap_hash_priority(p->val);
+			treap_insert_unique_with_priority(&p->treap_node,
+							  &treap2, priority,
+							  compare_link, NULL);
+		}
+		p = node_alloc(500);
+		if (treap_insert_unique_with_priority(&p->treap_node, &treap2,
+						      treap_hash_priority(500),
+						      compare_link, NULL)) {
+			printf("treap_insert_unique_with_priority failed !\n");
+			return 1;
+		}
+		node_free(p);
+
+		if (!treap_isvalid(&treap) || !treap_isvalid(&treap2) ||
+		    !same_shape(treap.node, treap2.node)) {
+			printf("treap_hash_priority: shapes differ !\n");
+			return 1;
+		}
+
+		treap_clear(&treap, destroy, NULL);
+		treap_clear(&treap2, destroy, NULL);
+		printf("6 node_cnt: %d\n", node_cnt);
+	}
+
 	return 0;
 }
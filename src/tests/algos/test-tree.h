@@ -0,0 +1,41 @@
+/*
+ * test-tree.h -- compare routines of the tests run on several trees
+ *
+ * TEST_TREE_COMPARE(name, type, member, key_type, key) defines
+ * name##_compare and name##_compare_link for the 'member' node of
+ * 'type', ordered by its 'key' field of 'key_type'.  name##_compare
+ * takes a pointer to a key_type.
+ *
+ * Define TEST_TREE_ON_COMPARE() before the include to count the
+ * compares.
+ */
+
+#ifndef __YC_TESTS_TEST_TREE_H_
+#define __YC_TESTS_TEST_TREE_H_
+
+#include <ycc/compiler.h>
+
+#ifndef TEST_TREE_ON_COMPARE
+#define TEST_TREE_ON_COMPARE()	do { } while (0)
+#endif
+
+#define TEST_TREE_COMPARE(name, type, member, key_type, key)		\
+static inline int name##_compare(const struct name##_node *node,	\
+				 const void *arg)			\
+{									\
+	key_type k = container_of(node, type, member)->key;		\
+									\
+	TEST_TREE_ON_COMPARE();						\
+	return k < *(const key_type*)arg ? -1 :				\
+	       k > *(const key_type*)arg;				\
+}									\
+									\
+static inline int name##_compare_link(const struct name##_node *node1,	\
+				      const struct name##_node *node2,	\
+				      const void *arg)			\
+{									\
+	return name##_compare(node1,					\
+			      &container_of(node2, type, member)->key);	\
+}
+
+#endif /* __YC_TESTS_TEST_TREE_H_ */
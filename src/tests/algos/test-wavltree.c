@@ -0,0 +1,157 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <ycc/algos/wavltree.h>
+
+#define SIZE	(256*1024)
+#define RANGE	4096
+
+struct node {
+	int val;
+	struct wavl_node wavl_node;
+};
+
+static int node_cnt = 0;
+
+static struct node *node_alloc(int val)
+{
+	struct node *p = malloc(sizeof(*p));
+
+	if (p) {
+		p->val = val;
+		++node_cnt;
+	}
+
+	return p;
+}
+
+static void node_free(struct node *p)
+{
+	free(p);
+	if (p)
+		--node_cnt;
+}
+
+static int compare(const struct wavl_node *wavl_node, const void *arg)
+{
+	int val = wavl_entry(wavl_node, struct node, wavl_node)->val;
+
+	return val < *(const int*)arg ? -1 : val > *(const int*)arg;
+}
+
+static int compare_link(const struct wavl_node *wavl_node1,
+			const struct wavl_node *wavl_node2,
+			const void *arg)
+{
+	int val = wavl_entry(wavl_node2, struct node, wavl_node)->val;
+
+	return compare(wavl_node1, &val);
+}
+
+static void destroy(struct wavl_node *node, const void *arg)
+{
+	node_free(wavl_entry(node, struct node, wavl_node));
+}
+
+static bool check_order(const struct wavl_root *wavl)
+{
+	const struct wavl_node *node = wavl_first(wavl), *next;
+
+	for (; node && (next = wavl_next(node)); node = next) {
+		if (compare_link(node, next, NULL) > 0)
+			return false;
+	}
+
+	return true;
+}
+
+int main()
+{
+	int i, val;
+	struct node *p;
+	struct wavl_node *wavl_node;
+	size_t height;
+
+	WAVL_DECLARE(wavl);
+
+	srand( (unsigned int)time(NULL) );
+
+	/* inserts only, an AVL tree: height < 1.44 log2(n + 2) */
+	for (i = 0; i < SIZE; ++i) {
+		p = node_alloc(i);
+		wavl_insert(&p->wavl_node, &wavl, compare_link, NULL);
+	}
+	height = wavl_height_max(&wavl);
+	if (!wavl_isvalid(&wavl) || !check_order(&wavl) ||
+	    height > 1.4405 * log2(SIZE + 2)) {
+		printf("wavl_insert: height %zu of %d nodes\n", height, SIZE);
+		return 1;
+	}
+	wavl_clear(&wavl, destroy, NULL);
+
+	/* mixed inserts and erases, duplicates too */
+	for (i = 0; i < SIZE; ++i) {
+		val = rand() % RANGE;
+		if (rand() % 2) {
+			p = node_alloc(val);
+			if (i % 3) {
+				wavl_insert(&p->wavl_node, &wavl,
+					    compare_link, NULL);
+			} else if (!wavl_insert_unique(&p->wavl_node, &wavl,
+						       compare_link, NULL)) {
+				if (!wavl_find(&wavl, compare, &val)) {
+					printf("wavl_insert_unique failed\n");
+					return 1;
+				}
+				node_free(p);
+			}
+		} else if ((wavl_node = wavl_find(&wavl, compare, &val))) {
+			wavl_erase(wavl_node, &wavl);
+			destroy(wavl_node, NULL);
+		}
+
+		if (!(i % 4096) && !wavl_isvalid(&wavl)) {
+			printf("wavl_isvalid failed !\n");
+			return 1;
+		}
+	}
+	if (!wavl_isvalid(&wavl) || !check_order(&wavl)) {
+		printf("wavl: mixed updates failed !\n");
+		return 1;
+	}
+	printf("1 node_cnt: %d, height: {%zu, %zu}\n", node_cnt,
+	       wavl_height_min(&wavl), wavl_height_max(&wavl));
+
+	/* erase all but a few in random order, the ranks shrink back */
+	for (i = 0; i < RANGE; ++i) {
+		val = rand() % RANGE;
+		if (val % 16)
+			wavl_erase_equal(&wavl, compare, destroy, &val, NULL);
+		if (!(i % 256) && !wavl_isvalid(&wavl)) {
+			printf("wavl_erase_equal: wavl_isvalid failed !\n");
+			return 1;
+		}
+	}
+	for (val = 0; val < RANGE; ++val) {
+		if (val % 16)
+			wavl_erase_equal(&wavl, compare, destroy, &val, NULL);
+	}
+	if (!wavl_isvalid(&wavl) || !check_order(&wavl)) {
+		printf("wavl: erase failed !\n");
+		return 1;
+	}
+	printf("2 node_cnt: %d, height: {%zu, %zu}\n", node_cnt,
+	       wavl_height_min(&wavl), wavl_height_max(&wavl));
+
+	wavl_clear(&wavl, destroy, NULL);
+	if (node_cnt || wavl_first(&wavl)) {
+		printf("wavl_clear: %d nodes left\n", node_cnt);
+		return 1;
+	}
+
+	printf("wavl ok\n");
+
+	return 0;
+}